@@ -0,0 +1,68 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_BENCHMARKS_BENCHMARK_HH
+#define PALUDIS_GUARD_BENCHMARKS_BENCHMARK_HH 1
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace paludis
+{
+    namespace benchmarks
+    {
+        /**
+         * Use the distribution data from the source tree, rather than
+         * requiring an install, unless the environment says otherwise.
+         */
+        inline void use_source_tree_data()
+        {
+            setenv("PALUDIS_DISTRIBUTIONS_DIR", PALUDIS_BENCHMARKS_SOURCE_DIR "/paludis/distributions", 0);
+            setenv("PALUDIS_DISTRIBUTION", "gentoo", 0);
+        }
+
+        /**
+         * Write one tab separated line: name, iterations, items handled per
+         * iteration, total milliseconds, microseconds per item.
+         */
+        inline void report(const std::string & name, unsigned iterations, std::size_t items, double ms)
+        {
+            std::cout << name << "\t" << iterations << "\t" << items << "\t" << ms << "\t"
+                << (0 == items || 0 == iterations ? 0.0 : ms * 1000.0 / (iterations * items)) << std::endl;
+        }
+
+        /**
+         * Run f iterations times, and report how long it took.
+         */
+        template <typename F_>
+        void time(const std::string & name, unsigned iterations, std::size_t items, const F_ & f)
+        {
+            auto start(std::chrono::steady_clock::now());
+            for (unsigned i(0) ; i < iterations ; ++i)
+                f();
+            auto ms(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            report(name, iterations, items, ms);
+        }
+    }
+}
+
+#endif
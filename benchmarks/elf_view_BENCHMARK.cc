@@ -0,0 +1,157 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * Compares reading DT_NEEDED from every ELF object in some directories
+ * using ElfObject over a SafeIFStream against ElfView over a MappedFile.
+ *
+ * Usage: elf_view_BENCHMARK [iterations] [dir ...]
+ *
+ * Writes one tab separated line per method: name, iterations, files read,
+ * total milliseconds, microseconds per file.
+ */
+
+#include <paludis/util/elf.hh>
+#include <paludis/util/elf_view.hh>
+#include <paludis/util/elf_types.hh>
+#include <paludis/util/elf_dynamic_section.hh>
+#include <paludis/util/elf_relocation_section.hh>
+#include <paludis/util/elf_symbol_section.hh>
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/options.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/visitor_cast.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/destringify.hh>
+
+#include <chrono>
+#include <iterator>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace paludis;
+
+namespace
+{
+    template <typename ElfType_>
+    bool needed_from_stream(std::istream & stream, unsigned & count)
+    {
+        if (! ElfObject<ElfType_>::is_valid_elf(stream))
+            return false;
+
+        ElfObject<ElfType_> elf(stream);
+        elf.resolve_all_strings();
+        for (const auto & section : elf.sections())
+            if (const auto * dyn_sec = visitor_cast<const DynamicSection<ElfType_> >(section))
+                for (const auto & entry : dyn_sec->entries())
+                    if (const auto * ent_str = visitor_cast<const DynamicEntryString<ElfType_> >(entry))
+                        if ("NEEDED" == ent_str->tag_name())
+                            ++count;
+        return true;
+    }
+
+    template <typename ElfType_>
+    bool needed_from_mapping(const MappedFile & mapped, unsigned & count)
+    {
+        if (! ElfView<ElfType_>::is_valid_elf(mapped))
+            return false;
+
+        ElfView<ElfType_> elf(mapped);
+        auto needed(elf.get_dynamic_strings(DT_NEEDED));
+        count += std::distance(needed->begin(), needed->end());
+        return true;
+    }
+
+    unsigned run_stream(const std::vector<FSPath> & files)
+    {
+        unsigned count(0);
+        for (const auto & f : files)
+        {
+            try
+            {
+                SafeIFStream stream(f);
+                needed_from_stream<Elf32Type>(stream, count) || needed_from_stream<Elf64Type>(stream, count);
+            }
+            catch (const Exception &)
+            {
+            }
+        }
+        return count;
+    }
+
+    unsigned run_mapped(const std::vector<FSPath> & files)
+    {
+        unsigned count(0);
+        for (const auto & f : files)
+        {
+            try
+            {
+                MappedFile mapped(f);
+                needed_from_mapping<Elf32Type>(mapped, count) || needed_from_mapping<Elf64Type>(mapped, count);
+            }
+            catch (const Exception &)
+            {
+            }
+        }
+        return count;
+    }
+
+    template <typename F_>
+    void time(const std::string & name, unsigned iterations, const std::vector<FSPath> & files, F_ f)
+    {
+        unsigned count(0);
+        auto start(std::chrono::steady_clock::now());
+        for (unsigned i(0) ; i < iterations ; ++i)
+            count = f(files);
+        auto ms(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        std::cout << name << "\t" << iterations << "\t" << files.size() << "\t" << ms << "\t"
+            << (files.empty() ? 0.0 : ms * 1000.0 / (iterations * files.size())) << std::endl;
+        std::cerr << name << ": found " << count << " DT_NEEDED entries" << std::endl;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned iterations(argc > 1 ? destringify<unsigned>(argv[1]) : 10);
+
+    std::vector<FSPath> dirs;
+    for (int i(2) ; i < argc ; ++i)
+        dirs.push_back(FSPath(argv[i]));
+    if (dirs.empty())
+        dirs.push_back(FSPath("/usr/lib"));
+
+    std::vector<FSPath> files;
+    for (const auto & d : dirs)
+        for (FSIterator i(d, { fsio_include_dotfiles }), i_end ; i != i_end ; ++i)
+            if (i->stat().is_regular_file() && std::string::npos != i->basename().find(".so"))
+                files.push_back(*i);
+
+    time("elf_object_istream", iterations, files, run_stream);
+    time("elf_view_mmap", iterations, files, run_mapped);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Times parsing and comparing VersionSpecs, and parsing dependency strings.
+ *
+ * Usage: parsing_BENCHMARK [iterations] [count]
+ *
+ * Writes one tab separated line per benchmark: name, iterations, items,
+ * total milliseconds, microseconds per item.
+ */
+
+#include <benchmarks/benchmark.hh>
+
+#include <paludis/repositories/fake/dep_parser.hh>
+#include <paludis/environments/test/test_environment.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/options.hh>
+#include <paludis/version_spec.hh>
+#include <paludis/user_dep_spec.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/spec_tree.hh>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::benchmarks;
+
+namespace
+{
+    const char * const suffixes[] = { "", "_alpha", "_beta2", "_pre20100101", "_rc3", "_p1", "-r1", "_rc1_p2-r3", "-scm" };
+
+    std::vector<std::string> make_version_strings(unsigned count)
+    {
+        std::vector<std::string> result;
+        for (unsigned i(0) ; i < count ; ++i)
+        {
+            std::string v(stringify(i % 7) + "." + stringify(i % 31) + "." + stringify(i % 113));
+            if (0 == i % 11)
+                v.append(".0.0.1");
+            if (0 == i % 5)
+                v.append("b");
+            v.append(suffixes[i % (sizeof(suffixes) / sizeof(suffixes[0]))]);
+            result.push_back(v);
+        }
+        return result;
+    }
+
+    std::vector<std::string> make_dep_strings(unsigned count)
+    {
+        std::vector<std::string> result;
+        for (unsigned i(0) ; i < count ; ++i)
+        {
+            std::string c("cat-" + stringify(i % 100));
+            std::string d(
+                    ">=" + c + "/pkg" + stringify(i) + "-1.2.3 "
+                    "foo-enabled? ( " + c + "/lib" + stringify(i) + "[bar-enabled][-baz-disabled] "
+                        "|| ( =" + c + "/alt" + stringify(i) + "-2* " + c + "/other" + stringify(i) + ":3 ) ) "
+                    "!<" + c + "/old" + stringify(i) + "-0.9 "
+                    "!foo-enabled? ( ~" + c + "/pkg" + stringify(i + 1) + "-1.0 )");
+            result.push_back(d);
+        }
+        return result;
+    }
+
+    std::vector<std::string> make_user_spec_strings(unsigned count)
+    {
+        std::vector<std::string> result;
+        for (unsigned i(0) ; i < count ; ++i)
+            result.push_back(">=cat-" + stringify(i % 100) + "/pkg" + stringify(i) + "-" + stringify(i % 9) + ".1:"
+                    + stringify(i % 3) + "::repo[foo][-bar]");
+        return result;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    use_source_tree_data();
+
+    try
+    {
+        unsigned iterations(argc > 1 ? destringify<unsigned>(argv[1]) : 3);
+        unsigned count(argc > 2 ? destringify<unsigned>(argv[2]) : 100000);
+
+        TestEnvironment env;
+        long sink(0);
+
+        const std::vector<std::string> version_strings(make_version_strings(count));
+        std::vector<VersionSpec> versions;
+        for (const auto & s : version_strings)
+            versions.push_back(VersionSpec(s, user_version_spec_options()));
+
+        time("version_spec_parse", iterations, version_strings.size(), [&] () {
+                for (const auto & s : version_strings)
+                    sink += VersionSpec(s, user_version_spec_options()).hash();
+                });
+
+        time("version_spec_compare", iterations, versions.size(), [&] () {
+                for (std::size_t i(0), i_end(versions.size()) ; i != i_end ; ++i)
+                    sink += versions[i].compare(versions[(i * 7919) % i_end]);
+                });
+
+        const std::vector<std::string> dep_strings(make_dep_strings(count / 10));
+        time("dep_string_parse", iterations, dep_strings.size(), [&] () {
+                for (const auto & s : dep_strings)
+                    sink += bool(fakerepository::parse_depend(s, &env));
+                });
+
+        const std::vector<std::string> user_spec_strings(make_user_spec_strings(count));
+        time("user_package_dep_spec_parse", iterations, user_spec_strings.size(), [&] () {
+                for (const auto & s : user_spec_strings)
+                    sink += bool(parse_user_package_dep_spec(s, &env, { }).package_ptr());
+                });
+
+        std::cerr << "checksum " << sink << std::endl;
+
+        return EXIT_SUCCESS;
+    }
+    catch (const Exception & e)
+    {
+        std::cerr << "Error:" << std::endl;
+        std::cerr << "  * " << e.backtrace("\n  * ") << e.message() << " (" << e.what() << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,137 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Times selections and match_package against a large FakeRepository.
+ *
+ * Usage: repository_BENCHMARK [iterations] [packages]
+ *
+ * Each package gets four versions, so the repository holds four times as
+ * many IDs as packages. Writes one tab separated line per benchmark: name,
+ * iterations, items, total milliseconds, microseconds per item.
+ */
+
+#include <benchmarks/benchmark.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+#include <paludis/environments/test/test_environment.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/options.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/match_package.hh>
+#include <paludis/user_dep_spec.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/selection.hh>
+#include <paludis/generator.hh>
+#include <paludis/filter.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/package_id.hh>
+
+#include <cstdlib>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::benchmarks;
+
+namespace
+{
+    const char * const versions[] = { "1.0", "1.1-r1", "2.0_rc1", "2.0" };
+
+    long count(const std::shared_ptr<const PackageIDSequence> & ids)
+    {
+        return std::distance(ids->begin(), ids->end());
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    use_source_tree_data();
+
+    try
+    {
+        unsigned iterations(argc > 1 ? destringify<unsigned>(argv[1]) : 3);
+        unsigned packages(argc > 2 ? destringify<unsigned>(argv[2]) : 25000);
+
+        TestEnvironment env;
+        std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                        n::environment() = &env,
+                        n::name() = RepositoryName("repo")
+                        )));
+        env.add_repository(1, repo);
+
+        std::vector<QualifiedPackageName> names;
+        std::vector<std::shared_ptr<const PackageID> > ids;
+        for (unsigned p(0) ; p < packages ; ++p)
+        {
+            names.push_back(CategoryNamePart("cat-" + stringify(p % 100)) + PackageNamePart("pkg" + stringify(p)));
+            for (const auto & v : versions)
+            {
+                std::shared_ptr<FakePackageID> id(repo->add_version(names.back(), VersionSpec(v, user_version_spec_options())));
+                id->choices_key()->add("", "foo-enabled");
+                id->choices_key()->add("", "bar-disabled");
+                ids.push_back(id);
+            }
+        }
+
+        std::vector<PackageDepSpec> specs;
+        for (const auto & n : names)
+            specs.push_back(parse_user_package_dep_spec(">=" + stringify(n) + "-1.1[foo-enabled][-bar-disabled]", &env, { }));
+
+        long sink(0);
+
+        time("selection_all_versions_sorted", iterations, names.size(), [&] () {
+                for (const auto & n : names)
+                    sink += count(env[selection::AllVersionsSorted(generator::Package(n))]);
+                });
+
+        time("selection_best_version_matching", iterations, specs.size(), [&] () {
+                for (const auto & s : specs)
+                    sink += count(env[selection::BestVersionOnly(generator::Matches(s, nullptr, { }) | filter::NotMasked())]);
+                });
+
+        time("selection_all_in_category", iterations, 100, [&] () {
+                for (unsigned c(0) ; c < 100 ; ++c)
+                    sink += count(env[selection::AllVersionsUnsorted(generator::Category(CategoryNamePart("cat-" + stringify(c))))]);
+                });
+
+        time("match_package", iterations, ids.size(), [&] () {
+                for (std::size_t i(0), i_end(ids.size()) ; i != i_end ; ++i)
+                    sink += match_package(env, specs[i / (sizeof(versions) / sizeof(versions[0]))], ids[i], nullptr, { });
+                });
+
+        std::cerr << "checksum " << sink << std::endl;
+
+        return EXIT_SUCCESS;
+    }
+    catch (const Exception & e)
+    {
+        std::cerr << "Error:" << std::endl;
+        std::cerr << "  * " << e.backtrace("\n  * ") << e.message() << " (" << e.what() << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,340 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Times the Decider and the Orderer on a large synthetic FakeRepository.
+ *
+ * Usage: resolver_BENCHMARK [iterations] [packages] [reach]
+ *
+ * Every package has three versions. Package i depends upon package i + 1,
+ * and upon packages 2i + 1 and 3i + 2, some of them through USE
+ * conditionals, USE dependencies and any-of groups. Every tenth package has
+ * an older version installed, and every seventh package carries blockers.
+ * The first package is used as the target, and the first reach packages
+ * depend only upon each other, so the target pulls in a chain reach
+ * packages deep whilst the rest of the repository is only searched.
+ *
+ * Writes one tab separated line per phase: name, iterations, resolutions,
+ * total milliseconds, microseconds per resolution. Time spent on attempts
+ * that end in a restart is counted against the decider.
+ */
+
+#include <benchmarks/benchmark.hh>
+
+#include <paludis/resolver/allow_choice_changes_helper.hh>
+#include <paludis/resolver/allowed_to_remove_helper.hh>
+#include <paludis/resolver/allowed_to_restart_helper.hh>
+#include <paludis/resolver/always_via_binary_helper.hh>
+#include <paludis/resolver/can_use_helper.hh>
+#include <paludis/resolver/confirm_helper.hh>
+#include <paludis/resolver/find_replacing_helper.hh>
+#include <paludis/resolver/find_repository_for_helper.hh>
+#include <paludis/resolver/get_constraints_for_dependent_helper.hh>
+#include <paludis/resolver/get_constraints_for_purge_helper.hh>
+#include <paludis/resolver/get_constraints_for_via_binary_helper.hh>
+#include <paludis/resolver/get_destination_types_for_blocker_helper.hh>
+#include <paludis/resolver/get_destination_types_for_error_helper.hh>
+#include <paludis/resolver/get_initial_constraints_for_helper.hh>
+#include <paludis/resolver/get_resolvents_for_helper.hh>
+#include <paludis/resolver/get_use_existing_nothing_helper.hh>
+#include <paludis/resolver/interest_in_spec_helper.hh>
+#include <paludis/resolver/make_destination_filtered_generator_helper.hh>
+#include <paludis/resolver/make_origin_filtered_generator_helper.hh>
+#include <paludis/resolver/make_unmaskable_filter_helper.hh>
+#include <paludis/resolver/order_early_helper.hh>
+#include <paludis/resolver/remove_hidden_helper.hh>
+#include <paludis/resolver/remove_if_dependent_helper.hh>
+#include <paludis/resolver/prefer_or_avoid_helper.hh>
+#include <paludis/resolver/promote_binaries_helper.hh>
+#include <paludis/resolver/resolver_functions.hh>
+#include <paludis/resolver/resolved.hh>
+#include <paludis/resolver/resolutions_by_resolvent.hh>
+#include <paludis/resolver/decider.hh>
+#include <paludis/resolver/orderer.hh>
+#include <paludis/resolver/decisions.hh>
+#include <paludis/resolver/decision.hh>
+#include <paludis/resolver/job_lists.hh>
+#include <paludis/resolver/job_list.hh>
+#include <paludis/resolver/job.hh>
+#include <paludis/resolver/nag.hh>
+#include <paludis/resolver/reason.hh>
+#include <paludis/resolver/suggest_restart.hh>
+#include <paludis/resolver/package_or_block_dep_spec.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_installed_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+#include <paludis/environments/test/test_environment.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/options.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/make_shared_copy.hh>
+#include <paludis/user_dep_spec.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/generator.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/selection.hh>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace paludis;
+using namespace paludis::resolver;
+using namespace paludis::benchmarks;
+
+namespace
+{
+    std::string name_of(unsigned p)
+    {
+        return "cat-" + stringify(p % 100) + "/pkg" + stringify(p);
+    }
+
+    std::string deps_of(unsigned p, unsigned limit)
+    {
+        std::string result;
+        if (p + 1 < limit)
+            result.append(">=" + name_of(p + 1) + "-1.0[foo-enabled] ");
+        if (2 * p + 1 < limit)
+            result.append("foo-enabled? ( " + name_of(2 * p + 1) + "[-bar-disabled] ) ");
+        if (3 * p + 2 < limit)
+            result.append("bar-disabled? ( " + name_of(3 * p + 2) + " ) || ( <" + name_of(3 * p + 2) + "-3 " + name_of(3 * p + 2) + " ) ");
+        if (0 == p % 7)
+            result.append("!<" + name_of(p + 1) + "-0.1 !cat-none/none" + stringify(p) + " ");
+        return result;
+    }
+
+    struct Helpers
+    {
+        AllowChoiceChangesHelper allow_choice_changes_helper;
+        AllowedToRemoveHelper allowed_to_remove_helper;
+        AllowedToRestartHelper allowed_to_restart_helper;
+        AlwaysViaBinaryHelper always_via_binary_helper;
+        CanUseHelper can_use_helper;
+        ConfirmHelper confirm_helper;
+        FindReplacingHelper find_replacing_helper;
+        FindRepositoryForHelper find_repository_for_helper;
+        GetConstraintsForDependentHelper get_constraints_for_dependent_helper;
+        GetConstraintsForPurgeHelper get_constraints_for_purge_helper;
+        GetConstraintsForViaBinaryHelper get_constraints_for_via_binary_helper;
+        GetDestinationTypesForBlockerHelper get_destination_types_for_blocker_helper;
+        GetDestinationTypesForErrorHelper get_destination_types_for_error_helper;
+        GetInitialConstraintsForHelper get_initial_constraints_for_helper;
+        GetUseExistingNothingHelper get_use_existing_nothing_helper;
+        InterestInSpecHelper interest_in_spec_helper;
+        MakeDestinationFilteredGeneratorHelper make_destination_filtered_generator_helper;
+        MakeOriginFilteredGeneratorHelper make_origin_filtered_generator_helper;
+        MakeUnmaskableFilterHelper make_unmaskable_filter_helper;
+        OrderEarlyHelper order_early_helper;
+        PreferOrAvoidHelper prefer_or_avoid_helper;
+        PromoteBinariesHelper promote_binaries_helper;
+        RemoveHiddenHelper remove_hidden_helper;
+        RemoveIfDependentHelper remove_if_dependent_helper;
+        GetResolventsForHelper get_resolvents_for_helper;
+
+        Helpers(const Environment * const env) :
+            allow_choice_changes_helper(env),
+            allowed_to_remove_helper(env),
+            allowed_to_restart_helper(env),
+            always_via_binary_helper(env),
+            can_use_helper(env),
+            confirm_helper(env),
+            find_replacing_helper(env),
+            find_repository_for_helper(env),
+            get_constraints_for_dependent_helper(env),
+            get_constraints_for_purge_helper(env),
+            get_constraints_for_via_binary_helper(env),
+            get_destination_types_for_blocker_helper(env),
+            get_destination_types_for_error_helper(env),
+            get_initial_constraints_for_helper(env),
+            get_use_existing_nothing_helper(env),
+            interest_in_spec_helper(env),
+            make_destination_filtered_generator_helper(env),
+            make_origin_filtered_generator_helper(env),
+            make_unmaskable_filter_helper(env),
+            order_early_helper(env),
+            prefer_or_avoid_helper(env),
+            promote_binaries_helper(env),
+            remove_hidden_helper(env),
+            remove_if_dependent_helper(env),
+            get_resolvents_for_helper(env, std::cref(remove_hidden_helper))
+        {
+            interest_in_spec_helper.set_follow_installed_dependencies(true);
+            make_unmaskable_filter_helper.set_override_masks(false);
+        }
+
+        ResolverFunctions functions()
+        {
+            return make_named_values<ResolverFunctions>(
+                    n::allow_choice_changes_fn() = std::cref(allow_choice_changes_helper),
+                    n::allowed_to_remove_fn() = std::cref(allowed_to_remove_helper),
+                    n::allowed_to_restart_fn() = std::cref(allowed_to_restart_helper),
+                    n::always_via_binary_fn() = std::cref(always_via_binary_helper),
+                    n::can_use_fn() = std::cref(can_use_helper),
+                    n::confirm_fn() = std::cref(confirm_helper),
+                    n::find_replacing_fn() = std::cref(find_replacing_helper),
+                    n::find_repository_for_fn() = std::cref(find_repository_for_helper),
+                    n::get_constraints_for_dependent_fn() = std::cref(get_constraints_for_dependent_helper),
+                    n::get_constraints_for_purge_fn() = std::cref(get_constraints_for_purge_helper),
+                    n::get_constraints_for_via_binary_fn() = std::cref(get_constraints_for_via_binary_helper),
+                    n::get_destination_types_for_blocker_fn() = std::cref(get_destination_types_for_blocker_helper),
+                    n::get_destination_types_for_error_fn() = std::cref(get_destination_types_for_error_helper),
+                    n::get_initial_constraints_for_fn() = std::cref(get_initial_constraints_for_helper),
+                    n::get_resolvents_for_fn() = std::cref(get_resolvents_for_helper),
+                    n::get_use_existing_nothing_fn() = std::cref(get_use_existing_nothing_helper),
+                    n::interest_in_spec_fn() = std::cref(interest_in_spec_helper),
+                    n::make_destination_filtered_generator_fn() = std::cref(make_destination_filtered_generator_helper),
+                    n::make_origin_filtered_generator_fn() = std::cref(make_origin_filtered_generator_helper),
+                    n::make_unmaskable_filter_fn() = std::cref(make_unmaskable_filter_helper),
+                    n::order_early_fn() = std::cref(order_early_helper),
+                    n::prefer_or_avoid_fn() = std::cref(prefer_or_avoid_helper),
+                    n::promote_binaries_fn() = std::cref(promote_binaries_helper),
+                    n::remove_hidden_fn() = std::cref(remove_hidden_helper),
+                    n::remove_if_dependent_fn() = std::cref(remove_if_dependent_helper)
+                    );
+        }
+    };
+
+    std::shared_ptr<Resolved> make_resolved()
+    {
+        return std::make_shared<Resolved>(make_named_values<Resolved>(
+                    n::job_lists() = make_shared_copy(make_named_values<JobLists>(
+                            n::execute_job_list() = std::make_shared<JobList<ExecuteJob>>(),
+                            n::pretend_job_list() = std::make_shared<JobList<PretendJob>>()
+                            )),
+                    n::nag() = std::make_shared<NAG>(),
+                    n::resolutions_by_resolvent() = std::make_shared<ResolutionsByResolvent>(),
+                    n::taken_change_or_remove_decisions() = std::make_shared<OrderedChangeOrRemoveDecisions>(),
+                    n::taken_unable_to_make_decisions() = std::make_shared<Decisions<UnableToMakeDecision>>(),
+                    n::taken_unconfirmed_decisions() = std::make_shared<Decisions<ConfirmableDecision>>(),
+                    n::taken_unorderable_decisions() = std::make_shared<OrderedChangeOrRemoveDecisions>(),
+                    n::untaken_change_or_remove_decisions() = std::make_shared<Decisions<ChangeOrRemoveDecision>>(),
+                    n::untaken_unable_to_make_decisions() = std::make_shared<Decisions<UnableToMakeDecision>>()
+                    ));
+    }
+
+    double ms_since(const std::chrono::steady_clock::time_point & start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    use_source_tree_data();
+
+    try
+    {
+        unsigned iterations(argc > 1 ? destringify<unsigned>(argv[1]) : 3);
+        unsigned packages(argc > 2 ? destringify<unsigned>(argv[2]) : 4000);
+        unsigned reach(argc > 3 ? destringify<unsigned>(argv[3]) : 500);
+
+        TestEnvironment env;
+        std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                        n::environment() = &env,
+                        n::name() = RepositoryName("repo")
+                        )));
+        env.add_repository(1, repo);
+
+        std::shared_ptr<FakeInstalledRepository> installed(std::make_shared<FakeInstalledRepository>(
+                    make_named_values<FakeInstalledRepositoryParams>(
+                        n::environment() = &env,
+                        n::name() = RepositoryName("installed"),
+                        n::suitable_destination() = true,
+                        n::supports_uninstall() = true
+                        )));
+        env.add_repository(2, installed);
+
+        time("synthesise", 1, packages * 3, [&] () {
+                for (unsigned p(0) ; p < packages ; ++p)
+                {
+                    QualifiedPackageName q(name_of(p));
+                    for (const auto & v : { "1.0", "2.0", "3.0" })
+                    {
+                        std::shared_ptr<FakePackageID> id(repo->add_version(q, VersionSpec(v, user_version_spec_options())));
+                        id->choices_key()->add("", "foo-enabled");
+                        id->choices_key()->add("", "bar-disabled");
+                        id->build_dependencies_key()->set_from_string(deps_of(p, p < reach ? reach : packages));
+                        id->run_dependencies_key()->set_from_string(deps_of(p, p < reach ? reach : packages));
+                    }
+
+                    if (0 == p % 10)
+                    {
+                        std::shared_ptr<FakePackageID> id(installed->add_version(q, VersionSpec("0.9", user_version_spec_options())));
+                        id->choices_key()->add("", "foo-enabled");
+                        id->choices_key()->add("", "bar-disabled");
+                    }
+                }
+                });
+
+        const PackageDepSpec target(parse_user_package_dep_spec(name_of(0), &env, { }));
+
+        double decider_ms(0), orderer_ms(0);
+        std::size_t resolutions(0), restarts(0);
+        for (unsigned i(0) ; i < iterations ; ++i)
+        {
+            Helpers helpers(&env);
+            while (true)
+            {
+                auto start(std::chrono::steady_clock::now());
+                try
+                {
+                    std::shared_ptr<Resolved> resolved(make_resolved());
+                    Decider decider(&env, helpers.functions(), resolved->resolutions_by_resolvent());
+                    Orderer orderer(&env, helpers.functions(), resolved);
+
+                    decider.add_target_with_reason(target, std::make_shared<TargetReason>(""));
+                    decider.resolve();
+                    decider_ms += ms_since(start);
+
+                    start = std::chrono::steady_clock::now();
+                    orderer.resolve();
+                    orderer_ms += ms_since(start);
+
+                    resolutions = std::distance(resolved->resolutions_by_resolvent()->begin(),
+                            resolved->resolutions_by_resolvent()->end());
+                    break;
+                }
+                catch (const SuggestRestart & e)
+                {
+                    decider_ms += ms_since(start);
+                    helpers.get_initial_constraints_for_helper.add_suggested_restart(e);
+                    ++restarts;
+                }
+            }
+        }
+
+        report("decider", iterations, resolutions, decider_ms);
+        report("orderer", iterations, resolutions, orderer_ms);
+        std::cerr << "restarts " << restarts << std::endl;
+
+        return EXIT_SUCCESS;
+    }
+    catch (const Exception & e)
+    {
+        std::cerr << "Error:" << std::endl;
+        std::cerr << "  * " << e.backtrace("\n  * ") << e.message() << " (" << e.what() << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
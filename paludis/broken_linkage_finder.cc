@@ -36,6 +36,7 @@
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_error.hh>
 #include <paludis/util/join.hh>
+#include <paludis/util/thread_pool.hh>
 
 #include <paludis/contents.hh>
 #include <paludis/environment.hh>
@@ -49,11 +50,15 @@
 
 #include <functional>
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <iterator>
+#include <list>
 #include <map>
 #include <set>
 #include <vector>
 #include <mutex>
+#include <thread>
 
 using namespace paludis;
 
@@ -75,6 +80,12 @@ namespace paludis
 
         std::mutex mutex;
 
+        std::mutex queue_mutex;
+        std::condition_variable queue_condition;
+        std::list<FSPath> queued_directories;
+        unsigned busy_workers;
+        std::exception_ptr worker_exception;
+
         bool has_files;
         Files files;
 
@@ -83,16 +94,20 @@ namespace paludis
 
         void search_directory(const FSPath &);
 
+        void queue_directory(const FSPath &);
+        void walk_worker() noexcept;
         void walk_directory(const FSPath &);
         void check_file(const FSPath &);
 
         void add_breakage(const FSPath &, const std::string &);
         void gather_package(const std::shared_ptr<const PackageID> &);
+        void gather_worker(PackageIDSequence::ConstIterator &, const PackageIDSequence::ConstIterator &) noexcept;
 
         Imp(const Environment * the_env, const std::shared_ptr<const Sequence<std::string>> & the_libraries) :
             env(the_env),
             config(the_env->preferred_root_key()->parse_value()),
             libraries(the_libraries),
+            busy_workers(0),
             has_files(false)
         {
         }
@@ -142,12 +157,29 @@ namespace
 
 BrokenLinkageFinder::BrokenLinkageFinder(const Environment * env, const std::shared_ptr<const Sequence<std::string>> & libraries) :
     _imp(env, libraries)
+{
+    _search(nullptr);
+}
+
+BrokenLinkageFinder::BrokenLinkageFinder(const Environment * env, const std::shared_ptr<const Sequence<std::string>> & libraries,
+        const FSPath & cache_file) :
+    _imp(env, libraries)
+{
+    _search(std::make_shared<FSPath>(cache_file));
+}
+
+void
+BrokenLinkageFinder::_search(const std::shared_ptr<const FSPath> & cache_file)
 {
     using namespace std::placeholders;
 
+    const Environment * const env(_imp->env);
+    const std::shared_ptr<const Sequence<std::string>> libraries(_imp->libraries);
+
     Context ctx("When checking for broken linkage in '" + stringify(env->preferred_root_key()->parse_value()) + "':");
 
-    _imp->checkers.push_back(std::shared_ptr<LinkageChecker>(std::make_shared<ElfLinkageChecker>(env->preferred_root_key()->parse_value(), libraries)));
+    _imp->checkers.push_back(std::shared_ptr<LinkageChecker>(std::make_shared<ElfLinkageChecker>(
+                    env->preferred_root_key()->parse_value(), libraries, cache_file)));
     if (libraries->empty())
         _imp->checkers.push_back(std::shared_ptr<LinkageChecker>(std::make_shared<LibtoolLinkageChecker>(env->preferred_root_key()->parse_value())));
 
@@ -172,6 +204,16 @@ BrokenLinkageFinder::BrokenLinkageFinder(const Environment * env, const std::sha
     std::for_each(search_dirs_pruned.begin(), search_dirs_pruned.end(),
                       std::bind(&Imp<BrokenLinkageFinder>::search_directory, _imp.get(), _1));
 
+    {
+        ThreadPool pool;
+        unsigned n_threads(std::max(1u, std::thread::hardware_concurrency()));
+        for (unsigned n(0) ; n != n_threads ; ++n)
+            pool.create_thread(std::bind(&Imp<BrokenLinkageFinder>::walk_worker, _imp.get()));
+    }
+
+    if (_imp->worker_exception)
+        std::rethrow_exception(_imp->worker_exception);
+
     for (const auto & dir : _imp->extra_lib_dirs)
     {
         Log::get_instance()->message("broken_linkage_finder.config", ll_debug, lc_context)
@@ -210,12 +252,65 @@ Imp<BrokenLinkageFinder>::search_directory(const FSPath & directory)
 
     FSPath with_root(env->preferred_root_key()->parse_value() / directory);
     if (with_root.stat().is_directory())
-        walk_directory(with_root);
+        queue_directory(with_root);
     else
         Log::get_instance()->message("broken_linkage_finder.missing", ll_debug, lc_context)
             << "'" << directory << "' is missing or not a directory";
 }
 
+void
+Imp<BrokenLinkageFinder>::queue_directory(const FSPath & directory)
+{
+    std::unique_lock<std::mutex> l(queue_mutex);
+    queued_directories.push_back(directory);
+    queue_condition.notify_one();
+}
+
+void
+Imp<BrokenLinkageFinder>::walk_worker() noexcept
+{
+    while (true)
+    {
+        FSPath directory("/");
+
+        {
+            std::unique_lock<std::mutex> l(queue_mutex);
+
+            /* we're done once nothing is queued and nobody is busy, since
+             * only a busy worker can queue more directories */
+            queue_condition.wait(l, [&] { return ! queued_directories.empty() || 0 == busy_workers; });
+            if (queued_directories.empty() || worker_exception)
+            {
+                queue_condition.notify_all();
+                return;
+            }
+
+            directory = queued_directories.front();
+            queued_directories.pop_front();
+            ++busy_workers;
+        }
+
+        try
+        {
+            Context context("When checking for broken linkage in '" + stringify(directory) + "':");
+            walk_directory(directory);
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> l(queue_mutex);
+            if (! worker_exception)
+                worker_exception = std::current_exception();
+            queued_directories.clear();
+        }
+
+        {
+            std::unique_lock<std::mutex> l(queue_mutex);
+            --busy_workers;
+            queue_condition.notify_all();
+        }
+    }
+}
+
 void
 Imp<BrokenLinkageFinder>::walk_directory(const FSPath & directory)
 {
@@ -267,7 +362,7 @@ Imp<BrokenLinkageFinder>::check_file(const FSPath & file)
         }
 
         else if (file_stat.is_directory())
-            walk_directory(file);
+            queue_directory(file);
 
         else if (file_stat.is_regular_file())
         {
@@ -303,8 +398,16 @@ Imp<BrokenLinkageFinder>::add_breakage(const FSPath & file, const std::string &
         std::shared_ptr<const PackageIDSequence> pkgs((*env)[selection::AllVersionsUnsorted(
                     generator::All() | filter::InstalledAtRoot(env->preferred_root_key()->parse_value()))]);
 
-        std::for_each(pkgs->begin(), pkgs->end(),
-                std::bind(&Imp<BrokenLinkageFinder>::gather_package, this, _1));
+        PackageIDSequence::ConstIterator p(pkgs->begin()), p_end(pkgs->end());
+        {
+            ThreadPool pool;
+            unsigned n_threads(std::max(1u, std::thread::hardware_concurrency()));
+            for (unsigned n(0) ; n != n_threads ; ++n)
+                pool.create_thread(std::bind(&Imp<BrokenLinkageFinder>::gather_worker, this, std::ref(p), std::cref(p_end)));
+        }
+
+        if (worker_exception)
+            std::rethrow_exception(worker_exception);
     }
 
     FSPath without_root(file.strip_leading(env->preferred_root_key()->parse_value()));
@@ -319,6 +422,33 @@ Imp<BrokenLinkageFinder>::add_breakage(const FSPath & file, const std::string &
         }
 }
 
+void
+Imp<BrokenLinkageFinder>::gather_worker(PackageIDSequence::ConstIterator & p, const PackageIDSequence::ConstIterator & p_end) noexcept
+{
+    while (true)
+    {
+        std::shared_ptr<const PackageID> pkg;
+
+        {
+            std::unique_lock<std::mutex> l(queue_mutex);
+            if (p == p_end || worker_exception)
+                return;
+            pkg = *p++;
+        }
+
+        try
+        {
+            gather_package(pkg);
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> l(queue_mutex);
+            if (! worker_exception)
+                worker_exception = std::current_exception();
+        }
+    }
+}
+
 void
 Imp<BrokenLinkageFinder>::gather_package(const std::shared_ptr<const PackageID> & pkg)
 {
@@ -39,8 +39,20 @@ namespace paludis
         private:
             Pimp<BrokenLinkageFinder> _imp;
 
+            void _search(const std::shared_ptr<const FSPath> &);
+
         public:
             BrokenLinkageFinder(const Environment *, const std::shared_ptr<const Sequence<std::string>> &);
+
+            /**
+             * As above, but remember what we learn about each file in the
+             * specified cache file, so that later runs only need to re-read
+             * files which have changed.
+             *
+             * \since 3.0
+             */
+            BrokenLinkageFinder(const Environment *, const std::shared_ptr<const Sequence<std::string>> &,
+                    const FSPath & cache_file);
             ~BrokenLinkageFinder();
 
             BrokenLinkageFinder(const BrokenLinkageFinder &) = delete;
@@ -228,7 +228,7 @@ CreateOutputManagerForRepositorySyncInfo::deserialise(Deserialisation & d)
 {
     Deserialisator v(d, "CreateOutputManagerForRepositorySyncInfo");
     return std::make_shared<CreateOutputManagerForRepositorySyncInfo>(
-                RepositoryName(v.member<std::string>("repo_name")),
+                RepositoryName(v.member<std::string>("repository_name")),
                 destringify<OutputExclusivity>(v.member<std::string>("output_exclusivity")),
                 v.member<ClientOutputFeatures>("client_output_features")
                 );
@@ -0,0 +1,416 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/distfile_index.hh>
+#include <paludis/package_id.hh>
+#include <paludis/metadata_key.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/spec_tree.hh>
+#include <paludis/choice.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/indirect_iterator-impl.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/thread_pool.hh>
+#include <paludis/util/tokeniser.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/md5.hh>
+#include <paludis/util/log.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace paludis;
+
+namespace
+{
+    const std::string index_magic("paludis-distfile-index-2");
+
+    struct Entry
+    {
+        std::string digest;
+        bool conditional;
+        std::string choices;
+        std::shared_ptr<Set<std::string> > all;
+        std::shared_ptr<Set<std::string> > used;
+
+        Entry() :
+            conditional(false),
+            all(std::make_shared<Set<std::string> >()),
+            used(std::make_shared<Set<std::string> >())
+        {
+        }
+    };
+
+    /* Finds every distfile, and the ones whose conditions are met. */
+    class DistfilesCollector
+    {
+        private:
+            const Environment * const env;
+            const std::shared_ptr<const PackageID> id;
+            Entry & entry;
+            unsigned unmet_depth;
+
+        public:
+            DistfilesCollector(const Environment * const e, const std::shared_ptr<const PackageID> & i, Entry & n) :
+                env(e),
+                id(i),
+                entry(n),
+                unmet_depth(0)
+            {
+            }
+
+            void visit(const FetchableURISpecTree::NodeType<AllDepSpec>::Type & node)
+            {
+                std::for_each(indirect_iterator(node.begin()), indirect_iterator(node.end()), accept_visitor(*this));
+            }
+
+            void visit(const FetchableURISpecTree::NodeType<ConditionalDepSpec>::Type & node)
+            {
+                entry.conditional = true;
+
+                bool met(0 == unmet_depth && node.spec()->condition_met(env, id));
+                if (! met)
+                    ++unmet_depth;
+                std::for_each(indirect_iterator(node.begin()), indirect_iterator(node.end()), accept_visitor(*this));
+                if (! met)
+                    --unmet_depth;
+            }
+
+            void visit(const FetchableURISpecTree::NodeType<FetchableURIDepSpec>::Type & node)
+            {
+                entry.all->insert(node.spec()->filename());
+                if (0 == unmet_depth)
+                    entry.used->insert(node.spec()->filename());
+            }
+
+            void visit(const FetchableURISpecTree::NodeType<URILabelsDepSpec>::Type &)
+            {
+            }
+    };
+
+    std::string digest_of(const std::string & s)
+    {
+        std::istringstream stream(s);
+        return MD5(stream).hexsum();
+    }
+
+    std::string enabled_choices(const std::shared_ptr<const PackageID> & id)
+    {
+        if (! id->choices_key())
+            return "";
+
+        std::vector<std::string> result;
+        auto choices(id->choices_key()->parse_value());
+        for (const auto & choice : *choices)
+            for (const auto & value : *choice)
+                if (value->enabled())
+                    result.push_back(stringify(value->name_with_prefix()));
+
+        return join(result.begin(), result.end(), " ");
+    }
+
+    std::vector<std::string> split_fields(const std::string & line)
+    {
+        std::vector<std::string> result;
+        std::string::size_type p(0);
+        while (true)
+        {
+            std::string::size_type q(line.find('\t', p));
+            result.push_back(line.substr(p, std::string::npos == q ? q : q - p));
+            if (std::string::npos == q)
+                break;
+            p = q + 1;
+        }
+        return result;
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<DistfileIndex>
+    {
+        const Environment * const env;
+        const std::shared_ptr<const FSPath> index_file;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> loaded_entries, current_entries;
+        bool changed;
+
+        Imp(const Environment * const e, const std::shared_ptr<const FSPath> & f) :
+            env(e),
+            index_file(f),
+            changed(false)
+        {
+        }
+
+        void load();
+        Entry entry_for(const std::shared_ptr<const PackageID> &);
+    };
+}
+
+void
+Imp<DistfileIndex>::load()
+{
+    Context context("When loading distfile index '" + stringify(*index_file) + "':");
+
+    if (! index_file->stat().is_regular_file())
+        return;
+
+    try
+    {
+        SafeIFStream stream(*index_file);
+        std::string line;
+        if ((! std::getline(stream, line)) || line != index_magic)
+        {
+            Log::get_instance()->message("distfile_index.bad_magic", ll_warning, lc_context)
+                << "Ignoring distfile index '" << *index_file << "' because it has an unrecognised format";
+            return;
+        }
+
+        /* id \t digest \t conditional \t choices \t all... \t used...,
+         * then end \t count. anything else means the file is damaged, and
+         * we can't tell which entries to trust, so we use none of them. */
+        bool valid(false);
+        while (std::getline(stream, line))
+        {
+            std::vector<std::string> fields(split_fields(line));
+            if (2 == fields.size() && "end" == fields[0])
+            {
+                valid = fields[1] == stringify(loaded_entries.size()) && ! std::getline(stream, line);
+                break;
+            }
+            else if (6 != fields.size())
+                break;
+
+            Entry entry;
+            entry.digest = fields[1];
+            entry.conditional = ("1" == fields[2]);
+            entry.choices = fields[3];
+            tokenise_whitespace(fields[4], entry.all->inserter());
+            tokenise_whitespace(fields[5], entry.used->inserter());
+
+            if (! loaded_entries.insert(std::make_pair(fields[0], entry)).second)
+                break;
+        }
+
+        if (! valid)
+        {
+            Log::get_instance()->message("distfile_index.damaged", ll_warning, lc_context)
+                << "Ignoring distfile index '" << *index_file << "' because it is damaged";
+            loaded_entries.clear();
+        }
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("distfile_index.failure", ll_warning, lc_context)
+            << "Ignoring distfile index '" << *index_file << "': '" << e.message() << "' (" << e.what() << ")";
+        loaded_entries.clear();
+    }
+
+    Log::get_instance()->message("distfile_index.loaded", ll_debug, lc_context)
+        << "Loaded " << loaded_entries.size() << " entries";
+}
+
+Entry
+Imp<DistfileIndex>::entry_for(const std::shared_ptr<const PackageID> & id)
+{
+    if (! id->fetches_key())
+        return Entry();
+
+    std::string key(stringify(*id));
+    auto unparsed(id->fetches_key()->unparsed_value());
+    std::string digest(unparsed ? digest_of(*unparsed) : "");
+
+    if (unparsed)
+    {
+        std::shared_ptr<Entry> candidate;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            auto c(current_entries.find(key));
+            if (current_entries.end() != c && c->second.digest == digest)
+                return c->second;
+
+            auto l(loaded_entries.find(key));
+            if (loaded_entries.end() != l && l->second.digest == digest)
+                candidate = std::make_shared<Entry>(l->second);
+        }
+
+        if (candidate && ((! candidate->conditional) || candidate->choices == enabled_choices(id)))
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            current_entries[key] = *candidate;
+            return *candidate;
+        }
+    }
+
+    Context context("When working out distfiles for '" + stringify(*id) + "':");
+
+    Entry result;
+    result.digest = digest;
+
+    DistfilesCollector collector(env, id, result);
+    id->fetches_key()->parse_value()->top()->accept(collector);
+
+    if (result.conditional)
+        result.choices = enabled_choices(id);
+
+    if (unparsed)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        current_entries[key] = result;
+        changed = true;
+    }
+
+    return result;
+}
+
+DistfileIndex::DistfileIndex(const Environment * const e, const std::shared_ptr<const FSPath> & f) :
+    _imp(e, f)
+{
+    if (_imp->index_file)
+        _imp->load();
+}
+
+DistfileIndex::~DistfileIndex() = default;
+
+const std::shared_ptr<const Set<std::string> >
+DistfileIndex::used_distfiles(const std::shared_ptr<const PackageID> & id)
+{
+    return _imp->entry_for(id).used;
+}
+
+const std::shared_ptr<const Set<std::string> >
+DistfileIndex::all_distfiles(const std::shared_ptr<const PackageID> & id)
+{
+    return _imp->entry_for(id).all;
+}
+
+void
+DistfileIndex::save()
+{
+    if (! _imp->index_file)
+        return;
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if ((! _imp->changed) && _imp->current_entries.size() == _imp->loaded_entries.size())
+        return;
+
+    Context context("When saving distfile index '" + stringify(*_imp->index_file) + "':");
+
+    try
+    {
+        AtomicOFStream stream(*_imp->index_file);
+        stream.stream() << index_magic << std::endl;
+
+        std::size_t count(0);
+        for (const auto & e : _imp->current_entries)
+        {
+            if (std::string::npos != e.first.find_first_of("\t\n"))
+                continue;
+
+            stream.stream() << e.first << "\t" << e.second.digest << "\t" << (e.second.conditional ? "1" : "0") << "\t"
+                << e.second.choices << "\t"
+                << join(e.second.all->begin(), e.second.all->end(), " ") << "\t"
+                << join(e.second.used->begin(), e.second.used->end(), " ") << std::endl;
+            ++count;
+        }
+
+        stream.stream() << "end\t" << count << std::endl;
+        stream.commit();
+        _imp->loaded_entries = _imp->current_entries;
+        _imp->changed = false;
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("distfile_index.failure", ll_warning, lc_context)
+            << "Could not write distfile index '" << *_imp->index_file << "': '" << e.message() << "' (" << e.what() << ")";
+    }
+}
+
+const std::shared_ptr<const FSPathSequence>
+paludis::scan_distdirs(const std::shared_ptr<const FSPathSequence> & dirs)
+{
+    std::vector<FSPath> dirs_vector(dirs->begin(), dirs->end());
+    std::vector<std::vector<FSPath> > found(dirs_vector.size());
+
+    std::atomic<unsigned> next_dir(0);
+    std::mutex exception_mutex;
+    std::exception_ptr worker_exception;
+
+    {
+        ThreadPool pool;
+        unsigned n_threads(std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), dirs_vector.size()));
+        for (unsigned n(0) ; n != n_threads ; ++n)
+            pool.create_thread([&] () noexcept {
+                    while (true)
+                    {
+                        unsigned d(next_dir++);
+                        if (d >= dirs_vector.size())
+                            return;
+
+                        try
+                        {
+                            for (FSIterator f(dirs_vector[d], { fsio_include_dotfiles, fsio_want_regular_files }), f_end ;
+                                    f != f_end ; ++f)
+                                found[d].push_back(*f);
+                        }
+                        catch (...)
+                        {
+                            std::unique_lock<std::mutex> lock(exception_mutex);
+                            if (! worker_exception)
+                                worker_exception = std::current_exception();
+                            next_dir = dirs_vector.size();
+                            return;
+                        }
+                    }
+                    });
+    }
+
+    if (worker_exception)
+        std::rethrow_exception(worker_exception);
+
+    auto result(std::make_shared<FSPathSequence>());
+    for (const auto & d : found)
+        for (const auto & f : d)
+            result->push_back(f);
+
+    return result;
+}
+
+namespace paludis
+{
+    template class Pimp<DistfileIndex>;
+}
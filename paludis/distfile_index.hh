@@ -0,0 +1,113 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_DISTFILE_INDEX_HH
+#define PALUDIS_GUARD_PALUDIS_DISTFILE_INDEX_HH 1
+
+#include <paludis/distfile_index-fwd.hh>
+#include <paludis/environment-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <paludis/util/set-fwd.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <memory>
+#include <string>
+
+/** \file
+ * Declarations for the DistfileIndex class.
+ *
+ * \ingroup g_metadata_key
+ */
+
+namespace paludis
+{
+    /**
+     * Works out which distfiles an ID fetches, optionally remembering the
+     * answers in an index file so that later runs needn't parse the fetches
+     * key of IDs whose value hasn't changed.
+     *
+     * Entries are keyed on a digest of the fetches key's unparsed value, so
+     * anything that changes the metadata (an edited ebuild or eclass, a
+     * regenerated cache, a reinstall) makes the entry stale. If the fetches
+     * key has conditionals, the used distfiles also depend upon the ID's
+     * enabled choices, which are remembered too. IDs whose fetches key can't
+     * give an unparsed value are always parsed. An index file that is
+     * damaged, for example cut short, is ignored entirely.
+     *
+     * \ingroup g_metadata_key
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE DistfileIndex
+    {
+        private:
+            Pimp<DistfileIndex> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            /**
+             * If index_file is null, nothing is remembered between runs.
+             */
+            DistfileIndex(const Environment * const, const std::shared_ptr<const FSPath> & index_file);
+            ~DistfileIndex();
+
+            DistfileIndex(const DistfileIndex &) = delete;
+            DistfileIndex & operator= (const DistfileIndex &) = delete;
+
+            ///\}
+
+            /**
+             * The distfiles an ID fetches with its current choices.
+             */
+            const std::shared_ptr<const Set<std::string> > used_distfiles(
+                    const std::shared_ptr<const PackageID> &) PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Every distfile an ID could fetch, whatever its choices.
+             */
+            const std::shared_ptr<const Set<std::string> > all_distfiles(
+                    const std::shared_ptr<const PackageID> &) PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Write the index file, if we have one and anything has changed.
+             *
+             * Only entries for IDs looked up since we were created are
+             * written, so IDs that have gone away are forgotten. Runs that
+             * look at different sets of IDs should use different files.
+             */
+            void save();
+    };
+
+    /**
+     * Every regular file directly inside any of the specified directories,
+     * in name order for each directory, with the directories read in
+     * parallel.
+     *
+     * \ingroup g_metadata_key
+     * \since 3.0
+     */
+    const std::shared_ptr<const FSPathSequence> scan_distdirs(
+            const std::shared_ptr<const FSPathSequence> &) PALUDIS_VISIBLE PALUDIS_ATTRIBUTE((warn_unused_result));
+
+    extern template class Pimp<DistfileIndex>;
+}
+
+#endif
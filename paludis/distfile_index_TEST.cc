@@ -0,0 +1,186 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/distfile_index.hh>
+#include <paludis/choice.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+
+#include <paludis/util/set.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/tribool.hh>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace paludis;
+
+namespace
+{
+    struct DistfileIndexTest :
+        testing::Test
+    {
+        TestEnvironment env;
+        std::shared_ptr<FakePackageID> id;
+
+        void SetUp() override
+        {
+            std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                            n::environment() = &env,
+                            n::name() = RepositoryName("repo"))));
+            env.add_repository(1, repo);
+
+            id = repo->add_version("cat", "pkg", "1");
+            id->choices_key()->add("", "on");
+            id->choices_key()->add("", "off");
+            env.set_want_choice_enabled(ChoicePrefixName(""), UnprefixedChoiceName("on"), true);
+            env.set_want_choice_enabled(ChoicePrefixName(""), UnprefixedChoiceName("off"), false);
+            id->fetches_key()->set_from_string("http://a/a.tar.gz on? ( http://a/b.tar.gz ) off? ( http://a/c.tar.gz )");
+        }
+
+        std::string str(const std::shared_ptr<const Set<std::string> > & s)
+        {
+            return join(s->begin(), s->end(), " ");
+        }
+    };
+}
+
+TEST_F(DistfileIndexTest, Distfiles)
+{
+    DistfileIndex index(&env, nullptr);
+    EXPECT_EQ("a.tar.gz b.tar.gz", str(index.used_distfiles(id)));
+    EXPECT_EQ("a.tar.gz b.tar.gz c.tar.gz", str(index.all_distfiles(id)));
+
+    env.set_want_choice_enabled(ChoicePrefixName(""), UnprefixedChoiceName("off"), true);
+    DistfileIndex again(&env, nullptr);
+    EXPECT_EQ("a.tar.gz b.tar.gz c.tar.gz", str(again.used_distfiles(id)));
+}
+
+TEST_F(DistfileIndexTest, Persisted)
+{
+    FSPath index_file(FSPath::cwd() / "distfile_index_TEST_dir" / "index");
+
+    {
+        DistfileIndex index(&env, std::make_shared<FSPath>(index_file));
+        EXPECT_EQ("a.tar.gz b.tar.gz", str(index.used_distfiles(id)));
+        index.save();
+    }
+
+    /* doctor the index, so we can tell whether it's used rather than the key */
+    std::string content;
+    {
+        SafeIFStream stream(index_file);
+        content.assign((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        std::string::size_type p;
+        while (std::string::npos != ((p = content.find("b.tar.gz"))))
+            content.replace(p, 8, "cached.tar.gz");
+    }
+    {
+        SafeOFStream stream(index_file, -1, true);
+        stream << content;
+    }
+
+    {
+        DistfileIndex index(&env, std::make_shared<FSPath>(index_file));
+        EXPECT_EQ("a.tar.gz cached.tar.gz", str(index.used_distfiles(id)));
+        EXPECT_EQ("a.tar.gz c.tar.gz cached.tar.gz", str(index.all_distfiles(id)));
+    }
+
+    /* different choices mean the used distfiles need working out again */
+    env.set_want_choice_enabled(ChoicePrefixName(""), UnprefixedChoiceName("off"), true);
+    {
+        DistfileIndex index(&env, std::make_shared<FSPath>(index_file));
+        EXPECT_EQ("a.tar.gz b.tar.gz c.tar.gz", str(index.used_distfiles(id)));
+    }
+    env.set_want_choice_enabled(ChoicePrefixName(""), UnprefixedChoiceName("off"), false);
+
+    /* as does a different value */
+    id->fetches_key()->set_from_string("http://a/a.tar.gz on? ( http://a/d.tar.gz )");
+    {
+        DistfileIndex index(&env, std::make_shared<FSPath>(index_file));
+        EXPECT_EQ("a.tar.gz d.tar.gz", str(index.used_distfiles(id)));
+        index.save();
+    }
+
+    {
+        DistfileIndex index(&env, std::make_shared<FSPath>(index_file));
+        EXPECT_EQ("a.tar.gz d.tar.gz", str(index.all_distfiles(id)));
+    }
+}
+
+TEST_F(DistfileIndexTest, Damaged)
+{
+    FSPath index_file(FSPath::cwd() / "distfile_index_TEST_dir" / "damaged");
+
+    {
+        DistfileIndex index(&env, std::make_shared<FSPath>(index_file));
+        EXPECT_EQ("a.tar.gz b.tar.gz", str(index.used_distfiles(id)));
+        index.save();
+    }
+
+    /* doctor the index as before, but lose its end too, as if it had been
+     * cut short */
+    std::string content;
+    {
+        SafeIFStream stream(index_file);
+        content.assign((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        std::string::size_type p;
+        while (std::string::npos != ((p = content.find("b.tar.gz"))))
+            content.replace(p, 8, "cached.tar.gz");
+        content.erase(content.rfind("end\t"));
+    }
+    {
+        SafeOFStream stream(index_file, -1, true);
+        stream << content;
+    }
+
+    {
+        DistfileIndex index(&env, std::make_shared<FSPath>(index_file));
+        EXPECT_EQ("a.tar.gz b.tar.gz", str(index.used_distfiles(id)));
+    }
+}
+
+TEST(ScanDistdirs, Works)
+{
+    auto dirs(std::make_shared<FSPathSequence>());
+    dirs->push_back(FSPath::cwd() / "distfile_index_TEST_dir" / "two");
+    dirs->push_back(FSPath::cwd() / "distfile_index_TEST_dir" / "one");
+
+    auto files(scan_distdirs(dirs));
+    std::string result;
+    for (const auto & f : *files)
+        result.append((result.empty() ? "" : " ") + f.dirname().basename() + "/" + f.basename());
+
+    EXPECT_EQ("two/.dotfile two/z.tar.gz one/a.tar.gz one/b.tar.gz", result);
+
+    dirs->push_back(FSPath::cwd() / "distfile_index_TEST_dir" / "missing");
+    EXPECT_THROW(auto PALUDIS_ATTRIBUTE((unused)) x(scan_distdirs(dirs)), FSError);
+}
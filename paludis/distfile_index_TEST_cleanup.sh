@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+if [ -d distfile_index_TEST_dir ] ; then
+    rm -fr distfile_index_TEST_dir
+else
+    true
+fi
+
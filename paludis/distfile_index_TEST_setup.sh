@@ -0,0 +1,8 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir distfile_index_TEST_dir || exit 2
+cd distfile_index_TEST_dir || exit 3
+
+mkdir one two one/subdir || exit 4
+touch one/a.tar.gz one/b.tar.gz two/z.tar.gz two/.dotfile || exit 5
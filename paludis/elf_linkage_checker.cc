@@ -20,10 +20,8 @@
 #include "elf_linkage_checker.hh"
 
 #include <paludis/util/elf.hh>
-#include <paludis/util/elf_dynamic_section.hh>
+#include <paludis/util/elf_view.hh>
 #include <paludis/util/elf_types.hh>
-#include <paludis/util/elf_relocation_section.hh>
-#include <paludis/util/elf_symbol_section.hh>
 
 #include <paludis/util/realpath.hh>
 #include <paludis/util/join.hh>
@@ -32,11 +30,16 @@
 #include <paludis/util/set.hh>
 #include <paludis/util/sequence.hh>
 #include <paludis/util/member_iterator-impl.hh>
-#include <paludis/util/visitor_cast.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/fs_path.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/tokeniser.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/destringify.hh>
 
 #include <algorithm>
 #include <cerrno>
@@ -75,16 +78,63 @@ namespace
             return arch;
         }
 
-        template <typename ElfType_>
-        ElfArchitecture(const ElfObject<ElfType_> & elf) :
+        template <template <typename> class Elf_, typename ElfType_>
+        ElfArchitecture(const Elf_<ElfType_> & elf) :
             _machine(normalise_arch(elf.get_arch())),
             _class(ElfType_::elf_class),
             _bigendian(elf.is_big_endian()),
             _mips_n32(EM_MIPS == _machine && MIPS_ABI2 & elf.get_flags())
         {
         }
+
+        ElfArchitecture(unsigned machine, unsigned char cls, bool bigendian, bool mips_n32) :
+            _machine(machine),
+            _class(cls),
+            _bigendian(bigendian),
+            _mips_n32(mips_n32)
+        {
+        }
     };
 
+    /**
+     * Everything we need to know about one file, so that we can skip
+     * re-reading it if it is unchanged next time.
+     */
+    struct ElfFileInfo
+    {
+        std::string stat_key;
+        bool is_elf;
+        bool interesting;
+        bool is_library;
+        ElfArchitecture arch;
+        std::vector<std::string> needed;
+
+        ElfFileInfo(const std::string & k) :
+            stat_key(k),
+            is_elf(false),
+            interesting(false),
+            is_library(false),
+            arch(0, 0, false, false)
+        {
+        }
+    };
+
+    const std::string cache_magic("paludis-elf-linkage-cache-1");
+
+    template <typename ElfType_>
+    void add_needed(ElfView<ElfType_> & elf, std::vector<std::string> & needed)
+    {
+        auto strings(elf.get_dynamic_strings(DT_NEEDED));
+        std::copy(strings->begin(), strings->end(), std::back_inserter(needed));
+    }
+
+    std::string make_stat_key(const FSStat & st)
+    {
+        return stringify(st.lowlevel_id().first) + " " + stringify(st.lowlevel_id().second) + " " +
+            stringify(st.mtim().seconds()) + " " + stringify(st.mtim().nanoseconds()) + " " +
+            stringify(st.file_size());
+    }
+
     bool
     ElfArchitecture::operator< (const ElfArchitecture & other) const
     {
@@ -100,6 +150,7 @@ namespace
 
 typedef std::multimap<FSPath, FSPath, FSPathComparator> Symlinks;
 typedef std::map<ElfArchitecture, std::map<std::string, std::vector<FSPath> > > Needed;
+typedef std::map<std::string, ElfFileInfo> ElfFileInfos;
 
 namespace paludis
 {
@@ -119,12 +170,23 @@ namespace paludis
 
         std::vector<FSPath> extra_lib_dirs;
 
-        template <typename> bool check_elf(const FSPath &, std::istream &);
+        std::shared_ptr<const FSPath> cache_file;
+        ElfFileInfos cached_infos, new_infos;
+
+        template <template <typename> class Elf_, typename ElfType_, typename Source_>
+        bool check_elf(const FSPath &, Source_ &, ElfFileInfo &);
+        void apply_info(const FSPath &, const ElfFileInfo &);
         void handle_library(const FSPath &, const ElfArchitecture &);
-        template <typename> bool check_extra_elf(const FSPath &, std::istream &, std::set<ElfArchitecture> &);
+        template <template <typename> class Elf_, typename ElfType_, typename Source_>
+        bool check_extra_elf(const FSPath &, Source_ &, std::set<ElfArchitecture> &);
 
-        Imp(const FSPath & the_root, const std::shared_ptr<const Sequence<std::string>> & the_libraries) :
-            root(the_root)
+        void load_cache();
+        void save_cache();
+
+        Imp(const FSPath & the_root, const std::shared_ptr<const Sequence<std::string>> & the_libraries,
+                const std::shared_ptr<const FSPath> & the_cache_file) :
+            root(the_root),
+            cache_file(the_cache_file)
         {
             for (const auto & library : *the_libraries)
                 check_libraries.insert(library);
@@ -132,9 +194,12 @@ namespace paludis
     };
 }
 
-ElfLinkageChecker::ElfLinkageChecker(const FSPath & root, const std::shared_ptr<const Sequence<std::string>> & libraries) :
-    _imp(root, libraries)
+ElfLinkageChecker::ElfLinkageChecker(const FSPath & root, const std::shared_ptr<const Sequence<std::string>> & libraries,
+        const std::shared_ptr<const FSPath> & cache_file) :
+    _imp(root, libraries, cache_file)
 {
+    if (_imp->cache_file)
+        _imp->load_cache();
 }
 
 ElfLinkageChecker::~ElfLinkageChecker() = default;
@@ -143,27 +208,55 @@ bool
 ElfLinkageChecker::check_file(const FSPath & file)
 {
     std::string basename(file.basename());
+    FSStat file_stat(file);
     if (! (std::string::npos != basename.find(".so.") ||
            (3 <= basename.length() && ".so" == basename.substr(basename.length() - 3)) ||
-           (0 != (file.stat().permissions() & S_IXUSR))))
+           (0 != (file_stat.permissions() & S_IXUSR))))
         return false;
 
-    SafeIFStream stream(file);
-    return _imp->check_elf<Elf32Type>(file, stream) || _imp->check_elf<Elf64Type>(file, stream);
+    ElfFileInfo info(make_stat_key(file_stat));
+    bool valid(false);
+
+    {
+        std::unique_lock<std::mutex> l(_imp->mutex);
+        auto c(_imp->cached_infos.find(stringify(file)));
+        if (_imp->cached_infos.end() != c && c->second.stat_key == info.stat_key)
+        {
+            info = c->second;
+            valid = true;
+        }
+    }
+
+    if (! valid)
+    {
+        /* read rather than map: a library being rewritten in place by a
+         * concurrent merge would SIGBUS us through a mapping */
+        SafeIFStream stream(file);
+        valid = _imp->check_elf<ElfView, Elf32Type>(file, stream, info) ||
+            _imp->check_elf<ElfView, Elf64Type>(file, stream, info);
+        if (valid && ! info.is_elf)
+            return true;
+    }
+
+    _imp->apply_info(file, info);
+    return info.is_elf;
 }
 
-template <typename ElfType_>
+template <template <typename> class Elf_, typename ElfType_, typename Source_>
 bool
-Imp<ElfLinkageChecker>::check_elf(const FSPath & file, std::istream & stream)
+Imp<ElfLinkageChecker>::check_elf(const FSPath & file, Source_ & source, ElfFileInfo & info)
 {
-    if (! ElfObject<ElfType_>::is_valid_elf(stream))
+    if (! Elf_<ElfType_>::is_valid_elf(source))
         return false;
 
     try
     {
         Context ctx("When checking '" + stringify(file) + "' as a " +
                     stringify<int>(ElfType_::elf_class * 32) + "-bit ELF file:");
-        ElfObject<ElfType_> elf(stream);
+        Elf_<ElfType_> elf(source);
+        info.is_elf = true;
+        info.arch = ElfArchitecture(elf);
+
         if (ET_EXEC != elf.get_type() && ET_DYN != elf.get_type())
         {
             Log::get_instance()->message("broken_linkage_finder.not_interesting", ll_debug, lc_context)
@@ -171,44 +264,135 @@ Imp<ElfLinkageChecker>::check_elf(const FSPath & file, std::istream & stream)
             return true;
         }
 
-        ElfArchitecture arch(elf);
-        elf.resolve_all_strings();
+        info.interesting = true;
+        info.is_library = ET_DYN == elf.get_type();
+        add_needed(elf, info.needed);
+    }
+    catch (const InvalidElfFileError & e)
+    {
+        Log::get_instance()->message("broken_linkage_finder.invalid", ll_warning, lc_no_context)
+            << "'" << file << "' appears to be invalid or corrupted: " << e.message();
+
+        /* don't remember broken files, so we warn about them every time */
+        info.is_elf = false;
+    }
+
+    return true;
+}
+
+void
+Imp<ElfLinkageChecker>::apply_info(const FSPath & file, const ElfFileInfo & info)
+{
+    std::unique_lock<std::mutex> l(mutex);
 
-        std::unique_lock<std::mutex> l(mutex);
+    if (cache_file && info.is_elf)
+        new_infos.insert(std::make_pair(stringify(file), info));
 
-        if (check_libraries.empty() && ET_DYN == elf.get_type())
-            handle_library(file, arch);
+    if (! info.interesting)
+        return;
 
-        for (const auto & section : elf.sections())
+    if (check_libraries.empty() && info.is_library)
+        handle_library(file, info.arch);
+
+    for (const auto & req : info.needed)
+        if (check_libraries.empty() || check_libraries.end() != check_libraries.find(req))
+        {
+            Log::get_instance()->message("broken_linkage_finder.depends", ll_debug, lc_context)
+                << "'" << file << "' depends on " << req;
+            needed[info.arch][req].push_back(file);
+        }
+}
+
+void
+Imp<ElfLinkageChecker>::load_cache()
+{
+    Context context("When loading ELF linkage cache '" + stringify(*cache_file) + "':");
+
+    if (! cache_file->stat().is_regular_file())
+        return;
+
+    try
+    {
+        SafeIFStream stream(*cache_file);
+        std::string line;
+        if ((! std::getline(stream, line)) || line != cache_magic)
         {
-            if (const auto *dyn_sec = visitor_cast<const DynamicSection<ElfType_>>(section))
+            Log::get_instance()->message("broken_linkage_finder.cache.bad_magic", ll_warning, lc_context)
+                << "Ignoring ELF linkage cache '" << *cache_file << "' because it has an unrecognised format";
+            return;
+        }
+
+        /* path \t dev ino mtime_s mtime_ns size \t machine class bigendian mips_n32 interesting library \t needed... */
+        while (std::getline(stream, line))
+        {
+            std::vector<std::string> fields;
+            tokenise<delim_kind::AnyOfTag, delim_mode::DelimiterTag>(line, "\t", "", std::back_inserter(fields));
+            if (fields.size() < 3 || fields.size() > 4)
+                continue;
+
+            std::vector<std::string> arch_fields;
+            tokenise_whitespace(fields[2], std::back_inserter(arch_fields));
+            if (arch_fields.size() != 6)
+                continue;
+
+            ElfFileInfo info(fields[1]);
+            info.is_elf = true;
+            info.arch = ElfArchitecture(destringify<unsigned>(arch_fields[0]), destringify<unsigned>(arch_fields[1]),
+                    destringify<bool>(arch_fields[2]), destringify<bool>(arch_fields[3]));
+            info.interesting = destringify<bool>(arch_fields[4]);
+            info.is_library = destringify<bool>(arch_fields[5]);
+            if (4 == fields.size())
+                tokenise_whitespace(fields[3], std::back_inserter(info.needed));
+
+            cached_infos.insert(std::make_pair(fields[0], info));
+        }
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("broken_linkage_finder.cache.failure", ll_warning, lc_context)
+            << "Ignoring ELF linkage cache '" << *cache_file << "': '" << e.message() << "' (" << e.what() << ")";
+        cached_infos.clear();
+    }
+
+    Log::get_instance()->message("broken_linkage_finder.cache.loaded", ll_debug, lc_context)
+        << "Loaded " << cached_infos.size() << " cached entries";
+}
+
+void
+Imp<ElfLinkageChecker>::save_cache()
+{
+    Context context("When saving ELF linkage cache '" + stringify(*cache_file) + "':");
+
+    FSPath tmp_file(cache_file->dirname() / (cache_file->basename() + ".tmp"));
+
+    try
+    {
+        {
+            SafeOFStream stream(tmp_file, -1, true);
+            stream << cache_magic << std::endl;
+
+            for (const auto & i : new_infos)
             {
-                for (const auto & entry : dyn_sec->entries())
-                {
-                    if (const auto *ent_str = visitor_cast<const DynamicEntryString<ElfType_>>(entry))
-                    {
-                        if (ent_str->tag_name() != "NEEDED")
-                            continue;
-
-                        const std::string & req((*ent_str)());
-                        if (check_libraries.empty() || check_libraries.end() != check_libraries.find(req))
-                        {
-                            Log::get_instance()->message("broken_linkage_finder.depends", ll_debug, lc_context)
-                                << "File depends on " << req;
-                            needed[arch][req].push_back(file);
-                        }
-                    }
-                }
+                if (std::string::npos != i.first.find_first_of("\t\n"))
+                    continue;
+
+                stream << i.first << "\t" << i.second.stat_key << "\t"
+                    << i.second.arch._machine << " " << unsigned(i.second.arch._class) << " "
+                    << stringify(i.second.arch._bigendian) << " " << stringify(i.second.arch._mips_n32) << " "
+                    << stringify(i.second.interesting) << " " << stringify(i.second.is_library);
+                if (! i.second.needed.empty())
+                    stream << "\t" << join(i.second.needed.begin(), i.second.needed.end(), " ");
+                stream << std::endl;
             }
         }
+
+        tmp_file.rename(*cache_file);
     }
-    catch (const InvalidElfFileError & e)
+    catch (const Exception & e)
     {
-        Log::get_instance()->message("broken_linkage_finder.invalid", ll_warning, lc_no_context)
-            << "'" << file << "' appears to be invalid or corrupted: " << e.message();
+        Log::get_instance()->message("broken_linkage_finder.cache.failure", ll_warning, lc_context)
+            << "Could not write ELF linkage cache '" << *cache_file << "': '" << e.message() << "' (" << e.what() << ")";
     }
-
-    return true;
 }
 
 void
@@ -306,9 +490,10 @@ ElfLinkageChecker::need_breakage_added(
             try
             {
                 SafeIFStream stream(file);
+                bool is_elf(_imp->check_extra_elf<ElfView, Elf32Type>(file, stream, missing.second) ||
+                        _imp->check_extra_elf<ElfView, Elf64Type>(file, stream, missing.second));
 
-                if (! (_imp->check_extra_elf<Elf32Type>(file, stream, missing.second) ||
-                       _imp->check_extra_elf<Elf64Type>(file, stream, missing.second)))
+                if (! is_elf)
                     Log::get_instance()->message("broken_linkage_finder.not_an_elf", ll_debug, lc_no_context)
                         << "'" << file << "' is not an ELF file";
             }
@@ -321,6 +506,9 @@ ElfLinkageChecker::need_breakage_added(
         }
     }
 
+    if (_imp->cache_file)
+        _imp->save_cache();
+
     for (const auto & missing : all_missing)
         for (const auto & arch : missing.second)
             std::for_each(_imp->needed[arch][missing.first].begin(),
@@ -329,18 +517,18 @@ ElfLinkageChecker::need_breakage_added(
 
 }
 
-template <typename ElfType_>
+template <template <typename> class Elf_, typename ElfType_, typename Source_>
 bool
-Imp<ElfLinkageChecker>::check_extra_elf(const FSPath & file, std::istream & stream, std::set<ElfArchitecture> & arches)
+Imp<ElfLinkageChecker>::check_extra_elf(const FSPath & file, Source_ & source, std::set<ElfArchitecture> & arches)
 {
-    if (! ElfObject<ElfType_>::is_valid_elf(stream))
+    if (! Elf_<ElfType_>::is_valid_elf(source))
         return false;
 
     Context ctx("When checking '" + stringify(file) + "' as a " + stringify<int>(ElfType_::elf_class * 32) + "-bit ELF file");
 
     try
     {
-        ElfObject<ElfType_> elf(stream);
+        Elf_<ElfType_> elf(source);
         if (ET_DYN == elf.get_type())
         {
             Log::get_instance()->message("broken_linkage_finder.is_library", ll_debug, lc_context)
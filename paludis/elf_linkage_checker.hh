@@ -34,7 +34,13 @@ namespace paludis
             Pimp<ElfLinkageChecker> _imp;
 
         public:
-            ElfLinkageChecker(const FSPath &, const std::shared_ptr<const Sequence<std::string>> &);
+            /**
+             * If the cache file is not null, information about each ELF
+             * file is remembered there, keyed by device, inode, mtime and
+             * size, and unchanged files are not re-read next time.
+             */
+            ElfLinkageChecker(const FSPath &, const std::shared_ptr<const Sequence<std::string>> &,
+                    const std::shared_ptr<const FSPath> &);
             virtual ~ElfLinkageChecker();
 
             virtual bool check_file(const FSPath &) PALUDIS_ATTRIBUTE((warn_unused_result));
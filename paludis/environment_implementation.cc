@@ -44,12 +44,16 @@
 #include <paludis/util/join.hh>
 #include <paludis/util/sequence-impl.hh>
 #include <paludis/util/set-impl.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/repository_name_cache.hh>
 
 #include <algorithm>
 #include <mutex>
 #include <map>
 #include <list>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 #include "config.h"
 
@@ -132,13 +136,92 @@ namespace paludis
         mutable std::shared_ptr<SetNameSet> set_names;
         mutable SetsStore sets;
 
+        typedef std::pair<std::shared_ptr<const RepositoryNameCache>, std::shared_ptr<const QualifiedPackageNameSet> > NamesIndexSource;
+
+        mutable std::mutex names_index_mutex;
+        mutable std::vector<NamesIndexSource> names_index_sources;
+        mutable std::unordered_map<PackageNamePart, std::vector<std::pair<unsigned, CategoryNamePart> >, Hash<PackageNamePart> > names_index;
+
         Imp() :
             loaded_sets(false)
         {
         }
+
+        std::shared_ptr<const QualifiedPackageNameSet> qualified_names_for(const PackageNamePart &) const;
     };
 }
 
+std::shared_ptr<const QualifiedPackageNameSet>
+Imp<EnvironmentImplementation>::qualified_names_for(const PackageNamePart & p) const
+{
+    /* The main tables of every names cache go into one combined index, so a
+     * lookup is a single hash probe however many repositories there are.
+     * A table only changes when its journal is folded back into it, so
+     * merging a package doesn't mean rebuilding the index; instead, each
+     * cache's journal is applied to what the index finds. */
+    std::vector<NamesIndexSource> sources;
+    std::vector<std::shared_ptr<const Repository> > cached;
+    std::list<std::shared_ptr<const Repository> > uncached;
+    for (const auto & repository : repositories)
+    {
+        auto cache(repository->names_cache());
+        auto table(cache ? cache->table_names() : nullptr);
+        if (table)
+        {
+            sources.push_back(std::make_pair(cache, table));
+            cached.push_back(repository);
+        }
+        else
+            uncached.push_back(repository);
+    }
+
+    std::vector<CategoryNamePartSet> found(sources.size());
+
+    {
+        std::unique_lock<std::mutex> lock(names_index_mutex);
+
+        if (sources != names_index_sources)
+        {
+            Context context("When building combined names index:");
+
+            names_index.clear();
+            for (unsigned n(0) ; n < sources.size() ; ++n)
+                for (const auto & q : *sources[n].second)
+                    names_index[q.package()].push_back(std::make_pair(n, q.category()));
+            names_index_sources = sources;
+        }
+
+        auto i(names_index.find(p));
+        if (names_index.end() != i)
+            for (const auto & c : i->second)
+                found[c.first].insert(c.second);
+    }
+
+    auto result(std::make_shared<QualifiedPackageNameSet>());
+    for (unsigned n(0) ; n < sources.size() ; ++n)
+    {
+        if (! sources[n].first->apply_journal(sources[n].second, p, found[n]))
+        {
+            /* its journal was folded in since we looked, so the index is
+             * stale for this one until the next lookup rebuilds it */
+            uncached.push_back(cached[n]);
+            continue;
+        }
+
+        for (const auto & c : found[n])
+            result->insert(c + p);
+    }
+
+    for (const auto & repository : uncached)
+    {
+        auto cats(repository->category_names_containing_package(p, { }));
+        for (const auto & c : *cats)
+            result->insert(c + p);
+    }
+
+    return result;
+}
+
 EnvironmentImplementation::EnvironmentImplementation() :
     _imp()
 {
@@ -528,8 +611,13 @@ EnvironmentImplementation::fetch_unique_qualified_package_name(const PackageName
     std::shared_ptr<QPNIMap> result(new QPNIMap);
     std::set<std::pair<CategoryNamePart, RepositoryName>, CategoryRepositoryNamePairComparator> checked;
 
-    std::shared_ptr<const PackageIDSequence> pkgs((*this)[selection::AllVersionsUnsorted(
-                generator::Matches(make_package_dep_spec({ }).package_name_part(p), nullptr, { }) | f)]);
+    auto pkgs(std::make_shared<PackageIDSequence>());
+    auto qualified_names(_imp->qualified_names_for(p));
+    for (const auto & candidate : *qualified_names)
+    {
+        auto ids((*this)[selection::AllVersionsUnsorted(generator::Package(candidate) | f)]);
+        std::copy(ids->begin(), ids->end(), pkgs->back_inserter());
+    }
 
     for (IndirectIterator<PackageIDSequence::ConstIterator> it(pkgs->begin()),
              it_end(pkgs->end()); it_end != it; ++it)
@@ -181,3 +181,28 @@ TEST(EnvironmentImplementation, Disambiguation)
     EXPECT_THROW(e.fetch_unique_qualified_package_name(PackageNamePart("pkg-foo"), filter::All(), false), AmbiguousPackageNameError);
 }
 
+
+TEST(EnvironmentImplementation, DisambiguationNoticesNewNames)
+{
+    TestEnvironment e;
+
+    std::shared_ptr<FakeRepository> r1(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &e,
+                    n::name() = RepositoryName("repo1"))));
+    r1->add_version(CategoryNamePart("cat-one") + PackageNamePart("pkg-one"), VersionSpec("0", { }));
+    e.add_repository(10, r1);
+
+    EXPECT_EQ("cat-one/pkg-one", stringify(e.fetch_unique_qualified_package_name(PackageNamePart("pkg-one"))));
+    EXPECT_THROW(e.fetch_unique_qualified_package_name(PackageNamePart("pkg-two")), NoSuchPackageError);
+
+    r1->add_version(CategoryNamePart("cat-two") + PackageNamePart("pkg-two"), VersionSpec("0", { }));
+    EXPECT_EQ("cat-two/pkg-two", stringify(e.fetch_unique_qualified_package_name(PackageNamePart("pkg-two"))));
+
+    std::shared_ptr<FakeRepository> r2(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &e,
+                    n::name() = RepositoryName("repo2"))));
+    r2->add_version(CategoryNamePart("cat-three") + PackageNamePart("pkg-one"), VersionSpec("0", { }));
+    e.add_repository(10, r2);
+
+    EXPECT_THROW(e.fetch_unique_qualified_package_name(PackageNamePart("pkg-one"), filter::All(), false), AmbiguousPackageNameError);
+}
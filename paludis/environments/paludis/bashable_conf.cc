@@ -18,6 +18,7 @@
  */
 
 #include <paludis/environments/paludis/bashable_conf.hh>
+#include <paludis/environments/paludis/config_snapshot.hh>
 
 #include <paludis/util/config_file.hh>
 #include <paludis/util/is_file_with_extension.hh>
@@ -32,6 +33,7 @@
 #include <paludis/util/env_var_names.hh>
 
 #include <functional>
+#include <sstream>
 
 using namespace paludis;
 using namespace paludis::paludis_environment;
@@ -47,6 +49,50 @@ std::string defined_vars_to_kv_func(
     return "";
 }
 
+int
+paludis::paludis_environment::run_bash_conf(const FSPath & f,
+        const std::shared_ptr<const Map<std::string, std::string> > & predefined_variables,
+        std::string & output)
+{
+    const std::string log_level(stringify(Log::get_instance()->log_level()));
+    const std::string ebuild_dir(getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis"));
+
+    std::string key, stamp;
+    if (ConfigSnapshot::get_instance()->bash_conf_is_pure())
+    {
+        stamp = file_stamp(f);
+        if (! stamp.empty())
+        {
+            key = "bash\t" + stringify(f);
+            stamp += "\t" + log_level + "\t" + ebuild_dir;
+            if (predefined_variables)
+                for (const auto & v : *predefined_variables)
+                    stamp += "\t" + v.first + "=" + v.second;
+
+            if (ConfigSnapshot::get_instance()->find(key, stamp, output))
+                return 0;
+        }
+    }
+
+    std::stringstream s;
+    Process process(ProcessCommand({ "bash", stringify(f) }));
+    process
+        .setenv("PALUDIS_LOG_LEVEL", log_level)
+        .setenv("PALUDIS_EBUILD_DIR", ebuild_dir)
+        .prefix_stderr(f.basename() + "> ")
+        .capture_stdout(s);
+    if (predefined_variables)
+        for (const auto & v : *predefined_variables)
+            process.setenv(v.first, v.second);
+    int exit_status(process.run().wait());
+    output = s.str();
+
+    if (0 == exit_status && ! key.empty())
+        ConfigSnapshot::get_instance()->store(key, stamp, output);
+
+    return exit_status;
+}
+
 std::shared_ptr<LineConfigFile>
 paludis::paludis_environment::make_bashable_conf(const FSPath & f, const LineConfigFileOptions & o)
 {
@@ -56,15 +102,9 @@ paludis::paludis_environment::make_bashable_conf(const FSPath & f, const LineCon
 
     if (is_file_with_extension(f, ".bash", { }))
     {
-        std::stringstream s;
-
-        Process process(ProcessCommand({ "bash", stringify(f) }));
-        process
-            .setenv("PALUDIS_LOG_LEVEL", stringify(Log::get_instance()->log_level()))
-            .setenv("PALUDIS_EBUILD_DIR", getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis"))
-            .prefix_stderr(f.basename() + "> ")
-            .capture_stdout(s);
-        int exit_status(process.run().wait());
+        std::string output;
+        int exit_status(run_bash_conf(f, nullptr, output));
+        std::istringstream s(output);
         result = std::make_shared<LineConfigFile>(s, o);
 
         if (exit_status != 0)
@@ -91,17 +131,9 @@ paludis::paludis_environment::make_bashable_kv_conf(const FSPath & f,
 
     if (is_file_with_extension(f, ".bash", { }))
     {
-        std::stringstream s;
-        Process process(ProcessCommand({ "bash", stringify(f) }));
-        process
-            .setenv("PALUDIS_LOG_LEVEL", stringify(Log::get_instance()->log_level()))
-            .setenv("PALUDIS_EBUILD_DIR", getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis"))
-            .prefix_stderr(f.basename() + "> ")
-            .capture_stdout(s);
-        for (Map<std::string, std::string>::ConstIterator i(predefined_variables->begin()),
-                end(predefined_variables->end()); i != end; ++i)
-            process.setenv(i->first, i->second);
-        int exit_status(process.run().wait());
+        std::string output;
+        int exit_status(run_bash_conf(f, predefined_variables, output));
+        std::istringstream s(output);
         result = std::make_shared<KeyValueConfigFile>(s, o, &KeyValueConfigFile::no_defaults, &KeyValueConfigFile::no_transformation);
 
         if (exit_status != 0)
@@ -120,4 +152,3 @@ paludis::paludis_environment::make_bashable_kv_conf(const FSPath & f,
 
     return result;
 }
-
@@ -30,6 +30,16 @@ namespace paludis
 {
     namespace paludis_environment
     {
+        /**
+         * Run a .bash configuration file, passing it any predefined variables,
+         * and return its exit status. Output may come from the ConfigSnapshot
+         * rather than from actually running the script.
+         */
+        int run_bash_conf(
+                const FSPath &,
+                const std::shared_ptr<const Map<std::string, std::string> > &,
+                std::string & output);
+
         std::shared_ptr<LineConfigFile> make_bashable_conf(
                 const FSPath &,
                 const LineConfigFileOptions &);
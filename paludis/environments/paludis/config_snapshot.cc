@@ -0,0 +1,229 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/environments/paludis/config_snapshot.hh>
+
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/singleton-impl.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_error.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/env_var_names.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/timestamp.hh>
+
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <sys/stat.h>
+
+using namespace paludis;
+using namespace paludis::paludis_environment;
+
+namespace
+{
+    static const std::string snapshot_magic("paludis-config-snapshot-1");
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<ConfigSnapshot>
+    {
+        typedef std::map<std::string, std::pair<std::string, std::string> > Entries;
+
+        mutable std::mutex mutex;
+        std::string file;
+        bool bash_conf_is_pure;
+        Entries entries;
+        bool dirty;
+
+        Imp() :
+            bash_conf_is_pure(false),
+            dirty(false)
+        {
+        }
+
+        void load_file();
+    };
+}
+
+void
+Imp<ConfigSnapshot>::load_file()
+{
+    Context context("When loading config snapshot '" + file + "':");
+
+    FSPath f(file);
+    if (! f.stat().is_regular_file())
+        return;
+
+    try
+    {
+        SafeIFStream stream(f);
+        std::string line;
+        if ((! std::getline(stream, line)) || line != snapshot_magic)
+        {
+            Log::get_instance()->message("paludis_environment.config_snapshot.bad_magic", ll_warning, lc_context)
+                << "Ignoring config snapshot '" << file << "' because it has an unrecognised format";
+            return;
+        }
+
+        /* key_length stamp_length result_length \n key stamp result */
+        while (std::getline(stream, line))
+        {
+            std::istringstream lengths(line);
+            std::string::size_type k, s, r;
+            std::string data;
+            if (lengths >> k >> s >> r)
+                data.resize(k + s + r);
+
+            if (data.empty() || ! stream.read(&data[0], data.length()))
+            {
+                Log::get_instance()->message("paludis_environment.config_snapshot.corrupt", ll_warning, lc_context)
+                    << "Ignoring config snapshot '" << file << "' because it is corrupt";
+                entries.clear();
+                return;
+            }
+
+            entries[data.substr(0, k)] = std::make_pair(data.substr(k, s), data.substr(k + s));
+        }
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("paludis_environment.config_snapshot.failure", ll_warning, lc_context)
+            << "Ignoring config snapshot '" << file << "': '" << e.message() << "' (" << e.what() << ")";
+        entries.clear();
+    }
+}
+
+ConfigSnapshot::ConfigSnapshot() :
+    _imp()
+{
+}
+
+ConfigSnapshot::~ConfigSnapshot() = default;
+
+void
+ConfigSnapshot::load()
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    std::string file(getenv_with_default(env_vars::config_snapshot, ""));
+    _imp->bash_conf_is_pure = ! getenv_with_default(env_vars::bash_conf_is_pure, "").empty();
+
+    if (file == _imp->file)
+        return;
+
+    _imp->file = file;
+    _imp->entries.clear();
+    _imp->dirty = false;
+
+    if (! _imp->file.empty())
+        _imp->load_file();
+}
+
+bool
+ConfigSnapshot::enabled() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    return ! _imp->file.empty();
+}
+
+bool
+ConfigSnapshot::bash_conf_is_pure() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    return (! _imp->file.empty()) && _imp->bash_conf_is_pure;
+}
+
+bool
+ConfigSnapshot::find(const std::string & key, const std::string & stamp, std::string & result) const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    auto e(_imp->entries.find(key));
+    if (_imp->entries.end() == e || e->second.first != stamp)
+        return false;
+
+    result = e->second.second;
+    return true;
+}
+
+void
+ConfigSnapshot::store(const std::string & key, const std::string & stamp, const std::string & result)
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (_imp->file.empty())
+        return;
+
+    _imp->entries[key] = std::make_pair(stamp, result);
+    _imp->dirty = true;
+}
+
+void
+ConfigSnapshot::save()
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (_imp->file.empty() || ! _imp->dirty)
+        return;
+    _imp->dirty = false;
+
+    Context context("When saving config snapshot '" + _imp->file + "':");
+
+    try
+    {
+        AtomicOFStream stream(FSPath(_imp->file));
+        stream.stream() << snapshot_magic << std::endl;
+
+        for (const auto & e : _imp->entries)
+            stream.stream() << e.first.length() << " " << e.second.first.length() << " " << e.second.second.length() << "\n"
+                << e.first << e.second.first << e.second.second;
+
+        stream.commit();
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("paludis_environment.config_snapshot.failure", ll_debug, lc_context)
+            << "Could not write config snapshot '" << _imp->file << "': '" << e.message() << "' (" << e.what() << ")";
+    }
+}
+
+std::string
+paludis::paludis_environment::file_stamp(const FSPath & f)
+{
+    /* FSStat uses lstat, but a symlinked config file changes when its
+     * target does */
+    struct stat st;
+    if (0 != ::stat(stringify(f).c_str(), &st) || ! S_ISREG(st.st_mode))
+        return "";
+    return stringify(st.st_mtim.tv_sec) + " " + stringify(st.st_mtim.tv_nsec) + " " + stringify(st.st_size)
+        + " " + stringify(st.st_ino);
+}
+
+namespace paludis
+{
+    template class Pimp<ConfigSnapshot>;
+    template class Singleton<ConfigSnapshot>;
+}
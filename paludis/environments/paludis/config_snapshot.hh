@@ -0,0 +1,104 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_ENVIRONMENTS_PALUDIS_CONFIG_SNAPSHOT_HH
+#define PALUDIS_GUARD_PALUDIS_ENVIRONMENTS_PALUDIS_CONFIG_SNAPSHOT_HH 1
+
+#include <paludis/util/fs_path-fwd.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/singleton.hh>
+#include <string>
+
+namespace paludis
+{
+    namespace paludis_environment
+    {
+        /**
+         * Remembers the results of the processes we start when loading
+         * configuration, so that short commands don't have to start them
+         * again on every run.
+         *
+         * Nothing is remembered unless PALUDIS_CONFIG_SNAPSHOT names a file.
+         * Each entry is stored along with a stamp describing everything its
+         * result depends upon, and is only used if the stamp still matches.
+         * The output of .bash configuration files is only remembered if
+         * PALUDIS_BASH_CONF_IS_PURE is also set, since we can't tell what
+         * else a script might look at.
+         *
+         * \since 3.0
+         */
+        class ConfigSnapshot :
+            public Singleton<ConfigSnapshot>
+        {
+            friend class Singleton<ConfigSnapshot>;
+
+            private:
+                Pimp<ConfigSnapshot> _imp;
+
+                ConfigSnapshot();
+                ~ConfigSnapshot();
+
+            public:
+                /**
+                 * Start using whichever snapshot file the environment says
+                 * to, forgetting anything remembered for a different one.
+                 */
+                void load();
+
+                /**
+                 * Are we remembering anything at all?
+                 */
+                bool enabled() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * May we remember what .bash configuration files output?
+                 */
+                bool bash_conf_is_pure() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Look up a remembered result, if its stamp matches.
+                 */
+                bool find(const std::string & key, const std::string & stamp, std::string & result) const;
+
+                /**
+                 * Remember a result.
+                 */
+                void store(const std::string & key, const std::string & stamp, const std::string & result);
+
+                /**
+                 * Write out the snapshot, if anything has changed.
+                 */
+                void save();
+        };
+
+        /**
+         * A stamp for a file, based upon its mtime, size and inode, or an
+         * empty string if it isn't a regular file. Symlinks are followed.
+         *
+         * \since 3.0
+         */
+        std::string file_stamp(const FSPath &) PALUDIS_ATTRIBUTE((warn_unused_result));
+    }
+
+    extern template class Pimp<paludis_environment::ConfigSnapshot>;
+    extern template class Singleton<paludis_environment::ConfigSnapshot>;
+}
+
+#endif
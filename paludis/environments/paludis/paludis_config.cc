@@ -28,6 +28,8 @@
 #include <paludis/environments/paludis/world.hh>
 #include <paludis/environments/paludis/extra_distribution_data.hh>
 #include <paludis/environments/paludis/suggestions_conf.hh>
+#include <paludis/environments/paludis/bashable_conf.hh>
+#include <paludis/environments/paludis/config_snapshot.hh>
 
 #include <paludis/util/config_file.hh>
 #include <paludis/util/destringify.hh>
@@ -49,6 +51,7 @@
 #include <paludis/util/process.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/timestamp.hh>
 #include <paludis/util/fs_error.hh>
 #include <paludis/util/env_var_names.hh>
 #include <paludis/util/options.hh>
@@ -255,14 +258,9 @@ namespace paludis
         }
         else if ((FSPath(config_dir) / "general.bash").stat().exists())
         {
-            std::stringstream s;
-            Process process(ProcessCommand({ "bash", stringify(FSPath(config_dir) / "general.bash") }));
-            process
-                .setenv("PALUDIS_LOG_LEVEL", stringify(Log::get_instance()->log_level()))
-                .setenv("PALUDIS_EBUILD_DIR", getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis"))
-                .prefix_stderr("general.bash> ")
-                .capture_stdout(s);
-            int exit_status(process.run().wait());
+            std::string output;
+            int exit_status(run_bash_conf(FSPath(config_dir) / "general.bash", nullptr, output));
+            std::istringstream s(output);
             kv = std::make_shared<KeyValueConfigFile>(
                 s,
                 KeyValueConfigFileOptions() + kvcfo_allow_env,
@@ -295,14 +293,9 @@ namespace paludis
                 << "The file '" << (FSPath(config_dir) / "environment.bash") << "' should be renamed to '"
                 << (FSPath(config_dir) / "general.bash") << "'.";
 
-            std::stringstream s;
-            Process process(ProcessCommand({ "bash", stringify(FSPath(config_dir) / "environment.bash") }));
-            process
-                .setenv("PALUDIS_LOG_LEVEL", stringify(Log::get_instance()->log_level()))
-                .setenv("PALUDIS_EBUILD_DIR", getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis"))
-                .prefix_stderr("general.bash> ")
-                .capture_stdout(s);
-            int exit_status(process.run().wait());
+            std::string output;
+            int exit_status(run_bash_conf(FSPath(config_dir) / "environment.bash", nullptr, output));
+            std::istringstream s(output);
             kv = std::make_shared<KeyValueConfigFile>(
                 s,
                 KeyValueConfigFileOptions() + kvcfo_allow_env,
@@ -378,6 +371,8 @@ PaludisConfig::PaludisConfig(PaludisEnvironment * const e, const std::string & s
 
     Context context("When loading paludis configuration:");
 
+    ConfigSnapshot::get_instance()->load();
+
     /* indirection */
     std::string local_config_suffix;
 
@@ -475,10 +470,35 @@ PaludisConfig::PaludisConfig(PaludisEnvironment * const e, const std::string & s
 
     /* check that we can safely use userpriv */
     {
-        Process process(ProcessCommand({ "sh", "-c", "ls -ld '" + stringify(_imp->local_config_dir) + "'/* >/dev/null 2>/dev/null" }));
-        process
-            .setuid_setgid(reduced_uid(), reduced_gid());
-        if (0 != process.run().wait())
+        /* the answer only depends upon who we are checking as, and the
+         * directories and user databases involved */
+        std::string key("userpriv\t" + stringify(_imp->local_config_dir));
+        std::string stamp(stringify(reduced_uid()) + " " + stringify(reduced_gid()));
+        for (FSPath d(_imp->local_config_dir) ; ; )
+        {
+            FSStat d_stat(d);
+            stamp += "\t" + (d_stat.exists() ? stringify(d_stat.permissions()) + " " + stringify(d_stat.owner()) + " " +
+                    stringify(d_stat.group()) : "");
+            if (d == _imp->local_config_dir && d_stat.exists())
+                stamp += " " + stringify(d_stat.mtim().seconds()) + " " + stringify(d_stat.mtim().nanoseconds());
+            FSPath parent(d.dirname());
+            if (parent == d || stringify(d) == "/")
+                break;
+            d = parent;
+        }
+        stamp += "\t" + file_stamp(FSPath("/etc/passwd")) + "\t" + file_stamp(FSPath("/etc/group"));
+
+        std::string accessible;
+        if (! ConfigSnapshot::get_instance()->find(key, stamp, accessible))
+        {
+            Process process(ProcessCommand({ "sh", "-c", "ls -ld '" + stringify(_imp->local_config_dir) + "'/* >/dev/null 2>/dev/null" }));
+            process
+                .setuid_setgid(reduced_uid(), reduced_gid());
+            accessible = 0 == process.run().wait() ? "yes" : "no";
+            ConfigSnapshot::get_instance()->store(key, stamp, accessible);
+        }
+
+        if (accessible != "yes")
         {
             Log::get_instance()->message("paludis_environment.userpriv.disabled", ll_warning, lc_context)
                 << "Cannot access configuration directory '" << _imp->local_config_dir
@@ -845,8 +865,9 @@ PaludisConfig::PaludisConfig(PaludisEnvironment * const e, const std::string & s
         }
     }
 
-
     _imp->bashrc_files->push_back(_imp->local_config_dir / dist->bashrc_filename());
+
+    ConfigSnapshot::get_instance()->save();
 }
 
 PaludisConfig::~PaludisConfig() = default;
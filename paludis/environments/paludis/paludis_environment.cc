@@ -213,6 +213,7 @@ PaludisEnvironment::perform_hook(
         for (std::list<std::pair<FSPath, bool> >::const_iterator h(_imp->hook_dirs.begin()),
                 h_end(_imp->hook_dirs.end()) ; h != h_end ; ++h)
             _imp->hooker->add_dir(h->first, h->second);
+        _imp->hooker->set_manifest_file(FSPath(_imp->config->system_root()) / "var" / "cache" / "paludis" / "hook_manifest");
     }
 
     return _imp->hooker->perform_hook(hook, optional_output_manager);
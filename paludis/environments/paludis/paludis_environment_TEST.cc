@@ -26,6 +26,9 @@
 #include <paludis/util/options.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/join.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/safe_ifstream.hh>
 
 #include <paludis/package_id.hh>
 #include <paludis/user_dep_spec.hh>
@@ -36,7 +39,10 @@
 #include <paludis/metadata_key.hh>
 #include <paludis/choice.hh>
 
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
+#include <fstream>
 #include <gtest/gtest.h>
 
 using namespace paludis;
@@ -178,3 +184,44 @@ TEST(PaludisEnvironment, Repositories)
     EXPECT_TRUE(env->more_important_than(RepositoryName("second"), RepositoryName("fifth")));
 }
 
+namespace
+{
+    int count_lines(const FSPath & f)
+    {
+        if (! f.stat().exists())
+            return 0;
+
+        SafeIFStream s(f);
+        return std::count(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>(), '\n');
+    }
+}
+
+TEST(PaludisEnvironment, ConfigSnapshot)
+{
+    FSPath home(FSPath::cwd() / "paludis_environment_TEST_dir" / "home6");
+    setenv("PALUDIS_HOME", stringify(home).c_str(), 1);
+    setenv("PALUDIS_CONFIG_SNAPSHOT", stringify(home / "snapshot").c_str(), 1);
+    setenv("PALUDIS_BASH_CONF_IS_PURE", "yes", 1);
+    unsetenv("PALUDIS_SKIP_CONFIG");
+
+    for (int n(0) ; n < 3 ; ++n)
+    {
+        if (2 == n)
+        {
+            std::ofstream script(stringify(home / ".paludis" / "use.bash"), std::ios::app);
+            script << "echo '*/* quoted-name'" << std::endl;
+        }
+
+        std::shared_ptr<Environment> env(std::make_shared<PaludisEnvironment>(""));
+        const std::shared_ptr<const PackageID> one(*(*env)[selection::RequireExactlyOne(
+                    generator::Matches(PackageDepSpec(parse_user_package_dep_spec("=cat-one/pkg-one-1",
+                                env.get(), { })), nullptr, { }))]->begin());
+
+        EXPECT_TRUE(get_use("foofoo", one));
+        EXPECT_EQ(2 == n, get_use("quoted-name", one));
+        EXPECT_EQ(2 == n ? 2 : 1, count_lines(home / "use.bash.runs"));
+    }
+
+    unsetenv("PALUDIS_CONFIG_SNAPSHOT");
+    unsetenv("PALUDIS_BASH_CONF_IS_PURE");
+}
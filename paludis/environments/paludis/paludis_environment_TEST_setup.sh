@@ -228,3 +228,22 @@ profiles = `pwd`/sixthrepo/profile
 cache = /var/empty
 END
 
+mkdir -p home6/.paludis/repositories
+cat <<END > home6/.paludis/use.bash
+echo run >> `pwd`/home6/use.bash.runs
+echo '*/* foofoo'
+END
+cat <<END > home6/.paludis/keywords.conf
+*/* keyword
+END
+cat <<END > home6/.paludis/licenses.conf
+*/* *
+END
+cat <<END > home6/.paludis/repositories/foo.conf
+format = e
+names_cache = /var/empty
+location = `pwd`/repo
+profiles = `pwd`/repo/profile
+cache = /var/empty
+END
+
@@ -31,6 +31,7 @@ add(`dep_spec',                                    `hh', `cc', `gtest', `fwd')
 add(`dep_spec_annotations',                        `hh', `cc', `fwd', `se')
 add(`dep_spec_data',                               `hh', `cc', `fwd')
 add(`dep_spec_flattener',                          `hh', `cc')
+add(`distfile_index',                              `hh', `cc', `fwd', `gtest', `testscript')
 add(`distribution',                                `hh', `cc', `impl', `fwd')
 add(`elf_linkage_checker',                         `hh', `cc')
 add(`elike_blocker',                               `hh', `cc', `fwd', `se')
@@ -79,6 +80,7 @@ add(`output_manager_from_environment',             `hh', `fwd', `cc')
 add(`package_dep_spec_collection',                 `hh', `cc', `fwd')
 add(`package_dep_spec_properties',                 `hh', `cc', `fwd')
 add(`package_id',                                  `hh', `cc', `fwd', `se')
+add(`package_id_stream',                           `hh', `cc', `fwd', `gtest')
 add(`paludis',                                     `hh')
 add(`paludislike_options_conf',                    `hh', `cc', `fwd')
 add(`partially_made_package_dep_spec',             `hh', `cc', `fwd', `se')
@@ -44,6 +44,7 @@
 #include <cstring>
 #include <cstdio>
 #include <list>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
@@ -72,11 +73,39 @@ namespace paludis
         FSMergerParams params;
         std::set<FSPath, FSPathComparator> elided_paths;
 
+        /* guards merged_ids, elided_paths and merged_entries, which are
+         * shared between threads if we merge in parallel */
+        std::mutex mutex;
+
         Imp(const FSMergerParams & p) :
             params(p)
         {
         }
 
+        bool remember_merged(const std::pair<dev_t, ino_t> & id, const std::string & path)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            bool first(merged_ids.end() == merged_ids.find(id));
+            merged_ids.insert(std::make_pair(id, path));
+            return first;
+        }
+
+        std::list<std::string> merged_as(const std::pair<dev_t, ino_t> & id)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::list<std::string> result;
+            std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(merged_ids.equal_range(id));
+            for (MergedMap::const_iterator i = ii.first ; i != ii.second ; ++i)
+                result.push_back(i->second);
+            return result;
+        }
+
+        void add_merged_entry(const FSPath & f)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            params.merged_entries()->insert(f);
+        }
+
         bool is_elided_directory(const FSPath & dir) const
         {
             for (FSIterator dentry(dir, { fsio_include_dotfiles }), invalid;
@@ -349,7 +378,7 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
                         ("INSTALL_SOURCE", stringify(src))
                         ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))
                         ("REAL_DESTINATION", stringify(dst_real))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.file.pre_hooks.failure", ll_warning, lc_context) <<
                 "Merge of '" << src << "' to '" << dst_dir << "' pre hooks returned non-zero";
 
@@ -370,8 +399,7 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
     {
         result += msi_rename;
 
-        bool touch(_imp->merged_ids.end() == _imp->merged_ids.find(src_stat.lowlevel_id()));
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst_real)));
+        bool touch(_imp->remember_merged(src_stat.lowlevel_id(), stringify(dst_real)));
 
         FSPath d(stringify(dst_real));
         if (touch && ! _imp->params.options()[mo_preserve_mtimes])
@@ -384,10 +412,9 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
     else
     {
         do_copy = true;
-        std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(_imp->merged_ids.equal_range(src_stat.lowlevel_id()));
-        for (MergedMap::const_iterator i = ii.first ; i != ii.second ; ++i)
+        for (const auto & i : _imp->merged_as(src_stat.lowlevel_id()))
         {
-            if (0 == ::link(i->second.c_str(), stringify(dst).c_str()))
+            if (0 == ::link(i.c_str(), stringify(dst).c_str()))
             {
                 if (0 != std::rename(stringify(dst).c_str(), stringify(dst_real).c_str()))
                     throw FSMergerError("rename(" + stringify(dst) + ", " + stringify(dst_real) + ") failed: " + stringify(::strerror(errno)));
@@ -396,7 +423,7 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
                 break;
             }
             Log::get_instance()->message("merger.file.link_failed", ll_debug, lc_context)
-                    << "link(" << i->second << ", " << dst_real << ") failed: "
+                    << "link(" << i << ", " << dst_real << ") failed: "
                     << ::strerror(errno);
         }
     }
@@ -463,7 +490,7 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
             throw FSMergerError(
                     "rename(" + stringify(dst) + ", " + stringify(dst_real) + ") failed: " + stringify(::strerror(errno)));
 
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst_real)));
+        _imp->remember_merged(src_stat.lowlevel_id(), stringify(dst_real));
     }
 
     if (fixed_ownership_for(src))
@@ -474,7 +501,7 @@ FSMerger::install_file(const FSPath & src, const FSPath & dst_dir, const std::st
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))
                          ("REAL_DESTINATION", stringify(dst_real))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.file.post_hooks.failed", ll_warning, lc_context) <<
             "Merge of '" << src << "' to '" << dst_dir << "' post hooks returned non-zero";
 
@@ -495,14 +522,13 @@ FSMerger::track_renamed_dir_recursive(const FSPath & dst)
             case et_sym:
                 rewrite_symlink_as_needed(*d, dst);
                 track_install_sym(*d, dst, merged_how);
-                _imp->merged_ids.insert(make_pair(d->stat().lowlevel_id(), stringify(*d)));
+                _imp->remember_merged(d->stat().lowlevel_id(), stringify(*d));
                 continue;
 
             case et_file:
                 {
                     FSStat d_star_stat(*d);
-                    bool touch(_imp->merged_ids.end() == _imp->merged_ids.find(d_star_stat.lowlevel_id()));
-                    _imp->merged_ids.insert(make_pair(d_star_stat.lowlevel_id(), stringify(*d)));
+                    bool touch(_imp->remember_merged(d_star_stat.lowlevel_id(), stringify(*d)));
 
                     if (touch && ! _imp->params.options()[mo_preserve_mtimes])
                         if (! d->utime(Timestamp::now()))
@@ -555,9 +581,10 @@ FSMerger::install_dir(const FSPath & src, const FSPath & dst_dir)
     FSMergerStatusFlags result;
     FSStat src_stat(src);
 
-    if (! _imp->elided_paths.empty())
+    if (_imp->params.parts() && _imp->params.should_merge())
     {
         const auto path = dst.strip_leading(_imp->params.root());
+        std::unique_lock<std::mutex> lock(_imp->mutex);
         if (_imp->elided_paths.find(path) != _imp->elided_paths.end())
         {
             set_skipped_dir(true);
@@ -569,7 +596,7 @@ FSMerger::install_dir(const FSPath & src, const FSPath & dst_dir)
                          Hook("merger_install_dir_pre")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.dir.pre_hooks.failure", ll_warning, lc_context)
             << "Merge of '" << src << "' to '" << dst_dir << "' pre hooks returned non-zero";
 
@@ -629,7 +656,7 @@ FSMerger::install_dir(const FSPath & src, const FSPath & dst_dir)
                          Hook("merger_install_dir_post")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst_dir / src.basename()))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.dir.post_hooks.failure", ll_warning, lc_context)
             << "Merge of '" << src << "' to '" << dst_dir << "' post hooks returned non-zero";
 
@@ -654,7 +681,7 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
                          Hook("merger_install_sym_pre")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.sym.pre_hooks.failure", ll_warning, lc_context)
             << "Merge of '" << src << "' to '" << dst_dir << "' pre hooks returned non-zero";
 
@@ -664,18 +691,16 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
     bool do_sym(true);
 
     FSCreateCon createcon(MatchPathCon::get_instance()->match(stringify(dst), S_IFLNK));
-    std::pair<MergedMap::const_iterator, MergedMap::const_iterator> ii(
-            _imp->merged_ids.equal_range(src_stat.lowlevel_id()));
-    for (MergedMap::const_iterator i = ii.first ; i != ii.second ; ++i)
+    for (const auto & i : _imp->merged_as(src_stat.lowlevel_id()))
     {
-        if (0 == ::link(i->second.c_str(), stringify(dst).c_str()))
+        if (0 == ::link(i.c_str(), stringify(dst).c_str()))
         {
             do_sym = false;
             result += msi_as_hardlink;
             break;
         }
         Log::get_instance()->message("merger.sym.link_failed", ll_debug, lc_context)
-            << "link(" << i->second + ", " << stringify(dst) << ") failed: "
+            << "link(" << i << ", " << stringify(dst) << ") failed: "
             << ::strerror(errno);
     }
 
@@ -684,7 +709,7 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
         if (0 != ::symlink(stringify(src.readlink()).c_str(), stringify(dst).c_str()))
             throw FSMergerError("Couldn't create symlink at '" + stringify(dst) + "': "
                     + stringify(::strerror(errno)));
-        _imp->merged_ids.insert(make_pair(src_stat.lowlevel_id(), stringify(dst)));
+        _imp->remember_merged(src_stat.lowlevel_id(), stringify(dst));
     }
 
     if (! _imp->params.no_chown())
@@ -698,7 +723,7 @@ FSMerger::install_sym(const FSPath & src, const FSPath & dst_dir)
                          Hook("merger_install_sym_post")
                          ("INSTALL_SOURCE", stringify(src))
                          ("INSTALL_DESTINATION", stringify(dst))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.sym.post_hooks.failure", ll_warning, lc_context) <<
             "Merge of '" << src << "' to '" << dst_dir << "' post hooks returned non-zero";
 
@@ -711,7 +736,7 @@ FSMerger::unlink_file(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_file_pre")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_file.pre_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' pre hooks returned non-zero";
 
@@ -721,7 +746,7 @@ FSMerger::unlink_file(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_file_post")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_file.post_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' post hooks returned non-zero";
 }
@@ -732,7 +757,7 @@ FSMerger::unlink_sym(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_sym_pre")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_sym.pre_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' pre hooks returned non-zero";
 
@@ -741,7 +766,7 @@ FSMerger::unlink_sym(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_sym_post")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_sym.post_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' post hooks returned non-zero";
 }
@@ -752,7 +777,7 @@ FSMerger::unlink_dir(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_dir_pre")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_dir.pre_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' pre hooks returned non-zero";
 
@@ -761,7 +786,7 @@ FSMerger::unlink_dir(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_dir_post")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_dir.post_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' post hooks returned non-zero";
 }
@@ -772,7 +797,7 @@ FSMerger::unlink_misc(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_misc_pre")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_misc.pre_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' pre hooks returned non-zero";
 
@@ -781,7 +806,7 @@ FSMerger::unlink_misc(FSPath d)
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_unlink_misc_post")
                          ("UNLINK_TARGET", stringify(d))),
-                _imp->params.maybe_output_manager()).max_exit_status())
+                merge_output_manager()).max_exit_status())
         Log::get_instance()->message("merger.unlink_misc.post_hooks.failure", ll_warning, lc_context) <<
             "Unmerge of '" << d << "' post hooks returned non-zero";
 }
@@ -896,7 +921,7 @@ FSMerger::track_install_file(const FSPath & src, const FSPath & dst_dir, const s
         return display_merge(et_file, dst_dir / src.basename(), flags,
                              src.basename() == dst_name ? "" : dst_name);
 
-    _imp->params.merged_entries()->insert(dst_dir / dst_name);
+    _imp->add_merged_entry(dst_dir / dst_name);
     record_install_file(src, dst_dir, dst_name, flags);
 }
 
@@ -906,14 +931,14 @@ FSMerger::track_install_dir(const FSPath & src, const FSPath & dst_dir, const FS
     if (flags[msi_unselected_part])
         return display_merge(et_dir, dst_dir / src.basename(), flags);
 
-    _imp->params.merged_entries()->insert(dst_dir / src.basename());
+    _imp->add_merged_entry(dst_dir / src.basename());
     record_install_dir(src, dst_dir, flags);
 }
 
 void
 FSMerger::track_install_under_dir(const FSPath & dst, const FSMergerStatusFlags & flags)
 {
-    _imp->params.merged_entries()->insert(dst);
+    _imp->add_merged_entry(dst);
     record_install_under_dir(dst, flags);
 }
 
@@ -923,7 +948,7 @@ FSMerger::track_install_sym(const FSPath & src, const FSPath & dst_dir, const FS
     if (flags[msi_unselected_part])
         return display_merge(et_sym, dst_dir / src.basename(), flags);
 
-    _imp->params.merged_entries()->insert(dst_dir / src.basename());
+    _imp->add_merged_entry(dst_dir / src.basename());
     record_install_sym(src, dst_dir, flags);
 }
 
@@ -1011,7 +1036,10 @@ FSMerger::on_enter_dir(bool is_check, const FSPath src)
     for (FSIterator dentry(src, { fsio_want_directories }), invalid;
             dentry != invalid; ++dentry)
         if (_imp->is_elided_directory(*dentry))
+        {
+            std::unique_lock<std::mutex> lock(_imp->mutex);
             _imp->elided_paths.insert(dentry->strip_leading(_imp->params.image()));
+        }
 }
 
 void
@@ -1068,6 +1096,50 @@ FSMerger::do_dir_recursive(bool is_check, const FSPath & src, const FSPath & dst
     Merger::do_dir_recursive(is_check, src, dst);
 }
 
+namespace
+{
+    /* hardlinks and directories merged through a symlink could tie one
+     * subtree to another, and the order in which they are merged would
+     * then matter */
+    bool merges_independently(const FSPath & src, const FSPath & dst)
+    {
+        for (FSIterator d(src, { fsio_include_dotfiles }), d_end ; d != d_end ; ++d)
+        {
+            struct stat st;
+            if (0 != ::lstat(stringify(*d).c_str(), &st))
+                return false;
+
+            if (S_ISDIR(st.st_mode))
+            {
+                if (FSStat(dst / d->basename()).is_symlink() || ! merges_independently(*d, dst / d->basename()))
+                    return false;
+            }
+            else if (st.st_nlink > 1)
+                return false;
+        }
+
+        return true;
+    }
+}
+
+bool
+FSMerger::can_merge_in_parallel(const FSPath & src, const FSPath & dst)
+{
+    Context context("When working out whether we can merge '" + stringify(src) + "' to '" + stringify(dst) + "' in parallel:");
+
+    if (! FSStat(dst).is_directory())
+        return false;
+
+    if (! merges_independently(src, dst))
+    {
+        Log::get_instance()->message("merger.parallel_merge.serial", ll_debug, lc_context) << "Merging '"
+            << src << "' serially, because it contains hardlinks or directories that would be merged through symlinks";
+        return false;
+    }
+
+    return true;
+}
+
 std::string
 FSMerger::make_arrows(const FSMergerStatusFlags & flags) const
 {
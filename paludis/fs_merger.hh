@@ -225,6 +225,8 @@ namespace paludis
 
             virtual void do_dir_recursive(bool is_check, const FSPath &, const FSPath &);
 
+            virtual bool can_merge_in_parallel(const FSPath &, const FSPath &);
+
             ///\}
 
             ///\name Configuration protection
@@ -444,6 +444,28 @@ TEST(Merger, Override)
     ASSERT_TRUE((data->root_dir / "sym_install_me").stat().is_symlink());
 }
 
+TEST(Merger, ParallelScan)
+{
+    auto data(make_merger("parallel_scan", { mo_allow_empty_dirs, mo_parallel_scan }));
+
+    ASSERT_TRUE(data->merger.check());
+    data->merger.merge();
+
+    ASSERT_TRUE((data->root_dir / "one" / "sub" / "file").stat().is_regular_file());
+    ASSERT_TRUE((data->root_dir / "two" / "file").stat().is_regular_file());
+    ASSERT_TRUE((data->root_dir / "two" / "sym").stat().is_symlink());
+    ASSERT_TRUE((data->root_dir / "three" / "sub" / "file").stat().is_regular_file());
+    ASSERT_TRUE((data->root_dir / "top_file").stat().is_regular_file());
+}
+
+TEST(Merger, ParallelScanConflict)
+{
+    auto data(make_merger("parallel_scan_conflict", { mo_allow_empty_dirs, mo_parallel_scan }));
+
+    ASSERT_TRUE(! data->merger.check());
+    ASSERT_TRUE((data->root_dir / "two" / "dir").stat().is_regular_file());
+}
+
 TEST(Merger, EmptyDirAllowed)
 {
     auto data(make_merger("empty_dir_allowed", { mo_allow_empty_dirs }));
@@ -87,6 +87,23 @@ mkdir override_dir/image/dir_install_me/
 ln -s override_dir/image/file_skip_me override_dir/image/sym_skip_me
 ln -s override_dir/image/file_install_me override_dir/image/sym_install_me
 
+mkdir -p parallel_scan_dir/{image,root}
+mkdir -p parallel_scan_dir/image/{one,two,three}/sub
+> parallel_scan_dir/image/one/sub/file
+> parallel_scan_dir/image/two/file
+ln -s file parallel_scan_dir/image/two/sym
+> parallel_scan_dir/image/three/sub/file
+> parallel_scan_dir/image/top_file
+mkdir -p parallel_scan_dir/root/two
+
+mkdir -p parallel_scan_conflict_dir/{image,root}
+mkdir -p parallel_scan_conflict_dir/image/{one,two}
+> parallel_scan_conflict_dir/image/one/file
+mkdir parallel_scan_conflict_dir/image/two/dir
+> parallel_scan_conflict_dir/image/two/dir/file
+mkdir -p parallel_scan_conflict_dir/root/two
+> parallel_scan_conflict_dir/root/two/dir
+
 mkdir -p empty_{dir,root}_{allowed,disallowed}_dir/{image,root}
 mkdir -p empty_dir_{allowed,disallowed}_dir/image/empty
 
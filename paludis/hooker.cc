@@ -25,6 +25,8 @@
 #include <paludis/output_manager.hh>
 #include <paludis/metadata_key.hh>
 #include <paludis/repository.hh>
+#include <paludis/buffer_output_manager.hh>
+#include <paludis/standard_output_manager.hh>
 
 #include <paludis/util/log.hh>
 #include <paludis/util/is_file_with_extension.hh>
@@ -41,8 +43,18 @@
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/env_var_names.hh>
-
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/thread_pool.hh>
+#include <paludis/util/destringify.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <list>
+#include <map>
+#include <vector>
 #include <iterator>
 #include <mutex>
 #include <dlfcn.h>
@@ -59,6 +71,184 @@ namespace
     static const std::string so_suffix("_" + stringify(PALUDIS_PC_SLOT)
             + ".so." + stringify(100 * PALUDIS_VERSION_MAJOR + PALUDIS_VERSION_MINOR));
 
+    static const std::string manifest_magic("paludis-hook-manifest");
+
+    /* bump this whenever the layout of the manifest changes */
+    static const std::string manifest_format_version("2");
+
+    FSPath hooker_script()
+    {
+        return FSPath(getenv_with_default(env_vars::hooker_dir, LIBEXECDIR "/paludis")) / "hooker.bash";
+    }
+
+    /**
+     * Remembers what fancy hooks said when asked for their auto hook names
+     * and their dependencies, so that we don't have to start a shell for
+     * every .hook file every time a hook is run. Entries are keyed on the
+     * hook file's mtime and size.
+     */
+    class HookManifest
+    {
+        private:
+            typedef std::map<std::string, std::pair<std::string, std::string> > Entries;
+
+            const FSPath _file;
+            const std::string _dirs;
+            const std::string _hooker;
+
+            std::mutex _mutex;
+            Entries _entries;
+            bool _dirty;
+
+            static std::string _key(const std::string & kind, const std::string & hook, const FSPath & f)
+            {
+                return kind + "\t" + hook + "\t" + stringify(f);
+            }
+
+            static std::string _stamp(const FSPath & f)
+            {
+                FSStat st(f);
+                if (! st.is_regular_file_or_symlink_to_regular_file())
+                    return "";
+                return stringify(st.mtim().seconds()) + " " + stringify(st.mtim().nanoseconds()) + " " + stringify(st.file_size());
+            }
+
+            void _load();
+
+        public:
+            HookManifest(const FSPath & f, const std::string & d) :
+                _file(f),
+                _dirs(d),
+                _hooker("hooker\t" + stringify(hooker_script()) + "\t" + _stamp(hooker_script())),
+                _dirty(false)
+            {
+                _load();
+            }
+
+            bool find(const std::string & kind, const std::string & hook, const FSPath & f, std::string & result)
+            {
+                std::string stamp(_stamp(f));
+                std::unique_lock<std::mutex> lock(_mutex);
+                Entries::const_iterator e(_entries.find(_key(kind, hook, f)));
+                if (_entries.end() == e || stamp.empty() || e->second.first != stamp)
+                    return false;
+
+                result = e->second.second;
+                return true;
+            }
+
+            void store(const std::string & kind, const std::string & hook, const FSPath & f, const std::string & result)
+            {
+                std::string stamp(_stamp(f));
+                if (stamp.empty() || std::string::npos != stringify(f).find_first_of("\t\n"))
+                    return;
+
+                std::unique_lock<std::mutex> lock(_mutex);
+                _entries[_key(kind, hook, f)] = std::make_pair(stamp, result);
+                _dirty = true;
+            }
+
+            void save();
+    };
+
+    void
+    HookManifest::_load()
+    {
+        Context context("When loading hook manifest '" + stringify(_file) + "':");
+
+        if (! _file.stat().is_regular_file())
+            return;
+
+        try
+        {
+            SafeIFStream stream(_file);
+            std::string line;
+            if ((! std::getline(stream, line)) || 0 != line.compare(0, manifest_magic.length() + 1, manifest_magic + " "))
+            {
+                Log::get_instance()->message("hook.manifest.bad_magic", ll_warning, lc_context)
+                    << "Ignoring hook manifest '" << _file << "' because it has an unrecognised format";
+                return;
+            }
+
+            /* written by a different version, so rebuild it quietly */
+            if (line.substr(manifest_magic.length() + 1) != manifest_format_version)
+                return;
+
+            /* hook directories have changed, so hook names and orderings may have too */
+            if ((! std::getline(stream, line)) || line != _dirs)
+                return;
+
+            /* hooker.bash answers the queries, so a different one may answer differently */
+            if ((! std::getline(stream, line)) || line != _hooker)
+                return;
+
+            /* kind \t hook \t path \t mtime_s mtime_ns size \t result */
+            while (std::getline(stream, line))
+            {
+                std::vector<std::string> fields;
+                std::string::size_type p(0);
+                for (int i(0) ; i < 4 && std::string::npos != p ; ++i)
+                {
+                    std::string::size_type q(line.find('\t', p));
+                    fields.push_back(line.substr(p, std::string::npos == q ? q : q - p));
+                    p = std::string::npos == q ? q : q + 1;
+                }
+
+                if (4 != fields.size() || std::string::npos == p)
+                    continue;
+
+                _entries.insert(std::make_pair(_key(fields[0], fields[1], FSPath(fields[2])),
+                            std::make_pair(fields[3], line.substr(p))));
+            }
+        }
+        catch (const Exception & e)
+        {
+            Log::get_instance()->message("hook.manifest.failure", ll_warning, lc_context)
+                << "Ignoring hook manifest '" << _file << "': '" << e.message() << "' (" << e.what() << ")";
+            _entries.clear();
+        }
+    }
+
+    void
+    HookManifest::save()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (! _dirty)
+            return;
+        _dirty = false;
+
+        Context context("When saving hook manifest '" + stringify(_file) + "':");
+
+        try
+        {
+            _file.dirname().mkdir(0755, { fspmkdo_ok_if_exists });
+
+            AtomicOFStream a(_file);
+            {
+                std::ostream & stream(a.stream());
+                stream << manifest_magic << " " << manifest_format_version << std::endl
+                    << _dirs << std::endl << _hooker << std::endl;
+
+                for (const auto & e : _entries)
+                {
+                    /* forget about hook files that have gone away */
+                    std::string path(e.first.substr(e.first.find('\t', e.first.find('\t') + 1) + 1));
+                    if (! FSPath(path).stat().exists())
+                        continue;
+
+                    stream << e.first << "\t" << e.second.first << "\t" << e.second.second << std::endl;
+                }
+            }
+
+            a.commit();
+        }
+        catch (const Exception & e)
+        {
+            Log::get_instance()->message("hook.manifest.failure", ll_debug, lc_context)
+                << "Could not write hook manifest '" << _file << "': '" << e.message() << "' (" << e.what() << ")";
+        }
+    }
+
     class BashHookFile :
         public HookFile
     {
@@ -101,14 +291,18 @@ namespace
             const FSPath _file_name;
             const bool _run_prefixed;
             const Environment * const _env;
+            const std::shared_ptr<HookManifest> _manifest;
 
             void _add_dependency_class(const Hook &, DirectedGraph<std::string, int> &, bool);
+            void _add_dependencies_from(const std::string &, DirectedGraph<std::string, int> &, bool);
 
         public:
-            FancyHookFile(const FSPath & f, const bool r, const Environment * const e) :
+            FancyHookFile(const FSPath & f, const bool r, const Environment * const e,
+                    const std::shared_ptr<HookManifest> & m) :
                 _file_name(f),
                 _run_prefixed(r),
-                _env(e)
+                _env(e),
+                _manifest(m)
             {
             }
 
@@ -225,8 +419,8 @@ FancyHookFile::run(const Hook & hook,
     Log::get_instance()->message("hook.fancy.starting", ll_debug, lc_no_context) << "Starting hook script '"
         << file_name() << "' for '" << hook.name() << "'";
 
-    Process process(ProcessCommand({ "sh", "-c", getenv_with_default(env_vars::hooker_dir, LIBEXECDIR "/paludis") +
-                "/hooker.bash '" + stringify(file_name()) + "' 'hook_run_" + stringify(hook.name()) + "'" }));
+    Process process(ProcessCommand({ "sh", "-c", stringify(hooker_script()) +
+                " '" + stringify(file_name()) + "' 'hook_run_" + stringify(hook.name()) + "'" }));
 
     process
         .setenv("ROOT", stringify(_env->preferred_root_key()->parse_value()))
@@ -283,11 +477,19 @@ FancyHookFile::auto_hook_names() const
 {
     Context c("When querying auto hook names for fancy hook '" + stringify(file_name()) + "':");
 
+    std::string cached;
+    if (_manifest && _manifest->find("auto", "", file_name(), cached))
+    {
+        std::shared_ptr<Sequence<std::string> > result(std::make_shared<Sequence<std::string>>());
+        tokenise_whitespace(cached, result->back_inserter());
+        return result;
+    }
+
     Log::get_instance()->message("hook.fancy.starting", ll_debug, lc_no_context) << "Starting hook script '" <<
         file_name() << "' for auto hook names";
 
-    Process process(ProcessCommand({ "sh", "-c", getenv_with_default(env_vars::hooker_dir, LIBEXECDIR "/paludis") +
-            "/hooker.bash '" + stringify(file_name()) + "' 'hook_auto_names'" }));
+    Process process(ProcessCommand({ "sh", "-c", stringify(hooker_script()) +
+            " '" + stringify(file_name()) + "' 'hook_auto_names'" }));
 
     process
         .setenv("ROOT", stringify(_env->preferred_root_key()->parse_value()))
@@ -314,6 +516,8 @@ FancyHookFile::auto_hook_names() const
         Log::get_instance()->message("hook.fancy.success", ll_debug, lc_no_context) << "Hook '" << file_name()
             << "' returned success '" << exit_status << "' for auto hook names, result ("
             << join(result->begin(), result->end(), ", ") << ")";
+        if (_manifest)
+            _manifest->store("auto", "", file_name(), join(result->begin(), result->end(), " "));
         return result;
     }
     else
@@ -339,11 +543,19 @@ FancyHookFile::_add_dependency_class(const Hook & hook, DirectedGraph<std::strin
     Context context("When adding dependency class '" + stringify(depend ? "depend" : "after") + "' for hook '"
             + stringify(hook.name()) + "' file '" + stringify(file_name()) + "':");
 
+    const std::string kind(depend ? "depend" : "after");
+    std::string deps;
+    if (_manifest && _manifest->find(kind, hook.name(), file_name(), deps))
+    {
+        _add_dependencies_from(deps, g, depend);
+        return;
+    }
+
     Log::get_instance()->message("hook.fancy.starting_dependencies", ll_debug, lc_no_context)
         << "Starting hook script '" << file_name() << "' for dependencies of '" << hook.name() << "'";
 
-    Process process(ProcessCommand({ "sh", "-c", getenv_with_default(env_vars::hooker_dir, LIBEXECDIR "/paludis") +
-            "/hooker.bash '" + stringify(file_name()) + "' 'hook_" + (depend ? "depend" : "after") + "_" +
+    Process process(ProcessCommand({ "sh", "-c", stringify(hooker_script()) +
+            " '" + stringify(file_name()) + "' 'hook_" + (depend ? "depend" : "after") + "_" +
             stringify(hook.name()) + "'" }));
 
     process
@@ -364,7 +576,7 @@ FancyHookFile::_add_dependency_class(const Hook & hook, DirectedGraph<std::strin
     process.capture_stdout(s);
     int exit_status(process.run().wait());
 
-    std::string deps((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+    deps.assign((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
 
     if (0 == exit_status)
     {
@@ -373,24 +585,35 @@ FancyHookFile::_add_dependency_class(const Hook & hook, DirectedGraph<std::strin
 
         std::set<std::string> deps_s;
         tokenise_whitespace(deps, std::inserter(deps_s, deps_s.end()));
+        if (_manifest)
+            _manifest->store(kind, hook.name(), file_name(), join(deps_s.begin(), deps_s.end(), " "));
 
-        for (const auto & deps_ : deps_s)
-        {
-            if (g.has_node(deps_))
-                g.add_edge(strip_trailing_string(file_name().basename(), ".hook"), deps_, 0);
-            else if (depend)
-                Log::get_instance()->message("hook.fancy.dependency_not_found", ll_warning, lc_context)
-                    << "Hook dependency '" << deps_ << "' for '" << file_name() << "' not found";
-            else
-                Log::get_instance()->message("hook.fancy.after_not_found", ll_debug, lc_context)
-                    << "Hook after '" << deps_ << "' for '" << file_name() << "' not found";
-        }
+        _add_dependencies_from(deps, g, depend);
     }
     else
         Log::get_instance()->message("hook.fancy.failure_dependencies", ll_warning, lc_no_context)
             << "Hook dependencies for '" << file_name() << "' returned failure '" << exit_status << "'";
 }
 
+void
+FancyHookFile::_add_dependencies_from(const std::string & deps, DirectedGraph<std::string, int> & g, bool depend)
+{
+    std::set<std::string> deps_s;
+    tokenise_whitespace(deps, std::inserter(deps_s, deps_s.end()));
+
+    for (const auto & deps_ : deps_s)
+    {
+        if (g.has_node(deps_))
+            g.add_edge(strip_trailing_string(file_name().basename(), ".hook"), deps_, 0);
+        else if (depend)
+            Log::get_instance()->message("hook.fancy.dependency_not_found", ll_warning, lc_context)
+                << "Hook dependency '" << deps_ << "' for '" << file_name() << "' not found";
+        else
+            Log::get_instance()->message("hook.fancy.after_not_found", ll_debug, lc_context)
+                << "Hook after '" << deps_ << "' for '" << file_name() << "' not found";
+    }
+}
+
 SoHookFile::SoHookFile(const FSPath & f, const bool, const Environment * const e) :
     _file_name(f),
     _env(e),
@@ -465,11 +688,14 @@ namespace paludis
     {
         const Environment * const env;
         std::list<std::pair<FSPath, bool> > dirs;
+        std::shared_ptr<const FSPath> manifest_file;
 
         mutable std::recursive_mutex hook_files_mutex;
         mutable std::map<std::string, std::shared_ptr<Sequence<std::shared_ptr<HookFile> > > > hook_files;
+        mutable std::map<std::string, std::vector<unsigned> > hook_file_levels;
         mutable std::map<std::string, std::map<std::string, std::shared_ptr<HookFile> > > auto_hook_files;
         mutable bool has_auto_hook_files;
+        mutable std::shared_ptr<HookManifest> manifest;
 
         Imp(const Environment * const e) :
             env(e),
@@ -477,6 +703,19 @@ namespace paludis
         {
         }
 
+        void need_manifest() const
+        {
+            std::unique_lock<std::recursive_mutex> l(hook_files_mutex);
+
+            if (manifest || ! manifest_file)
+                return;
+
+            std::string d("dirs");
+            for (const auto & dir : dirs)
+                d.append("\t" + stringify(dir.first) + ":" + stringify(dir.second));
+            manifest = std::make_shared<HookManifest>(*manifest_file, d);
+        }
+
         void need_auto_hook_files() const
         {
             std::unique_lock<std::recursive_mutex> l(hook_files_mutex);
@@ -484,6 +723,7 @@ namespace paludis
             if (has_auto_hook_files)
                 return;
             has_auto_hook_files = true;
+            need_manifest();
 
             Context context("When loading auto hooks:");
 
@@ -500,7 +740,7 @@ namespace paludis
 
                     if (is_file_with_extension(*e, ".hook", { }))
                     {
-                        hook_file = std::make_shared<FancyHookFile>(*e, dir.second, env);
+                        hook_file = std::make_shared<FancyHookFile>(*e, dir.second, env, manifest);
                         name = strip_trailing_string(e->basename(), ".hook");
                     }
                     else if (is_file_with_extension(*e, so_suffix, { }))
@@ -539,10 +779,25 @@ Hooker::add_dir(const FSPath & dir, const bool v)
 {
     std::unique_lock<std::recursive_mutex> l(_imp->hook_files_mutex);
     _imp->hook_files.clear();
+    _imp->hook_file_levels.clear();
     _imp->auto_hook_files.clear();
+    _imp->has_auto_hook_files = false;
+    _imp->manifest.reset();
     _imp->dirs.push_back(std::make_pair(dir, v));
 }
 
+void
+Hooker::set_manifest_file(const FSPath & f)
+{
+    std::unique_lock<std::recursive_mutex> l(_imp->hook_files_mutex);
+    _imp->hook_files.clear();
+    _imp->hook_file_levels.clear();
+    _imp->auto_hook_files.clear();
+    _imp->has_auto_hook_files = false;
+    _imp->manifest.reset();
+    _imp->manifest_file = std::make_shared<FSPath>(f);
+}
+
 namespace
 {
     struct PyHookFileHandle :
@@ -605,7 +860,7 @@ Hooker::_find_hooks(const Hook & hook) const
 
             if (is_file_with_extension(*e, ".hook", { }))
                 if (! hook_files.insert(std::make_pair(strip_trailing_string(e->basename(), ".hook"),
-                                std::shared_ptr<HookFile>(std::make_shared<FancyHookFile>(*e, d->second, _imp->env)))).second)
+                                std::shared_ptr<HookFile>(std::make_shared<FancyHookFile>(*e, d->second, _imp->env, _imp->manifest)))).second)
                     Log::get_instance()->message("hook.discarding", ll_warning, lc_context) << "Discarding hook file '" << *e
                         << "' because of naming conflict with '" <<
                         hook_files.find(stringify(strip_trailing_string(e->basename(), ".hook")))->second->file_name() << "'";
@@ -713,14 +968,114 @@ Hooker::_find_hooks(const Hook & hook) const
         }
     }
 
+    /* a hook's level is one more than the highest level of anything it
+     * depends upon, so hooks on the same level can be run together */
+    std::vector<unsigned> & levels(_imp->hook_file_levels[hook.name()]);
+    levels.clear();
+    for (std::list<std::string>::const_iterator o(ordered.begin()), o_end(ordered.end()) ;
+            o != o_end ; ++o)
+    {
+        unsigned level(0), n(0);
+        for (std::list<std::string>::const_iterator p(ordered.begin()) ; p != o ; ++p, ++n)
+            if (hook_deps.has_edge(*o, *p) || hook_deps.has_edge(*p, *o))
+                level = std::max(level, levels[n] + 1);
+        levels.push_back(level);
+    }
+
     std::shared_ptr<Sequence<std::shared_ptr<HookFile> > > result(std::make_shared<Sequence<std::shared_ptr<HookFile> >>());
     for (std::list<std::string>::const_iterator o(ordered.begin()), o_end(ordered.end()) ;
             o != o_end ; ++o)
         result->push_back(hook_files.find(*o)->second);
 
+    if (_imp->manifest)
+        _imp->manifest->save();
+
     return result;
 }
 
+namespace
+{
+    unsigned hook_jobs()
+    {
+        Context context("When working out how many hooks to run at once:");
+
+        try
+        {
+            unsigned jobs(destringify<unsigned>(getenv_with_default(env_vars::hook_jobs, "1")));
+            return 0 == jobs ? 1 : jobs;
+        }
+        catch (const DestringifyError & e)
+        {
+            Log::get_instance()->message("hook.bad_jobs", ll_warning, lc_context)
+                << "Ignoring bad value for " << env_vars::hook_jobs << ": '" << e.message() << "'";
+            return 1;
+        }
+    }
+
+    bool hook_file_exists(const std::shared_ptr<HookFile> & f)
+    {
+        if (f->file_name().stat().is_regular_file_or_symlink_to_regular_file())
+            return true;
+
+        Log::get_instance()->message("hook.not_regular_file", ll_warning, lc_context) << "Hook file '" <<
+            f->file_name() << "' is not a regular file or has been removed";
+        return false;
+    }
+
+    /* Run hook files that don't depend upon one another, at most jobs at a
+     * time. Output is buffered per hook and written out in the order the
+     * hooks would have run sequentially. */
+    void run_hook_level(
+            const Hook & hook,
+            const std::vector<std::shared_ptr<HookFile> > & level,
+            const unsigned jobs,
+            const std::shared_ptr<OutputManager> & optional_output_manager,
+            HookResult & result)
+    {
+        if (1 == level.size())
+        {
+            result.max_exit_status() = std::max(result.max_exit_status(), level.front()->run(hook, optional_output_manager).max_exit_status());
+            return;
+        }
+
+        const std::shared_ptr<OutputManager> child(optional_output_manager ? optional_output_manager :
+                std::make_shared<StandardOutputManager>());
+        std::vector<std::shared_ptr<BufferOutputManager> > buffers;
+        for (std::size_t i(0) ; i < level.size() ; ++i)
+            buffers.push_back(std::make_shared<BufferOutputManager>(child));
+
+        std::vector<int> exit_statuses(level.size(), 0);
+        std::vector<std::exception_ptr> exceptions(level.size());
+        std::atomic<std::size_t> next(0);
+
+        {
+            ThreadPool pool;
+            for (std::size_t t(0), t_end(std::min<std::size_t>(jobs, level.size())) ; t != t_end ; ++t)
+                pool.create_thread([&] () noexcept {
+                        for (std::size_t i(next++) ; i < level.size() ; i = next++)
+                        {
+                            try
+                            {
+                                exit_statuses[i] = level[i]->run(hook, buffers[i]).max_exit_status();
+                            }
+                            catch (...)
+                            {
+                                exceptions[i] = std::current_exception();
+                            }
+                        }
+                    });
+        }
+
+        for (std::size_t i(0) ; i < level.size() ; ++i)
+        {
+            buffers[i]->flush();
+            if (exceptions[i])
+                std::rethrow_exception(exceptions[i]);
+            result.max_exit_status() = std::max(result.max_exit_status(), exit_statuses[i]);
+        }
+    }
+}
+
 HookResult
 Hooker::perform_hook(
         const Hook & hook,
@@ -775,38 +1130,59 @@ Hooker::perform_hook(
 
     /* file hooks, but only if necessary */
 
-    std::unique_lock<std::recursive_mutex> l(_imp->hook_files_mutex);
-    std::map<std::string, std::shared_ptr<Sequence<std::shared_ptr<HookFile> > > >::iterator h(_imp->hook_files.find(hook.name()));
+    /* hooks may themselves trigger hooks, possibly from another thread if
+     * we are running them in parallel, so don't hold the lock while running
+     * them. add_dir replaces rather than modifies the sequence, so our copy
+     * stays valid. */
+    std::shared_ptr<const Sequence<std::shared_ptr<HookFile> > > files;
+    std::vector<unsigned> levels;
+    {
+        std::unique_lock<std::recursive_mutex> l(_imp->hook_files_mutex);
+        std::map<std::string, std::shared_ptr<Sequence<std::shared_ptr<HookFile> > > >::iterator h(_imp->hook_files.find(hook.name()));
 
-    if (h == _imp->hook_files.end())
-        h = _imp->hook_files.insert(std::make_pair(hook.name(), _find_hooks(hook))).first;
+        if (h == _imp->hook_files.end())
+            h = _imp->hook_files.insert(std::make_pair(hook.name(), _find_hooks(hook))).first;
+
+        files = h->second;
+        levels = _imp->hook_file_levels[hook.name()];
+    }
 
-    if (! h->second->empty())
+    if (! files->empty())
     {
         do
         {
             switch (hook.output_dest)
             {
                 case hod_stdout:
-                    for (Sequence<std::shared_ptr<HookFile> >::ConstIterator f(h->second->begin()),
-                            f_end(h->second->end()) ; f != f_end ; ++f)
-                        if ((*f)->file_name().stat().is_regular_file_or_symlink_to_regular_file())
-                            result.max_exit_status() = std::max(result.max_exit_status(), (*f)->run(hook, optional_output_manager).max_exit_status());
-                        else
-                            Log::get_instance()->message("hook.not_regular_file", ll_warning, lc_context) << "Hook file '" <<
-                                (*f)->file_name() << "' is not a regular file or has been removed";
+                    {
+                        const unsigned jobs(hook_jobs());
+                        if (1 == jobs)
+                        {
+                            for (Sequence<std::shared_ptr<HookFile> >::ConstIterator f(files->begin()),
+                                    f_end(files->end()) ; f != f_end ; ++f)
+                                if (hook_file_exists(*f))
+                                    result.max_exit_status() = std::max(result.max_exit_status(), (*f)->run(hook, optional_output_manager).max_exit_status());
+                            continue;
+                        }
+
+                        std::map<unsigned, std::vector<std::shared_ptr<HookFile> > > by_level;
+                        unsigned n(0);
+                        for (Sequence<std::shared_ptr<HookFile> >::ConstIterator f(files->begin()),
+                                f_end(files->end()) ; f != f_end ; ++f, ++n)
+                            if (hook_file_exists(*f))
+                                by_level[n < levels.size() ? levels[n] : n].push_back(*f);
+
+                        for (const auto & level : by_level)
+                            run_hook_level(hook, level.second, jobs, optional_output_manager, result);
+                    }
                     continue;
 
                 case hod_grab:
-                    for (Sequence<std::shared_ptr<HookFile> >::ConstIterator f(h->second->begin()),
-                            f_end(h->second->end()) ; f != f_end ; ++f)
+                    for (Sequence<std::shared_ptr<HookFile> >::ConstIterator f(files->begin()),
+                            f_end(files->end()) ; f != f_end ; ++f)
                     {
-                        if (! (*f)->file_name().stat().is_regular_file_or_symlink_to_regular_file())
-                        {
-                            Log::get_instance()->message("hook.not_regular_file", ll_warning, lc_context) << "Hook file '" <<
-                                (*f)->file_name() << "' is not a regular file or has been removed";
+                        if (! hook_file_exists(*f))
                             continue;
-                        }
 
                         HookResult tmp((*f)->run(hook, optional_output_manager));
                         if (tmp.max_exit_status() > result.max_exit_status())
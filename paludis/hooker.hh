@@ -117,6 +117,16 @@ namespace paludis
              * Add a new hook directory.
              */
             void add_dir(const FSPath &, const bool output_prefixed);
+
+            /**
+             * Remember the auto hook names and dependencies of fancy hooks
+             * in the given file, so later runs need not ask each hook
+             * again. Entries are revalidated against each hook file's
+             * mtime and size, and discarded if the hook directories change.
+             *
+             * \since 3.0
+             */
+            void set_manifest_file(const FSPath &);
     };
 }
 
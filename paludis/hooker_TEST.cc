@@ -24,8 +24,12 @@
 
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/fs_stat.hh>
 
 #include <iterator>
+#include <fcntl.h>
+#include <cstdlib>
 
 #include <gtest/gtest.h>
 
@@ -214,3 +218,69 @@ TEST(Hooker, BadOutput)
 }
 
 
+
+namespace
+{
+    std::string run_manifest_hook()
+    {
+        TestEnvironment env;
+        Hooker hooker(&env);
+        hooker.add_dir(FSPath("hooker_TEST_dir/manifest"), false);
+        hooker.set_manifest_file(FSPath("hooker_TEST_dir/manifest_cache/hook_manifest"));
+
+        FSPath("hooker_TEST_dir/manifest.out").unlink();
+        HookResult result(hooker.perform_hook(Hook("manifest_hook"), nullptr));
+        EXPECT_EQ(0, result.max_exit_status());
+
+        SafeIFStream f(FSPath("hooker_TEST_dir/manifest.out"));
+        return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    }
+}
+
+TEST(Hooker, Manifest)
+{
+    EXPECT_EQ("names\ndepend\nother\nrun\n", run_manifest_hook());
+    EXPECT_TRUE(FSPath("hooker_TEST_dir/manifest_cache/hook_manifest").stat().is_regular_file());
+    EXPECT_EQ("other\nrun\n", run_manifest_hook());
+
+    {
+        SafeOFStream f(FSPath("hooker_TEST_dir/manifest/auto/counted.hook"), O_WRONLY | O_APPEND, false);
+        f << "# changed" << std::endl;
+    }
+
+    EXPECT_EQ("names\ndepend\nother\nrun\n", run_manifest_hook());
+    EXPECT_EQ("other\nrun\n", run_manifest_hook());
+
+    {
+        FSPath manifest("hooker_TEST_dir/manifest_cache/hook_manifest");
+        std::string contents;
+        {
+            SafeIFStream f(manifest);
+            contents.assign((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        }
+
+        SafeOFStream f(manifest, -1, false);
+        f << "paludis-hook-manifest 1" << contents.substr(contents.find('\n'));
+    }
+
+    EXPECT_EQ("names\ndepend\nother\nrun\n", run_manifest_hook());
+    EXPECT_EQ("other\nrun\n", run_manifest_hook());
+}
+
+TEST(Hooker, Parallel)
+{
+    TestEnvironment env;
+    Hooker hooker(&env);
+
+    FSPath("hooker_TEST_dir/parallel.out").unlink();
+    hooker.add_dir(FSPath("hooker_TEST_dir/"), false);
+
+    ::setenv("PALUDIS_HOOK_JOBS", "2", 1);
+    HookResult result(hooker.perform_hook(Hook("parallel"), nullptr));
+    ::unsetenv("PALUDIS_HOOK_JOBS");
+    EXPECT_EQ(3, result.max_exit_status());
+
+    SafeIFStream f(FSPath("hooker_TEST_dir/parallel.out"));
+    std::string line((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    EXPECT_TRUE(line == "one\ntwo\nthree\n" || line == "two\none\nthree\n") << line;
+}
@@ -293,3 +293,56 @@ for a in a b c d e f g h i ; do
     ln -s ../cycles.common cycles/${a}.hook
 done
 
+
+mkdir -p manifest/auto manifest/manifest_hook
+cat <<"END" > manifest/auto/counted.hook
+hook_auto_names() {
+    echo names >> ${HOOK_FILE%/*}/../../manifest.out
+    echo manifest_hook
+}
+
+hook_run_manifest_hook() {
+    echo run >> ${HOOK_FILE%/*}/../../manifest.out
+}
+
+hook_depend_manifest_hook() {
+    echo depend >> ${HOOK_FILE%/*}/../../manifest.out
+    echo other
+}
+END
+chmod +x manifest/auto/counted.hook
+
+cat <<"END" > manifest/manifest_hook/other.hook
+hook_run_manifest_hook() {
+    echo other >> ${HOOK_FILE%/*}/../../manifest.out
+}
+END
+chmod +x manifest/manifest_hook/other.hook
+
+mkdir parallel
+mkfifo parallel_one.fifo parallel_two.fifo
+for a in one two ; do
+    [[ ${a} == one ]] && b=two || b=one
+    # each hook says it has started on its own fifo, and waits to hear the
+    # same from the other; opening read-write never blocks, and keeps what
+    # was written around for as long as either hook is running
+    cat <<END > parallel/${a}.hook
+hook_run_parallel() {
+    exec 3<>\${HOOK_FILE%/*}/../parallel_${a}.fifo 4<>\${HOOK_FILE%/*}/../parallel_${b}.fifo
+    echo started >&3
+    read -t 10 -u 4 || exit 9
+    echo ${a} >> \${HOOK_FILE%/*}/../parallel.out
+}
+END
+done
+cat <<"END" > parallel/three.hook
+hook_run_parallel() {
+    echo three >> ${HOOK_FILE%/*}/../parallel.out
+    exit 3
+}
+
+hook_depend_parallel() {
+    echo one two
+}
+END
+chmod +x parallel/*.hook
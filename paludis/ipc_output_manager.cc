@@ -39,16 +39,31 @@
 #include <paludis/environment.hh>
 #include <functional>
 #include <vector>
+#include <list>
 #include <cstdlib>
 #include <cstring>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
 
 using namespace paludis;
 
+namespace
+{
+    /* lengths are given as decimal, followed by a space, so that a frame
+     * can carry commands containing any character other than a nul */
+    std::string make_batch(const std::list<std::string> & commands)
+    {
+        std::string result("BATCH 1 ");
+        for (const auto & c : commands)
+            result.append(stringify(c.length()) + " " + c);
+        return result;
+    }
+}
+
 namespace paludis
 {
     template <>
@@ -60,8 +75,23 @@ namespace paludis
         std::shared_ptr<SafeIFStream> pipe_command_read_stream;
         std::shared_ptr<SafeOFStream> pipe_command_write_stream;
 
+        bool pipelined;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::list<std::string> queued;
+        int in_flight;
+        bool finishing;
+        bool broken;
+        std::string error;
+        std::thread ack_thread;
+
         Imp(int r, int w) :
-            pipe_command_write_stream(std::make_shared<SafeOFStream>(w, false))
+            pipe_command_write_stream(std::make_shared<SafeOFStream>(w, false)),
+            pipelined(false),
+            in_flight(0),
+            finishing(false),
+            broken(false)
         {
             *pipe_command_write_stream << "PING 1 GOAT" << '\0' << std::flush;
 
@@ -71,6 +101,140 @@ namespace paludis
                 throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
             if (response != "OPONG GOAT")
                 throw InternalError(PALUDIS_HERE, "got response '" + response + "'");
+
+            /* older input managers say they don't know what this is, and we
+             * stick to one command and one response at a time */
+            *pipe_command_write_stream << "FEATURES 1 PIPELINE" << '\0' << std::flush;
+            if (! std::getline(*pipe_command_read_stream, response, '\0'))
+                throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
+            pipelined = (response == "O PIPELINE");
+        }
+
+        std::string send_and_wait(const std::string & command)
+        {
+            *pipe_command_write_stream << command << '\0' << std::flush;
+
+            std::string response;
+            if (! std::getline(*pipe_command_read_stream, response, '\0'))
+                throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
+            return response;
+        }
+
+        /* must hold mutex. we only ever have one frame in flight, and
+         * anything sent whilst waiting for its acknowledgement gets queued
+         * up and sent together in the next one. */
+        void send_queued()
+        {
+            if (queued.empty() || 0 != in_flight || broken)
+                return;
+
+            if (1 == queued.size())
+                *pipe_command_write_stream << queued.front() << '\0' << std::flush;
+            else
+                *pipe_command_write_stream << make_batch(queued) << '\0' << std::flush;
+
+            queued.clear();
+            ++in_flight;
+        }
+
+        void ack_thread_func() noexcept
+        {
+            while (true)
+            {
+                std::string response;
+                bool ok(false);
+                try
+                {
+                    ok = bool(std::getline(*pipe_command_read_stream, response, '\0'));
+                }
+                catch (const Exception &)
+                {
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                if (! ok)
+                {
+                    broken = true;
+                    if (error.empty())
+                        error = "couldn't get a pipe command response";
+                    condition.notify_all();
+                    return;
+                }
+
+                if (response != "O" && error.empty())
+                    error = "got response '" + response + "'";
+                --in_flight;
+
+                try
+                {
+                    send_queued();
+                }
+                catch (const Exception & e)
+                {
+                    broken = true;
+                    if (error.empty())
+                        error = "couldn't send pipe command: " + e.message();
+                }
+
+                condition.notify_all();
+
+                if ((finishing && 0 == in_flight && queued.empty()) || broken)
+                    return;
+            }
+        }
+
+        void start_pipelining()
+        {
+            if (pipelined)
+                ack_thread = std::thread(std::bind(&Imp::ack_thread_func, this));
+        }
+
+        void command(const std::string & c, const bool wait, const bool last = false)
+        {
+            if (! pipelined)
+            {
+                std::string response(send_and_wait(c));
+                if (response != "O")
+                    throw InternalError(PALUDIS_HERE, "got response '" + response + "'");
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (last)
+                finishing = true;
+            queued.push_back(c);
+            send_queued();
+
+            if (wait)
+            {
+                while ((0 != in_flight || ! queued.empty()) && ! broken)
+                    condition.wait(lock);
+
+                if (! error.empty())
+                    throw InternalError(PALUDIS_HERE, error);
+            }
+        }
+
+        void finish()
+        {
+            if (pipelined)
+            {
+                /* the ack thread stops by itself once this is acknowledged */
+                try
+                {
+                    command("FINISHED 1", true, true);
+                }
+                catch (...)
+                {
+                    if (ack_thread.joinable())
+                        ack_thread.join();
+                    throw;
+                }
+
+                ack_thread.join();
+            }
+            else
+                command("FINISHED 1", true);
         }
     };
 }
@@ -121,19 +285,15 @@ IPCOutputManager::IPCOutputManager(const int r, const int w, const CreateOutputM
     if (0 != ::fcntl(stderr_fd, F_SETFD, FD_CLOEXEC))
         throw InternalError(PALUDIS_HERE, "fcntl failed");
 
+    _imp->start_pipelining();
+
     Log::get_instance()->message("ipc_output_manager.constructed", ll_debug, lc_context)
-        << "Constructed";
+        << "Constructed" << (_imp->pipelined ? " (pipelined)" : "");
 }
 
 IPCOutputManager::~IPCOutputManager() noexcept(false)
 {
-    *_imp->pipe_command_write_stream << "FINISHED 1" << '\0' << std::flush;
-
-    std::string response;
-    if (! std::getline(*_imp->pipe_command_read_stream, response, '\0'))
-        throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
-    if (response != "O")
-        throw InternalError(PALUDIS_HERE, "got response '" + response + "'");
+    _imp->finish();
 }
 
 std::ostream &
@@ -151,37 +311,20 @@ IPCOutputManager::stderr_stream()
 void
 IPCOutputManager::message(const MessageType t, const std::string & s)
 {
-    *_imp->pipe_command_write_stream << "MESSAGE 1 " << t << " " << s << '\0' << std::flush;
-
-    std::string response;
-    if (! std::getline(*_imp->pipe_command_read_stream, response, '\0'))
-        throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
-    if (response != "O")
-        throw InternalError(PALUDIS_HERE, "got response '" + response + "'");
+    /* nothing waits for messages, so they can go in the background */
+    _imp->command("MESSAGE 1 " + stringify(t) + " " + s, false);
 }
 
 void
 IPCOutputManager::succeeded()
 {
-    *_imp->pipe_command_write_stream << "SUCCEEDED 1" << '\0' << std::flush;
-
-    std::string response;
-    if (! std::getline(*_imp->pipe_command_read_stream, response, '\0'))
-        throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
-    if (response != "O")
-        throw InternalError(PALUDIS_HERE, "got response '" + response + "'");
+    _imp->command("SUCCEEDED 1", true);
 }
 
 void
 IPCOutputManager::ignore_succeeded()
 {
-    *_imp->pipe_command_write_stream << "IGNORE_SUCCEEDED 1" << '\0' << std::flush;
-
-    std::string response;
-    if (! std::getline(*_imp->pipe_command_read_stream, response, '\0'))
-        throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
-    if (response != "O")
-        throw InternalError(PALUDIS_HERE, "got response '" + response + "'");
+    _imp->command("IGNORE_SUCCEEDED 1", true);
 }
 
 void
@@ -198,13 +341,7 @@ IPCOutputManager::want_to_flush() const
 void
 IPCOutputManager::nothing_more_to_come()
 {
-    *_imp->pipe_command_write_stream << "NOTHING_MORE_TO_COME 1" << '\0' << std::flush;
-
-    std::string response;
-    if (! std::getline(*_imp->pipe_command_read_stream, response, '\0'))
-        throw InternalError(PALUDIS_HERE, "couldn't get a pipe command response");
-    if (response != "O")
-        throw InternalError(PALUDIS_HERE, "got response '" + response + "'");
+    _imp->command("NOTHING_MORE_TO_COME 1", true);
 }
 
 namespace paludis
@@ -235,6 +372,13 @@ namespace paludis
                 throw InternalError(PALUDIS_HERE, "fcntl failed");
             if (0 != ::fcntl(stderr_pipe.read_fd(), F_SETFD, FD_CLOEXEC))
                 throw InternalError(PALUDIS_HERE, "fcntl failed");
+
+#ifdef F_SETPIPE_SZ
+            /* give chatty builds more room before they block on us. the
+             * kernel may refuse, in which case the default is fine. */
+            ::fcntl(stdout_pipe.write_fd(), F_SETPIPE_SZ, 1024 * 1024);
+            ::fcntl(stderr_pipe.write_fd(), F_SETPIPE_SZ, 1024 * 1024);
+#endif
         }
     };
 }
@@ -267,6 +411,46 @@ IPCInputManager::_pipe_command_handler(const std::string & s)
     Log::get_instance()->message("ipc_input_manager.pipe_command.called", ll_debug, lc_context)
         << "Pipe command called: '" << s << "'";
 
+    /* a batch holds several length prefixed commands, which might contain
+     * any amount of whitespace, so it can't be tokenised */
+    if (0 == s.compare(0, 8, "BATCH 1 "))
+    {
+        std::string result("O");
+        std::string::size_type p(8);
+        while (p < s.length())
+        {
+            std::string::size_type space(s.find(' ', p));
+            if (std::string::npos == space)
+                return "Ebad BATCH subcommand";
+
+            std::string::size_type length;
+            try
+            {
+                length = destringify<std::string::size_type>(s.substr(p, space - p));
+            }
+            catch (const DestringifyError &)
+            {
+                return "Ebad BATCH subcommand";
+            }
+
+            if (length > s.length() - space - 1)
+                return "Ebad BATCH subcommand";
+
+            std::string command(s.substr(space + 1, length));
+            p = space + 1 + length;
+
+            if (0 == command.compare(0, 5, "BATCH") || 0 == command.compare(0, 6, "CREATE"))
+                return "Ebad BATCH subcommand";
+
+            /* carry on after a failure, but report the first one */
+            std::string response(_pipe_command_handler(command));
+            if (response != "O" && result == "O")
+                result = response;
+        }
+
+        return result;
+    }
+
     std::vector<std::string> tokens;
     tokenise_whitespace(s, std::back_inserter(tokens));
 
@@ -279,6 +463,18 @@ IPCInputManager::_pipe_command_handler(const std::string & s)
             return "Ebad PING subcommand";
         return "OPONG " + tokens[2];
     }
+    else if (tokens[0] == "FEATURES")
+    {
+        /* reply with whichever of the requested features we support */
+        if (tokens.size() < 2 || tokens[1] != "1")
+            return "Ebad FEATURES subcommand";
+
+        std::string result("O");
+        for (auto t(next(tokens.begin(), 2)), t_end(tokens.end()) ; t != t_end ; ++t)
+            if (*t == "PIPELINE")
+                result.append(" " + *t);
+        return result;
+    }
     else if (tokens[0] == "CREATE")
     {
         if (tokens.size() != 3 || tokens[1] != "1")
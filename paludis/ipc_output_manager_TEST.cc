@@ -0,0 +1,219 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/ipc_output_manager.hh>
+#include <paludis/create_output_manager_info.hh>
+#include <paludis/name.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/util/pipe.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/options.hh>
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    struct RecordingOutputManager :
+        OutputManager
+    {
+        std::stringstream out, err;
+        std::vector<std::string> messages;
+        int succeeded_count = 0;
+        bool nothing_more = false;
+
+        std::ostream & stdout_stream() override
+        {
+            return out;
+        }
+
+        std::ostream & stderr_stream() override
+        {
+            return err;
+        }
+
+        void succeeded() override
+        {
+            ++succeeded_count;
+        }
+
+        void ignore_succeeded() override
+        {
+        }
+
+        void flush() override
+        {
+        }
+
+        bool want_to_flush() const override
+        {
+            return false;
+        }
+
+        void nothing_more_to_come() override
+        {
+            nothing_more = true;
+        }
+
+        void message(const MessageType t, const std::string & s) override
+        {
+            messages.push_back(stringify(t) + " " + s);
+        }
+    };
+
+    struct RecordingEnvironment :
+        TestEnvironment
+    {
+        const std::shared_ptr<OutputManager> create_output_manager(
+                const CreateOutputManagerInfo &) const override
+        {
+            return std::make_shared<RecordingOutputManager>();
+        }
+    };
+
+    /* does what Process does with a pipe command handler, remembering what
+     * it was sent */
+    void serve(const Pipe & commands, const Pipe & responses,
+            const std::function<std::string (const std::string &)> & handler,
+            std::vector<std::string> & seen)
+    {
+        std::string buffer;
+        while (true)
+        {
+            char buf[4096];
+            int n(::read(commands.read_fd(), buf, sizeof(buf)));
+            if (n <= 0)
+                return;
+            buffer.append(buf, n);
+
+            std::string::size_type p;
+            while (std::string::npos != ((p = buffer.find('\0'))))
+            {
+                std::string op(buffer.substr(0, p));
+                buffer.erase(0, p + 1);
+                seen.push_back(op);
+
+                std::string response(handler(op) + std::string(1, '\0'));
+                if (ssize_t(response.length()) != ::write(responses.write_fd(), response.data(), response.length()))
+                    return;
+
+                if (op.length() >= 10 && 0 == op.compare(op.length() - 10, 10, "FINISHED 1"))
+                    return;
+            }
+        }
+    }
+
+    std::shared_ptr<RecordingOutputManager> run(const bool old_peer, std::vector<std::string> & seen)
+    {
+        RecordingEnvironment env;
+        Pipe commands(true), responses(true);
+        std::shared_ptr<RecordingOutputManager> result;
+
+        {
+            IPCInputManager input_manager(&env, std::function<void (const std::shared_ptr<OutputManager> &)>());
+            auto handler(input_manager.pipe_command_handler());
+            std::function<std::string (const std::string &)> h(handler);
+            if (old_peer)
+                h = [&] (const std::string & s) -> std::string {
+                    if (0 == s.compare(0, 8, "FEATURES"))
+                        return "Eunknown pipe command";
+                    return handler(s);
+                };
+
+            std::thread server(std::bind(&serve, std::cref(commands), std::cref(responses), h, std::ref(seen)));
+
+            {
+                IPCOutputManager output_manager(responses.read_fd(), commands.write_fd(),
+                        CreateOutputManagerForRepositorySyncInfo(RepositoryName("repo"), oe_exclusive, ClientOutputFeatures()));
+
+                output_manager.stdout_stream() << "some output" << std::flush;
+                for (int i(0) ; i < 500 ; ++i)
+                    output_manager.message(mt_info, "message " + stringify(i));
+                output_manager.succeeded();
+                output_manager.message(mt_warn, "after succeeded");
+                output_manager.nothing_more_to_come();
+            }
+
+            server.join();
+            result = std::static_pointer_cast<RecordingOutputManager>(input_manager.underlying_output_manager_if_constructed());
+        }
+
+        return result;
+    }
+
+    void check(const std::shared_ptr<RecordingOutputManager> & m)
+    {
+        ASSERT_TRUE(bool(m));
+        EXPECT_EQ("some output", m->out.str());
+        ASSERT_EQ(501u, m->messages.size());
+        for (int i(0) ; i < 500 ; ++i)
+            EXPECT_EQ("info message " + stringify(i), m->messages[i]);
+        EXPECT_EQ("warn after succeeded", m->messages[500]);
+        EXPECT_EQ(1, m->succeeded_count);
+        EXPECT_TRUE(m->nothing_more);
+    }
+}
+
+TEST(IPCOutputManager, Pipelined)
+{
+    std::vector<std::string> seen;
+    check(run(false, seen));
+
+    /* messages sent whilst waiting for an acknowledgement should have been
+     * coalesced */
+    EXPECT_LT(seen.size(), 500u);
+    EXPECT_TRUE(seen.end() != std::find_if(seen.begin(), seen.end(), [] (const std::string & s) {
+                return 0 == s.compare(0, 8, "BATCH 1 "); }));
+}
+
+TEST(IPCOutputManager, OldPeer)
+{
+    std::vector<std::string> seen;
+    check(run(true, seen));
+
+    EXPECT_TRUE(seen.end() == std::find_if(seen.begin(), seen.end(), [] (const std::string & s) {
+                return 0 == s.compare(0, 5, "BATCH"); }));
+    EXPECT_GT(seen.size(), 500u);
+}
+
+TEST(IPCInputManager, BadBatch)
+{
+    TestEnvironment env;
+    IPCInputManager input_manager(&env, std::function<void (const std::shared_ptr<OutputManager> &)>());
+    auto handler(input_manager.pipe_command_handler());
+
+    EXPECT_EQ("Ebad BATCH subcommand", handler("BATCH 1 x"));
+    EXPECT_EQ("Ebad BATCH subcommand", handler("BATCH 1 100 PING 1 GOAT"));
+    EXPECT_EQ("Ebad BATCH subcommand", handler("BATCH 1 11 BATCH 1 1 x"));
+    EXPECT_EQ("Eunknown pipe command", handler("BATCH 1 3 FOO"));
+    EXPECT_EQ("O", handler("BATCH 1 "));
+    EXPECT_EQ("O PIPELINE", handler("FEATURES 1 PIPELINE MONKEYS"));
+    EXPECT_EQ("O", handler("FEATURES 1 MONKEYS"));
+}
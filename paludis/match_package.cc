@@ -37,6 +37,7 @@
 #include <paludis/util/sequence.hh>
 #include <paludis/util/indirect_iterator-impl.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/profiler.hh>
 
 #include <functional>
 #include <algorithm>
@@ -102,6 +103,8 @@ paludis::match_package_with_maybe_changes(
         const ChangedChoices * const maybe_changes_to_target,
         const MatchPackageOptions & options)
 {
+    Profiler::count("match_package", [&] { return stringify(id->repository_name()); });
+
     if (spec.package_ptr() && *spec.package_ptr() != id->name())
         return false;
 
@@ -25,12 +25,23 @@
 #include <paludis/util/timestamp.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
+#include <paludis/util/thread_pool.hh>
+#include <paludis/util/save.hh>
 #include <paludis/selinux/security_context.hh>
 #include <paludis/environment.hh>
 #include <paludis/hook.hh>
+#include <paludis/buffer_output_manager.hh>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
 #include <set>
+#include <thread>
+#include <vector>
 #include <istream>
 #include <ostream>
+#include <sstream>
 
 using namespace paludis;
 
@@ -50,6 +61,9 @@ namespace paludis
 
         std::set<FSPath, FSPathComparator> fixed_entries;
 
+        /* only populated for the duration of a mo_parallel_scan check */
+        std::map<FSPath, EntryType, FSPathComparator> scanned_entry_types;
+
         Imp(const MergerParams & p) :
             params(p),
             result(true),
@@ -61,6 +75,95 @@ namespace paludis
 
 #include <paludis/merger-se.cc>
 
+namespace
+{
+    typedef std::map<FSPath, EntryType, FSPathComparator> ScannedEntryTypes;
+
+    typedef std::function<EntryType (const FSPath &)> EntryTypeFunction;
+
+    void scan_subtree(const EntryTypeFunction & entry_type, const FSPath & src, const FSPath & dst_dir, ScannedEntryTypes & result)
+    {
+        const FSPath dst(dst_dir / src.basename());
+        EntryType src_type(entry_type(src));
+        result.insert(std::make_pair(src, src_type));
+        result.insert(std::make_pair(dst, entry_type(dst)));
+
+        if (et_dir == src_type)
+            for (FSIterator d(src, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
+                scan_subtree(entry_type, *d, dst, result);
+    }
+
+    void scan_worker(const EntryTypeFunction & entry_type, std::mutex & mutex, std::vector<FSPath>::const_iterator & i,
+            const std::vector<FSPath>::const_iterator & i_end, const FSPath & dst, ScannedEntryTypes & result) noexcept
+    {
+        ScannedEntryTypes local;
+
+        while (true)
+        {
+            FSPath src("/");
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (i == i_end)
+                    break;
+                src = *i++;
+            }
+
+            try
+            {
+                scan_subtree(entry_type, src, dst, local);
+            }
+            catch (const Exception &)
+            {
+                /* the serial pass will stat anything we missed, and report it properly */
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        result.insert(local.begin(), local.end());
+    }
+
+    struct MergeSubtree
+    {
+        const Merger * const merger;
+        const FSPath src;
+        const std::shared_ptr<BufferOutputManager> output_manager;
+        std::vector<std::pair<std::ostream *, std::shared_ptr<std::ostringstream> > > streams;
+        bool skip_dir;
+        bool done;
+        std::exception_ptr exception;
+
+        MergeSubtree(const Merger * const m, const FSPath & s, const std::shared_ptr<OutputManager> & o) :
+            merger(m),
+            src(s),
+            output_manager(std::make_shared<BufferOutputManager>(o)),
+            skip_dir(false),
+            done(false)
+        {
+        }
+
+        void flush()
+        {
+            output_manager->flush();
+            for (auto & s : streams)
+                *s.first << s.second->str() << std::flush;
+        }
+    };
+
+    /* the subtree this thread is merging, if we're in a parallel merge */
+    thread_local MergeSubtree * current_merge_subtree(nullptr);
+
+    MergeSubtree * merge_subtree_for(const Merger * const m)
+    {
+        return (current_merge_subtree && current_merge_subtree->merger == m) ? current_merge_subtree : nullptr;
+    }
+
+    bool & skip_dir_for(const Merger * const m, bool & serial_skip_dir)
+    {
+        MergeSubtree * const subtree(merge_subtree_for(m));
+        return subtree ? subtree->skip_dir : serial_skip_dir;
+    }
+}
+
 Merger::Merger(const MergerParams & p) :
     _imp(p)
 {
@@ -87,7 +190,15 @@ Merger::check()
                 _imp->params.maybe_output_manager()).max_exit_status())
         make_check_fail();
 
-    do_dir_recursive(true, _imp->params.image(), _imp->params.root() / _imp->params.install_under());
+    {
+        /* the scan results are only good for this check, even if it throws */
+        Save<ScannedEntryTypes> save_scanned_entry_types(&_imp->scanned_entry_types);
+
+        if (_imp->params.options()[mo_parallel_scan])
+            scan_in_parallel(_imp->params.image(), _imp->params.root() / _imp->params.install_under());
+
+        do_dir_recursive(true, _imp->params.image(), _imp->params.root() / _imp->params.install_under());
+    }
 
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
                          Hook("merger_check_post")
@@ -118,7 +229,12 @@ Merger::merge()
     if (! _imp->params.no_chown())
         do_ownership_fixes_recursive(_imp->params.image());
 
-    do_dir_recursive(false, _imp->params.image(), canonicalise_root_path(_imp->params.root() / _imp->params.install_under()));
+    const FSPath dst(canonicalise_root_path(_imp->params.root() / _imp->params.install_under()));
+    if (_imp->params.options()[mo_parallel_merge] && _imp->params.maybe_output_manager()
+            && can_merge_in_parallel(_imp->params.image(), dst))
+        merge_in_parallel(_imp->params.image(), dst);
+    else
+        do_dir_recursive(false, _imp->params.image(), dst);
     on_done_merge();
 
     if (0 != _imp->params.environment()->perform_hook(extend_hook(
@@ -137,6 +253,146 @@ Merger::make_check_fail()
     _imp->result = false;
 }
 
+void
+Merger::scan_in_parallel(const FSPath & src, const FSPath & dst)
+{
+    Context context("When scanning '" + stringify(src) + "' to '" + stringify(dst) + "' in parallel:");
+
+    std::vector<FSPath> subtrees;
+    for (FSIterator d(src, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
+        subtrees.push_back(*d);
+
+    unsigned n_threads(std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), subtrees.size()));
+
+    /* entry_type only consults scanned_entry_types, which we leave alone
+     * until the workers are done, so it is safe to call from them */
+    const EntryTypeFunction entry_type_function(std::bind(&Merger::entry_type, this, std::placeholders::_1));
+
+    std::mutex mutex;
+    ScannedEntryTypes scanned;
+    std::vector<FSPath>::const_iterator i(subtrees.begin()), i_end(subtrees.end());
+    {
+        ThreadPool pool;
+        for (unsigned n(0) ; n != n_threads ; ++n)
+            pool.create_thread(std::bind(&scan_worker, std::cref(entry_type_function), std::ref(mutex), std::ref(i),
+                        std::cref(i_end), std::cref(dst), std::ref(scanned)));
+    }
+    _imp->scanned_entry_types.insert(scanned.begin(), scanned.end());
+
+    Log::get_instance()->message("merger.parallel_scan.done", ll_debug, lc_context) << "Scanned "
+        << _imp->scanned_entry_types.size() << " entries in " << subtrees.size() << " subtrees using " << n_threads << " threads";
+}
+
+bool
+Merger::can_merge_in_parallel(const FSPath &, const FSPath &)
+{
+    return false;
+}
+
+void
+Merger::merge_in_parallel(const FSPath & src, const FSPath & dst)
+{
+    Context context("When performing merge from '" + stringify(src) + "' to '" + stringify(dst) + "' in parallel:");
+
+    if (! src.stat().is_directory())
+        throw MergerError("Source directory '" + stringify(src) + "' is not a directory");
+
+    on_enter_dir(false, src);
+
+    std::vector<MergeSubtree> subtrees;
+    for (FSIterator d(src, { fsio_include_dotfiles, fsio_inode_sort }), d_end ; d != d_end ; ++d)
+        subtrees.emplace_back(this, *d, _imp->params.maybe_output_manager());
+
+    unsigned n_threads(std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), subtrees.size()));
+
+    /* each subtree's output is passed on once every subtree before it is
+     * done, so it comes out in the same order as for a serial merge. once
+     * something fails we start no more subtrees, but let those already
+     * running finish so that what they did gets recorded. */
+    std::mutex mutex;
+    std::size_t next(0), next_to_flush(0);
+    bool failed(false);
+
+    {
+        ThreadPool pool;
+        for (unsigned n(0) ; n != n_threads ; ++n)
+            pool.create_thread([&] () noexcept {
+                    Context worker_context("When performing merge from '" + stringify(src) + "' to '" + stringify(dst) + "' in parallel:");
+
+                    while (true)
+                    {
+                        MergeSubtree * subtree;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            if (failed || next == subtrees.size())
+                                break;
+                            subtree = &subtrees[next++];
+                        }
+
+                        current_merge_subtree = subtree;
+                        try
+                        {
+                            do_entry(false, subtree->src, dst);
+                        }
+                        catch (...)
+                        {
+                            subtree->exception = std::current_exception();
+                        }
+                        current_merge_subtree = nullptr;
+
+                        std::unique_lock<std::mutex> lock(mutex);
+                        subtree->done = true;
+                        if (subtree->exception)
+                            failed = true;
+                        for ( ; next_to_flush != subtrees.size() && subtrees[next_to_flush].done ; ++next_to_flush)
+                        {
+                            try
+                            {
+                                subtrees[next_to_flush].flush();
+                            }
+                            catch (...)
+                            {
+                                if (! subtrees[next_to_flush].exception)
+                                    subtrees[next_to_flush].exception = std::current_exception();
+                                failed = true;
+                            }
+                        }
+                    }
+                });
+    }
+
+    for (auto & subtree : subtrees)
+        if (subtree.exception)
+            std::rethrow_exception(subtree.exception);
+
+    on_leave_dir(false, src);
+
+    Log::get_instance()->message("merger.parallel_merge.done", ll_debug, lc_context) << "Merged "
+        << subtrees.size() << " subtrees using " << n_threads << " threads";
+}
+
+const std::shared_ptr<OutputManager>
+Merger::merge_output_manager() const
+{
+    MergeSubtree * const subtree(merge_subtree_for(this));
+    return subtree ? subtree->output_manager : _imp->params.maybe_output_manager();
+}
+
+std::ostream &
+Merger::ordered_stream(std::ostream & s) const
+{
+    MergeSubtree * const subtree(merge_subtree_for(this));
+    if (! subtree)
+        return s;
+
+    for (auto & b : subtree->streams)
+        if (b.first == &s)
+            return *b.second;
+
+    subtree->streams.push_back(std::make_pair(&s, std::make_shared<std::ostringstream>()));
+    return *subtree->streams.back().second;
+}
+
 void
 Merger::do_dir_recursive(bool is_check, const FSPath & src, const FSPath & dst)
 {
@@ -163,43 +419,48 @@ Merger::do_dir_recursive(bool is_check, const FSPath & src, const FSPath & dst)
     }
 
     for ( ; d != d_end ; ++d)
-    {
-        EntryType m(entry_type(*d));
-        switch (m)
-        {
-            case et_sym:
-                on_sym(is_check, *d, dst);
-                continue;
+        do_entry(is_check, *d, dst);
 
-            case et_file:
-                on_file(is_check, *d, dst);
-                continue;
+    on_leave_dir(is_check, src);
+}
 
-            case et_dir:
-                on_dir(is_check, *d, dst);
-                if (_imp->result)
-                {
-                    if (! _imp->skip_dir)
-                        do_dir_recursive(is_check, *d,
-                                is_check ? (dst / d->basename()) : canonicalise_root_path(dst / d->basename()));
-                    else
-                        _imp->skip_dir = false;
-                }
-                continue;
+void
+Merger::do_entry(bool is_check, const FSPath & src, const FSPath & dst)
+{
+    EntryType m(entry_type(src));
+    switch (m)
+    {
+        case et_sym:
+            on_sym(is_check, src, dst);
+            return;
 
-            case et_misc:
-                on_misc(is_check, *d, dst);
-                continue;
+        case et_file:
+            on_file(is_check, src, dst);
+            return;
 
-            case et_nothing:
-            case last_et:
-                ;
-        }
+        case et_dir:
+            on_dir(is_check, src, dst);
+            if (_imp->result)
+            {
+                bool & skip_dir(skip_dir_for(this, _imp->skip_dir));
+                if (! skip_dir)
+                    do_dir_recursive(is_check, src,
+                            is_check ? (dst / src.basename()) : canonicalise_root_path(dst / src.basename()));
+                else
+                    skip_dir = false;
+            }
+            return;
 
-        throw InternalError(PALUDIS_HERE, "Unexpected entry_type '" + stringify(m) + "'");
+        case et_misc:
+            on_misc(is_check, src, dst);
+            return;
+
+        case et_nothing:
+        case last_et:
+            ;
     }
 
-    on_leave_dir(is_check, src);
+    throw InternalError(PALUDIS_HERE, "Unexpected entry_type '" + stringify(m) + "'");
 }
 
 void
@@ -217,6 +478,10 @@ Merger::entry_type(const FSPath & f)
 {
     Context context("When checking type of '" + stringify(f) + "':");
 
+    auto s(_imp->scanned_entry_types.find(f));
+    if (s != _imp->scanned_entry_types.end())
+        return s->second;
+
     FSStat f_stat(f);
 
     if (! f_stat.exists())
@@ -260,7 +525,7 @@ Merger::on_file(bool is_check, const FSPath & src, const FSPath & dst)
                         ("INSTALL_SOURCE", stringify(src))
                         ("INSTALL_DESTINATION", stringify(staged))
                         .grab_output(Hook::AllowedOutputValues()("skip"))),
-                    _imp->params.maybe_output_manager()));
+                    merge_output_manager()));
 
         if (hr.max_exit_status() != 0)
             Log::get_instance()->message("merger.file.skip_hooks.failure", ll_warning, lc_context) << "Merge of '"
@@ -309,7 +574,7 @@ Merger::on_dir(bool is_check, const FSPath & src, const FSPath & dst)
                         ("INSTALL_SOURCE", stringify(src))
                         ("INSTALL_DESTINATION", stringify(staged))
                         .grab_output(Hook::AllowedOutputValues()("skip"))),
-                    _imp->params.maybe_output_manager()));
+                    merge_output_manager()));
 
         if (hr.max_exit_status() != 0)
             Log::get_instance()->message("merger.dir.skip_hooks.failure", ll_warning, lc_context) << "Merge of '"
@@ -318,7 +583,7 @@ Merger::on_dir(bool is_check, const FSPath & src, const FSPath & dst)
         {
             std::string tidy(stringify(staged.strip_leading(_imp->params.root().realpath())));
             display_override("--- [skp] " + tidy);
-            _imp->skip_dir = true;
+            skip_dir_for(this, _imp->skip_dir) = true;
             return;
         }
     }
@@ -360,7 +625,7 @@ Merger::on_sym(bool is_check, const FSPath & src, const FSPath & dst)
                         ("INSTALL_SOURCE", stringify(src))
                         ("INSTALL_DESTINATION", stringify(staged))
                         .grab_output(Hook::AllowedOutputValues()("skip"))),
-                    _imp->params.maybe_output_manager()));
+                    merge_output_manager()));
 
         if (hr.max_exit_status() != 0)
             Log::get_instance()->message("merger.sym.skip_hooks.failure", ll_warning, lc_context) << "Merge of '"
@@ -413,7 +678,7 @@ Merger::symlink_needs_rewriting(const FSPath & sym)
 void
 Merger::set_skipped_dir(const bool value)
 {
-    _imp->skip_dir = value;
+    skip_dir_for(this, _imp->skip_dir) = value;
 }
 
 void
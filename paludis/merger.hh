@@ -29,6 +29,7 @@
 #include <paludis/environment-fwd.hh>
 #include <paludis/merger_entry_type.hh>
 #include <paludis/output_manager-fwd.hh>
+#include <iosfwd>
 
 namespace paludis
 {
@@ -85,6 +86,8 @@ namespace paludis
         private:
             Pimp<Merger> _imp;
 
+            void do_entry(bool is_check, const FSPath &, const FSPath &);
+
         protected:
             bool symlink_needs_rewriting(const FSPath &);
             void rewrite_symlink_as_needed(const FSPath &, const FSPath &);
@@ -102,6 +105,52 @@ namespace paludis
              */
             void make_check_fail();
 
+            /**
+             * Determine the entry types of everything the check pass will
+             * look at, fanning out across top-level subtrees of the image.
+             * The check pass then uses these rather than doing its own
+             * stats. Used if mo_parallel_scan is set.
+             *
+             * \since 3.0
+             */
+            void scan_in_parallel(const FSPath & src, const FSPath & dst);
+
+            /**
+             * Whether the merge pass from src to dst may be split across
+             * top-level subtrees of the image. Used if mo_parallel_merge is
+             * set. By default, never.
+             *
+             * \since 3.0
+             */
+            virtual bool can_merge_in_parallel(const FSPath & src, const FSPath & dst);
+
+            /**
+             * Perform the merge pass, handling each top-level subtree of the
+             * image on its own thread. Anything written via
+             * merge_output_manager() or ordered_stream() is buffered per
+             * subtree, and passed on in the order a serial merge would have
+             * written it.
+             *
+             * \since 3.0
+             */
+            void merge_in_parallel(const FSPath & src, const FSPath & dst);
+
+            /**
+             * The output manager to use for anything written during the
+             * merge pass, rather than maybe_output_manager.
+             *
+             * \since 3.0
+             */
+            const std::shared_ptr<OutputManager> merge_output_manager() const;
+
+            /**
+             * The stream to use in place of s for records, such as CONTENTS,
+             * whose order must not depend upon whether we merged in parallel.
+             *
+             * \since 3.0
+             */
+            std::ostream & ordered_stream(std::ostream & s) const;
+
             /**
              * Handle a directory, recursively.
              */
@@ -55,6 +55,12 @@ MetadataValueKey<T_>::~MetadataValueKey()
 
 MetadataSpecTreeKey<FetchableURISpecTree>::~MetadataSpecTreeKey() = default;
 
+const std::shared_ptr<const std::string>
+MetadataSpecTreeKey<FetchableURISpecTree>::unparsed_value() const
+{
+    return nullptr;
+}
+
 MetadataSpecTreeKey<DependencySpecTree>::~MetadataSpecTreeKey() = default;
 
 namespace paludis
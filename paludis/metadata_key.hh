@@ -350,6 +350,20 @@ namespace paludis
              */
             virtual const std::shared_ptr<const URILabel> initial_label() const
                 PALUDIS_ATTRIBUTE((warn_unused_result)) = 0;
+
+            /**
+             * Return our value as it was before parsing, if we have it, or
+             * null otherwise.
+             *
+             * If an ID's key has the same unparsed value as before, its
+             * parsed value is the same too, so callers can use this to tell
+             * whether something they worked out from an earlier parse, perhaps
+             * in an earlier run, still holds.
+             *
+             * \since 3.0
+             */
+            virtual const std::shared_ptr<const std::string> unparsed_value() const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
     };
 
     /**
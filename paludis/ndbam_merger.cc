@@ -181,15 +181,16 @@ NDBAMMerger::record_install_file(const FSPath & src, const FSPath & dst_dir, con
     if (_imp->params.parts())
         part = _imp->params.parts()->classify(FSPath(tidy)).value();
 
-    *_imp->contents_file << "type=file";
-    *_imp->contents_file << " path=" << escape(tidy_real);
-    *_imp->contents_file << " md5=" << md5.hexsum();
-    *_imp->contents_file << " mtime=" << timestamp;
+    std::ostream & contents(ordered_stream(*_imp->contents_file));
+    contents << "type=file";
+    contents << " path=" << escape(tidy_real);
+    contents << " md5=" << md5.hexsum();
+    contents << " mtime=" << timestamp;
     if (!part.empty())
-        *_imp->contents_file << " part=" << part;
+        contents << " part=" << part;
     if (_imp->params.is_volatile()(FSPath(tidy)))
-        *_imp->contents_file << " volatile=true";
-    *_imp->contents_file << std::endl;
+        contents << " volatile=true";
+    contents << std::endl;
 }
 
 void
@@ -200,7 +201,7 @@ NDBAMMerger::record_install_dir(const FSPath & src, const FSPath & dst_dir, cons
 
     display_merge(et_dir, dir, flags);
 
-    *_imp->contents_file << "type=dir path=" << escape(tidy) << std::endl;
+    ordered_stream(*_imp->contents_file) << "type=dir path=" << escape(tidy) << std::endl;
 }
 
 void
@@ -210,7 +211,7 @@ NDBAMMerger::record_install_under_dir(const FSPath & dst, const FSMergerStatusFl
 
     display_merge(et_dir, dst, flags);
 
-    *_imp->contents_file << "type=dir path=" << escape(tidy) << std::endl;
+    ordered_stream(*_imp->contents_file) << "type=dir path=" << escape(tidy) << std::endl;
 }
 
 void
@@ -223,12 +224,13 @@ NDBAMMerger::record_install_sym(const FSPath & src, const FSPath & dst_dir, cons
 
     display_merge(et_sym, sym, flags);
 
-    *_imp->contents_file << "type=sym path=" << escape(tidy);
-    *_imp->contents_file << " target=" << escape(target);
-    *_imp->contents_file << " mtime=" << timestamp.seconds();
+    std::ostream & contents(ordered_stream(*_imp->contents_file));
+    contents << "type=sym path=" << escape(tidy);
+    contents << " target=" << escape(target);
+    contents << " mtime=" << timestamp.seconds();
     if (_imp->params.is_volatile()(FSPath(tidy)))
-        *_imp->contents_file << " volatile=true";
-    *_imp->contents_file << std::endl;
+        contents << " volatile=true";
+    contents << std::endl;
 }
 
 void
@@ -341,6 +343,6 @@ NDBAMMerger::on_enter_dir(bool is_check, const FSPath src)
 void
 NDBAMMerger::display_override(const std::string & message) const
 {
-    _imp->params.output_manager()->stdout_stream() << message << std::endl;
+    merge_output_manager()->stdout_stream() << message << std::endl;
 }
 
@@ -0,0 +1,134 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/package_id_stream.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/generator.hh>
+#include <paludis/filter.hh>
+#include <paludis/package_id.hh>
+#include <paludis/name.hh>
+#include <paludis/repository.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/wrapped_output_iterator.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/exception.hh>
+#include <algorithm>
+
+using namespace paludis;
+
+namespace paludis
+{
+    template <>
+    struct Imp<PackageIDStream>
+    {
+        const Environment * const env;
+        const FilteredGenerator fg;
+        const RepositoryContentMayExcludes may_excludes;
+
+        bool started;
+        std::shared_ptr<const RepositoryNameSet> repositories;
+        std::shared_ptr<const QualifiedPackageNameSet> packages;
+        QualifiedPackageNameSet::ConstIterator next_package;
+
+        std::shared_ptr<const PackageIDSequence> current;
+        PackageIDSequence::ConstIterator next_id;
+
+        Imp(const Environment * const e, const FilteredGenerator & f) :
+            env(e),
+            fg(f),
+            may_excludes(f.filter().may_excludes()),
+            started(false)
+        {
+        }
+
+        /* only names are worked out here, no IDs */
+        void start()
+        {
+            std::shared_ptr<const RepositoryNameSet> r(fg.filter().repositories(env, fg.generator().repositories(env, may_excludes)));
+            std::shared_ptr<const QualifiedPackageNameSet> p(std::make_shared<QualifiedPackageNameSet>());
+            if (! r->empty())
+            {
+                std::shared_ptr<const CategoryNamePartSet> c(fg.filter().categories(env, r, fg.generator().categories(env, r, may_excludes)));
+                if (! c->empty())
+                    p = fg.filter().packages(env, r, fg.generator().packages(env, r, c, may_excludes));
+            }
+
+            repositories = r;
+            packages = p;
+            next_package = packages->begin();
+            started = true;
+        }
+    };
+}
+
+PackageIDStream::PackageIDStream(const Environment * const e, const FilteredGenerator & f) :
+    _imp(e, f)
+{
+}
+
+PackageIDStream::~PackageIDStream() = default;
+
+std::shared_ptr<const PackageIDSequence>
+PackageIDStream::next_package()
+{
+    Context context("When finding the next package from " + stringify(_imp->fg) + ":");
+
+    if (! _imp->started)
+        _imp->start();
+
+    while (_imp->next_package != _imp->packages->end())
+    {
+        std::shared_ptr<QualifiedPackageNameSet> s(std::make_shared<QualifiedPackageNameSet>());
+        s->insert(*_imp->next_package++);
+
+        std::shared_ptr<const PackageIDSet> i(_imp->fg.filter().ids(_imp->env,
+                    _imp->fg.generator().ids(_imp->env, _imp->repositories, s, _imp->may_excludes)));
+        if (i->empty())
+            continue;
+
+        std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
+        std::copy(i->begin(), i->end(), result->back_inserter());
+        result->sort(PackageIDComparator(_imp->env));
+        return result;
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<const PackageID>
+PackageIDStream::next()
+{
+    if ((! _imp->current) || _imp->next_id == _imp->current->end())
+    {
+        _imp->current = next_package();
+        if (! _imp->current)
+            return nullptr;
+        _imp->next_id = _imp->current->begin();
+    }
+
+    return *_imp->next_id++;
+}
+
+namespace paludis
+{
+    template class Pimp<PackageIDStream>;
+}
@@ -0,0 +1,88 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_PACKAGE_ID_STREAM_HH
+#define PALUDIS_GUARD_PALUDIS_PACKAGE_ID_STREAM_HH 1
+
+#include <paludis/package_id_stream-fwd.hh>
+#include <paludis/filtered_generator-fwd.hh>
+#include <paludis/environment-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <memory>
+
+/** \file
+ * Declarations for the PackageIDStream class.
+ *
+ * \ingroup g_selections
+ */
+
+namespace paludis
+{
+    /**
+     * Pulls the PackageID instances matching a FilteredGenerator one package
+     * at a time, rather than finding every one of them up front as
+     * Environment::operator[] does.
+     *
+     * Only the names of the candidate packages are kept for the whole of the
+     * stream's life, so memory use doesn't grow with the number of IDs in the
+     * tree, and a caller that stops pulling early never has the remaining IDs
+     * loaded at all.
+     *
+     * \ingroup g_selections
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE PackageIDStream
+    {
+        private:
+            Pimp<PackageIDStream> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            PackageIDStream(const Environment * const, const FilteredGenerator &);
+            ~PackageIDStream();
+
+            PackageIDStream(const PackageIDStream &) = delete;
+            PackageIDStream & operator= (const PackageIDStream &) = delete;
+
+            ///\}
+
+            /**
+             * Return the matching IDs for the next package that has any,
+             * sorted as for selection::AllVersionsSorted, or null if there
+             * are no more.
+             */
+            std::shared_ptr<const PackageIDSequence> next_package() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Return the next matching ID, or null if there are no more.
+             *
+             * Packages are visited in name order, so the IDs come out in the
+             * same order as for selection::AllVersionsSorted.
+             */
+            std::shared_ptr<const PackageID> next() PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
+    extern template class Pimp<PackageIDStream>;
+}
+
+#endif
@@ -0,0 +1,116 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/package_id_stream.hh>
+#include <paludis/selection.hh>
+#include <paludis/generator.hh>
+#include <paludis/filter.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/package_id.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/indirect_iterator-impl.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/stringify.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    struct PackageIDStreamTest :
+        testing::Test
+    {
+        TestEnvironment env;
+
+        void SetUp() override
+        {
+            std::shared_ptr<FakeRepository> r1(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                            n::environment() = &env,
+                            n::name() = RepositoryName("repo1"))));
+            r1->add_version("cat", "one", "1");
+            r1->add_version("cat", "two", "2");
+            r1->add_version("cat", "two", "1");
+            r1->add_version("dog", "three", "1");
+            env.add_repository(11, r1);
+
+            std::shared_ptr<FakeRepository> r2(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                            n::environment() = &env,
+                            n::name() = RepositoryName("repo2"))));
+            r2->add_version("cat", "two", "3");
+            r2->add_version("dog", "four", "1");
+            env.add_repository(10, r2);
+        }
+
+        std::string all_of(PackageIDStream & stream)
+        {
+            std::string result;
+            while (auto id = stream.next())
+                result.append((result.empty() ? "" : " ") + stringify(*id));
+            return result;
+        }
+    };
+}
+
+TEST_F(PackageIDStreamTest, SameAsAllVersionsSorted)
+{
+    PackageIDStream stream(&env, generator::All());
+    EXPECT_EQ("cat/one-1:0::repo1 cat/two-1:0::repo1 cat/two-2:0::repo1 cat/two-3:0::repo2 "
+            "dog/four-1:0::repo2 dog/three-1:0::repo1", all_of(stream));
+    EXPECT_FALSE(stream.next());
+
+    PackageIDStream again(&env, generator::All());
+    auto ids(env[selection::AllVersionsSorted(generator::All())]);
+    EXPECT_EQ(join(indirect_iterator(ids->begin()), indirect_iterator(ids->end()), " "), all_of(again));
+}
+
+TEST_F(PackageIDStreamTest, ByPackage)
+{
+    PackageIDStream stream(&env, generator::All() | filter::All());
+
+    auto p1(stream.next_package());
+    ASSERT_TRUE(bool(p1));
+    EXPECT_EQ("cat/one-1:0::repo1", join(indirect_iterator(p1->begin()), indirect_iterator(p1->end()), " "));
+
+    auto p2(stream.next_package());
+    ASSERT_TRUE(bool(p2));
+    EXPECT_EQ("cat/two-1:0::repo1 cat/two-2:0::repo1 cat/two-3:0::repo2", join(indirect_iterator(p2->begin()), indirect_iterator(p2->end()), " "));
+
+    EXPECT_TRUE(bool(stream.next_package()));
+    EXPECT_TRUE(bool(stream.next_package()));
+    EXPECT_FALSE(stream.next_package());
+}
+
+TEST_F(PackageIDStreamTest, Filtered)
+{
+    PackageIDStream stream(&env, generator::InRepository(RepositoryName("repo2")));
+    EXPECT_EQ("cat/two-3:0::repo2 dog/four-1:0::repo2", all_of(stream));
+
+    PackageIDStream nothing(&env, generator::Package(QualifiedPackageName("cat/missing")));
+    EXPECT_FALSE(nothing.next_package());
+    EXPECT_FALSE(nothing.next());
+}
@@ -0,0 +1,452 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/distfile_digester.hh>
+#include <paludis/repositories/e/memoised_hashes.hh>
+
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/thread_pool.hh>
+#include <paludis/util/digest_registry.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <list>
+#include <mutex>
+#include <streambuf>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    /* one read of the destination is shared out in chunks this big, with at
+     * most this many waiting for any one algorithm */
+    const std::string::size_type chunk_size(1024 * 1024);
+    const std::deque<int>::size_type chunks_queued_limit(4);
+
+    off_t size_of(const FSPath & f)
+    {
+        struct stat s;
+        if (0 != ::stat(stringify(f).c_str(), &s))
+            return 0;
+        return s.st_size;
+    }
+
+    bool unchanged(const struct stat & a, const struct stat & b)
+    {
+        return a.st_dev == b.st_dev && a.st_ino == b.st_ino && a.st_size == b.st_size &&
+            a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec &&
+            a.st_ctim.tv_sec == b.st_ctim.tv_sec && a.st_ctim.tv_nsec == b.st_ctim.tv_nsec;
+    }
+
+    struct Consumer
+    {
+        std::string algo;
+        DigestRegistry::Function digest;
+
+        std::deque<std::shared_ptr<std::string> > queue;
+        bool gone;
+
+        std::string hexsum;
+        bool ok;
+
+        Consumer(const std::string & a, const DigestRegistry::Function & d) :
+            algo(a),
+            digest(d),
+            gone(false),
+            ok(false)
+        {
+        }
+    };
+
+    struct Chunks
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool done;
+
+        Chunks() :
+            done(false)
+        {
+        }
+    };
+
+    /* Hands an algorithm the chunks that the reader shares out. */
+    class ChunkStreamBuf :
+        public std::streambuf
+    {
+        private:
+            Chunks & _chunks;
+            Consumer & _consumer;
+            std::shared_ptr<std::string> _current;
+
+        public:
+            ChunkStreamBuf(Chunks & c, Consumer & u) :
+                _chunks(c),
+                _consumer(u)
+            {
+            }
+
+        protected:
+            int_type underflow() override
+            {
+                std::unique_lock<std::mutex> lock(_chunks.mutex);
+                _chunks.condition.wait(lock, [&] () { return _chunks.done || ! _consumer.queue.empty(); });
+                if (_consumer.queue.empty())
+                    return traits_type::eof();
+
+                _current = _consumer.queue.front();
+                _consumer.queue.pop_front();
+                _chunks.condition.notify_all();
+                lock.unlock();
+
+                setg(&(*_current)[0], &(*_current)[0], &(*_current)[0] + _current->size());
+                return traits_type::to_int_type(*gptr());
+            }
+    };
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<DistfileDigester>
+    {
+        const FSPath destination;
+        const FSPath partial;
+        const off_t expected_size;
+        const std::function<void ()> oversize;
+        std::list<Consumer> consumers;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool fetch_done;
+        std::atomic<bool> oversized;
+        bool digested;
+
+        std::unique_ptr<ThreadPool> pool;
+
+        Imp(const FSPath & d, const off_t s, const std::function<void ()> & o) :
+            destination(d),
+            partial(d.dirname() / (d.basename() + ".-PARTIAL-")),
+            expected_size(s),
+            oversize(o),
+            fetch_done(false),
+            oversized(false),
+            digested(false),
+            pool(new ThreadPool)
+        {
+        }
+
+        void stop_watching()
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                fetch_done = true;
+            }
+            condition.notify_all();
+            pool.reset();
+        }
+
+        bool share_out(const int fd, const int copy_fd, off_t & total);
+        void remember();
+        void digest_destination();
+    };
+}
+
+/* Reads fd in chunks, handing each chunk to every algorithm and, if copy_fd
+ * is not -1, writing it there too. Stops as soon as more than the expected
+ * size has been read. */
+bool
+Imp<DistfileDigester>::share_out(const int fd, const int copy_fd, off_t & total)
+{
+    Chunks chunks;
+    bool read_failed(false);
+
+    ThreadPool digesters;
+    for (auto & c : consumers)
+    {
+        Consumer * const consumer(&c);
+        consumer->gone = false;
+        consumer->ok = false;
+        digesters.create_thread([&chunks, consumer] () noexcept {
+                {
+                    ChunkStreamBuf buf(chunks, *consumer);
+                    std::istream stream(&buf);
+                    try
+                    {
+                        consumer->hexsum = consumer->digest(stream);
+                        consumer->ok = true;
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(chunks.mutex);
+                consumer->gone = true;
+                consumer->queue.clear();
+                chunks.condition.notify_all();
+                });
+    }
+
+    try
+    {
+        while (true)
+        {
+            std::shared_ptr<std::string> chunk(std::make_shared<std::string>(chunk_size, '\0'));
+            ssize_t n(::read(fd, &(*chunk)[0], chunk_size));
+            if (-1 == n && EINTR == errno)
+                continue;
+            else if (-1 == n)
+            {
+                read_failed = true;
+                break;
+            }
+            else if (0 == n)
+                break;
+
+            chunk->resize(n);
+            total += n;
+            if (total > expected_size)
+            {
+                read_failed = true;
+                break;
+            }
+
+            if (-1 != copy_fd)
+            {
+                std::string::size_type written(0);
+                while (written < chunk->size())
+                {
+                    ssize_t w(::write(copy_fd, chunk->data() + written, chunk->size() - written));
+                    if (-1 == w && EINTR == errno)
+                        continue;
+                    else if (-1 == w)
+                        break;
+                    written += w;
+                }
+
+                if (written != chunk->size())
+                {
+                    read_failed = true;
+                    break;
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(chunks.mutex);
+            chunks.condition.wait(lock, [&] () {
+                    return std::all_of(consumers.begin(), consumers.end(), [] (const Consumer & c) {
+                            return c.gone || c.queue.size() < chunks_queued_limit; });
+                    });
+            for (auto & c : consumers)
+                if (! c.gone)
+                    c.queue.push_back(chunk);
+            chunks.condition.notify_all();
+        }
+    }
+    catch (...)
+    {
+        read_failed = true;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(chunks.mutex);
+        chunks.done = true;
+    }
+    chunks.condition.notify_all();
+
+    return ! read_failed;
+}
+
+void
+Imp<DistfileDigester>::remember()
+{
+    for (const auto & c : consumers)
+        if (c.ok)
+            MemoisedHashes::get_instance()->set(c.algo, destination, c.hexsum);
+    digested = true;
+}
+
+void
+Imp<DistfileDigester>::digest_destination()
+{
+    int fd(::open(stringify(destination).c_str(), O_RDONLY | O_CLOEXEC));
+    if (-1 == fd)
+        return;
+
+    struct stat before;
+    if (0 != ::fstat(fd, &before) || (! S_ISREG(before.st_mode)) || before.st_size != expected_size)
+    {
+        ::close(fd);
+        return;
+    }
+
+    off_t total(0);
+    bool read_failed(! share_out(fd, -1, total));
+
+    /* only trust what we read if nothing touched the file whilst we were
+     * reading it, and we read exactly what was there */
+    struct stat after, after_path;
+    bool same(0 == ::fstat(fd, &after) && unchanged(before, after) &&
+            0 == ::stat(stringify(destination).c_str(), &after_path) && unchanged(before, after_path));
+    ::close(fd);
+
+    if (read_failed || (! same) || total != expected_size)
+    {
+        Log::get_instance()->message("e.distfile_digester.changed", ll_debug, lc_context)
+            << "Not remembering hashes for '" << destination << "' because it changed whilst we were reading it";
+        return;
+    }
+
+    remember();
+}
+
+DistfileDigester::DistfileDigester(
+        const FSPath & destination,
+        const off_t expected_size,
+        const std::shared_ptr<const Set<std::string> > & algorithms,
+        const std::function<void ()> & oversize) :
+    _imp(destination, expected_size, oversize)
+{
+    for (const auto & algo : *algorithms)
+    {
+        DigestRegistry::Function digest(DigestRegistry::get_instance()->get(algo));
+        if (digest)
+            _imp->consumers.push_back(Consumer(algo, digest));
+    }
+
+    /* only look at the size whilst the fetcher is writing, since anything we
+     * read now might be thrown away or rewritten */
+    _imp->pool->create_thread([this] () noexcept {
+            std::unique_lock<std::mutex> lock(_imp->mutex);
+            while (! _imp->fetch_done)
+            {
+                lock.unlock();
+                if (std::max(size_of(_imp->partial), size_of(_imp->destination)) > _imp->expected_size)
+                {
+                    _imp->oversized = true;
+                    _imp->oversize();
+                    return;
+                }
+                lock.lock();
+
+                _imp->condition.wait_for(lock, std::chrono::milliseconds(50), [&] () { return _imp->fetch_done; });
+            }
+            });
+}
+
+DistfileDigester::~DistfileDigester()
+{
+    _imp->stop_watching();
+}
+
+bool
+DistfileDigester::finish(const bool fetch_succeeded)
+{
+    _imp->stop_watching();
+
+    if (_imp->oversized || size_of(_imp->destination) > _imp->expected_size)
+        return false;
+
+    if (fetch_succeeded && ! _imp->digested)
+        _imp->digest_destination();
+
+    return true;
+}
+
+bool
+DistfileDigester::copy_from(const FSPath & source)
+{
+    _imp->stop_watching();
+
+    int in_fd(::open(stringify(source).c_str(), O_RDONLY | O_CLOEXEC));
+    if (-1 == in_fd)
+        return false;
+
+    struct stat before;
+    if (0 != ::fstat(in_fd, &before) || ! S_ISREG(before.st_mode))
+    {
+        ::close(in_fd);
+        return false;
+    }
+
+    if (before.st_size > _imp->expected_size)
+    {
+        ::close(in_fd);
+        _imp->oversized = true;
+        return false;
+    }
+
+    int out_fd(::open(stringify(_imp->partial).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+    if (-1 == out_fd)
+    {
+        ::close(in_fd);
+        return false;
+    }
+
+    off_t total(0);
+    bool ok(_imp->share_out(in_fd, out_fd, total));
+    ::close(in_fd);
+    if (0 != ::close(out_fd))
+        ok = false;
+
+    if (total > _imp->expected_size)
+        _imp->oversized = true;
+
+    if ((! ok) || _imp->oversized)
+    {
+        _imp->partial.unlink();
+        return false;
+    }
+
+    if (0 != ::rename(stringify(_imp->partial).c_str(), stringify(_imp->destination).c_str()))
+    {
+        _imp->partial.unlink();
+        return false;
+    }
+
+    /* what we hashed is exactly what we wrote, so it only needs to be the
+     * right size to be worth remembering */
+    if (total == _imp->expected_size)
+        _imp->remember();
+    else
+        _imp->digested = true;
+
+    return true;
+}
+
+namespace paludis
+{
+    template class Pimp<DistfileDigester>;
+}
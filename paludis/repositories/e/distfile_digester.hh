@@ -0,0 +1,101 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_DISTFILE_DIGESTER_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_DISTFILE_DIGESTER_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/set-fwd.hh>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+namespace paludis
+{
+    namespace erepository
+    {
+        /**
+         * Watches a distfile whilst a fetcher writes it, and works out its
+         * Manifest hashes once the fetch is done, so that checking it
+         * afterwards need not read the whole file again.
+         *
+         * Whilst the fetch runs we only look at the size of the .-PARTIAL-
+         * or final file. If it grows past the expected size, the oversize
+         * function is called straight away, so that the fetch can be
+         * abandoned.
+         *
+         * A local file can instead be fetched with copy_from(), which
+         * hashes each chunk as it writes it.
+         *
+         * \ingroup grperepository
+         * \since 3.0
+         */
+        class PALUDIS_VISIBLE DistfileDigester
+        {
+            private:
+                Pimp<DistfileDigester> _imp;
+
+            public:
+                DistfileDigester(
+                        const FSPath & destination,
+                        const off_t expected_size,
+                        const std::shared_ptr<const Set<std::string> > & algorithms,
+                        const std::function<void ()> & oversize);
+
+                ~DistfileDigester();
+
+                DistfileDigester(const DistfileDigester &) = delete;
+                DistfileDigester & operator= (const DistfileDigester &) = delete;
+
+                /**
+                 * Call once the fetcher has exited. If the fetch succeeded,
+                 * reads the destination once, feeding every algorithm, and
+                 * records the hashes in MemoisedHashes if the file was
+                 * exactly the expected size and did not change whilst we
+                 * read it.
+                 *
+                 * Returns false if the file grew past the expected size.
+                 */
+                bool finish(const bool fetch_succeeded);
+
+                /**
+                 * Fetch a local file ourselves, rather than running a
+                 * fetcher. Copies it into the .-PARTIAL- file, feeding
+                 * every algorithm with each chunk as it is written, and
+                 * then renames it into place. Gives up as soon as more than
+                 * the expected size has been read. The hashes are recorded
+                 * in MemoisedHashes if exactly the expected size was copied.
+                 *
+                 * Returns false, having removed the partial file, if the
+                 * copy failed or was too big. Call finish() afterwards as
+                 * usual, which will not read the file again.
+                 */
+                bool copy_from(const FSPath & source);
+        };
+    }
+
+    extern template class Pimp<erepository::DistfileDigester>;
+}
+
+#endif
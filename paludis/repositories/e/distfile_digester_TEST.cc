@@ -0,0 +1,185 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/distfile_digester.hh>
+#include <paludis/repositories/e/memoised_hashes.hh>
+
+#include <paludis/util/set.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/digest_registry.hh>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    void write_slowly(const FSPath & f, const std::string & chunk, int chunks)
+    {
+        SafeOFStream s(f, -1, true);
+        for (int i(0) ; i < chunks ; ++i)
+        {
+            s << chunk << std::flush;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    std::string digest_of(const std::string & algo, const FSPath & f)
+    {
+        SafeIFStream s(f);
+        return DigestRegistry::get_instance()->get(algo)(s);
+    }
+}
+
+TEST(DistfileDigester, HashesFetchedFile)
+{
+    FSPath destination("distfile_digester_TEST_dir/fetched");
+    FSPath partial("distfile_digester_TEST_dir/fetched.-PARTIAL-");
+
+    auto algorithms(std::make_shared<Set<std::string> >());
+    algorithms->insert("SHA256");
+    algorithms->insert("MD5");
+    algorithms->insert("NOT-A-HASH");
+
+    std::atomic<bool> oversize(false);
+    DistfileDigester digester(destination, 40 * 10, algorithms, [&] () { oversize = true; });
+
+    /* use a whole-second mtime, since we need to put it back later, and
+     * not everywhere can set nanoseconds */
+    Timestamp mtime(1234567890, 0);
+
+    std::thread writer([&] () {
+            write_slowly(partial, std::string(40, 'x'), 10);
+            partial.rename(destination);
+            destination.utime(mtime);
+            });
+    writer.join();
+
+    EXPECT_TRUE(digester.finish(true));
+    EXPECT_FALSE(oversize);
+
+    std::string sha256(digest_of("SHA256", destination));
+
+    /* replace the contents without changing the mtime, so we can tell that
+     * the hash comes from the digester rather than from reading the file */
+    {
+        SafeOFStream s(destination, -1, true);
+        s << std::string(40 * 10, 'y');
+    }
+    destination.utime(mtime);
+
+    SafeIFStream s(destination);
+    EXPECT_EQ(sha256, MemoisedHashes::get_instance()->get("SHA256", destination, s));
+    EXPECT_NE(sha256, digest_of("SHA256", destination));
+}
+
+TEST(DistfileDigester, Oversize)
+{
+    FSPath destination("distfile_digester_TEST_dir/oversize");
+
+    auto algorithms(std::make_shared<Set<std::string> >());
+    algorithms->insert("SHA256");
+
+    std::atomic<bool> oversize(false);
+    DistfileDigester digester(destination, 100, algorithms, [&] () { oversize = true; });
+
+    std::thread writer([&] () { write_slowly(destination, std::string(40, 'x'), 5); });
+    writer.join();
+
+    /* the size is only polled, so give it a chance to notice */
+    for (int i(0) ; i < 100 && ! oversize ; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    EXPECT_FALSE(digester.finish(true));
+    EXPECT_TRUE(oversize);
+}
+
+TEST(DistfileDigester, WrongSize)
+{
+    FSPath destination("distfile_digester_TEST_dir/short");
+
+    auto algorithms(std::make_shared<Set<std::string> >());
+    algorithms->insert("SHA256");
+
+    DistfileDigester digester(destination, 100, algorithms, [] () { });
+    Timestamp mtime(1234567890, 0);
+    write_slowly(destination, std::string(40, 'x'), 1);
+    destination.utime(mtime);
+    EXPECT_TRUE(digester.finish(true));
+
+    {
+        SafeOFStream s(destination, -1, true);
+        s << std::string(40, 'y');
+    }
+    destination.utime(mtime);
+
+    SafeIFStream s(destination);
+    EXPECT_EQ(digest_of("SHA256", destination), MemoisedHashes::get_instance()->get("SHA256", destination, s));
+}
+
+TEST(DistfileDigester, CopyFrom)
+{
+    FSPath source("distfile_digester_TEST_dir/source");
+    FSPath destination("distfile_digester_TEST_dir/copied");
+    write_slowly(source, std::string(40, 'x'), 3);
+
+    auto algorithms(std::make_shared<Set<std::string> >());
+    algorithms->insert("SHA256");
+
+    DistfileDigester digester(destination, 40 * 3, algorithms, [] () { });
+    EXPECT_TRUE(digester.copy_from(source));
+    EXPECT_TRUE(digester.finish(true));
+    EXPECT_FALSE(FSPath("distfile_digester_TEST_dir/copied.-PARTIAL-").stat().exists());
+
+    std::string sha256(digest_of("SHA256", source));
+    EXPECT_EQ(sha256, digest_of("SHA256", destination));
+
+    /* the hash must come from the copy, so the stream we hand over in case
+     * it isn't remembered should not get read */
+    FSPath other("distfile_digester_TEST_dir/other");
+    write_slowly(other, std::string(40, 'y'), 3);
+    SafeIFStream s(other);
+    EXPECT_EQ(sha256, MemoisedHashes::get_instance()->get("SHA256", destination, s));
+}
+
+TEST(DistfileDigester, CopyFromOversize)
+{
+    FSPath source("distfile_digester_TEST_dir/big_source");
+    FSPath destination("distfile_digester_TEST_dir/big_copied");
+    write_slowly(source, std::string(40, 'x'), 3);
+
+    auto algorithms(std::make_shared<Set<std::string> >());
+    algorithms->insert("SHA256");
+
+    DistfileDigester digester(destination, 100, algorithms, [] () { });
+    EXPECT_FALSE(digester.copy_from(source));
+    EXPECT_FALSE(digester.finish(false));
+    EXPECT_FALSE(destination.stat().exists());
+    EXPECT_FALSE(FSPath("distfile_digester_TEST_dir/big_copied.-PARTIAL-").stat().exists());
+}
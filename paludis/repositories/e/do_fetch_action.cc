@@ -25,6 +25,7 @@
 #include <paludis/repositories/e/aa_visitor.hh>
 #include <paludis/repositories/e/check_fetched_files_visitor.hh>
 #include <paludis/repositories/e/fetch_visitor.hh>
+#include <paludis/repositories/e/mirror_health.hh>
 #include <paludis/repositories/e/make_use.hh>
 #include <paludis/repositories/e/can_skip_phase.hh>
 #include <paludis/repositories/e/ebuild.hh>
@@ -121,8 +122,11 @@ paludis::erepository::do_fetch_action(
                     repo->params().distdir(), fetch_action.options.fetch_parts()[fp_unneeded],
                     fetch_userpriv_ok, mirrors_name,
                     id->fetches_key()->initial_label(), fetch_action.options.safe_resume(),
+                    manifest_ignore == repo->params().use_manifest() ? FSPath("/var/empty") :
+                        repo->layout()->package_directory(id->name()) / "Manifest",
                     output_manager, std::bind(&ERepository::get_mirrors, repo, std::placeholders::_1));
             fetches->top()->accept(f);
+            MirrorHealth::get_instance()->save_changes();
         }
 
         fetches->top()->accept(c);
@@ -39,6 +39,8 @@
 #include <paludis/util/join.hh>
 #include <paludis/util/return_literal_function.hh>
 #include <paludis/util/tokeniser.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/env_var_names.hh>
 
 #include <paludis/action.hh>
 #include <paludis/dep_spec_flattener.hh>
@@ -272,6 +274,10 @@ paludis::erepository::do_install_action(
             MergerOptions extra_merger_options;
             if (work_choice && ELikeWorkChoiceValue::should_merge_nondestructively(work_choice->parameter()))
                 extra_merger_options += mo_nondestructive;
+            if (! getenv_with_default(env_vars::parallel_merge_scan, "").empty())
+                extra_merger_options += mo_parallel_scan;
+            if (! getenv_with_default(env_vars::parallel_merge, "").empty())
+                extra_merger_options += mo_parallel_merge;
 
             Timestamp build_start_time(FSPath(package_builddir / "temp" / "build_start_time").stat().mtim());
             destination->destination_interface()->merge(
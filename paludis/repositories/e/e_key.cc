@@ -300,6 +300,12 @@ EFetchableURIKey::initial_label() const
     return result;
 }
 
+const std::shared_ptr<const std::string>
+EFetchableURIKey::unparsed_value() const
+{
+    return std::make_shared<std::string>(_imp->string_value);
+}
+
 const std::string
 EFetchableURIKey::raw_name() const
 {
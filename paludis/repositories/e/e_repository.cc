@@ -32,7 +32,8 @@
 #include <paludis/repositories/e/layout.hh>
 #include <paludis/repositories/e/info_metadata_key.hh>
 #include <paludis/repositories/e/extra_distribution_data.hh>
-#include <paludis/repositories/e/memoised_hashes.hh>
+#include <paludis/repositories/e/manifest_hasher.hh>
+#include <paludis/repositories/e/manifest2_reader.hh>
 #include <paludis/repositories/e/ebuild_id.hh>
 #include <paludis/repositories/e/eapi_phase.hh>
 #include <paludis/repositories/e/can_skip_phase.hh>
@@ -234,6 +235,10 @@ namespace paludis
         ~Imp();
 
         void need_profiles() const;
+        void purge_write_cache(const std::shared_ptr<const QualifiedPackageNameSet> & only) const;
+        std::shared_ptr<const QualifiedPackageNameSet> packages_for_changed_paths(
+                const std::shared_ptr<const Set<std::string> > & paths) const;
+        void update_names_cache_from_pending() const;
 
         std::shared_ptr<const MetadataValueKey<std::string> > format_key;
         std::shared_ptr<const MetadataValueKey<std::string> > layout_key;
@@ -413,6 +418,155 @@ namespace paludis
 
     Imp<ERepository>::~Imp() = default;
 
+    void
+    Imp<ERepository>::purge_write_cache(const std::shared_ptr<const QualifiedPackageNameSet> & only) const
+    {
+        FSPath write_cache(params.write_cache());
+        if (write_cache == FSPath("/var/empty"))
+            return;
+
+        if (params.append_repository_name_to_write_cache())
+            write_cache /= stringify(repo->name());
+
+        if (! write_cache.stat().is_directory_or_symlink_to_directory())
+            return;
+
+        const std::shared_ptr<const EAPI> eapi(EAPIData::get_instance()->eapi_from_string(
+                    params.eapi_when_unknown()));
+
+        std::set<std::string> only_categories;
+        if (only)
+            for (const auto & q : *only)
+                only_categories.insert(stringify(q.category()));
+
+        for (FSIterator dc(write_cache, { fsio_inode_sort, fsio_want_directories, fsio_deref_symlinks_for_wants }), dc_end ; dc != dc_end ; ++dc)
+        {
+            if (only && ! only_categories.count(dc->basename()))
+                continue;
+
+            for (FSIterator dp(*dc, { fsio_inode_sort, fsio_want_regular_files, fsio_deref_symlinks_for_wants }), dp_end ; dp != dp_end ; ++dp)
+            {
+                try
+                {
+                    CategoryNamePart cnp(dc->basename());
+                    std::string pv(dp->basename());
+                    VersionSpec v(elike_get_remove_trailing_version(pv, eapi->supported()->version_spec_options()));
+                    PackageNamePart p(pv);
+
+                    if (only && ! only->count(cnp + p))
+                        continue;
+
+                    std::shared_ptr<const PackageIDSequence> ids(layout->package_ids(cnp + p));
+                    bool found(false);
+                    for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
+                            i != i_end ; ++i)
+                    {
+                        /* 00 is *not* equal to 0 here */
+                        if (stringify((*i)->version()) != stringify(v))
+                            continue;
+
+                        std::static_pointer_cast<const ERepositoryID>(*i)->purge_invalid_cache();
+
+                        found = true;
+                        break;
+                    }
+
+                    if (! found)
+                        FSPath(*dp).unlink();
+                }
+                catch (const Exception & e)
+                {
+                    Log::get_instance()->message("e.ebuild.purge_write_cache.ignoring", ll_warning, lc_context)
+                        << "Ignoring exception '" << e.message() << "' (" << e.what() << ") when purging invalid write_cache entries";
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<const QualifiedPackageNameSet>
+    Imp<ERepository>::packages_for_changed_paths(const std::shared_ptr<const Set<std::string> > & paths) const
+    {
+        if (! paths)
+            return nullptr;
+
+        /* eclasses and exlibs need nothing here, since cache entries already
+         * check their mtimes, but a new categories list or layout.conf can
+         * change which packages exist anywhere */
+        std::string categories_file(stringify(layout->categories_file()));
+        std::string location(stringify(params.location()) + "/");
+        if (0 == categories_file.compare(0, location.length(), location))
+            categories_file.erase(0, location.length());
+
+        /* packages live in category_directory(cat) / pkg, so everything
+         * below the category directories' parent may be a package, but where
+         * that parent is depends upon the layout */
+        std::string packages_root(stringify(layout->category_directory(CategoryNamePart("category")).dirname()) + "/");
+        if (0 != packages_root.compare(0, location.length(), location))
+            return nullptr;
+        packages_root.erase(0, location.length());
+
+        auto result(std::make_shared<QualifiedPackageNameSet>());
+        for (const auto & path : *paths)
+        {
+            if (path == categories_file || path == "metadata/layout.conf")
+                return nullptr;
+
+            if (0 != path.compare(0, packages_root.length(), packages_root))
+                continue;
+
+            std::string::size_type p(path.find('/', packages_root.length()));
+            if (std::string::npos == p)
+                continue;
+            std::string::size_type q(path.find('/', p + 1));
+
+            try
+            {
+                CategoryNamePart c(path.substr(packages_root.length(), p - packages_root.length()));
+                if (! layout->has_category_named(c))
+                    continue;
+
+                QualifiedPackageName qpn(c + PackageNamePart(path.substr(p + 1, std::string::npos == q ? q : q - p - 1)));
+
+                /* make sure we agree with the layout about where it lives */
+                if (layout->package_directory(qpn) != params.location() / path.substr(0, q))
+                    return nullptr;
+
+                result->insert(qpn);
+            }
+            catch (const NameError &)
+            {
+            }
+        }
+
+        return result;
+    }
+
+    void
+    Imp<ERepository>::update_names_cache_from_pending() const
+    {
+        /* no record, or a sync which couldn't tell what it changed, means
+         * only a full regeneration will do, which waits for sync_all_post
+         * when the layout has been reloaded */
+        std::shared_ptr<const QualifiedPackageNameSet> pending(names_cache->pending());
+        if (! pending)
+            return;
+
+        Context context("When updating names cache for " + stringify(pending->size()) + " changed packages:");
+
+        /* the layout may have loaded package names before the sync, so look
+         * at the tree itself */
+        QualifiedPackageNameSet added, removed;
+        for (const auto & q : *pending)
+            if (layout->package_directory(q).stat().is_directory_or_symlink_to_directory())
+                added.insert(q);
+            else
+                removed.insert(q);
+
+        names_cache->update(added, removed);
+        names_cache->clear_pending();
+        purge_write_cache(pending);
+    }
+
     void
     Imp<ERepository>::need_profiles() const
     {
@@ -758,10 +912,12 @@ ERepository::sync(
                 ));
         try
         {
-            syncer.sync(opts);
+            _imp->names_cache->add_pending(_imp->packages_for_changed_paths(syncer.sync_reporting_changes(opts)));
         }
         catch (const SyncFailedError &)
         {
+            /* we've no idea what a failed sync left behind */
+            _imp->names_cache->add_pending(nullptr);
             continue;
         }
 
@@ -772,6 +928,8 @@ ERepository::sync(
     if (! ok)
         throw SyncFailedError(stringify(_imp->params.location()), sync_uri);
 
+    _imp->update_names_cache_from_pending();
+
     return true;
 }
 
@@ -787,57 +945,7 @@ ERepository::purge_invalid_cache() const
 {
     Context context("When purging invalid write_cache:");
 
-    FSPath write_cache(_imp->params.write_cache());
-    if (write_cache == FSPath("/var/empty"))
-        return;
-
-    if (_imp->params.append_repository_name_to_write_cache())
-        write_cache /= stringify(name());
-
-    if (! write_cache.stat().is_directory_or_symlink_to_directory())
-        return;
-
-    const std::shared_ptr<const EAPI> eapi(EAPIData::get_instance()->eapi_from_string(
-                _imp->params.eapi_when_unknown()));
-
-    std::shared_ptr<EclassMtimes> eclass_mtimes(std::make_shared<EclassMtimes>(this, _imp->params.eclassdirs()));
-
-    for (FSIterator dc(write_cache, { fsio_inode_sort, fsio_want_directories, fsio_deref_symlinks_for_wants }), dc_end ; dc != dc_end ; ++dc)
-    {
-        for (FSIterator dp(*dc, { fsio_inode_sort, fsio_want_regular_files, fsio_deref_symlinks_for_wants }), dp_end ; dp != dp_end ; ++dp)
-        {
-            try
-            {
-                CategoryNamePart cnp(dc->basename());
-                std::string pv(dp->basename());
-                VersionSpec v(elike_get_remove_trailing_version(pv, eapi->supported()->version_spec_options()));
-                PackageNamePart p(pv);
-
-                std::shared_ptr<const PackageIDSequence> ids(_imp->layout->package_ids(cnp + p));
-                bool found(false);
-                for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
-                        i != i_end ; ++i)
-                {
-                    /* 00 is *not* equal to 0 here */
-                    if (stringify((*i)->version()) != stringify(v))
-                        continue;
-
-                    std::static_pointer_cast<const ERepositoryID>(*i)->purge_invalid_cache();
-
-                    found = true;
-                    break;
-                }
-
-                if (! found)
-                    FSPath(*dp).unlink();
-            }
-            catch (const Exception & e)
-            {
-                Log::get_instance()->message("e.ebuild.purge_write_cache.ignoring", ll_warning, lc_context)
-                    << "Ignoring exception '" << e.message() << "' (" << e.what() << ") when purging invalid write_cache entries";
-            }
-        }
-    }
+    _imp->purge_write_cache(nullptr);
 }
 
 void
@@ -893,6 +1001,7 @@ void
 ERepository::regenerate_cache() const
 {
     _imp->names_cache->regenerate_cache();
+    _imp->names_cache->clear_pending();
 }
 
 std::shared_ptr<const CategoryNamePartSet>
@@ -908,6 +1017,12 @@ ERepository::category_names_containing_package(const PackageNamePart & p,
     return result ? result : Repository::category_names_containing_package(p, x);
 }
 
+std::shared_ptr<const RepositoryNameCache>
+ERepository::names_cache() const
+{
+    return _imp->names_cache;
+}
+
 const ERepositoryParams &
 ERepository::params() const
 {
@@ -942,6 +1057,11 @@ ERepository::perform_hook(const Hook & hook, const std::shared_ptr<OutputManager
             || hook.name() == "uninstall_all_post")
         update_news();
 
+    /* syncs which could tell what they changed have already updated the
+     * names cache, so only the rest need a full regeneration */
+    if (hook.name() == "sync_all_post" && _imp->names_cache->needs_regeneration())
+        regenerate_cache();
+
     return make_named_values<HookResult>(n::max_exit_status() = 0, n::output() = "");
 }
 
@@ -981,101 +1101,145 @@ ERepository::some_ids_might_not_be_masked() const
 
 void
 ERepository::make_manifest(const QualifiedPackageName & qpn)
+{
+    std::shared_ptr<QualifiedPackageNameSet> qpns(std::make_shared<QualifiedPackageNameSet>());
+    qpns->insert(qpn);
+    make_manifests(qpns);
+}
+
+namespace
+{
+    struct ManifestBeingMade
+    {
+        FSPath package_dir;
+        std::vector<std::pair<std::pair<std::string, std::string>, unsigned> > lines;
+    };
+
+    /* Only DIST entries are reused. Distfiles are what is expensive to hash,
+     * and unlike files under version control they can't turn up alongside a
+     * stale Manifest that was written after them. */
+    std::shared_ptr<const Map<std::string, std::string> > reusable_dist_hashes(
+            const Manifest2Reader & old_manifest,
+            const FSStat & old_manifest_stat,
+            const std::shared_ptr<const Set<std::string> > & algorithms,
+            const std::string & name,
+            const FSStat & file_stat)
+    {
+        if (! old_manifest_stat.exists())
+            return nullptr;
+
+        auto e(old_manifest.find("DIST", name));
+        if (e == old_manifest.end() || e->size() != file_stat.file_size())
+            return nullptr;
+
+        if (! (file_stat.mtim() < old_manifest_stat.mtim() && file_stat.ctim() < old_manifest_stat.mtim()))
+            return nullptr;
+
+        for (const auto & algo : *algorithms)
+            if (e->hashes()->end() == e->hashes()->find(algo))
+                return nullptr;
+
+        return e->hashes();
+    }
+}
+
+void
+ERepository::make_manifests(const std::shared_ptr<const QualifiedPackageNameSet> & qpns)
 {
     for (Set<std::string>::ConstIterator it(_imp->params.manifest_hashes()->begin()),
              it_end(_imp->params.manifest_hashes()->end()); it_end != it; ++it)
         if (! DigestRegistry::get_instance()->get(*it))
             throw ERepositoryConfigurationError("Manifest hash function '" + *it + "' is not supported");
 
-    FSPath package_dir = _imp->layout->package_directory(qpn);
-
-    std::vector<std::pair<std::pair<std::string, std::string>, std::string> > lines;
-    auto files(_imp->layout->manifest_files(qpn, package_dir));
+    /* work out what every Manifest needs first, and then hash everything at
+     * once, so that a whole category or repository keeps all of our threads
+     * busy */
+    ManifestHasher hasher(_imp->params.manifest_hashes());
+    std::vector<ManifestBeingMade> manifests;
 
-    if (! _imp->params.thin_manifests())
+    for (const auto & qpn : *qpns)
     {
-        for (auto f(files->begin()) ; f != files->end() ; ++f)
-        {
-            FSPath file(f->first);
-            FSStat file_stat(file);
-            std::string filename = file.basename();
-            std::string file_type(f->second);
-
-            if ("AUX" == file_type)
-            {
-                filename = stringify(file).substr(stringify(package_dir / "files").length()+1);
-            }
+        Context context("When working out the Manifest for '" + stringify(qpn) + "' in '" + stringify(name()) + "':");
 
-            SafeIFStream file_stream(file);
+        FSPath package_dir = _imp->layout->package_directory(qpn);
+        manifests.push_back(ManifestBeingMade{ package_dir, { } });
+        auto & manifest(manifests.back());
 
-            std::string line(file_type + " " + filename + " " + stringify(file.stat().file_size()));
+        FSPath old_manifest_file(package_dir / "Manifest");
+        FSStat old_manifest_stat(old_manifest_file);
+        Manifest2Reader old_manifest(old_manifest_file);
 
-            for (Set<std::string>::ConstIterator it(_imp->params.manifest_hashes()->begin()),
-                     it_end(_imp->params.manifest_hashes()->end()); it_end != it; ++it)
+        if (! _imp->params.thin_manifests())
+        {
+            auto files(_imp->layout->manifest_files(qpn, package_dir));
+            for (auto f(files->begin()) ; f != files->end() ; ++f)
             {
-                file_stream.clear();
-                file_stream.seekg(0, std::ios::beg);
-                line += " " + *it + " " + DigestRegistry::get_instance()->get(*it)(file_stream);
-            }
+                FSPath file(f->first);
+                std::string filename = file.basename();
+                std::string file_type(f->second);
 
-            lines.push_back(std::make_pair(std::make_pair(file_type, filename), line));
-        }
-    }
+                if ("AUX" == file_type)
+                {
+                    filename = stringify(file).substr(stringify(package_dir / "files").length()+1);
+                }
 
-    std::shared_ptr<const PackageIDSequence> versions;
-    versions = package_ids(qpn, { });
+                manifest.lines.push_back(std::make_pair(std::make_pair(file_type, filename),
+                            hasher.add(file_type, filename, file, nullptr)));
+            }
+        }
 
-    std::set<std::string> done_files;
+        std::shared_ptr<const PackageIDSequence> versions;
+        versions = package_ids(qpn, { });
 
-    for (PackageIDSequence::ConstIterator v(versions->begin()),
-            v_end(versions->end()) ;
-            v != v_end ; ++v)
-    {
-        std::shared_ptr<const PackageID> id = (*v);
-        if (! id->fetches_key())
-            continue;
-        AAVisitor aa;
-        id->fetches_key()->parse_value()->top()->accept(aa);
+        std::set<std::string> done_files;
 
-        for (AAVisitor::ConstIterator d(aa.begin()) ;
-                d != aa.end() ; ++d)
+        for (PackageIDSequence::ConstIterator v(versions->begin()),
+                v_end(versions->end()) ;
+                v != v_end ; ++v)
         {
-            if (done_files.count(*d))
+            std::shared_ptr<const PackageID> id = (*v);
+            if (! id->fetches_key())
                 continue;
-            done_files.insert(*d);
-
-            FSPath f(params().distdir() / *d);
-            FSStat f_stat(f);
-
-            if (! f_stat.is_regular_file_or_symlink_to_regular_file())
-                throw MissingDistfileError("Distfile '" + f.basename() + "' does not exist");
+            AAVisitor aa;
+            id->fetches_key()->parse_value()->top()->accept(aa);
 
-            SafeIFStream file_stream(f);
-
-            MemoisedHashes * hashes = MemoisedHashes::get_instance();
+            for (AAVisitor::ConstIterator d(aa.begin()) ;
+                    d != aa.end() ; ++d)
+            {
+                if (done_files.count(*d))
+                    continue;
+                done_files.insert(*d);
 
-            std::string line("DIST " + f.basename() + " " + stringify(f_stat.file_size()));
+                FSPath f(params().distdir() / *d);
+                FSStat f_stat(f);
 
-            for (Set<std::string>::ConstIterator it(_imp->params.manifest_hashes()->begin()),
-                     it_end(_imp->params.manifest_hashes()->end()); it_end != it; ++it)
-                line += " " + *it + " " + hashes->get(*it, f, file_stream);
+                if (! f_stat.is_regular_file_or_symlink_to_regular_file())
+                    throw MissingDistfileError("Distfile '" + f.basename() + "' does not exist");
 
-            lines.push_back(std::make_pair(std::make_pair("DIST", f.basename()), line));
+                manifest.lines.push_back(std::make_pair(std::make_pair("DIST", f.basename()),
+                            hasher.add("DIST", f.basename(), f, reusable_dist_hashes(old_manifest, old_manifest_stat,
+                                    _imp->params.manifest_hashes(), f.basename(), f_stat))));
+            }
         }
     }
 
-    std::sort(lines.begin(), lines.end());
-
-    FSPath(package_dir / "Manifest").unlink();
+    hasher.run();
 
-    if (! lines.empty())
+    for (auto & manifest : manifests)
     {
-        SafeOFStream manifest(FSPath(package_dir / "Manifest"), -1, true);
-        if (! manifest)
-            throw ERepositoryConfigurationError("Couldn't open Manifest for writing.");
+        std::sort(manifest.lines.begin(), manifest.lines.end());
 
-        for (auto it(lines.begin()), it_end(lines.end()); it_end != it; ++it)
-            manifest << it->second << std::endl;
+        FSPath(manifest.package_dir / "Manifest").unlink();
+
+        if (! manifest.lines.empty())
+        {
+            SafeOFStream out(FSPath(manifest.package_dir / "Manifest"), -1, true);
+            if (! out)
+                throw ERepositoryConfigurationError("Couldn't open Manifest for writing.");
+
+            for (auto it(manifest.lines.begin()), it_end(manifest.lines.end()); it_end != it; ++it)
+                out << hasher.line(it->second) << std::endl;
+        }
     }
 }
 
@@ -92,6 +92,7 @@ namespace paludis
 
             /* RepositoryManifestInterface */
             virtual void make_manifest(const QualifiedPackageName & qpn);
+            virtual void make_manifests(const std::shared_ptr<const QualifiedPackageNameSet> & qpns);
 
             /* RepositorySyncableInterface */
 
@@ -123,6 +124,8 @@ namespace paludis
             virtual std::shared_ptr<const CategoryNamePartSet> category_names_containing_package(
                     const PackageNamePart &, const RepositoryContentMayExcludes &) const;
 
+            virtual std::shared_ptr<const RepositoryNameCache> names_cache() const;
+
             virtual bool has_package_named(const QualifiedPackageName &, const RepositoryContentMayExcludes &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
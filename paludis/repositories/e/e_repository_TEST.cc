@@ -36,6 +36,10 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
 
 #include <paludis/standard_output_manager.hh>
 #include <paludis/package_id.hh>
@@ -49,6 +53,7 @@
 #include <paludis/repository_factory.hh>
 #include <paludis/choice.hh>
 #include <paludis/unformatted_pretty_printer.hh>
+#include <paludis/hook.hh>
 
 #include <paludis/util/indirect_iterator-impl.hh>
 
@@ -762,6 +767,51 @@ TEST_F(ERepositoryQueryUseTest, UseStableMaskForce)
     while (accept_unstable);
 }
 
+TEST_F(ERepositoryQueryUseTest, UseStackPrecedence)
+{
+    TestEnvironment env;
+    std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+    keys->insert("format", "e");
+    keys->insert("names_cache", "/var/empty");
+    keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9b"));
+    keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo9b/profiles/profile/child"));
+    keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+    std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1))));
+    env.add_repository(1, repo);
+
+    for (int pass = 1 ; pass <= 2 ; ++pass)
+    {
+        const std::shared_ptr<const PackageID> stable(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat/pkg-1",
+                                &env, { })), nullptr, { }))]->begin());
+        const std::shared_ptr<const PackageID> unstable(*env[selection::RequireExactlyOne(generator::Matches(
+                        PackageDepSpec(parse_user_package_dep_spec("=cat/pkg-2",
+                                &env, { })), nullptr, { }))]->begin());
+
+        for (const auto & id : { stable, unstable })
+        {
+            test_choice(id, "gmask-pkgunmask", false, false, false);
+            test_choice(id, "pkgmask-chgunmask", false, false, false);
+            test_choice(id, "pkgunmask-chgmask", false, false, true);
+            test_choice(id, "gforce-pkgunforce", false, false, false);
+            test_choice(id, "pkgforce-chgunforce", false, false, false);
+            test_choice(id, "guse-pkgoff", false, false, false);
+            test_choice(id, "pkguse-chgoff", true, true, false);
+        }
+
+        test_choice(stable, "pkgstmask", false, false, true);
+        test_choice(stable, "gmask-chpkgstunmask", false, false, false);
+        test_choice(stable, "verpkgmask", false, false, false);
+        test_choice(stable, "pkgstforce", true, true, true);
+
+        test_choice(unstable, "pkgstmask", false, false, false);
+        test_choice(unstable, "gmask-chpkgstunmask", false, false, true);
+        test_choice(unstable, "verpkgmask", false, false, true);
+        test_choice(unstable, "pkgstforce", false, false, false);
+    }
+}
+
 TEST(ERepository, Masks)
 {
     TestEnvironment env;
@@ -889,6 +939,39 @@ TEST(ERepository, Manifest)
     EXPECT_TRUE(! FSStat(FSPath("e_repository_TEST_dir/repo11b/category/package2/Manifest")).exists());
 }
 
+TEST(ERepository, ManifestReuse)
+{
+    TestEnvironment env;
+    std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+    keys->insert("format", "e");
+    keys->insert("names_cache", "/var/empty");
+    keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo11c"));
+    keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo11c/profiles/profile"));
+    keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+    std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1))));
+    env.add_repository(1, repo);
+
+    FSPath manifest("e_repository_TEST_dir/repo11c/category/package/Manifest");
+
+    /* the distfile is older than the Manifest, so its entry is trusted */
+    manifest.utime(Timestamp(Timestamp::now().seconds() + 60, 0));
+    std::shared_ptr<QualifiedPackageNameSet> qpns(std::make_shared<QualifiedPackageNameSet>());
+    qpns->insert(QualifiedPackageName("category/package"));
+    qpns->insert(QualifiedPackageName("category/other"));
+    repo->make_manifests(qpns);
+
+    EXPECT_EQ("DIST foo 10 SHA256 0000000000000000000000000000000000000000000000000000000000000000\n", contents(stringify(manifest)));
+    EXPECT_EQ("DIST bar 12 SHA256 27cd06afc317a809116e7730736663b9f09dd863fcc37b69d32d4f5eb58708b2\n",
+            contents("e_repository_TEST_dir/repo11c/category/other/Manifest"));
+
+    /* but not once the distfile is newer */
+    manifest.utime(Timestamp(1000000000, 0));
+    repo->make_manifest(QualifiedPackageName("category/package"));
+
+    EXPECT_EQ("DIST foo 10 SHA256 4bc453b53cb3d914b45f4b250294236adba2c0e09ff6f03793949e7e39fd4cc1\n", contents(stringify(manifest)));
+}
+
 TEST(ERepository, Fetch)
 {
     TestEnvironment env;
@@ -1053,3 +1136,86 @@ TEST(ERepository, ParseEAPI)
     EXPECT_EQ("", eapis[i]) << "(i == " << i << ")";
 }
 
+namespace
+{
+    struct SyncTestEnvironment :
+        TestEnvironment
+    {
+        std::shared_ptr<const FSPathSequence> syncers_dirs() const override
+        {
+            std::shared_ptr<FSPathSequence> result(std::make_shared<FSPathSequence>());
+            result->push_back(FSPath::cwd() / "e_repository_TEST_dir" / "syncers");
+            return result;
+        }
+    };
+
+    std::string categories_containing(const std::shared_ptr<const Repository> & repo, const std::string & p)
+    {
+        std::shared_ptr<const CategoryNamePartSet> cats(repo->category_names_containing_package(PackageNamePart(p), { }));
+        return join(cats->begin(), cats->end(), " ");
+    }
+}
+
+TEST(ERepository, SyncUpdatesNamesCacheExheres)
+{
+    SyncTestEnvironment env;
+    std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+    keys->insert("format", "exheres");
+    keys->insert("names_cache", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "names_cache21"));
+    keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo21"));
+    keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo21/profiles/profile"));
+    keys->insert("layout", "exheres");
+    keys->insert("eapi_when_unknown", "exheres-0");
+    keys->insert("eapi_when_unspecified", "exheres-0");
+    keys->insert("profile_eapi", "exheres-0");
+    keys->insert("sync", "test://nowhere");
+    keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+    std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1))));
+    env.add_repository(1, repo);
+
+    repo->regenerate_cache();
+    EXPECT_EQ("cat", categories_containing(repo, "one"));
+    EXPECT_EQ("cat", categories_containing(repo, "gone"));
+    EXPECT_EQ("", categories_containing(repo, "two"));
+
+    EXPECT_TRUE(repo->sync("", "", std::make_shared<StandardOutputManager>()));
+    EXPECT_EQ("cat", categories_containing(repo, "one"));
+    EXPECT_EQ("", categories_containing(repo, "gone"));
+    EXPECT_EQ("cat", categories_containing(repo, "two"));
+    EXPECT_TRUE(! (FSPath::cwd() / "e_repository_TEST_dir" / "names_cache21" / "test-repo-21" / "_PENDING_").stat().exists());
+}
+
+TEST(ERepository, SyncWithUnknownChangesRegeneratesNamesCache)
+{
+    SyncTestEnvironment env;
+    std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
+    keys->insert("format", "exheres");
+    keys->insert("names_cache", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "names_cache22"));
+    keys->insert("location", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo22"));
+    keys->insert("profiles", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "repo22/profiles/profile"));
+    keys->insert("layout", "exheres");
+    keys->insert("eapi_when_unknown", "exheres-0");
+    keys->insert("eapi_when_unspecified", "exheres-0");
+    keys->insert("profile_eapi", "exheres-0");
+    keys->insert("sync", "untold://nowhere");
+    keys->insert("builddir", stringify(FSPath::cwd() / "e_repository_TEST_dir" / "build"));
+    std::shared_ptr<ERepository> repo(std::static_pointer_cast<ERepository>(ERepository::repository_factory_create(&env,
+                    std::bind(from_keys, keys, std::placeholders::_1))));
+    env.add_repository(1, repo);
+
+    repo->regenerate_cache();
+    EXPECT_EQ("cat", categories_containing(repo, "gone"));
+    EXPECT_EQ("", categories_containing(repo, "two"));
+
+    FSPath pending_file(FSPath::cwd() / "e_repository_TEST_dir" / "names_cache22" / "test-repo-22" / "_PENDING_");
+    EXPECT_TRUE(repo->sync("", "", std::make_shared<StandardOutputManager>()));
+    EXPECT_TRUE(pending_file.stat().exists());
+
+    repo->invalidate();
+    EXPECT_EQ(0, repo->perform_hook(Hook("sync_all_post"), nullptr).max_exit_status());
+    EXPECT_EQ("cat", categories_containing(repo, "one"));
+    EXPECT_EQ("", categories_containing(repo, "gone"));
+    EXPECT_EQ("cat", categories_containing(repo, "two"));
+    EXPECT_TRUE(! pending_file.stat().exists());
+}
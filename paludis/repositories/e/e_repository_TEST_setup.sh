@@ -370,6 +370,78 @@ sed -e '/KEYWORDS/s/test/~test/' cat/stable/stable-1.ebuild > cat/unstable/unsta
 sed -e '/KEYWORDS/s/test/detest/' cat/stable/stable-1.ebuild > cat/missing/missing-1.ebuild || exit 1
 cd ..
 
+mkdir -p repo9b/{eclass,distfiles,profiles/{profile,profile/child},cat/pkg} || exit 1
+cd repo9b || exit 1
+echo "test-repo-9b" > profiles/repo_name || exit 1
+cat <<END >profiles/categories || exit 1
+cat
+END
+cat <<END > profiles/arch.list || exit 1
+test
+END
+cat <<END >profiles/profile/eapi || exit 1
+5
+END
+cat <<END >profiles/profile/make.defaults || exit 1
+ARCH=test
+USE="guse-pkgoff"
+END
+cat <<END >profiles/profile/use.mask || exit 1
+gmask-pkgunmask
+gmask-chpkgstunmask
+END
+cat <<END >profiles/profile/package.use.mask || exit 1
+cat/pkg -gmask-pkgunmask pkgmask-chgunmask -pkgunmask-chgmask
+>=cat/pkg-2 verpkgmask
+END
+cat <<END >profiles/profile/package.use.stable.mask || exit 1
+cat/pkg pkgstmask
+END
+cat <<END >profiles/profile/use.force || exit 1
+gforce-pkgunforce
+END
+cat <<END >profiles/profile/package.use.force || exit 1
+cat/pkg -gforce-pkgunforce pkgforce-chgunforce
+END
+cat <<END >profiles/profile/package.use.stable.force || exit 1
+cat/pkg pkgstforce
+END
+cat <<END >profiles/profile/package.use || exit 1
+cat/pkg -guse-pkgoff pkguse-chgoff
+END
+cat <<END >profiles/profile/child/eapi || exit 1
+5
+END
+cat <<END >profiles/profile/child/parent || exit 1
+..
+END
+cat <<END >profiles/profile/child/make.defaults || exit 1
+USE="-pkguse-chgoff"
+END
+cat <<END >profiles/profile/child/use.mask || exit 1
+-pkgmask-chgunmask
+pkgunmask-chgmask
+END
+cat <<END >profiles/profile/child/package.use.stable.mask || exit 1
+cat/pkg -gmask-chpkgstunmask
+END
+cat <<END >profiles/profile/child/use.force || exit 1
+-pkgforce-chgunforce
+END
+cat <<END > cat/pkg/pkg-1.ebuild || exit 1
+EAPI=5
+KEYWORDS="test"
+IUSE="
+gmask-pkgunmask pkgmask-chgunmask pkgunmask-chgmask
+pkgstmask gmask-chpkgstunmask verpkgmask
+gforce-pkgunforce pkgforce-chgunforce pkgstforce
+guse-pkgoff pkguse-chgoff
+"
+SLOT="0"
+END
+sed -e '/KEYWORDS/s/test/~test/' cat/pkg/pkg-1.ebuild > cat/pkg/pkg-2.ebuild || exit 1
+cd ..
+
 mkdir -p repo10/{eclass,distfiles,profiles/profile/subprofile,cat/masked,cat/not_masked,cat/was_masked} || exit 1
 cd repo10 || exit 1
 echo "test-repo-10" > profiles/repo_name || exit 1
@@ -577,6 +649,41 @@ DIST foo 10 SHA256 4bc453b53cb3d914b45f4b250294236adba2c0e09ff6f03793949e7e39fd4
 END
 cd ..
 
+mkdir -p repo11c/{eclass,distfiles,metadata,profiles/profile} || exit 1
+mkdir -p repo11c/category/{package,other} || exit 1
+cd repo11c || exit 1
+echo "manifest-hashes = SHA256" > metadata/layout.conf || exit 1
+echo "thin-manifests = true" >> metadata/layout.conf || exit 1
+echo "test-repo-11c" >> profiles/repo_name || exit 1
+echo "category" >> profiles/categories || exit 1
+cat <<END > profiles/profile/make.defaults
+ARCH=test
+END
+cat <<END > category/package/package-1.ebuild || exit 1
+DESCRIPTION="The Description"
+HOMEPAGE="http://example.com/"
+SRC_URI="foo"
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+DEPEND=""
+END
+cat <<END > category/other/other-1.ebuild || exit 1
+DESCRIPTION="The Description"
+HOMEPAGE="http://example.com/"
+SRC_URI="bar"
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+DEPEND=""
+END
+echo "something" > distfiles/foo || exit 1
+echo "for nothing" > distfiles/bar || exit 1
+cat <<END > category/package/Manifest || exit 1
+DIST foo 10 SHA256 0000000000000000000000000000000000000000000000000000000000000000
+END
 mkdir -p repo12/{profiles/profile,metadata} || exit 1
 cd repo12 || exit 1
 echo "test-repo-12" >> profiles/repo_name || exit 1
@@ -961,3 +1068,49 @@ cd ..
 
 cd ..
 
+mkdir -p repo21/{profiles/profile,metadata,packages/cat/one,packages/cat/gone} names_cache21 syncers || exit 1
+cd repo21 || exit 1
+echo "test-repo-21" >> profiles/repo_name || exit 1
+echo "cat" >> metadata/categories.conf || exit 1
+cat <<END > profiles/profile/make.defaults
+END
+for p in one gone ; do
+    cat <<END > packages/cat/${p}/${p}-1.exheres-0 || exit 1
+SLOT="0"
+PLATFORMS="test"
+END
+done
+cd ..
+
+cat <<'END' > syncers/dotest || exit 1
+#!/usr/bin/env bash
+dir="${@: -2:1}"
+mkdir -p "${dir}"/packages/cat/two || exit 1
+cp "${dir}"/packages/cat/one/one-1.exheres-0 "${dir}"/packages/cat/two/two-1.exheres-0 || exit 1
+rm -r "${dir}"/packages/cat/gone || exit 1
+printf '%s\n' packages/cat/two/two-1.exheres-0 packages/cat/gone/gone-1.exheres-0 > "${PALUDIS_SYNC_CHANGED_PATHS_FILE}"
+END
+chmod +x syncers/dotest || exit 1
+
+mkdir -p repo22/{profiles/profile,metadata,packages/cat/one,packages/cat/gone} names_cache22 || exit 1
+cd repo22 || exit 1
+echo "test-repo-22" >> profiles/repo_name || exit 1
+echo "cat" >> metadata/categories.conf || exit 1
+cat <<END > profiles/profile/make.defaults
+END
+for p in one gone ; do
+    cat <<END > packages/cat/${p}/${p}-1.exheres-0 || exit 1
+SLOT="0"
+PLATFORMS="test"
+END
+done
+cd ..
+
+cat <<'END' > syncers/dountold || exit 1
+#!/usr/bin/env bash
+dir="${@: -2:1}"
+mkdir -p "${dir}"/packages/cat/two || exit 1
+cp "${dir}"/packages/cat/one/one-1.exheres-0 "${dir}"/packages/cat/two/two-1.exheres-0 || exit 1
+rm -r "${dir}"/packages/cat/gone || exit 1
+END
+chmod +x syncers/dountold || exit 1
@@ -69,6 +69,7 @@
 #include <paludis/util/upper_lower.hh>
 #include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/strip.hh>
+#include <paludis/util/profiler.hh>
 
 #include <set>
 #include <iterator>
@@ -234,6 +235,7 @@ EbuildID::need_non_xml_keys_added() const
     _imp->has_non_xml_keys = true;
 
     Context context("When generating metadata for ID '" + canonical_form(idcf_full) + "':");
+    ProfileScope profile_scope("EbuildID metadata", "metadata", [&] { return stringify(repository_name()); });
 
     add_metadata_key(_imp->fs_location);
 
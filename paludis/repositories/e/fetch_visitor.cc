@@ -22,6 +22,9 @@
 #include <paludis/repositories/e/e_repository_id.hh>
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/repositories/e/dep_parser.hh>
+#include <paludis/repositories/e/manifest2_reader.hh>
+#include <paludis/repositories/e/distfile_digester.hh>
+#include <paludis/repositories/e/mirror_health.hh>
 
 #include <paludis/dep_spec.hh>
 #include <paludis/environment.hh>
@@ -42,13 +45,26 @@
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/env_var_names.hh>
 #include <paludis/util/upper_lower.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/map.hh>
 
 #include <algorithm>
+#include <chrono>
 #include <list>
 
+#include <signal.h>
+#include <sys/stat.h>
+
 using namespace paludis;
 using namespace paludis::erepository;
 
+namespace
+{
+    /* what a fetcher exits with when it couldn't reach the host or timed
+     * out, as for wget */
+    const int fetcher_network_failure(4);
+}
+
 namespace paludis
 {
     template <>
@@ -63,11 +79,15 @@ namespace paludis
         const std::string mirrors_name;
         std::shared_ptr<const URILabel> default_label;
         const bool safe_resume;
+        const FSPath manifest;
         const std::shared_ptr<OutputManager> output_manager;
         const GetMirrorsFunction get_mirrors_fn;
 
         std::list<const URILabel *> labels;
 
+        bool manifest_loaded;
+        std::shared_ptr<const Manifest2Reader> manifest_reader;
+
         Imp(
                 const Environment * const e,
                 const std::shared_ptr<const PackageID> & i,
@@ -78,6 +98,7 @@ namespace paludis
                 const std::string & m,
                 const std::shared_ptr<const URILabel> & n,
                 const bool sr,
+                const FSPath & mf,
                 const std::shared_ptr<OutputManager> & md,
                 const GetMirrorsFunction & g) :
             env(e),
@@ -89,11 +110,40 @@ namespace paludis
             mirrors_name(m),
             default_label(n),
             safe_resume(sr),
+            manifest(mf),
             output_manager(md),
-            get_mirrors_fn(g)
+            get_mirrors_fn(g),
+            manifest_loaded(false)
         {
             labels.push_front(default_label.get());
         }
+
+        const Manifest2Entry * manifest_entry(const std::string & filename)
+        {
+            if (! manifest_loaded)
+            {
+                manifest_loaded = true;
+                if (manifest.stat().is_regular_file_or_symlink_to_regular_file())
+                {
+                    try
+                    {
+                        manifest_reader = std::make_shared<Manifest2Reader>(manifest);
+                    }
+                    catch (const Manifest2Error &)
+                    {
+                        /* CheckFetchedFilesVisitor will complain about this */
+                    }
+                }
+            }
+
+            if (! manifest_reader)
+                return nullptr;
+
+            Manifest2Reader::ConstIterator m(manifest_reader->find("DIST", filename));
+            if (m == manifest_reader->end())
+                return nullptr;
+            return &*m;
+        }
     };
 }
 
@@ -107,9 +157,10 @@ FetchVisitor::FetchVisitor(
         const std::string & m,
         const std::shared_ptr<const URILabel> & n,
         const bool sr,
+        const FSPath & mf,
         const std::shared_ptr<OutputManager> & md,
         const GetMirrorsFunction & g) :
-    _imp(e, i, p, d, f, u, m, n, sr, md, g)
+    _imp(e, i, p, d, f, u, m, n, sr, mf, md, g)
 {
 }
 
@@ -148,6 +199,25 @@ namespace
     {
         return d / ("do" + tolower(x));
     }
+
+    /* the file that a file:// URI names, worked out as dofile does */
+    FSPath local_file(const std::string & uri)
+    {
+        std::string::size_type p(uri.find_first_not_of('/', std::string("file:").length()));
+        return FSPath("/" + (std::string::npos == p ? std::string("") : uri.substr(p)));
+    }
+
+    /* whether the fetcher could have read the file, had we run it as the
+     * given user, ignoring supplementary groups */
+    bool readable_by(const FSStat & s, const uid_t uid, const gid_t gid)
+    {
+        if (s.owner() == uid)
+            return s.permissions() & S_IRUSR;
+        else if (s.group() == gid)
+            return s.permissions() & S_IRGRP;
+        else
+            return s.permissions() & S_IROTH;
+    }
 }
 
 void
@@ -162,6 +232,12 @@ FetchVisitor::visit(const FetchableURISpecTree::NodeType<FetchableURIDepSpec>::T
     SourceURIFinder source_uri_finder(_imp->env, repo.get(),
             node.spec()->original_url(), node.spec()->filename(), _imp->mirrors_name, _imp->get_mirrors_fn);
     (*_imp->labels.begin())->accept(source_uri_finder);
+
+    /* try the hosts that have worked best for us before first */
+    const FSPath mirror_health_file(_imp->distdir / ".paludis-mirror-health");
+    source_uri_finder.rank([&] (const std::string & uri) {
+            return MirrorHealth::get_instance()->score(mirror_health_file, uri);
+            });
     for (SourceURIFinder::ConstIterator i(source_uri_finder.begin()), i_end(source_uri_finder.end()) ;
             i != i_end ; ++i)
     {
@@ -252,7 +328,71 @@ FetchVisitor::visit(const FetchableURISpecTree::NodeType<FetchableURIDepSpec>::T
                 _imp->output_manager->stdout_stream() << "Trying to fetch '" << i->first << "' to '" <<
                     i->second << "'..." << std::endl;
 
-                if (0 != fetch_process.run().wait())
+                const Manifest2Entry * const entry(_imp->manifest_entry(node.spec()->filename()));
+                auto algorithms(std::make_shared<Set<std::string> >());
+                if (entry)
+                    for (const auto & h : *entry->hashes())
+                        algorithms->insert(h.first);
+
+                /* a local file we can copy ourselves, hashing it as we go,
+                 * as long as the fetcher would have been allowed to read it */
+                FSPath source(local_file(i->first));
+                bool copy_locally(false);
+                if (entry && "file" == tolower(protocol))
+                {
+                    FSStat source_stat(source.realpath_if_exists());
+                    copy_locally = source_stat.is_regular_file() && ((! _imp->userpriv) ||
+                            readable_by(source_stat, _imp->env->reduced_uid(), _imp->env->reduced_gid()));
+                }
+
+                auto start_time(std::chrono::steady_clock::now());
+                int exit_status(0);
+                bool oversized(false);
+
+                if (copy_locally)
+                {
+                    DistfileDigester digester(destination, entry->size(), algorithms, [] () { });
+                    exit_status = digester.copy_from(source) ? 0 : 1;
+                    oversized = ! digester.finish(0 == exit_status);
+
+                    if (0 == exit_status && _imp->userpriv)
+                        destination.chown(_imp->env->reduced_uid(), _imp->env->reduced_gid());
+                }
+                else
+                {
+                    RunningProcessHandle handle(fetch_process.run());
+
+                    /* give up as soon as the file is bigger than the Manifest says
+                     * it should be, and hash it once it is here so that checking
+                     * it need not read it again */
+                    std::unique_ptr<DistfileDigester> digester;
+                    if (entry)
+                        digester.reset(new DistfileDigester(destination, entry->size(), algorithms,
+                                [&handle] () { handle.signal(SIGTERM); }));
+
+                    exit_status = handle.wait();
+                    oversized = digester && ! digester->finish(0 == exit_status);
+                }
+
+                if (oversized)
+                {
+                    _imp->output_manager->stdout_stream() << "Fetch of '" << i->first << "' exceeded the Manifest size of "
+                        << entry->size() << " bytes, abandoning it" << std::endl;
+                    FSPath(destination.dirname() / (destination.basename() + ".-PARTIAL-")).unlink();
+                    exit_status = 1;
+                }
+
+                /* a missing file or our own abandoning of it says nothing
+                 * about the host, but being unable to reach it does */
+                std::chrono::duration<double> seconds(std::chrono::steady_clock::now() - start_time);
+                FSStat fetched_stat(destination);
+                if (0 == exit_status && fetched_stat.exists())
+                    MirrorHealth::get_instance()->record(mirror_health_file, i->first, true,
+                            fetched_stat.file_size(), seconds.count());
+                else if (fetcher_network_failure == exit_status)
+                    MirrorHealth::get_instance()->record(mirror_health_file, i->first, false, 0, seconds.count());
+
+                if (0 != exit_status)
                     destination.unlink();
                 break;
             }
@@ -53,6 +53,7 @@ namespace paludis
                         const std::string & mirrors_name,
                         const std::shared_ptr<const URILabel> & initial_label,
                         const bool safe_resume,
+                        const FSPath & manifest,
                         const std::shared_ptr<OutputManager> &,
                         const GetMirrorsFunction &);
 
@@ -79,7 +79,7 @@ TEST(FetchVisitor, Works)
                         &env, { }), nullptr, { }))]->begin(),
             *eapi, FSPath("fetch_visitor_TEST_dir/out"),
             false, false, "test", std::make_shared<URIListedThenMirrorsLabel>("listed-then-mirrors"), false,
-            std::make_shared<StandardOutputManager>(), get_mirrors_fn);
+            FSPath("/var/empty"), std::make_shared<StandardOutputManager>(), get_mirrors_fn);
     parse_fetchable_uri("file:///" + stringify(FSPath("fetch_visitor_TEST_dir/in/input1").realpath()), &env, *eapi, false)->top()->accept(v);
 
     ASSERT_TRUE(FSPath("fetch_visitor_TEST_dir/out/input1").stat().is_regular_file());
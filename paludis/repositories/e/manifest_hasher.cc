@@ -0,0 +1,190 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/repositories/e/manifest_hasher.hh>
+#include <paludis/repositories/e/memoised_hashes.hh>
+
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/thread_pool.hh>
+#include <paludis/util/digest_registry.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/map.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    struct Job
+    {
+        std::string type;
+        std::string name;
+        FSPath file;
+        std::shared_ptr<const Map<std::string, std::string> > known_hashes;
+        std::string line;
+    };
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<ManifestHasher>
+    {
+        const std::shared_ptr<const Set<std::string> > algorithms;
+        std::vector<Job> jobs;
+
+        std::atomic<unsigned> next_job;
+        std::mutex exception_mutex;
+        std::exception_ptr worker_exception;
+
+        Imp(const std::shared_ptr<const Set<std::string> > & a) :
+            algorithms(a),
+            next_job(0)
+        {
+        }
+
+        void hash(Job & job)
+        {
+            Context context("When working out Manifest hashes for '" + stringify(job.file) + "':");
+
+            std::map<std::string, std::string> hashes;
+            std::size_t size;
+
+            if (job.known_hashes)
+            {
+                for (const auto & algo : *algorithms)
+                    hashes[algo] = job.known_hashes->find(algo)->second;
+                size = job.file.stat().file_size();
+            }
+            else
+            {
+                const bool is_dist("DIST" == job.type);
+
+                std::vector<std::string> missing;
+                for (const auto & algo : *algorithms)
+                {
+                    std::string h(is_dist ? MemoisedHashes::get_instance()->get_if_known(algo, job.file) : "");
+                    if (h.empty())
+                        missing.push_back(algo);
+                    else
+                        hashes[algo] = h;
+                }
+
+                size = job.file.stat().file_size();
+
+                /* read rather than map, since a distfile being rewritten in
+                 * place by a fetcher would SIGBUS us through a mapping.
+                 * Rereads for later algorithms come from the page cache. */
+                for (const auto & algo : missing)
+                {
+                    SafeIFStream stream(job.file);
+                    hashes[algo] = DigestRegistry::get_instance()->get(algo)(stream);
+
+                    if (is_dist)
+                        MemoisedHashes::get_instance()->set(algo, job.file, hashes[algo]);
+                }
+            }
+
+            job.line = job.type + " " + job.name + " " + stringify(size);
+            for (const auto & algo : *algorithms)
+                job.line += " " + algo + " " + hashes[algo];
+        }
+
+        void worker() noexcept
+        {
+            while (true)
+            {
+                unsigned n(next_job++);
+                if (n >= jobs.size())
+                    return;
+
+                try
+                {
+                    hash(jobs[n]);
+                }
+                catch (...)
+                {
+                    std::unique_lock<std::mutex> lock(exception_mutex);
+                    if (! worker_exception)
+                        worker_exception = std::current_exception();
+                    next_job = jobs.size();
+                    return;
+                }
+            }
+        }
+    };
+}
+
+ManifestHasher::ManifestHasher(const std::shared_ptr<const Set<std::string> > & a) :
+    _imp(a)
+{
+}
+
+ManifestHasher::~ManifestHasher() = default;
+
+unsigned
+ManifestHasher::add(
+        const std::string & type,
+        const std::string & name,
+        const FSPath & file,
+        const std::shared_ptr<const Map<std::string, std::string> > & known_hashes)
+{
+    _imp->jobs.push_back(Job{ type, name, file, known_hashes, "" });
+    return _imp->jobs.size() - 1;
+}
+
+void
+ManifestHasher::run()
+{
+    _imp->next_job = 0;
+
+    {
+        ThreadPool pool;
+        unsigned n_threads(std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), _imp->jobs.size()));
+        for (unsigned n(0) ; n != n_threads ; ++n)
+            pool.create_thread([this] () noexcept { _imp->worker(); });
+    }
+
+    if (_imp->worker_exception)
+        std::rethrow_exception(_imp->worker_exception);
+}
+
+const std::string
+ManifestHasher::line(const unsigned n) const
+{
+    return _imp->jobs.at(n).line;
+}
+
+namespace paludis
+{
+    template class Pimp<ManifestHasher>;
+}
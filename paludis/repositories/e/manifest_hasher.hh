@@ -0,0 +1,86 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MANIFEST_HASHER_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MANIFEST_HASHER_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/set-fwd.hh>
+#include <paludis/util/map-fwd.hh>
+
+#include <memory>
+#include <string>
+
+namespace paludis
+{
+    namespace erepository
+    {
+        /**
+         * Works out the lines for one or more Manifests.
+         *
+         * Files are spread over a pool of threads, and each file is read
+         * only once however many algorithms are wanted. DIST hashes are
+         * shared with MemoisedHashes, so that distfiles hashed whilst being
+         * fetched or checked aren't read again.
+         *
+         * \ingroup grperepository
+         * \since 3.0
+         */
+        class PALUDIS_VISIBLE ManifestHasher
+        {
+            private:
+                Pimp<ManifestHasher> _imp;
+
+            public:
+                explicit ManifestHasher(const std::shared_ptr<const Set<std::string> > & algorithms);
+                ~ManifestHasher();
+
+                ManifestHasher(const ManifestHasher &) = delete;
+                ManifestHasher & operator= (const ManifestHasher &) = delete;
+
+                /**
+                 * Queue a file, returning a handle for use with line().
+                 *
+                 * If known_hashes is not null, it must hold a hash for every
+                 * algorithm, and the file isn't read at all.
+                 */
+                unsigned add(
+                        const std::string & type,
+                        const std::string & name,
+                        const FSPath & file,
+                        const std::shared_ptr<const Map<std::string, std::string> > & known_hashes);
+
+                /**
+                 * Hash everything queued, rethrowing the first failure.
+                 */
+                void run();
+
+                /**
+                 * The Manifest line for something queued, after run().
+                 */
+                const std::string line(const unsigned) const PALUDIS_ATTRIBUTE((warn_unused_result));
+        };
+    }
+
+    extern template class Pimp<erepository::ManifestHasher>;
+}
+
+#endif
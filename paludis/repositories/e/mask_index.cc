@@ -0,0 +1,208 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/mask_index.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/options.hh>
+#include <paludis/dep_spec.hh>
+#include <paludis/package_id.hh>
+#include <paludis/match_package.hh>
+#include <paludis/version_requirements.hh>
+#include <paludis/version_operator.hh>
+#include <paludis/version_spec.hh>
+#include <paludis/name.hh>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    struct IndexedMask
+    {
+        unsigned order;
+        std::shared_ptr<const MaskInfo> info;
+    };
+
+    typedef std::vector<std::pair<VersionSpec, IndexedMask> > VersionedMasks;
+
+    struct PackageMasks
+    {
+        std::vector<IndexedMask> unversioned;
+        VersionedMasks equal;
+        VersionedMasks less;
+        VersionedMasks less_equal;
+        VersionedMasks greater;
+        VersionedMasks greater_equal;
+        std::vector<std::pair<PackageDepSpec, IndexedMask> > other;
+    };
+
+    bool compare_versions(const std::pair<VersionSpec, IndexedMask> & a, const std::pair<VersionSpec, IndexedMask> & b)
+    {
+        return a.first < b.first;
+    }
+
+    bool compare_order(const IndexedMask & a, const IndexedMask & b)
+    {
+        return a.order < b.order;
+    }
+
+    void insert_sorted(VersionedMasks & masks, const VersionSpec & v, const IndexedMask & m)
+    {
+        auto p(std::make_pair(v, m));
+        masks.insert(std::upper_bound(masks.begin(), masks.end(), p, &compare_versions), p);
+    }
+
+    template <typename I_>
+    void copy_masks(I_ begin, I_ end, std::vector<IndexedMask> & result)
+    {
+        for ( ; begin != end ; ++begin)
+            result.push_back(begin->second);
+    }
+
+    bool is_version_only(const PackageDepSpec & spec)
+    {
+        if (spec.package_name_part_ptr() || spec.category_name_part_ptr() || spec.slot_requirement_ptr() ||
+                spec.in_repository_ptr() || spec.from_repository_ptr() || spec.installed_at_path_ptr() ||
+                spec.installable_to_repository_ptr() || spec.installable_to_path_ptr())
+            return false;
+
+        if (spec.additional_requirements_ptr() &&
+                spec.additional_requirements_ptr()->begin() != spec.additional_requirements_ptr()->end())
+            return false;
+
+        return true;
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<MaskIndex>
+    {
+        const Environment * const env;
+        unsigned next_order;
+        std::unordered_map<QualifiedPackageName, PackageMasks, Hash<QualifiedPackageName> > masks;
+
+        Imp(const Environment * const e) :
+            env(e),
+            next_order(0)
+        {
+        }
+    };
+}
+
+MaskIndex::MaskIndex(const Environment * const e) :
+    _imp(e)
+{
+}
+
+MaskIndex::~MaskIndex() = default;
+
+void
+MaskIndex::add(const PackageDepSpec & spec, const std::shared_ptr<const MaskInfo> & info)
+{
+    if (! spec.package_ptr())
+        throw InternalError(PALUDIS_HERE, "MaskIndex::add called with a spec that has no package");
+
+    IndexedMask mask{ _imp->next_order++, info };
+    PackageMasks & p(_imp->masks[*spec.package_ptr()]);
+
+    if (is_version_only(spec))
+    {
+        auto reqs(spec.version_requirements_ptr());
+        if ((! reqs) || reqs->begin() == reqs->end())
+        {
+            p.unversioned.push_back(mask);
+            return;
+        }
+
+        if (std::next(reqs->begin()) == reqs->end())
+        {
+            const VersionSpec & v(reqs->begin()->version_spec());
+            switch (reqs->begin()->version_operator().value())
+            {
+                case vo_equal:
+                    insert_sorted(p.equal, v, mask);
+                    return;
+                case vo_less:
+                    insert_sorted(p.less, v, mask);
+                    return;
+                case vo_less_equal:
+                    insert_sorted(p.less_equal, v, mask);
+                    return;
+                case vo_greater:
+                    insert_sorted(p.greater, v, mask);
+                    return;
+                case vo_greater_equal:
+                    insert_sorted(p.greater_equal, v, mask);
+                    return;
+
+                case vo_tilde:
+                case vo_equal_star:
+                case vo_tilde_greater:
+                case last_vo:
+                    break;
+            }
+        }
+    }
+
+    p.other.push_back(std::make_pair(spec, mask));
+}
+
+const std::shared_ptr<const MasksInfo>
+MaskIndex::query(const std::shared_ptr<const PackageID> & id) const
+{
+    auto result(std::make_shared<MasksInfo>());
+
+    auto r(_imp->masks.find(id->name()));
+    if (_imp->masks.end() == r)
+        return result;
+
+    const PackageMasks & p(r->second);
+    const std::pair<VersionSpec, IndexedMask> key(id->version(), IndexedMask{ 0, nullptr });
+    std::vector<IndexedMask> matches(p.unversioned);
+
+    auto e(std::equal_range(p.equal.begin(), p.equal.end(), key, &compare_versions));
+    copy_masks(e.first, e.second, matches);
+
+    /* id < bound and id <= bound are suffixes, id > bound and id >= bound are prefixes */
+    copy_masks(std::upper_bound(p.less.begin(), p.less.end(), key, &compare_versions), p.less.end(), matches);
+    copy_masks(std::lower_bound(p.less_equal.begin(), p.less_equal.end(), key, &compare_versions), p.less_equal.end(), matches);
+    copy_masks(p.greater.begin(), std::lower_bound(p.greater.begin(), p.greater.end(), key, &compare_versions), matches);
+    copy_masks(p.greater_equal.begin(), std::upper_bound(p.greater_equal.begin(), p.greater_equal.end(), key, &compare_versions), matches);
+
+    for (const auto & o : p.other)
+        if (match_package(*_imp->env, o.first, id, nullptr, { }))
+            matches.push_back(o.second);
+
+    std::sort(matches.begin(), matches.end(), &compare_order);
+    for (const auto & m : matches)
+        result->push_back(*m.info);
+
+    return result;
+}
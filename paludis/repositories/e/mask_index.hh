@@ -0,0 +1,72 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MASK_INDEX_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MASK_INDEX_HH 1
+
+#include <paludis/repositories/e/mask_info.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/environment-fwd.hh>
+#include <paludis/dep_spec-fwd.hh>
+#include <paludis/package_id-fwd.hh>
+
+#include <memory>
+
+namespace paludis
+{
+    namespace erepository
+    {
+        /**
+         * Holds repository package masks in a form that can be queried
+         * without calling match_package for every mask line.
+         *
+         * Specs that restrict only on package name and a single ordered
+         * version operator (=, <, <=, >, >=) are kept in sorted version
+         * lists, so a query is a handful of binary searches. Anything
+         * else falls back to match_package.
+         *
+         * \ingroup grperepository
+         * \since 3.0
+         */
+        class PALUDIS_VISIBLE MaskIndex
+        {
+            private:
+                Pimp<MaskIndex> _imp;
+
+            public:
+                explicit MaskIndex(const Environment * const);
+                ~MaskIndex();
+
+                MaskIndex(const MaskIndex &) = delete;
+                MaskIndex & operator= (const MaskIndex &) = delete;
+
+                /**
+                 * Add a mask. The spec must have a package_ptr. Query results
+                 * are returned in the order that masks were added.
+                 */
+                void add(const PackageDepSpec &, const std::shared_ptr<const MaskInfo> &);
+
+                const std::shared_ptr<const MasksInfo> query(const std::shared_ptr<const PackageID> & id) const;
+        };
+    }
+}
+
+#endif
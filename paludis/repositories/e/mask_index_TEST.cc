@@ -0,0 +1,100 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/mask_index.hh>
+
+#include <paludis/util/join.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/options.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/fake_package_id.hh>
+
+#include <paludis/user_dep_spec.hh>
+#include <paludis/match_package.hh>
+#include <paludis/package_id.hh>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    std::string tokens(const std::shared_ptr<const MasksInfo> & m)
+    {
+        std::string result;
+        for (const auto & i : *m)
+            result.append((result.empty() ? "" : " ") + i.token());
+        return result;
+    }
+}
+
+TEST(MaskIndex, Works)
+{
+    TestEnvironment env;
+    std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo"))));
+    env.add_repository(1, repo);
+
+    std::vector<std::shared_ptr<const PackageID> > ids;
+    for (const auto & v : { "1", "1.1", "1.10", "2", "2-r1", "3_alpha", "3", "10" })
+    {
+        auto id(repo->add_version("cat", "pkg", v));
+        id->set_slot(SlotName(ids.empty() ? "a" : "0"));
+        ids.push_back(id);
+    }
+    ids.push_back(repo->add_version("cat", "other", "1"));
+
+    const std::vector<std::string> specs{ "cat/pkg", "=cat/pkg-1.1", "<cat/pkg-2", "<=cat/pkg-2", ">cat/pkg-2",
+        ">=cat/pkg-2-r1", "=cat/pkg-3", "~cat/pkg-2", "=cat/pkg-1*", "cat/pkg:a", "cat/pkg::repo", "=cat/pkg-1.1",
+        "<cat/pkg-1", ">cat/pkg-10", "cat/other", "=cat/other-2" };
+
+    MaskIndex index(&env);
+    std::vector<PackageDepSpec> parsed;
+    for (auto s(specs.begin()), s_end(specs.end()) ; s != s_end ; ++s)
+    {
+        parsed.push_back(parse_user_package_dep_spec(*s, &env, { }));
+        index.add(parsed.back(), std::make_shared<MaskInfo>(make_named_values<MaskInfo>(
+                        n::comment() = "",
+                        n::mask_file() = FSPath("/package.mask"),
+                        n::token() = *s
+                        )));
+    }
+
+    for (const auto & id : ids)
+    {
+        std::string expected;
+        for (unsigned i(0) ; i < specs.size() ; ++i)
+            if (match_package(env, parsed[i], id, nullptr, { }))
+                expected.append((expected.empty() ? "" : " ") + specs[i]);
+
+        EXPECT_EQ(expected, tokens(index.query(id))) << *id;
+    }
+
+    EXPECT_EQ("cat/pkg <cat/pkg-2 <=cat/pkg-2 =cat/pkg-1* cat/pkg:a cat/pkg::repo", tokens(index.query(ids.front())));
+    EXPECT_EQ("", tokens(index.query(repo->add_version("cat", "unmasked", "1"))));
+}
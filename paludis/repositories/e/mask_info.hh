@@ -24,6 +24,7 @@
 #include <paludis/util/fs_path.hh>
 #include <paludis/util/sequence.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/attributes.hh>
 
 namespace paludis
 {
@@ -46,8 +47,8 @@ namespace paludis
         typedef Sequence<MaskInfo> MasksInfo;
     }
 
-    extern template class Sequence<erepository::MaskInfo>;
-    extern template class WrappedForwardIterator<Sequence<erepository::MaskInfo>::ConstIterator, const erepository::MaskInfo>;
+    extern template class PALUDIS_VISIBLE Sequence<erepository::MaskInfo>;
+    extern template class PALUDIS_VISIBLE WrappedForwardIterator<Sequence<erepository::MaskInfo>::ConstIteratorTag, const erepository::MaskInfo>;
 }
 
 #endif
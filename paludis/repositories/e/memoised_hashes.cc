@@ -57,29 +57,53 @@ MemoisedHashes::~MemoisedHashes() = default;
 
 const std::string
 MemoisedHashes::get(const std::string & algo, const FSPath & file, SafeIFStream & stream) const
+{
+    std::string result(get_if_known(algo, file));
+    if (! result.empty())
+        return result;
+
+    /* don't hold the lock whilst hashing, so that other files can be looked
+     * up or hashed at the same time */
+    result = DigestRegistry::get_instance()->get(algo)(stream);
+    stream.clear();
+    stream.seekg(0, std::ios::beg);
+
+    set(algo, file, result);
+    return result;
+}
+
+const std::string
+MemoisedHashes::get_if_known(const std::string & algo, const FSPath & file) const
 {
     std::pair<std::string, std::string> key(stringify(file), algo);
     Timestamp mtime(file.stat().mtim());
 
     std::unique_lock<std::mutex> lock(_imp->mutex);
 
-    HashesMap::iterator i(_imp->hashes.find(key));
-
+    HashesMap::const_iterator i(_imp->hashes.find(key));
     if (i == _imp->hashes.end() || i->second.first != mtime)
-    {
-        std::pair<Timestamp, std::string> value(std::make_pair(mtime, DigestRegistry::get_instance()->get(algo)(stream)));
-        stream.clear();
-        stream.seekg(0, std::ios::beg);
-
-        if (i != _imp->hashes.end())
-            i->second = value;
-        else
-            i = _imp->hashes.insert(std::make_pair(key, value)).first;
-    }
+        return "";
 
     return i->second.second;
 }
 
+void
+MemoisedHashes::set(const std::string & algo, const FSPath & file, const std::string & hexsum) const
+{
+    std::pair<std::string, std::string> key(stringify(file), algo);
+    Timestamp mtime(file.stat().mtim());
+
+    std::pair<Timestamp, std::string> value(std::make_pair(mtime, hexsum));
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    HashesMap::iterator i(_imp->hashes.find(key));
+    if (i != _imp->hashes.end())
+        i->second = value;
+    else
+        _imp->hashes.insert(std::make_pair(key, value));
+}
+
 namespace paludis
 {
     template class Pimp<MemoisedHashes>;
@@ -40,6 +40,22 @@ namespace paludis
 
                 const std::string get(const std::string & algo, const FSPath & file, SafeIFStream & stream) const;
 
+                /**
+                 * Return a remembered hash, or an empty string if we don't
+                 * have one for the file as it currently is.
+                 *
+                 * \since 3.0
+                 */
+                const std::string get_if_known(const std::string & algo, const FSPath & file) const;
+
+                /**
+                 * Remember a hash that was worked out elsewhere, for instance
+                 * whilst the file was being fetched.
+                 *
+                 * \since 3.0
+                 */
+                void set(const std::string & algo, const FSPath & file, const std::string & hexsum) const;
+
             private:
                 MemoisedHashes();
                 ~MemoisedHashes();
@@ -0,0 +1,251 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/repositories/e/mirror_health.hh>
+
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/singleton-impl.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/tokeniser.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/log.hh>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+namespace
+{
+    const std::string magic("paludis-mirror-health-1");
+
+    /* each new result for a host makes the old ones count for this much
+     * less, so a mirror that has come back to life recovers quickly */
+    const double decay(0.8);
+
+    /* a host fetching at this many bytes per second gets half marks for
+     * speed */
+    const double reference_throughput(1024.0 * 1024.0);
+
+    struct HostStats
+    {
+        double successes;
+        double failures;
+        double bytes;
+        double seconds;
+
+        HostStats() :
+            successes(0),
+            failures(0),
+            bytes(0),
+            seconds(0)
+        {
+        }
+    };
+
+    typedef std::map<std::string, HostStats> HostStatsMap;
+
+    void load(const FSPath & file, HostStatsMap & stats)
+    {
+        if (! file.stat().is_regular_file_or_symlink_to_regular_file())
+            return;
+
+        try
+        {
+            SafeIFStream f(file);
+            std::string line;
+            if ((! std::getline(f, line)) || line != magic)
+            {
+                Log::get_instance()->message("e.mirror_health.bad_file", ll_debug, lc_context)
+                    << "Ignoring mirror health file '" << file << "' with unrecognised format";
+                return;
+            }
+
+            while (std::getline(f, line))
+            {
+                std::vector<std::string> tokens;
+                tokenise_whitespace(line, std::back_inserter(tokens));
+                if (5 != tokens.size())
+                    continue;
+
+                HostStats s;
+                s.successes = destringify<double>(tokens[1]);
+                s.failures = destringify<double>(tokens[2]);
+                s.bytes = destringify<double>(tokens[3]);
+                s.seconds = destringify<double>(tokens[4]);
+                stats[tokens[0]] = s;
+            }
+        }
+        catch (const Exception & e)
+        {
+            Log::get_instance()->message("e.mirror_health.bad_file", ll_debug, lc_context)
+                << "Ignoring mirror health file '" << file << "': '" << e.message() << "' (" << e.what() << ")";
+            stats.clear();
+        }
+    }
+
+    void save(const FSPath & file, const HostStatsMap & stats)
+    {
+        try
+        {
+            AtomicOFStream f(file);
+            f.stream() << magic << std::endl;
+            for (const auto & s : stats)
+                f.stream() << s.first << "\t" << s.second.successes << "\t" << s.second.failures
+                    << "\t" << s.second.bytes << "\t" << s.second.seconds << std::endl;
+            f.commit();
+        }
+        catch (const Exception & e)
+        {
+            Log::get_instance()->message("e.mirror_health.save_failed", ll_debug, lc_context)
+                << "Couldn't save mirror health to '" << file << "': '" << e.message() << "' (" << e.what() << ")";
+        }
+    }
+}
+
+namespace paludis
+{
+    template <>
+    struct Imp<MirrorHealth>
+    {
+        mutable std::mutex mutex;
+        mutable std::map<std::string, HostStatsMap> files;
+        std::set<std::string> changed_files;
+
+        HostStatsMap & stats_for(const FSPath & file) const
+        {
+            auto i(files.find(stringify(file)));
+            if (i == files.end())
+            {
+                i = files.insert(std::make_pair(stringify(file), HostStatsMap())).first;
+                load(file, i->second);
+            }
+
+            return i->second;
+        }
+    };
+}
+
+MirrorHealth::MirrorHealth() = default;
+
+MirrorHealth::~MirrorHealth() = default;
+
+std::string
+MirrorHealth::host_of(const std::string & uri)
+{
+    std::string::size_type p(uri.find("://"));
+    if (std::string::npos == p)
+        return "";
+
+    std::string host(uri.substr(p + 3));
+    host.erase(std::min(host.find('/'), host.length()));
+
+    std::string::size_type at(host.rfind('@'));
+    if (std::string::npos != at)
+        host.erase(0, at + 1);
+
+    /* a port doesn't make it a different host, but [::1] needs care */
+    std::string::size_type colon(host.find(':', host.empty() || '[' != host[0] ? 0 : host.find(']')));
+    if (std::string::npos != colon)
+        host.erase(colon);
+
+    return host;
+}
+
+double
+MirrorHealth::score(const FSPath & file, const std::string & uri) const
+{
+    std::string host(host_of(uri));
+    if (host.empty())
+        return 0.5;
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    const HostStatsMap & stats(_imp->stats_for(file));
+    auto s(stats.find(host));
+    if (s == stats.end())
+        return 0.5;
+
+    /* mostly how often it works, with unknown hosts in the middle, and then
+     * how fast it is */
+    double rate((s->second.successes + 1.0) / (s->second.successes + s->second.failures + 2.0));
+
+    double speed(0.5);
+    if (s->second.seconds > 0 && s->second.bytes > 0)
+    {
+        double throughput(s->second.bytes / s->second.seconds);
+        speed = throughput / (throughput + reference_throughput);
+    }
+
+    return 0.75 * rate + 0.25 * speed;
+}
+
+void
+MirrorHealth::record(const FSPath & file, const std::string & uri, const bool success,
+        const off_t bytes, const double seconds)
+{
+    std::string host(host_of(uri));
+    if (host.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    HostStatsMap & stats(_imp->stats_for(file));
+    HostStats & s(stats[host]);
+
+    s.successes *= decay;
+    s.failures *= decay;
+    s.bytes *= decay;
+    s.seconds *= decay;
+
+    if (success)
+    {
+        s.successes += 1;
+        s.bytes += bytes;
+        s.seconds += seconds;
+    }
+    else
+        s.failures += 1;
+
+    _imp->changed_files.insert(stringify(file));
+}
+
+void
+MirrorHealth::save_changes()
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    for (const auto & f : _imp->changed_files)
+        save(FSPath(f), _imp->files[f]);
+    _imp->changed_files.clear();
+}
+
+namespace paludis
+{
+    template class Pimp<MirrorHealth>;
+    template class Singleton<MirrorHealth>;
+}
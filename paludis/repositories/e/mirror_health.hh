@@ -0,0 +1,93 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MIRROR_HEALTH_HH
+#define PALUDIS_GUARD_PALUDIS_REPOSITORIES_E_MIRROR_HEALTH_HH 1
+
+#include <paludis/util/pimp.hh>
+#include <paludis/util/singleton.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/fs_path-fwd.hh>
+
+#include <string>
+#include <sys/types.h>
+
+namespace paludis
+{
+    namespace erepository
+    {
+        /**
+         * Remembers how well fetching from each host has gone, so that
+         * SourceURIFinder can try the mirrors most likely to work quickly
+         * first.
+         *
+         * Statistics are kept per host in a small file, usually in the
+         * distdir, and are written back by save_changes once a batch of
+         * fetches is done. Older results count for less as newer ones
+         * arrive.
+         *
+         * \ingroup grperepository
+         * \since 3.0
+         */
+        class PALUDIS_VISIBLE MirrorHealth :
+            public Singleton<MirrorHealth>
+        {
+            friend class Singleton<MirrorHealth>;
+
+            private:
+                Pimp<MirrorHealth> _imp;
+
+                MirrorHealth();
+                ~MirrorHealth();
+
+            public:
+                /**
+                 * The host part of a URI, without any user or port, or an
+                 * empty string if it has none, as for file:// URIs.
+                 */
+                static std::string host_of(const std::string & uri) PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * How good a bet fetching from this URI's host is, between 0
+                 * and 1. Hosts we know nothing about score 0.5.
+                 */
+                double score(const FSPath & file, const std::string & uri) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Record the result of a fetch. Only failures that say
+                 * something about the host, such as being unable to connect
+                 * or timing out, should be recorded.
+                 */
+                void record(const FSPath & file, const std::string & uri, const bool success,
+                        const off_t bytes, const double seconds);
+
+                /**
+                 * Write back any files with results recorded since they
+                 * were last saved.
+                 */
+                void save_changes();
+        };
+    }
+
+    extern template class Pimp<erepository::MirrorHealth>;
+    extern template class Singleton<erepository::MirrorHealth>;
+}
+
+#endif
@@ -0,0 +1,96 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/repositories/e/mirror_health.hh>
+
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/safe_ofstream.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::erepository;
+
+TEST(MirrorHealth, HostOf)
+{
+    EXPECT_EQ("example.com", MirrorHealth::host_of("http://example.com/path/file"));
+    EXPECT_EQ("example.com", MirrorHealth::host_of("https://user@example.com:8080/file"));
+    EXPECT_EQ("[::1]", MirrorHealth::host_of("http://[::1]:8080/file"));
+    EXPECT_EQ("example.com", MirrorHealth::host_of("ftp://example.com"));
+    EXPECT_EQ("", MirrorHealth::host_of("/local/path"));
+}
+
+TEST(MirrorHealth, Unknown)
+{
+    FSPath file(FSPath::cwd() / "mirror_health_TEST_dir" / "unknown");
+    EXPECT_DOUBLE_EQ(0.5, MirrorHealth::get_instance()->score(file, "http://nowhere.example/file"));
+    EXPECT_DOUBLE_EQ(0.5, MirrorHealth::get_instance()->score(file, "file"));
+    EXPECT_TRUE(! file.stat().exists());
+}
+
+TEST(MirrorHealth, Ranking)
+{
+    FSPath file(FSPath::cwd() / "mirror_health_TEST_dir" / "ranking");
+
+    MirrorHealth::get_instance()->record(file, "http://good.example/a", true, 10 * 1024 * 1024, 1.0);
+    MirrorHealth::get_instance()->record(file, "http://slow.example/a", true, 1024, 1.0);
+    MirrorHealth::get_instance()->record(file, "http://bad.example/a", false, 0, 5.0);
+
+    double good(MirrorHealth::get_instance()->score(file, "http://good.example/b"));
+    double slow(MirrorHealth::get_instance()->score(file, "http://slow.example/b"));
+    double bad(MirrorHealth::get_instance()->score(file, "http://bad.example/b"));
+    double unknown(MirrorHealth::get_instance()->score(file, "http://unknown.example/b"));
+
+    EXPECT_GT(good, slow);
+    EXPECT_GT(slow, unknown);
+    EXPECT_GT(unknown, bad);
+
+    /* a bad mirror that starts working again recovers */
+    for (int n(0) ; n < 10 ; ++n)
+        MirrorHealth::get_instance()->record(file, "http://bad.example/a", true, 10 * 1024 * 1024, 1.0);
+    EXPECT_GT(MirrorHealth::get_instance()->score(file, "http://bad.example/b"), slow);
+}
+
+TEST(MirrorHealth, Persisted)
+{
+    FSPath file(FSPath::cwd() / "mirror_health_TEST_dir" / "persisted");
+    MirrorHealth::get_instance()->record(file, "http://bad.example/a", false, 0, 1.0);
+    EXPECT_TRUE(! file.stat().exists());
+    MirrorHealth::get_instance()->save_changes();
+    ASSERT_TRUE(file.stat().is_regular_file());
+
+    /* reach the same file by another name, so it has to be read back in */
+    FSPath other(FSPath::cwd() / "mirror_health_TEST_dir" / "." / "persisted");
+    EXPECT_DOUBLE_EQ(MirrorHealth::get_instance()->score(file, "http://bad.example/b"),
+            MirrorHealth::get_instance()->score(other, "http://bad.example/b"));
+    EXPECT_LT(MirrorHealth::get_instance()->score(other, "http://bad.example/b"), 0.5);
+}
+
+TEST(MirrorHealth, BadFile)
+{
+    FSPath file(FSPath::cwd() / "mirror_health_TEST_dir" / "bad");
+    {
+        SafeOFStream s(file, -1, true);
+        s << "not a mirror health file" << std::endl;
+        s << "bad.example\t0\t10\t0\t0" << std::endl;
+    }
+
+    EXPECT_DOUBLE_EQ(0.5, MirrorHealth::get_instance()->score(file, "http://bad.example/b"));
+}
@@ -29,7 +29,9 @@
 #include <paludis/util/sequence-impl.hh>
 #include <paludis/util/pimp-impl.hh>
 
+#include <algorithm>
 #include <list>
+#include <vector>
 
 using namespace paludis;
 using namespace paludis::erepository;
@@ -49,6 +51,7 @@ namespace paludis
         const GetMirrorsFunction get_mirrors_fn;
 
         Items items;
+        std::vector<Items::size_type> group_sizes;
 
         Imp(const Environment * const e, const Repository * const r, const std::string & u, const std::string & f,
                 const std::string & m, const GetMirrorsFunction & g) :
@@ -139,6 +142,7 @@ void
 SourceURIFinder::add_local_mirrors()
 {
     Context context("When adding local mirrors:");
+    Items::size_type size_before(_imp->items.size());
 
     std::shared_ptr<const MirrorsSequence> mirrors(_imp->env->mirrors("*"));
     if (mirrors->empty())
@@ -150,12 +154,15 @@ SourceURIFinder::add_local_mirrors()
             << "Adding " << strip_trailing(*m, "/") << "/" << _imp->filename;
         _imp->items.push_back(std::make_pair(strip_trailing(*m, "/") + "/" + _imp->filename, _imp->filename));
     }
+
+    _imp->group_sizes.push_back(_imp->items.size() - size_before);
 }
 
 void
 SourceURIFinder::add_mirrors()
 {
     Context context("When adding repository mirrors from '" + _imp->mirrors_name + "':");
+    Items::size_type size_before(_imp->items.size());
 
     {
         std::shared_ptr<const MirrorsSequence> mirrors(_imp->env->mirrors(_imp->mirrors_name));
@@ -180,12 +187,15 @@ SourceURIFinder::add_mirrors()
             _imp->items.push_back(std::make_pair(strip_trailing(*m, "/") + "/" + _imp->filename, _imp->filename));
         }
     }
+
+    _imp->group_sizes.push_back(_imp->items.size() - size_before);
 }
 
 void
 SourceURIFinder::add_listed()
 {
     Context context("When adding listed locations:");
+    Items::size_type size_before(_imp->items.size());
 
     if (0 == _imp->url.compare(0, 9, "mirror://"))
     {
@@ -226,6 +236,32 @@ SourceURIFinder::add_listed()
         Log::get_instance()->message("e.source_uri_finder.adding", ll_debug, lc_context) << "Adding " << _imp->url;
         _imp->items.push_back(std::make_pair(_imp->url, _imp->filename));
     }
+
+    _imp->group_sizes.push_back(_imp->items.size() - size_before);
+}
+
+void
+SourceURIFinder::rank(const URIScoreFunction & score)
+{
+    Items result;
+    Items::iterator i(_imp->items.begin());
+    for (auto size : _imp->group_sizes)
+    {
+        std::vector<std::pair<double, std::pair<std::string, std::string> > > group;
+        for (Items::size_type n(0) ; n < size ; ++n, ++i)
+            group.push_back(std::make_pair(score(i->first), *i));
+
+        std::stable_sort(group.begin(), group.end(), [] (
+                    const std::pair<double, std::pair<std::string, std::string> > & a,
+                    const std::pair<double, std::pair<std::string, std::string> > & b) {
+                return a.first > b.first;
+                });
+
+        for (auto & g : group)
+            result.push_back(g.second);
+    }
+
+    _imp->items.swap(result);
 }
 
 namespace paludis
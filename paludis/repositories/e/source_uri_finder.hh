@@ -34,6 +34,13 @@ namespace paludis
     {
         typedef std::function<std::shared_ptr<const MirrorsSequence> (const std::string &)> GetMirrorsFunction;
 
+        /**
+         * How good a bet fetching from a URI is, higher being better.
+         *
+         * \since 3.0
+         */
+        typedef std::function<double (const std::string &)> URIScoreFunction;
+
         class PALUDIS_VISIBLE SourceURIFinder
         {
             private:
@@ -64,6 +71,16 @@ namespace paludis
                 void visit(const URIListedThenMirrorsLabel &);
                 void visit(const URILocalMirrorsOnlyLabel &);
                 void visit(const URIManualOnlyLabel &);
+
+                /**
+                 * Reorder the URIs found so far, best score first. Local
+                 * mirrors, mirrors and listed locations are each reordered
+                 * amongst themselves, so the label's preference between them
+                 * is kept. URIs that score the same keep their order.
+                 *
+                 * \since 3.0
+                 */
+                void rank(const URIScoreFunction &);
         };
     }
 }
@@ -113,3 +113,49 @@ TEST(SourceURIFinder, Mirrors)
     ASSERT_TRUE(i == f.end());
 }
 
+TEST(SourceURIFinder, Rank)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(1, repo);
+
+    SourceURIFinder f(&env, repo.get(), "mirror://example/path/input", "output", "repo", get_mirrors_fn);
+    URIMirrorsThenListedLabel label("mirrors-then-listed");
+    label.accept(f);
+
+    f.rank([] (const std::string & u) -> double {
+            if (u == "http://fake-repo/fake-repo/output")
+                return 0.0;
+            if (u == "http://fake-example/fake-example/path/input")
+                return 1.0;
+            return 0.5;
+            });
+
+    SourceURIFinder::ConstIterator i(f.begin());
+
+    ASSERT_TRUE(i != f.end());
+    EXPECT_EQ("http://fake-repo/fake-repo/output", i->first);
+
+    ++i;
+
+    ASSERT_TRUE(i != f.end());
+    EXPECT_EQ("http://fake-example/fake-example/path/input", i->first);
+
+    ++i;
+
+    ASSERT_TRUE(i != f.end());
+    EXPECT_EQ("http://example-mirror-1/example-mirror-1/path/input", i->first);
+
+    ++i;
+
+    ASSERT_TRUE(i != f.end());
+    EXPECT_EQ("http://example-mirror-2/example-mirror-2/path/input", i->first);
+
+    ++i;
+
+    ASSERT_TRUE(i == f.end());
+}
+
@@ -18,29 +18,22 @@
  */
 
 #include <paludis/repositories/e/traditional_mask_store.hh>
+#include <paludis/repositories/e/mask_index.hh>
 #include <paludis/repositories/e/traditional_profile_file.hh>
 #include <paludis/repositories/e/traditional_mask_file.hh>
 #include <paludis/repositories/e/eapi.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/exception.hh>
-#include <paludis/util/hashes.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/log.hh>
 #include <paludis/dep_spec.hh>
 #include <paludis/package_id.hh>
-#include <paludis/match_package.hh>
 
 #include <algorithm>
-#include <unordered_map>
-#include <list>
 
 using namespace paludis;
 using namespace paludis::erepository;
 
-typedef std::unordered_map<QualifiedPackageName,
-        std::list<std::pair<PackageDepSpec, std::shared_ptr<const MaskInfo> > >,
-        Hash<QualifiedPackageName> > RepositoryMaskMap;
-
 namespace paludis
 {
     template <>
@@ -51,13 +44,14 @@ namespace paludis
         const std::shared_ptr<const FSPathSequence> files;
         EAPIForFileFunction eapi_for_file;
 
-        RepositoryMaskMap repo_mask;
+        MaskIndex repo_mask;
 
         Imp(const Environment * const e, const RepositoryName & r, const std::shared_ptr<const FSPathSequence> & f, const EAPIForFileFunction & n) :
             env(e),
             repo_name(r),
             files(f),
-            eapi_for_file(n)
+            eapi_for_file(n),
+            repo_mask(e)
         {
         }
     };
@@ -96,7 +90,7 @@ TraditionalMaskStore::_populate()
                         line->second.first, line->first->supported()->package_dep_spec_parse_options(),
                         line->first->supported()->version_spec_options()));
             if (a.package_ptr())
-                _imp->repo_mask[*a.package_ptr()].push_back(std::make_pair(a, line->second.second));
+                _imp->repo_mask.add(a, line->second.second);
             else
                 Log::get_instance()->message("e.package_mask.bad_spec", ll_warning, lc_context)
                     << "Loading package mask spec '" << line->second.first << "' failed because specification does not restrict to a "
@@ -118,13 +112,6 @@ TraditionalMaskStore::_populate()
 const std::shared_ptr<const MasksInfo>
 TraditionalMaskStore::query(const std::shared_ptr<const PackageID> & id) const
 {
-    auto result(std::make_shared<MasksInfo>());
-    auto r(_imp->repo_mask.find(id->name()));
-    if (_imp->repo_mask.end() != r)
-        for (const auto & k : r->second)
-            if (match_package(*_imp->env, k.first, id, nullptr, { }))
-                result->push_back(*k.second);
-
-    return result;
+    return _imp->repo_mask.query(id);
 }
 
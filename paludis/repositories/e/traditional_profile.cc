@@ -56,6 +56,8 @@
 #include <list>
 #include <algorithm>
 #include <set>
+#include <map>
+#include <memory>
 #include <vector>
 #include <mutex>
 
@@ -97,6 +99,33 @@ namespace
     };
 
     typedef std::list<StackedValues> StackedValuesList;
+
+    /* flag -> (state, position in the flattened profile stack); a later
+     * position overrides an earlier one */
+    typedef std::unordered_map<ChoiceNameWithPrefix, std::pair<bool, unsigned>, Hash<ChoiceNameWithPrefix> > SequencedFlagStatusMap;
+
+    struct PackageFlagRule
+    {
+        unsigned position;
+        bool stable_only;
+        std::shared_ptr<const PackageDepSpec> spec;
+        const FlagStatusMap * flags;
+    };
+
+    struct PackageFlagRules
+    {
+        std::unordered_map<QualifiedPackageName, std::vector<PackageFlagRule>, Hash<QualifiedPackageName> > by_package;
+        std::vector<PackageFlagRule> other;
+    };
+
+    /* keyed on ownership rather than address, so an entry can never be
+     * mistaken for one belonging to a new ID that reuses a freed address */
+    typedef std::map<std::weak_ptr<const PackageID>, std::shared_ptr<const SequencedFlagStatusMap>,
+            std::owner_less<std::weak_ptr<const PackageID> > > FlagStateCache;
+
+    /* enough for every candidate in a typical resolution, without letting a
+     * long-lived process such as cave serve grow without bound */
+    const std::size_t flag_state_cache_limit(8192);
 }
 
 namespace paludis
@@ -130,6 +159,19 @@ namespace paludis
         mutable std::unordered_map<char, KnownMap> known_choice_value_names_for_separator;
         StackedValuesList stacked_values_list;
 
+        SequencedFlagStatusMap use_mask;
+        SequencedFlagStatusMap stable_use_mask;
+        SequencedFlagStatusMap use_force;
+        SequencedFlagStatusMap stable_use_force;
+        PackageFlagRules package_use;
+        PackageFlagRules package_use_mask;
+        PackageFlagRules package_use_force;
+
+        mutable std::mutex flag_state_cache_mutex;
+        mutable FlagStateCache use_cache;
+        mutable FlagStateCache use_mask_cache;
+        mutable FlagStateCache use_force_cache;
+
         PackageMaskMap package_mask;
 
         Imp(const Environment * const e,
@@ -191,6 +233,9 @@ namespace
             const EAPI & eapi,
             const FSPath & file,
             PackageFlagStatusMapList & m);
+
+    void flatten_stacked_values(
+            Pimp<TraditionalProfile> & _imp);
 }
 
 namespace
@@ -750,6 +795,120 @@ namespace
     }
 }
 
+namespace
+{
+    void add_sequenced_flags(SequencedFlagStatusMap & result, const FlagStatusMap & flags, const unsigned position)
+    {
+        for (const auto & f : flags)
+        {
+            auto r(result.insert(std::make_pair(f.first, std::make_pair(f.second, position))));
+            if ((! r.second) && r.first->second.second < position)
+                r.first->second = std::make_pair(f.second, position);
+        }
+    }
+
+    void add_package_flag_rules(PackageFlagRules & rules, const PackageFlagStatusMapList & m,
+            const bool stable_only, unsigned & position)
+    {
+        for (const auto & g : m)
+        {
+            PackageFlagRule rule{ position++, stable_only, g.first, &g.second };
+            if (g.first->package_ptr())
+                rules.by_package[*g.first->package_ptr()].push_back(rule);
+            else
+                rules.other.push_back(rule);
+        }
+    }
+
+    void flatten_stacked_values(
+            Pimp<TraditionalProfile> & _imp)
+    {
+        /* Number every assignment in the order use_masked and friends
+         * would have applied it, so that a per-package result can be
+         * combined with the precomputed global state by comparing
+         * positions rather than by walking the stack again. */
+        unsigned position(0);
+        for (const auto & i : _imp->stacked_values_list)
+        {
+            add_sequenced_flags(_imp->use_mask, i.use_mask, position);
+            add_sequenced_flags(_imp->stable_use_mask, i.use_mask, position++);
+            add_sequenced_flags(_imp->stable_use_mask, i.use_stable_mask, position++);
+            add_package_flag_rules(_imp->package_use_mask, i.package_use_mask, false, position);
+            add_package_flag_rules(_imp->package_use_mask, i.package_use_stable_mask, true, position);
+
+            add_sequenced_flags(_imp->use_force, i.use_force, position);
+            add_sequenced_flags(_imp->stable_use_force, i.use_force, position++);
+            add_sequenced_flags(_imp->stable_use_force, i.use_stable_force, position++);
+            add_package_flag_rules(_imp->package_use_force, i.package_use_force, false, position);
+            add_package_flag_rules(_imp->package_use_force, i.package_use_stable_force, true, position);
+
+            add_package_flag_rules(_imp->package_use, i.package_use, false, position);
+        }
+    }
+
+    const std::shared_ptr<const SequencedFlagStatusMap> package_flag_state(
+            const Environment * const env,
+            std::mutex & mutex,
+            FlagStateCache & cache,
+            const PackageFlagRules & rules,
+            const std::shared_ptr<const PackageID> & id,
+            const bool stable)
+    {
+        const std::weak_ptr<const PackageID> key(id);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto c(cache.find(key));
+            if (cache.end() != c)
+                return c->second;
+        }
+
+        auto result(std::make_shared<SequencedFlagStatusMap>());
+        auto apply([&] (const std::vector<PackageFlagRule> & v) {
+                for (const auto & r : v)
+                    if ((stable || ! r.stable_only) && match_package(*env, *r.spec, id, nullptr, { }))
+                        add_sequenced_flags(*result, *r.flags, r.position);
+                });
+
+        auto b(rules.by_package.find(id->name()));
+        if (rules.by_package.end() != b)
+            apply(b->second);
+        apply(rules.other);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (cache.size() >= flag_state_cache_limit)
+        {
+            for (auto c(cache.begin()), c_end(cache.end()) ; c != c_end ; )
+                if (c->first.expired())
+                    cache.erase(c++);
+                else
+                    ++c;
+
+            /* everything is still alive, so start again rather than pick
+             * victims; recomputing an entry is only a bucket of matches */
+            if (cache.size() >= flag_state_cache_limit / 2)
+                cache.clear();
+        }
+
+        cache.insert(std::make_pair(key, result));
+        return result;
+    }
+
+    bool lookup_flag_state(const SequencedFlagStatusMap & global, const SequencedFlagStatusMap & package,
+            const ChoiceNameWithPrefix & value_prefixed)
+    {
+        auto g(global.find(value_prefixed));
+        auto p(package.find(value_prefixed));
+
+        if (package.end() == p)
+            return global.end() == g ? false : g->second.first;
+        else if (global.end() == g || g->second.second < p->second.second)
+            return p->second.first;
+        else
+            return g->second.first;
+    }
+}
+
 TraditionalProfile::TraditionalProfile(
         const Environment * const env,
         const RepositoryName & name,
@@ -788,6 +947,7 @@ TraditionalProfile::TraditionalProfile(
     fish_out_use_expand_names(_imp);
     if (! arch_var_if_special.empty())
         handle_profile_arch_var(_imp, arch_var_if_special);
+    flatten_stacked_values(_imp);
 }
 
 TraditionalProfile::~TraditionalProfile() = default;
@@ -810,46 +970,9 @@ TraditionalProfile::use_masked(
             (! use_state_ignoring_masks(id, choice, value_unprefixed, value_prefixed).is_true()))
         return true;
 
-    bool result(false);
-    for (StackedValuesList::const_iterator i(_imp->stacked_values_list.begin()),
-            i_end(_imp->stacked_values_list.end()) ; i != i_end ; ++i)
-    {
-        FlagStatusMap::const_iterator f(i->use_mask.find(value_prefixed));
-        if (i->use_mask.end() != f)
-            result = f->second;
-
-        if (id->is_stable())
-        {
-            FlagStatusMap::const_iterator fs(i->use_stable_mask.find(value_prefixed));
-            if (i->use_stable_mask.end() != fs)
-                result = fs->second;
-        }
-
-        for (const auto & g : i->package_use_mask)
-        {
-            if (! match_package(*_imp->env, *g.first, id, nullptr, { }))
-                continue;
-
-            FlagStatusMap::const_iterator h(g.second.find(value_prefixed));
-            if (g.second.end() != h)
-                result = h->second;
-        }
-
-        if (id->is_stable())
-        {
-            for (const auto & gs : i->package_use_stable_mask)
-            {
-                if (! match_package(*_imp->env, *gs.first, id, nullptr, { }))
-                    continue;
-
-                FlagStatusMap::const_iterator hs(gs.second.find(value_prefixed));
-                if (gs.second.end() != hs)
-                    result = hs->second;
-            }
-        }
-    }
-
-    return result;
+    const bool stable(id->is_stable());
+    auto package(package_flag_state(_imp->env, _imp->flag_state_cache_mutex, _imp->use_mask_cache, _imp->package_use_mask, id, stable));
+    return lookup_flag_state(stable ? _imp->stable_use_mask : _imp->use_mask, *package, value_prefixed);
 }
 
 bool
@@ -865,46 +988,9 @@ TraditionalProfile::use_forced(
     if (stringify(choice->prefix()).empty() && _imp->is_arch_flag(value_unprefixed))
         return true;
 
-    bool result(false);
-    for (StackedValuesList::const_iterator i(_imp->stacked_values_list.begin()),
-            i_end(_imp->stacked_values_list.end()) ; i != i_end ; ++i)
-    {
-        FlagStatusMap::const_iterator f(i->use_force.find(value_prefixed));
-        if (i->use_force.end() != f)
-            result = f->second;
-
-        if (id->is_stable())
-        {
-            FlagStatusMap::const_iterator fs(i->use_stable_force.find(value_prefixed));
-            if (i->use_stable_force.end() != fs)
-                result = fs->second;
-        }
-
-        for (const auto & g : i->package_use_force)
-        {
-            if (! match_package(*_imp->env, *g.first, id, nullptr, { }))
-                continue;
-
-            FlagStatusMap::const_iterator h(g.second.find(value_prefixed));
-            if (g.second.end() != h)
-                result = h->second;
-        }
-
-        if (id->is_stable())
-        {
-            for (const auto & gs : i->package_use_stable_force)
-            {
-                if (! match_package(*_imp->env, *gs.first, id, nullptr, { }))
-                    continue;
-
-                FlagStatusMap::const_iterator hs(gs.second.find(value_prefixed));
-                if (gs.second.end() != hs)
-                    result = hs->second;
-            }
-        }
-    }
-
-    return result;
+    const bool stable(id->is_stable());
+    auto package(package_flag_state(_imp->env, _imp->flag_state_cache_mutex, _imp->use_force_cache, _imp->package_use_force, id, stable));
+    return lookup_flag_state(stable ? _imp->stable_use_force : _imp->use_force, *package, value_prefixed);
 }
 
 Tribool
@@ -915,24 +1001,13 @@ TraditionalProfile::use_state_ignoring_masks(
         const ChoiceNameWithPrefix & value_prefixed
         ) const
 {
-    std::pair<ChoicePrefixName, UnprefixedChoiceName> prefix_value(choice->prefix(), value_unprefixed);
-    Tribool result(_imp->use.end() != _imp->use.find(prefix_value) ? Tribool(true) : Tribool(indeterminate));
-
-    for (StackedValuesList::const_iterator i(_imp->stacked_values_list.begin()),
-            i_end(_imp->stacked_values_list.end()) ; i != i_end ; ++i)
-    {
-        for (const auto & g : i->package_use)
-        {
-            if (! match_package(*_imp->env, *g.first, id, nullptr, { }))
-                continue;
-
-            FlagStatusMap::const_iterator h(g.second.find(value_prefixed));
-            if (g.second.end() != h)
-                result = h->second ? true : false;
-        }
-    }
+    auto package(package_flag_state(_imp->env, _imp->flag_state_cache_mutex, _imp->use_cache, _imp->package_use, id, false));
+    auto p(package->find(value_prefixed));
+    if (package->end() != p)
+        return p->second.first ? Tribool(true) : Tribool(false);
 
-    return result;
+    std::pair<ChoicePrefixName, UnprefixedChoiceName> prefix_value(choice->prefix(), value_unprefixed);
+    return _imp->use.end() != _imp->use.find(prefix_value) ? Tribool(true) : Tribool(indeterminate);
 }
 
 namespace
@@ -163,7 +163,7 @@ VDBMerger::record_install_file(const FSPath & src, const FSPath & dst_dir, const
     display_merge(et_file, renamed_file, flags,
                   src.basename() == dst_name ? "" : dst_name);
 
-    *_imp->contents_file << "obj " << tidy_real << " " << md5.hexsum() << " " << timestamp.seconds() << std::endl;
+    ordered_stream(*_imp->contents_file) << "obj " << tidy_real << " " << md5.hexsum() << " " << timestamp.seconds() << std::endl;
 }
 
 void
@@ -174,7 +174,7 @@ VDBMerger::record_install_dir(const FSPath & src, const FSPath & dst_dir, const
 
     display_merge(et_dir, dir, flags);
 
-    *_imp->contents_file << "dir " << tidy << std::endl;
+    ordered_stream(*_imp->contents_file) << "dir " << tidy << std::endl;
 }
 
 void
@@ -184,7 +184,7 @@ VDBMerger::record_install_under_dir(const FSPath & dst_dir, const FSMergerStatus
 
     display_merge(et_dir, dst_dir, flags);
 
-    *_imp->contents_file << "dir " << tidy << std::endl;
+    ordered_stream(*_imp->contents_file) << "dir " << tidy << std::endl;
 }
 
 void
@@ -197,7 +197,7 @@ VDBMerger::record_install_sym(const FSPath & src, const FSPath & dst_dir, const
 
     display_merge(et_sym, sym, flags);
 
-    *_imp->contents_file << "sym " << tidy << " -> " << target << " " << timestamp.seconds() << std::endl;
+    ordered_stream(*_imp->contents_file) << "sym " << tidy << " -> " << target << " " << timestamp.seconds() << std::endl;
 }
 
 void
@@ -344,6 +344,6 @@ VDBMerger::on_sym(bool is_check, const FSPath & src, const FSPath & dst)
 void
 VDBMerger::display_override(const std::string & message) const
 {
-    _imp->params.output_manager()->stdout_stream() << message << std::endl;
+    merge_output_manager()->stdout_stream() << message << std::endl;
 }
 
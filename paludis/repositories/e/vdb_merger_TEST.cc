@@ -213,3 +213,55 @@ INSTANTIATE_TEST_CASE_P(Errors, VDBMergerErrorTest, testing::Values(
             std::string("sym_arrow2")
             ));
 
+namespace
+{
+    std::string merge_and_read_contents(TestEnvironment & env, const std::string & root, const MergerOptions & options)
+    {
+        const FSPath dir(FSPath::cwd() / "vdb_merger_TEST_dir" / "parallel_merge_dir");
+        const FSPath contents(FSPath::cwd() / "vdb_merger_TEST_dir" / "CONTENTS" / root);
+
+        VDBMergerNoDisplay merger(make_named_values<VDBMergerParams>(
+                    n::config_protect() = "",
+                    n::config_protect_mask() = "",
+                    n::contents_file() = contents,
+                    n::environment() = &env,
+                    n::fix_mtimes_before() = Timestamp(0, 0),
+                    n::fs_merger_options() = FSMergerOptions(),
+                    n::image() = dir / "image",
+                    n::merged_entries() = std::make_shared<FSPathSet>(),
+                    n::options() = options,
+                    n::output_manager() = std::make_shared<StandardOutputManager>(),
+                    n::package_id() = std::shared_ptr<PackageID>(),
+                    n::permit_destination() = std::bind(return_literal_function(true)),
+                    n::root() = dir / root
+                    ));
+
+        EXPECT_TRUE(merger.check());
+        merger.merge();
+
+        /* symlinks are recorded with the time they were merged, which can
+         * differ between the two merges */
+        SafeIFStream stream(contents);
+        std::string result, line;
+        while (std::getline(stream, line))
+        {
+            if (0 == line.compare(0, 4, "sym "))
+                line.erase(line.rfind(' '));
+            result.append(line + "\n");
+        }
+        return result;
+    }
+}
+
+TEST(VDBMerger, ParallelMerge)
+{
+    TestEnvironment env;
+    const MergerOptions options(MergerOptions() + mo_allow_empty_dirs + mo_nondestructive + mo_preserve_mtimes);
+
+    const std::string serial(merge_and_read_contents(env, "serial_root", options));
+    const std::string parallel(merge_and_read_contents(env, "parallel_root", options + mo_parallel_merge));
+
+    EXPECT_NE(std::string::npos, serial.find("obj /usr/sub/deeper/z "));
+    EXPECT_NE(std::string::npos, serial.find("sym /etc/link -> a"));
+    EXPECT_EQ(serial, parallel);
+}
@@ -84,6 +84,18 @@ mkdir -p sym_arrow2_dir/{image,root} || exit 4
 mkdir sym_arrow2_dir/image/"dir -> ectory" || exit 5
 ln -s bar sym_arrow2_dir/image/"dir -> ectory/sym" || exit 5
 
+mkdir -p parallel_merge_dir/{image,serial_root,parallel_root} || exit 4
+for d in usr etc opt var ; do
+    mkdir -p parallel_merge_dir/image/${d}/sub/deeper || exit 5
+    for f in a b c d e ; do
+        echo ${d}${f} > parallel_merge_dir/image/${d}/${f} || exit 5
+        echo ${f} > parallel_merge_dir/image/${d}/sub/${f} || exit 5
+    done
+    echo z > parallel_merge_dir/image/${d}/sub/deeper/z || exit 5
+    ln -s a parallel_merge_dir/image/${d}/link || exit 5
+done
+echo top > parallel_merge_dir/image/topfile || exit 5
+mkdir parallel_merge_dir/image/empty || exit 5
 
 for d in *_dir; do
     ln -s ${d} ${d%_dir}
@@ -589,6 +589,12 @@ VDBRepository::category_names_containing_package(const PackageNamePart & p, cons
     return result ? result : Repository::category_names_containing_package(p, x);
 }
 
+std::shared_ptr<const RepositoryNameCache>
+VDBRepository::names_cache() const
+{
+    return _imp->names_cache;
+}
+
 namespace
 {
     bool parallel_slot_is_same(const std::shared_ptr<const PackageID> & a,
@@ -134,6 +134,9 @@ namespace paludis
                     const PackageNamePart &, const RepositoryContentMayExcludes &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual std::shared_ptr<const RepositoryNameCache> names_cache() const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual bool has_package_named(const QualifiedPackageName &, const RepositoryContentMayExcludes &) const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
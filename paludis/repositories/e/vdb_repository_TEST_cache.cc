@@ -26,8 +26,8 @@
 #include <paludis/util/sequence.hh>
 #include <paludis/util/options.hh>
 #include <paludis/util/make_named_values.hh>
-#include <paludis/util/safe_ifstream.hh>
-#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/set.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/indirect_iterator-impl.hh>
@@ -43,11 +43,9 @@
 #include <paludis/action.hh>
 #include <paludis/choice.hh>
 #include <paludis/unformatted_pretty_printer.hh>
+#include <paludis/repository_name_cache.hh>
 
 #include <functional>
-#include <algorithm>
-#include <iterator>
-#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -108,23 +106,13 @@ namespace
                             &env, { })), nullptr, { }))]->begin())->perform_action(install_action);
     }
 
-    void read_cache(const FSPath & names_cache, std::vector<FSPath> & vec)
+    std::string read_cache(const FSPath & names_cache, const Repository * const repo)
     {
-        using namespace std::placeholders;
-        std::remove_copy_if(FSIterator(names_cache, { fsio_include_dotfiles }),
-                            FSIterator(), std::back_inserter(vec),
-                            std::bind(&std::equal_to<std::string>::operator(),
-                                      std::equal_to<std::string>(),
-                                      "_VERSION_", std::bind(&FSPath::basename, _1)));
-    }
-
-    std::string read_file(const FSPath & f)
-    {
-        SafeIFStream s(f);
-        std::stringstream ss;
-        std::copy(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>(),
-                  std::ostreambuf_iterator<char>(ss));
-        return ss.str();
+        RepositoryNameCache cache(names_cache.dirname(), repo);
+        const std::shared_ptr<const QualifiedPackageNameSet> names(cache.package_names());
+        if (! names)
+            return "unusable";
+        return join(names->begin(), names->end(), " ");
     }
 }
 
@@ -170,64 +158,42 @@ TEST(NamesCache, Incremental)
             ));
 
     {
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(0U, cache_contents.size());
+        EXPECT_EQ("", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat1/pkg1-1::namesincrtest_src", "");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat1/pkg1-1::namesincrtest_src", "");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat1/pkg1-1.1::namesincrtest_src", "=cat1/pkg1-1::installed");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat1/pkg1-1::namesincrtest_src", "=cat1/pkg1-1.1::installed");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat1/pkg1-2::namesincrtest_src", "");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
@@ -237,24 +203,14 @@ TEST(NamesCache, Incremental)
         inst_id->perform_action(uninstall_action);
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat1/pkg2-1::namesincrtest_src", "");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(2U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("pkg2", cache_contents.back().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg2"));
+        EXPECT_EQ("cat1/pkg1 cat1/pkg2", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
@@ -264,22 +220,14 @@ TEST(NamesCache, Incremental)
         inst_id->perform_action(uninstall_action);
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat2/pkg1-1::namesincrtest_src", "");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\ncat2\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1 cat2/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
@@ -289,11 +237,7 @@ TEST(NamesCache, Incremental)
         inst_id->perform_action(uninstall_action);
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat1\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat1/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
@@ -303,31 +247,21 @@ TEST(NamesCache, Incremental)
         inst_id->perform_action(uninstall_action);
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(0U, cache_contents.size());
+        EXPECT_EQ("", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat3/pkg1-1::namesincrtest_src", "");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat3\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat3/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 
     {
         install(env, vdb_repo, "=cat3/pkg1-2::namesincrtest_src", "=cat3/pkg1-1::installed");
         vdb_repo->invalidate();
 
-        std::vector<FSPath> cache_contents;
-        read_cache(names_cache, cache_contents);
-        EXPECT_EQ(1U, cache_contents.size());
-        EXPECT_EQ("pkg1", cache_contents.front().basename());
-        EXPECT_EQ("cat3\n", read_file(names_cache / "pkg1"));
+        EXPECT_EQ("cat3/pkg1", read_cache(names_cache, vdb_repo.get()));
     }
 }
 
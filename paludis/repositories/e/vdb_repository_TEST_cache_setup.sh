@@ -9,8 +9,9 @@ mkdir -p build
 mkdir -p root/etc
 
 mkdir -p namesincrtest/.cache/names/installed namesincrtest_src/{eclass,profiles/profile,cat1/{pkg1,pkg2},{cat2,cat3}/pkg1} || exit 1
-echo paludis-2 >namesincrtest/.cache/names/installed/_VERSION_
+echo paludis-3 >namesincrtest/.cache/names/installed/_VERSION_
 echo installed >>namesincrtest/.cache/names/installed/_VERSION_
+printf 'paludis-names-3\n\000\000\000\001\000\000\000\000\000\000\000\000' >namesincrtest/.cache/names/installed/_NAMES_
 
 cat <<END > namesincrtest_src/profiles/profile/make.defaults
 ARCH=test
@@ -327,6 +327,12 @@ FakeMetadataSpecTreeKey<FetchableURISpecTree>::initial_label() const
     return _imp->initial_label;
 }
 
+const std::shared_ptr<const std::string>
+FakeMetadataSpecTreeKey<FetchableURISpecTree>::unparsed_value() const
+{
+    return std::make_shared<std::string>(_imp->string_value);
+}
+
 FakeMetadataSpecTreeKey<DependencySpecTree>::FakeMetadataSpecTreeKey(const std::string & r, const std::string & h, const std::string & v,
         const std::function<const std::shared_ptr<const DependencySpecTree> (const std::string &)> & f,
         const std::shared_ptr<const DependenciesLabelSequence> & s, const MetadataKeyType t) :
@@ -115,6 +115,9 @@ namespace paludis
             virtual const std::shared_ptr<const URILabel> initial_label() const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            virtual const std::shared_ptr<const std::string> unparsed_value() const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             virtual const std::string raw_name() const PALUDIS_ATTRIBUTE((warn_unused_result));
             virtual const std::string human_name() const PALUDIS_ATTRIBUTE((warn_unused_result));
             virtual MetadataKeyType type() const PALUDIS_ATTRIBUTE((warn_unused_result));
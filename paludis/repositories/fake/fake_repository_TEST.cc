@@ -18,10 +18,19 @@
  */
 
 #include <paludis/repositories/fake/fake_repository.hh>
+#include <paludis/repositories/fake/dep_parser.hh>
 
 #include <paludis/environments/test/test_environment.hh>
 
 #include <paludis/util/make_named_values.hh>
+#include <paludis/util/indirect_iterator-impl.hh>
+#include <paludis/util/stringify.hh>
+
+#include <paludis/dep_spec.hh>
+#include <paludis/dep_spec_annotations.hh>
+#include <paludis/spec_tree.hh>
+
+#include <algorithm>
 
 #include <gtest/gtest.h>
 
@@ -36,3 +45,29 @@ TEST(FakeRepository, Works)
                     )));
 }
 
+
+TEST(FakeRepository, Blockers)
+{
+    TestEnvironment env;
+    std::shared_ptr<DependencySpecTree> d(fakerepository::parse_depend("!a/a !!b/b", &env));
+
+    std::string roles;
+    d->top()->make_accept(
+            [&] (const DependencySpecTree::NodeType<BlockDepSpec>::Type & node) {
+                roles.append(dsar_blocker_strong == find_blocker_role_in_annotations(node.spec()->maybe_annotations())
+                        ? "strong " + stringify(node.spec()->blocking()) + ";" : "weak " + stringify(node.spec()->blocking()) + ";");
+            },
+
+            [&] (const DependencySpecTree::NodeType<AllDepSpec>::Type & node, const Revisit<void, DependencySpecTree::BasicNode> & revisit) {
+                std::for_each(indirect_iterator(node.begin()), indirect_iterator(node.end()), revisit);
+            },
+
+            [&] (const DependencySpecTree::NodeType<PackageDepSpec>::Type &) { },
+            [&] (const DependencySpecTree::NodeType<NamedSetDepSpec>::Type &) { },
+            [&] (const DependencySpecTree::NodeType<DependenciesLabelsDepSpec>::Type &) { },
+            [&] (const DependencySpecTree::NodeType<AnyDepSpec>::Type &, const Revisit<void, DependencySpecTree::BasicNode> &) { },
+            [&] (const DependencySpecTree::NodeType<ConditionalDepSpec>::Type &, const Revisit<void, DependencySpecTree::BasicNode> &) { }
+            );
+
+    EXPECT_EQ("weak a/a;strong b/b;", roles);
+}
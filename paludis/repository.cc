@@ -153,6 +153,12 @@ Repository::category_names_containing_package(const PackageNamePart & p, const R
     return result;
 }
 
+std::shared_ptr<const RepositoryNameCache>
+Repository::names_cache() const
+{
+    return nullptr;
+}
+
 void
 Repository::regenerate_cache() const
 {
@@ -169,6 +175,13 @@ RepositoryDestinationInterface::~RepositoryDestinationInterface() = default;
 
 RepositoryManifestInterface::~RepositoryManifestInterface() = default;
 
+void
+RepositoryManifestInterface::make_manifests(const std::shared_ptr<const QualifiedPackageNameSet> & qpns)
+{
+    for (const auto & qpn : *qpns)
+        make_manifest(qpn);
+}
+
 std::shared_ptr<const CategoryNamePartSet>
 Repository::unimportant_category_names(const RepositoryContentMayExcludes &) const
 {
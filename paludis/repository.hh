@@ -364,6 +364,16 @@ namespace paludis
                     const PackageNamePart & p,
                     const RepositoryContentMayExcludes & repository_content_may_excludes) const;
 
+            /**
+             * Fetch our names cache, if we have one, or a zero pointer
+             * otherwise.
+             *
+             * Used by Environment to build a combined names index.
+             *
+             * \since 3.0
+             */
+            virtual std::shared_ptr<const RepositoryNameCache> names_cache() const;
+
             /**
              * Fetch our package names.
              */
@@ -565,6 +575,15 @@ namespace paludis
              */
             virtual void make_manifest(const QualifiedPackageName &) = 0;
 
+            /**
+             * Makes the Manifests for several packages at once, which may
+             * be much quicker than making them one at a time. By default,
+             * just calls make_manifest for each.
+             *
+             * \since 3.0
+             */
+            virtual void make_manifests(const std::shared_ptr<const QualifiedPackageNameSet> &);
+
             ///\name Basic operations
             ///\{
 
@@ -25,25 +25,127 @@
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/wrapped_output_iterator.hh>
-#include <paludis/util/hashes.hh>
+#include <paludis/util/byte_swap.hh>
+#include <paludis/util/mapped_file.hh>
 #include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/fs_iterator.hh>
 #include <paludis/util/fs_stat.hh>
 #include <paludis/util/fs_error.hh>
-#include <unordered_map>
+#include <map>
 #include <memory>
 #include <set>
 #include <mutex>
+#include <vector>
 #include <cstring>
+#include <cstdint>
 #include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
 
 using namespace paludis;
 
-namespace paludis
+/*
+ * The names cache for a repository is a directory containing a _VERSION_
+ * file and a single _NAMES_ file, which is a hash table that can be used
+ * directly from a mapping:
+ *
+ *     "paludis-names-3\n"            16 bytes of magic
+ *     bucket count                    uint32, big endian
+ *     bucket offsets                  (bucket count + 1) * uint32, big endian
+ *     records                         "pkg cat1 cat2 ...\n", grouped by bucket
+ *
+ * Bucket n holds the records from offset n to offset n + 1, relative to the
+ * start of the records. Package names are hashed using 32-bit FNV-1a, which
+ * unlike std::hash is stable between builds.
+ */
+
+/*
+ * Packages added or removed since _NAMES_ was written are appended to a
+ * _JOURNAL_ file, one "+cat/pkg" or "-cat/pkg" per line, so that merging a
+ * package does not mean rewriting the whole table. Once the journal gets
+ * long enough, it is folded back into _NAMES_. Changes to either file are
+ * serialised between processes by holding a lock on _LOCK_.
+ */
+
+/*
+ * After a sync which could tell us what it changed, there is also a
+ * _PENDING_ file, listing one cat/pkg per line, or a single "*" if some
+ * sync since the last regeneration could not. Regenerating removes it.
+ */
+
+namespace
 {
-    typedef std::unordered_map<PackageNamePart, std::set<CategoryNamePart>, Hash<PackageNamePart> > NameCacheMap;
+    const std::string names_file_magic("paludis-names-3\n");
+    const std::string version_string("paludis-3");
+
+    typedef std::map<PackageNamePart, std::set<CategoryNamePart> > NamesMap;
+    typedef std::map<PackageNamePart, std::map<CategoryNamePart, bool> > JournalMap;
+
+    const unsigned journal_compact_threshold(64);
+
+    class NamesCacheLock
+    {
+        private:
+            int _fd;
+
+        public:
+            explicit NamesCacheLock(const FSPath & location) :
+                _fd(::open(stringify(location / "_LOCK_").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644))
+            {
+                if (-1 == _fd)
+                {
+                    Log::get_instance()->message("repository.names_cache.lock_failed", ll_debug, lc_context)
+                        << "Cannot open lock file in '" << location << "': " << ::strerror(errno);
+                    return;
+                }
+
+                while (-1 == ::lockf(_fd, F_LOCK, 0))
+                    if (EINTR != errno)
+                    {
+                        Log::get_instance()->message("repository.names_cache.lock_failed", ll_warning, lc_context)
+                            << "Cannot lock '" << (location / "_LOCK_") << "': " << ::strerror(errno);
+                        break;
+                    }
+            }
+
+            ~NamesCacheLock()
+            {
+                if (-1 != _fd)
+                    ::close(_fd);
+            }
+
+            NamesCacheLock(const NamesCacheLock &) = delete;
+            NamesCacheLock & operator= (const NamesCacheLock &) = delete;
+    };
 
+    uint32_t hash_name(const char * s, std::size_t len)
+    {
+        uint32_t result(2166136261u);
+        for (std::size_t i(0) ; i < len ; ++i)
+        {
+            result ^= static_cast<unsigned char>(s[i]);
+            result *= 16777619u;
+        }
+        return result;
+    }
+
+    uint32_t read_uint32(const char * p)
+    {
+        uint32_t result;
+        std::memcpy(&result, p, sizeof(result));
+        return from_bigendian(result);
+    }
+
+    std::string encode_uint32(uint32_t v)
+    {
+        v = to_bigendian(v);
+        return std::string(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+}
+
+namespace paludis
+{
     template<>
     struct Imp<RepositoryNameCache>
     {
@@ -53,129 +155,365 @@ namespace paludis
         mutable FSPath location;
         const Repository * const repo;
 
-        mutable NameCacheMap name_cache_map;
-        mutable bool checked_name_cache_map;
+        mutable bool checked;
+        mutable std::unique_ptr<MappedFile> names_file;
+        mutable uint32_t bucket_count;
+        mutable const char * records;
+        mutable std::shared_ptr<QualifiedPackageNameSet> all_names;
+        mutable std::shared_ptr<QualifiedPackageNameSet> table_names;
+        mutable JournalMap journal;
+        mutable unsigned journal_entries;
 
         Imp(const FSPath & l, const Repository * const r) :
             usable(l != FSPath("/var/empty")),
             location(l == FSPath("/var/empty") ? l : l / stringify(r->name())),
             repo(r),
-            checked_name_cache_map(false)
+            checked(false),
+            bucket_count(0),
+            records(nullptr),
+            journal_entries(0)
         {
         }
 
-        NameCacheMap::iterator find(const PackageNamePart &) const;
-        void update(const PackageNamePart & p, NameCacheMap::iterator r);
+        bool check() const;
+        bool map_names_file() const;
+        bool read_journal() const;
+        void find(const PackageNamePart &, std::set<CategoryNamePart> &) const;
+        void find_in_names_file(const PackageNamePart &, std::set<CategoryNamePart> &) const;
+        void read_names_file(NamesMap &) const;
+        void read_all(NamesMap &) const;
+        void write(const NamesMap &) const;
+        void append_journal(const QualifiedPackageNameSet &, const QualifiedPackageNameSet &) const;
+        void compact() const;
     };
 }
 
-NameCacheMap::iterator
-Imp<RepositoryNameCache>::find(const PackageNamePart & p) const
+bool
+Imp<RepositoryNameCache>::check() const
+{
+    if (checked)
+        return usable;
+
+    if (location.stat().is_directory() && (location / "_VERSION_").stat().exists())
+    {
+        SafeIFStream vvf(location / "_VERSION_");
+        std::string line;
+        std::getline(vvf, line);
+        if (line != version_string)
+        {
+            Log::get_instance()->message("repository.names_cache.unsupported", ll_warning, lc_context)
+                << "Names cache for '" << repo->name() << "' has version string '" << line
+                << "', which is not supported. Was it generated using a different Paludis version? Perhaps you need to regenerate "
+                "the cache using 'cave fix-cache'?";
+            usable = false;
+            return false;
+        }
+        std::getline(vvf, line);
+        if (line != stringify(repo->name()))
+        {
+            Log::get_instance()->message("repository.names_cache.different", ll_warning, lc_context)
+                << "Names cache for '" << repo->name() << "' was generated for repository '" << line
+                << "', so it cannot be used. You must not have multiple name caches at the same location.";
+            usable = false;
+            return false;
+        }
+    }
+    else if ((location.dirname() / "_VERSION_").stat().exists())
+    {
+        Log::get_instance()->message("repository.names_cache.old", ll_warning, lc_context)
+            << "Names cache for '" << repo->name() << "' does not exist at '" << location
+            << "', but a names cache exists at '" << location.dirname()
+            << "'. This was probably generated by a Paludis version "
+            "older than 0.18.0. The names cache now automatically appends the repository name to the "
+            "directory. You probably want to manually remove '" << location.dirname() <<
+            "' and then regenerate the cache.";
+        usable = false;
+        return false;
+    }
+    else
+    {
+        Log::get_instance()->message("repository.names_cache.unversioned", ll_warning, lc_context)
+            << "Names cache for '" << repo->name()
+            << "' has no version information, so cannot be used. Either it was generated using "
+            "an older Paludis version or it has not yet been generated. Perhaps you need to regenerate "
+            "the cache using 'cave fix-cache'?";
+        usable = false;
+        return false;
+    }
+
+    if (! (map_names_file() && read_journal()))
+    {
+        Log::get_instance()->message("repository.names_cache.corrupt", ll_warning, lc_context)
+            << "Names cache for '" << repo->name() << "' at '" << location
+            << "' is missing or corrupt. Perhaps you need to regenerate the cache using 'cave fix-cache'?";
+        usable = false;
+        return false;
+    }
+
+    checked = true;
+    return true;
+}
+
+bool
+Imp<RepositoryNameCache>::map_names_file() const
+{
+    names_file.reset();
+    records = nullptr;
+    bucket_count = 0;
+    all_names.reset();
+    table_names.reset();
+
+    try
+    {
+        names_file.reset(new MappedFile(location / "_NAMES_"));
+    }
+    catch (const MappedFileError &)
+    {
+        return false;
+    }
+
+    const char * const data(names_file->data());
+    const std::size_t size(names_file->size());
+    const std::size_t header_size(names_file_magic.length() + sizeof(uint32_t));
+
+    if (size < header_size || 0 != names_file_magic.compare(0, std::string::npos, data, names_file_magic.length()))
+        return false;
+
+    uint32_t count(read_uint32(data + names_file_magic.length()));
+    if (0 == count || (size - header_size) / sizeof(uint32_t) < std::size_t(count) + 1)
+        return false;
+
+    const std::size_t records_offset(header_size + (std::size_t(count) + 1) * sizeof(uint32_t));
+    if (read_uint32(data + header_size + count * sizeof(uint32_t)) != size - records_offset)
+        return false;
+
+    bucket_count = count;
+    records = data + records_offset;
+    return true;
+}
+
+bool
+Imp<RepositoryNameCache>::read_journal() const
 {
-    NameCacheMap::iterator r(name_cache_map.find(p));
+    journal.clear();
+    journal_entries = 0;
+
+    FSPath journal_file(location / "_JOURNAL_");
+    if (! journal_file.stat().exists())
+        return true;
+
+    try
+    {
+        SafeIFStream f(journal_file);
+        std::string line;
+        while (std::getline(f, line))
+        {
+            /* a line without a newline was cut short, and was never
+             * acknowledged, so ignore it */
+            if (f.eof())
+                break;
 
-    location = FSPath(stringify(location));
+            if (line.length() < 2 || (line[0] != '+' && line[0] != '-'))
+                return false;
 
-    if (name_cache_map.end() == r)
+            QualifiedPackageName q(line.substr(1));
+            journal[q.package()][q.category()] = ('+' == line[0]);
+            ++journal_entries;
+        }
+    }
+    catch (const NameError &)
+    {
+        return false;
+    }
+    catch (const SafeIFStreamError &)
     {
-        r = name_cache_map.insert(std::make_pair(p, std::set<CategoryNamePart>())).first;
+        return false;
+    }
+
+    return true;
+}
+
+void
+Imp<RepositoryNameCache>::find(const PackageNamePart & p, std::set<CategoryNamePart> & result) const
+{
+    find_in_names_file(p, result);
 
-        if (! checked_name_cache_map)
+    auto j(journal.find(p));
+    if (journal.end() != j)
+        for (const auto & c : j->second)
         {
-            if (location.stat().is_directory() && (location / "_VERSION_").stat().exists())
-            {
-                SafeIFStream vvf(location / "_VERSION_");
-                std::string line;
-                std::getline(vvf, line);
-                if (line != "paludis-2")
-                {
-                    Log::get_instance()->message("repository.names_cache.unsupported", ll_warning, lc_context)
-                        << "Names cache for '" << repo->name() << "' has version string '" << line
-                        << "', which is not supported. Was it generated using a different Paludis version? Perhaps you need to regenerate "
-                        "the cache using 'cave fix-cache'?";
-                    usable = false;
-                    return name_cache_map.end();
-                }
-                std::getline(vvf, line);
-                if (line != stringify(repo->name()))
-                {
-                    Log::get_instance()->message("repository.names_cache.different", ll_warning, lc_context)
-                        << "Names cache for '" << repo->name() << "' was generated for repository '" << line
-                        << "', so it cannot be used. You must not have multiple name caches at the same location.";
-                    usable = false;
-                    return name_cache_map.end();
-                }
-                checked_name_cache_map = true;
-            }
-            else if ((location.dirname() / "_VERSION_").stat().exists())
-            {
-                Log::get_instance()->message("repository.names_cache.old", ll_warning, lc_context)
-                    << "Names cache for '" << repo->name() << "' does not exist at '" << location
-                    << "', but a names cache exists at '" << location.dirname()
-                    << "'. This was probably generated by a Paludis version "
-                    "older than 0.18.0. The names cache now automatically appends the repository name to the "
-                    "directory. You probably want to manually remove '" << location.dirname() <<
-                    "' and then regenerate the cache.";
-                usable = false;
-                return name_cache_map.end();
-            }
+            if (c.second)
+                result.insert(c.first);
             else
-            {
-                Log::get_instance()->message("repository.names_cache.unversioned", ll_warning, lc_context)
-                    << "Names cache for '" << repo->name()
-                    << "' has no version information, so cannot be used. Either it was generated using "
-                    "an older Paludis version or it has not yet been generated. Perhaps you need to regenerate "
-                    "the cache using 'cave fix-cache'?";
-                usable = false;
-                return name_cache_map.end();
-            }
+                result.erase(c.first);
         }
+}
+
+void
+Imp<RepositoryNameCache>::find_in_names_file(const PackageNamePart & p, std::set<CategoryNamePart> & result) const
+{
+    const std::string name(stringify(p));
+    const char * const offsets(names_file->data() + names_file_magic.length() + sizeof(uint32_t));
+    const uint32_t bucket(hash_name(name.data(), name.length()) % bucket_count);
+
+    const char * cur(records + read_uint32(offsets + bucket * sizeof(uint32_t)));
+    const char * const end(records + read_uint32(offsets + (bucket + 1) * sizeof(uint32_t)));
+    if (end < cur || end > records + read_uint32(offsets + bucket_count * sizeof(uint32_t)))
+        return;
 
-        FSPath ff(location / stringify(p));
-        if (ff.stat().exists())
+    while (cur < end)
+    {
+        const char * const eol(static_cast<const char *>(std::memchr(cur, '\n', end - cur)));
+        const char * const line_end(eol ? eol : end);
+        const char * const space(static_cast<const char *>(std::memchr(cur, ' ', line_end - cur)));
+        const char * const name_end(space ? space : line_end);
+
+        if (std::size_t(name_end - cur) == name.length() && 0 == name.compare(0, name.length(), cur, name.length()))
         {
-            SafeIFStream f(ff);
-            std::string line;
-            while (std::getline(f, line))
-                r->second.insert(CategoryNamePart(line));
+            const char * c(name_end);
+            while (c < line_end)
+            {
+                ++c;
+                const char * const c_end(static_cast<const char *>(std::memchr(c, ' ', line_end - c)));
+                const char * const cat_end(c_end ? c_end : line_end);
+                if (cat_end != c)
+                    result.insert(CategoryNamePart(std::string(c, cat_end)));
+                c = cat_end;
+            }
+            return;
         }
-    }
 
-    return r;
+        cur = line_end + 1;
+    }
 }
 
 void
-Imp<RepositoryNameCache>::update(const PackageNamePart & p, NameCacheMap::iterator r)
+Imp<RepositoryNameCache>::read_names_file(NamesMap & result) const
 {
-    FSPath ff(location / stringify(p));
-    if (r->second.empty() && ff.stat().exists())
+    const char * cur(records);
+    const char * const end(names_file->data() + names_file->size());
+
+    while (cur < end)
     {
-        try
+        const char * const eol(static_cast<const char *>(std::memchr(cur, '\n', end - cur)));
+        const char * const line_end(eol ? eol : end);
+        const char * const space(static_cast<const char *>(std::memchr(cur, ' ', line_end - cur)));
+        const char * const name_end(space ? space : line_end);
+
+        std::set<CategoryNamePart> & cats(result[PackageNamePart(std::string(cur, name_end))]);
+        const char * c(name_end);
+        while (c < line_end)
         {
-            ff.unlink();
+            ++c;
+            const char * const c_end(static_cast<const char *>(std::memchr(c, ' ', line_end - c)));
+            const char * const cat_end(c_end ? c_end : line_end);
+            if (cat_end != c)
+                cats.insert(CategoryNamePart(std::string(c, cat_end)));
+            c = cat_end;
         }
-        catch (const FSError & e)
+
+        cur = line_end + 1;
+    }
+}
+
+void
+Imp<RepositoryNameCache>::read_all(NamesMap & result) const
+{
+    read_names_file(result);
+
+    for (const auto & j : journal)
+        for (const auto & c : j.second)
         {
-            Log::get_instance()->message("repository.names_cache.unlink_failed", ll_warning, lc_context)
-                << "Cannot unlink '" << ff << "': " << e.message() << " (" << e.what() << ")";
+            if (c.second)
+                result[j.first].insert(c.first);
+            else
+                result[j.first].erase(c.first);
         }
-        return;
+}
+
+void
+Imp<RepositoryNameCache>::write(const NamesMap & names) const
+{
+    uint32_t count(0);
+    for (const auto & n : names)
+        if (! n.second.empty())
+            ++count;
+
+    /* roughly one record per bucket keeps lookups to a single comparison */
+    const uint32_t n_buckets(count + 1);
+    std::vector<std::string> buckets(n_buckets);
+    for (const auto & n : names)
+    {
+        if (n.second.empty())
+            continue;
+
+        const std::string name(stringify(n.first));
+        std::string & b(buckets[hash_name(name.data(), name.length()) % n_buckets]);
+        b.append(name);
+        for (const auto & c : n.second)
+            b.append(" " + stringify(c));
+        b.append("\n");
     }
 
-    try
     {
-        SafeOFStream f(ff, -1, true);
+        AtomicOFStream a(location / "_NAMES_");
+        std::ostream & f(a.stream());
+        f << names_file_magic;
+        f << encode_uint32(n_buckets);
 
-        for (std::set<CategoryNamePart>::const_iterator it(r->second.begin()),
-                 it_end(r->second.end()); it_end != it; ++it)
-            f << *it << std::endl;
+        uint32_t offset(0);
+        for (const auto & b : buckets)
+        {
+            f << encode_uint32(offset);
+            offset += b.length();
+        }
+        f << encode_uint32(offset);
+
+        for (const auto & b : buckets)
+            f << b;
+
+        names_file.reset();
+        a.commit();
     }
-    catch (const SafeOFStreamError & e)
+
+    if (! map_names_file())
+        throw InternalError(PALUDIS_HERE, "Couldn't read back names cache we just wrote to '" + stringify(location) + "'");
+}
+
+void
+Imp<RepositoryNameCache>::append_journal(const QualifiedPackageNameSet & added, const QualifiedPackageNameSet & removed) const
+{
     {
-        Log::get_instance()->message("repository.names_cache.write_failed", ll_warning, lc_context)
-            << "Cannot write '" << ff << "': '" << e.message() << "' (" << e.what() << ")";
-        return;
+        SafeOFStream f(location / "_JOURNAL_", O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, true);
+        for (const auto & q : removed)
+            f << "-" << q << "\n";
+        for (const auto & q : added)
+            f << "+" << q << "\n";
     }
+
+    for (const auto & q : removed)
+        journal[q.package()][q.category()] = false;
+    for (const auto & q : added)
+        journal[q.package()][q.category()] = true;
+    journal_entries += removed.size() + added.size();
+    all_names.reset();
+}
+
+void
+Imp<RepositoryNameCache>::compact() const
+{
+    /* another process may have changed things since we last looked, so
+     * start again from what is on disk */
+    if (! (map_names_file() && read_journal()))
+        throw InternalError(PALUDIS_HERE, "Names cache at '" + stringify(location) + "' became unreadable");
+
+    NamesMap names;
+    read_all(names);
+    write(names);
+
+    (location / "_JOURNAL_").unlink();
+    journal.clear();
+    journal_entries = 0;
 }
 
 RepositoryNameCache::RepositoryNameCache(
@@ -197,15 +535,94 @@ RepositoryNameCache::category_names_containing_package(const PackageNamePart & p
 
     Context context("When using name cache at '" + stringify(_imp->location) + "':");
 
-    std::shared_ptr<CategoryNamePartSet> result(std::make_shared<CategoryNamePartSet>());
-    NameCacheMap::iterator r(_imp->find(p));
-    if (_imp->name_cache_map.end() == r)
+    if (! _imp->check())
         return std::shared_ptr<const CategoryNamePartSet>();
 
-    std::copy(r->second.begin(), r->second.end(), result->inserter());
+    std::set<CategoryNamePart> cats;
+    _imp->find(p, cats);
+
+    std::shared_ptr<CategoryNamePartSet> result(std::make_shared<CategoryNamePartSet>());
+    std::copy(cats.begin(), cats.end(), result->inserter());
     return result;
 }
 
+std::shared_ptr<const QualifiedPackageNameSet>
+RepositoryNameCache::package_names() const
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (! usable())
+        return std::shared_ptr<const QualifiedPackageNameSet>();
+
+    Context context("When using name cache at '" + stringify(_imp->location) + "':");
+
+    if (! _imp->check())
+        return std::shared_ptr<const QualifiedPackageNameSet>();
+
+    if (! _imp->all_names)
+    {
+        NamesMap names;
+        _imp->read_all(names);
+
+        _imp->all_names = std::make_shared<QualifiedPackageNameSet>();
+        for (const auto & n : names)
+            for (const auto & c : n.second)
+                _imp->all_names->insert(c + n.first);
+    }
+
+    return _imp->all_names;
+}
+
+std::shared_ptr<const QualifiedPackageNameSet>
+RepositoryNameCache::table_names() const
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (! usable())
+        return std::shared_ptr<const QualifiedPackageNameSet>();
+
+    Context context("When using name cache at '" + stringify(_imp->location) + "':");
+
+    if (! _imp->check())
+        return std::shared_ptr<const QualifiedPackageNameSet>();
+
+    if (! _imp->table_names)
+    {
+        NamesMap names;
+        _imp->read_names_file(names);
+
+        _imp->table_names = std::make_shared<QualifiedPackageNameSet>();
+        for (const auto & n : names)
+            for (const auto & c : n.second)
+                _imp->table_names->insert(c + n.first);
+    }
+
+    return _imp->table_names;
+}
+
+bool
+RepositoryNameCache::apply_journal(const std::shared_ptr<const QualifiedPackageNameSet> & table,
+        const PackageNamePart & p, CategoryNamePartSet & cats) const
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    /* the journal has been folded into a new table since the caller looked */
+    if ((! table) || table != _imp->table_names)
+        return false;
+
+    auto j(_imp->journal.find(p));
+    if (_imp->journal.end() != j)
+        for (const auto & c : j->second)
+        {
+            if (c.second)
+                cats.insert(c.first);
+            else
+                cats.erase(c.first);
+        }
+
+    return true;
+}
+
 void
 RepositoryNameCache::regenerate_cache() const
 {
@@ -217,9 +634,11 @@ RepositoryNameCache::regenerate_cache() const
     Context context("When generating repository names cache at '"
             + stringify(_imp->location) + "':");
 
-    if (_imp->location.stat().is_directory())
-        for (FSIterator i(_imp->location, { fsio_inode_sort }), i_end ; i != i_end ; ++i)
-            i->unlink();
+    _imp->names_file.reset();
+    _imp->table_names.reset();
+    _imp->journal.clear();
+    _imp->journal_entries = 0;
+    _imp->checked = false;
 
     FSPath main_cache_dir(_imp->location.dirname());
     FSStat main_cache_dir_stat(main_cache_dir);
@@ -231,7 +650,13 @@ RepositoryNameCache::regenerate_cache() const
     if (_imp->location.mkdir(main_cache_dir_stat.permissions(), { fspmkdo_ok_if_exists }))
         _imp->location.chmod(main_cache_dir_stat.permissions());
 
-    std::unordered_map<std::string, std::string, Hash<std::string> > m;
+    NamesCacheLock lock(_imp->location);
+
+    for (FSIterator i(_imp->location, { fsio_inode_sort }), i_end ; i != i_end ; ++i)
+        if (i->basename() != "_LOCK_")
+            i->unlink();
+
+    NamesMap names;
 
     std::shared_ptr<const CategoryNamePartSet> cats(_imp->repo->category_names({ }));
     for (CategoryNamePartSet::ConstIterator c(cats->begin()), c_end(cats->end()) ;
@@ -240,32 +665,28 @@ RepositoryNameCache::regenerate_cache() const
         std::shared_ptr<const QualifiedPackageNameSet> pkgs(_imp->repo->package_names(*c, { }));
         for (QualifiedPackageNameSet::ConstIterator p(pkgs->begin()), p_end(pkgs->end()) ;
                 p != p_end ; ++p)
-            m[stringify(p->package())].append(stringify(*c) + "\n");
+            names[p->package()].insert(*c);
     }
 
-    for (std::unordered_map<std::string, std::string, Hash<std::string> >::const_iterator e(m.begin()), e_end(m.end()) ;
-            e != e_end ; ++e)
+    try
     {
-        try
-        {
-            SafeOFStream f(_imp->location / stringify(e->first), -1, true);
-            f << e->second;
-        }
-        catch (const SafeOFStreamError & ee)
-        {
-            Log::get_instance()->message("repository.names_cache.write_failed", ll_warning, lc_context)
-                << "Cannot write to '" << _imp->location << "': '" << ee.message() << "' (" << ee.what() << ")";
-            continue;
-        }
+        _imp->write(names);
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("repository.names_cache.write_failed", ll_warning, lc_context)
+            << "Cannot write to '" << _imp->location << "': '" << e.message() << "' (" << e.what() << ")";
+        return;
     }
 
     try
     {
-        SafeOFStream f(_imp->location / "_VERSION_", -1, true);;
-        f << "paludis-2" << std::endl;
-        f << _imp->repo->name() << std::endl;
+        AtomicOFStream a(_imp->location / "_VERSION_");
+        a.stream() << version_string << std::endl;
+        a.stream() << _imp->repo->name() << std::endl;
+        a.commit();
     }
-    catch (const SafeOFStreamError & e)
+    catch (const Exception & e)
     {
         Log::get_instance()->message("repository.names_cache.write_failed", ll_warning, lc_context)
             << "Cannot write to '" << _imp->location << "': '" << e.message() << "' (" << e.what() << ")";
@@ -273,41 +694,176 @@ RepositoryNameCache::regenerate_cache() const
 }
 
 void
-RepositoryNameCache::add(const QualifiedPackageName & q)
+RepositoryNameCache::update(const QualifiedPackageNameSet & added, const QualifiedPackageNameSet & removed)
 {
     std::unique_lock<std::mutex> l(_imp->mutex);
 
     if (! usable())
         return;
 
-    Context context("When adding '" + stringify(q) + "' to name cache at '" + stringify(_imp->location) + "':");
+    Context context("When updating name cache at '" + stringify(_imp->location) + "':");
 
-    std::shared_ptr<CategoryNamePartSet> result(std::make_shared<CategoryNamePartSet>());
-    NameCacheMap::iterator r(_imp->find(q.package()));
-    if (_imp->name_cache_map.end() == r)
+    if (! _imp->check())
+        return;
+
+    if (added.empty() && removed.empty())
         return;
 
-    r->second.insert(q.category());
-    _imp->update(q.package(), r);
+    try
+    {
+        NamesCacheLock lock(_imp->location);
+
+        _imp->append_journal(added, removed);
+        if (_imp->journal_entries >= journal_compact_threshold)
+            _imp->compact();
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("repository.names_cache.write_failed", ll_warning, lc_context)
+            << "Cannot write to '" << _imp->location << "': '" << e.message() << "' (" << e.what() << ")";
+        _imp->usable = false;
+    }
+}
+
+void
+RepositoryNameCache::add(const QualifiedPackageName & q)
+{
+    QualifiedPackageNameSet added;
+    added.insert(q);
+    update(added, QualifiedPackageNameSet());
 }
 
 void
 RepositoryNameCache::remove(const QualifiedPackageName & q)
+{
+    QualifiedPackageNameSet removed;
+    removed.insert(q);
+    update(QualifiedPackageNameSet(), removed);
+}
+
+void
+RepositoryNameCache::add_pending(const std::shared_ptr<const QualifiedPackageNameSet> & names)
 {
     std::unique_lock<std::mutex> l(_imp->mutex);
 
     if (! usable())
         return;
 
-    Context context("When removing '" + stringify(q) + "' from name cache at '" + stringify(_imp->location) + "':");
+    Context context("When recording pending names cache changes at '" + stringify(_imp->location) + "':");
 
-    std::shared_ptr<CategoryNamePartSet> result(std::make_shared<CategoryNamePartSet>());
-    NameCacheMap::iterator r(_imp->find(q.package()));
-    if (_imp->name_cache_map.end() == r)
+    /* no cache yet, so the next regeneration will be a full one anyway */
+    if (! _imp->location.stat().is_directory())
+        return;
+
+    NamesCacheLock lock(_imp->location);
+
+    FSPath pending_file(_imp->location / "_PENDING_");
+    std::set<std::string> lines;
+
+    /* with no pending file, everything up to now is already in the cache, so
+     * we only need to remember what this sync changed */
+    if (names && pending_file.stat().exists())
+    {
+        SafeIFStream f(pending_file);
+        std::string line;
+        while (std::getline(f, line))
+            if (! line.empty())
+                lines.insert(line);
+    }
+
+    if ((! names) || lines.count("*"))
+        lines = std::set<std::string>{ "*" };
+    else
+        for (const auto & q : *names)
+            lines.insert(stringify(q));
+
+    try
+    {
+        AtomicOFStream f(pending_file);
+        for (const auto & line : lines)
+            f.stream() << line << std::endl;
+        f.commit();
+    }
+    catch (const Exception & e)
+    {
+        Log::get_instance()->message("repository.names_cache.write_failed", ll_warning, lc_context)
+            << "Cannot write to '" << _imp->location << "': '" << e.message() << "' (" << e.what() << ")";
+        pending_file.unlink();
+    }
+}
+
+std::shared_ptr<const QualifiedPackageNameSet>
+RepositoryNameCache::pending() const
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (! usable())
+        return nullptr;
+
+    Context context("When reading pending names cache changes at '" + stringify(_imp->location) + "':");
+
+    FSPath pending_file(_imp->location / "_PENDING_");
+    if ((! pending_file.stat().exists()) || ! _imp->check())
+        return nullptr;
+
+    auto result(std::make_shared<QualifiedPackageNameSet>());
+    SafeIFStream f(pending_file);
+    std::string line;
+    while (std::getline(f, line))
+    {
+        if (line.empty())
+            continue;
+        if ("*" == line)
+            return nullptr;
+
+        try
+        {
+            result->insert(QualifiedPackageName(line));
+        }
+        catch (const NameError &)
+        {
+            return nullptr;
+        }
+    }
+
+    return result;
+}
+
+bool
+RepositoryNameCache::needs_regeneration() const
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (_imp->location == FSPath("/var/empty"))
+        return false;
+
+    Context context("When checking whether names cache at '" + stringify(_imp->location) + "' needs regenerating:");
+
+    if (! (_imp->location / "_VERSION_").stat().exists())
+        return true;
+
+    FSPath pending_file(_imp->location / "_PENDING_");
+    if (! pending_file.stat().exists())
+        return false;
+
+    SafeIFStream f(pending_file);
+    std::string line;
+    while (std::getline(f, line))
+        if ("*" == line)
+            return true;
+
+    return false;
+}
+
+void
+RepositoryNameCache::clear_pending()
+{
+    std::unique_lock<std::mutex> l(_imp->mutex);
+
+    if (_imp->location == FSPath("/var/empty"))
         return;
 
-    r->second.erase(q.category());
-    _imp->update(q.package(), r);
+    (_imp->location / "_PENDING_").unlink();
 }
 
 bool
@@ -315,4 +871,3 @@ RepositoryNameCache::usable() const noexcept
 {
     return _imp->usable;
 }
-
@@ -78,6 +78,43 @@ namespace paludis
             std::shared_ptr<const CategoryNamePartSet> category_names_containing_package(
                     const PackageNamePart & p) const;
 
+            /**
+             * Fetch every package name in the cache.
+             *
+             * May return a zero pointer, like category_names_containing_package.
+             * The same pointer is returned until the cache is changed.
+             *
+             * \since 3.0
+             */
+            std::shared_ptr<const QualifiedPackageNameSet> package_names() const;
+
+            /**
+             * Fetch every package name in the main cache file, ignoring any
+             * journal entries.
+             *
+             * May return a zero pointer, like category_names_containing_package.
+             * The same pointer is returned until the main cache file is
+             * rewritten, which only happens when the cache is regenerated or
+             * when the journal is folded back into it, so this is suitable
+             * for building longer lived indexes. Use apply_journal to bring
+             * lookups in such an index up to date.
+             *
+             * \since 3.0
+             */
+            std::shared_ptr<const QualifiedPackageNameSet> table_names() const;
+
+            /**
+             * Apply our journal entries for a package to the categories
+             * found for it in the result of an earlier table_names call.
+             *
+             * Returns false, leaving the categories alone, if that table is
+             * no longer current, in which case the caller must look again.
+             *
+             * \since 3.0
+             */
+            bool apply_journal(const std::shared_ptr<const QualifiedPackageNameSet> & table,
+                    const PackageNamePart &, CategoryNamePartSet &) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             /**
              * Whether or not our cache is usable.
              *
@@ -101,6 +138,57 @@ namespace paludis
              */
             void remove(const QualifiedPackageName &);
 
+            /**
+             * Add and remove several packages at once.
+             *
+             * Changes are appended to a journal, which is only folded back
+             * into the main cache file once it gets long.
+             *
+             * \since 3.0
+             */
+            void update(const QualifiedPackageNameSet & added, const QualifiedPackageNameSet & removed);
+
+            /**
+             * Record that a sync may have added or removed the given packages,
+             * so that the next regeneration only needs to look at them.
+             *
+             * A zero pointer means the sync could not tell what changed, and
+             * the next regeneration must be a full one.
+             *
+             * \since 3.0
+             */
+            void add_pending(const std::shared_ptr<const QualifiedPackageNameSet> &);
+
+            /**
+             * The packages recorded by add_pending since the cache was last
+             * regenerated.
+             *
+             * Returns a zero pointer if there is no such record, or if the
+             * cache itself is not usable, in which case a full regeneration
+             * is needed.
+             *
+             * \since 3.0
+             */
+            std::shared_ptr<const QualifiedPackageNameSet> pending() const;
+
+            /**
+             * Whether only a full regeneration will bring the cache up to
+             * date, either because it has never been generated, or because
+             * add_pending was told that a sync could not say what it
+             * changed.
+             *
+             * \since 3.0
+             */
+            bool needs_regeneration() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Forget the packages recorded by add_pending, once they have
+             * been dealt with using update.
+             *
+             * \since 3.0
+             */
+            void clear_pending();
+
             ///\}
     };
 }
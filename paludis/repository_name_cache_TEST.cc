@@ -23,6 +23,8 @@
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/set.hh>
 #include <paludis/util/make_named_values.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/stringify.hh>
 
 #include <paludis/environments/test/test_environment.hh>
 #include <paludis/repositories/fake/fake_repository.hh>
@@ -104,7 +106,7 @@ TEST(RepositoryNameCache, BadRepo)
     EXPECT_TRUE(! cache.usable());
 }
 
-TEST(RepositoryNameCache, Good)
+TEST(RepositoryNameCache, Paludis2Format)
 {
     TestEnvironment env;
     const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
@@ -113,18 +115,40 @@ TEST(RepositoryNameCache, Good)
                     )));
     env.add_repository(10, repo);
 
-    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/good_repo"), repo.get());
+    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/paludis_2_format"), repo.get());
     EXPECT_TRUE(cache.usable());
+    EXPECT_TRUE(! cache.category_names_containing_package(PackageNamePart("foo")));
+    EXPECT_TRUE(! cache.usable());
+}
 
-    std::shared_ptr<const CategoryNamePartSet> foo(cache.category_names_containing_package(PackageNamePart("foo")));
+TEST(RepositoryNameCache, NoNames)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(10, repo);
+
+    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/no_names"), repo.get());
     EXPECT_TRUE(cache.usable());
-    EXPECT_TRUE(bool(foo));
-    EXPECT_EQ("bar baz", join(foo->begin(), foo->end(), " "));
+    EXPECT_TRUE(! cache.category_names_containing_package(PackageNamePart("foo")));
+    EXPECT_TRUE(! cache.usable());
+}
 
-    std::shared_ptr<const CategoryNamePartSet> moo(cache.category_names_containing_package(PackageNamePart("moo")));
+TEST(RepositoryNameCache, CorruptNames)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(10, repo);
+
+    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/corrupt_names"), repo.get());
     EXPECT_TRUE(cache.usable());
-    EXPECT_TRUE(bool(moo));
-    EXPECT_TRUE(moo->empty());
+    EXPECT_TRUE(! cache.package_names());
+    EXPECT_TRUE(! cache.usable());
 }
 
 TEST(RepositoryNameCache, Generate)
@@ -139,6 +163,7 @@ TEST(RepositoryNameCache, Generate)
     RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/generated"), repo.get());
     repo->add_package(QualifiedPackageName("bar/foo"));
     repo->add_package(QualifiedPackageName("baz/foo"));
+    repo->add_package(QualifiedPackageName("baz/oink"));
 
     EXPECT_TRUE(cache.usable());
     cache.regenerate_cache();
@@ -153,5 +178,179 @@ TEST(RepositoryNameCache, Generate)
     EXPECT_TRUE(cache.usable());
     EXPECT_TRUE(bool(moo));
     EXPECT_TRUE(moo->empty());
+
+    RepositoryNameCache reread(FSPath("repository_name_cache_TEST_dir/generated"), repo.get());
+    std::shared_ptr<const CategoryNamePartSet> foo2(reread.category_names_containing_package(PackageNamePart("foo")));
+    EXPECT_TRUE(reread.usable());
+    EXPECT_TRUE(bool(foo2));
+    EXPECT_EQ("bar baz", join(foo2->begin(), foo2->end(), " "));
+
+    std::shared_ptr<const QualifiedPackageNameSet> all(reread.package_names());
+    EXPECT_TRUE(bool(all));
+    EXPECT_EQ("bar/foo baz/foo baz/oink", join(all->begin(), all->end(), " "));
+    EXPECT_EQ(all, reread.package_names());
 }
 
+TEST(RepositoryNameCache, Update)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(10, repo);
+
+    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/updated"), repo.get());
+    repo->add_package(QualifiedPackageName("bar/foo"));
+    cache.regenerate_cache();
+
+    std::shared_ptr<const QualifiedPackageNameSet> before(cache.package_names());
+    EXPECT_EQ("bar/foo", join(before->begin(), before->end(), " "));
+
+    cache.add(QualifiedPackageName("baz/foo"));
+    cache.add(QualifiedPackageName("baz/moo"));
+    std::shared_ptr<const QualifiedPackageNameSet> after_add(cache.package_names());
+    EXPECT_NE(before, after_add);
+    EXPECT_EQ("bar/foo baz/foo baz/moo", join(after_add->begin(), after_add->end(), " "));
+
+    cache.remove(QualifiedPackageName("bar/foo"));
+    std::shared_ptr<const CategoryNamePartSet> foo(cache.category_names_containing_package(PackageNamePart("foo")));
+    EXPECT_EQ("baz", join(foo->begin(), foo->end(), " "));
+
+    QualifiedPackageNameSet added, removed;
+    added.insert(QualifiedPackageName("quux/foo"));
+    added.insert(QualifiedPackageName("quux/oink"));
+    removed.insert(QualifiedPackageName("baz/moo"));
+    cache.update(added, removed);
+
+    RepositoryNameCache reread(FSPath("repository_name_cache_TEST_dir/updated"), repo.get());
+    std::shared_ptr<const QualifiedPackageNameSet> all(reread.package_names());
+    EXPECT_TRUE(reread.usable());
+    EXPECT_EQ("baz/foo quux/foo quux/oink", join(all->begin(), all->end(), " "));
+    EXPECT_TRUE(reread.category_names_containing_package(PackageNamePart("moo"))->empty());
+}
+
+TEST(RepositoryNameCache, Journal)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(10, repo);
+
+    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/journal"), repo.get());
+    repo->add_package(QualifiedPackageName("bar/foo"));
+    cache.regenerate_cache();
+
+    FSPath journal_file("repository_name_cache_TEST_dir/journal/repo/_JOURNAL_");
+    cache.add(QualifiedPackageName("baz/foo"));
+    cache.remove(QualifiedPackageName("bar/foo"));
+    EXPECT_TRUE(journal_file.stat().exists());
+
+    RepositoryNameCache reread(FSPath("repository_name_cache_TEST_dir/journal"), repo.get());
+    std::shared_ptr<const CategoryNamePartSet> foo(reread.category_names_containing_package(PackageNamePart("foo")));
+    EXPECT_TRUE(reread.usable());
+    EXPECT_EQ("baz", join(foo->begin(), foo->end(), " "));
+
+    QualifiedPackageNameSet added;
+    for (int i(0) ; i < 100 ; ++i)
+        added.insert(QualifiedPackageName("cat/pkg" + stringify(i)));
+    cache.update(added, QualifiedPackageNameSet());
+    EXPECT_TRUE(! journal_file.stat().exists());
+
+    RepositoryNameCache compacted(FSPath("repository_name_cache_TEST_dir/journal"), repo.get());
+    std::shared_ptr<const QualifiedPackageNameSet> all(compacted.package_names());
+    EXPECT_TRUE(compacted.usable());
+    EXPECT_EQ(101, std::distance(all->begin(), all->end()));
+    std::shared_ptr<const CategoryNamePartSet> foo2(compacted.category_names_containing_package(PackageNamePart("foo")));
+    EXPECT_EQ("baz", join(foo2->begin(), foo2->end(), " "));
+}
+
+
+TEST(RepositoryNameCache, TableNames)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(10, repo);
+
+    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/table_names"), repo.get());
+    repo->add_package(QualifiedPackageName("bar/foo"));
+    cache.regenerate_cache();
+
+    std::shared_ptr<const QualifiedPackageNameSet> table(cache.table_names());
+    ASSERT_TRUE(bool(table));
+    EXPECT_EQ("bar/foo", join(table->begin(), table->end(), " "));
+
+    cache.add(QualifiedPackageName("baz/foo"));
+    cache.remove(QualifiedPackageName("bar/foo"));
+    EXPECT_EQ(table, cache.table_names());
+
+    CategoryNamePartSet cats;
+    cats.insert(CategoryNamePart("bar"));
+    ASSERT_TRUE(cache.apply_journal(table, PackageNamePart("foo"), cats));
+    EXPECT_EQ("baz", join(cats.begin(), cats.end(), " "));
+
+    QualifiedPackageNameSet added;
+    for (int i(0) ; i < 100 ; ++i)
+        added.insert(QualifiedPackageName("cat/pkg" + stringify(i)));
+    cache.update(added, QualifiedPackageNameSet());
+
+    CategoryNamePartSet stale;
+    EXPECT_FALSE(cache.apply_journal(table, PackageNamePart("foo"), stale));
+
+    std::shared_ptr<const QualifiedPackageNameSet> compacted(cache.table_names());
+    ASSERT_TRUE(bool(compacted));
+    EXPECT_NE(table, compacted);
+    EXPECT_EQ(101, std::distance(compacted->begin(), compacted->end()));
+}
+
+TEST(RepositoryNameCache, Pending)
+{
+    TestEnvironment env;
+    const std::shared_ptr<FakeRepository> repo(std::make_shared<FakeRepository>(make_named_values<FakeRepositoryParams>(
+                    n::environment() = &env,
+                    n::name() = RepositoryName("repo")
+                    )));
+    env.add_repository(10, repo);
+
+    RepositoryNameCache cache(FSPath("repository_name_cache_TEST_dir/pending"), repo.get());
+    repo->add_package(QualifiedPackageName("bar/foo"));
+    EXPECT_TRUE(cache.needs_regeneration());
+    cache.regenerate_cache();
+    EXPECT_FALSE(bool(cache.pending()));
+    EXPECT_FALSE(cache.needs_regeneration());
+
+    auto first(std::make_shared<QualifiedPackageNameSet>());
+    first->insert(QualifiedPackageName("bar/foo"));
+    cache.add_pending(first);
+    auto second(std::make_shared<QualifiedPackageNameSet>());
+    second->insert(QualifiedPackageName("baz/moo"));
+    cache.add_pending(second);
+
+    RepositoryNameCache reread(FSPath("repository_name_cache_TEST_dir/pending"), repo.get());
+    std::shared_ptr<const QualifiedPackageNameSet> pending(reread.pending());
+    EXPECT_TRUE(bool(pending));
+    EXPECT_EQ("bar/foo baz/moo", join(pending->begin(), pending->end(), " "));
+    EXPECT_FALSE(reread.needs_regeneration());
+
+    reread.clear_pending();
+    EXPECT_FALSE(bool(cache.pending()));
+
+    /* once we don't know what a sync changed, later syncs can't help */
+    cache.add_pending(first);
+    cache.add_pending(nullptr);
+    cache.add_pending(second);
+    EXPECT_FALSE(bool(cache.pending()));
+    EXPECT_TRUE(cache.needs_regeneration());
+
+    cache.regenerate_cache();
+    EXPECT_FALSE(cache.needs_regeneration());
+    cache.add_pending(second);
+    pending = cache.pending();
+    EXPECT_TRUE(bool(pending));
+    EXPECT_EQ("baz/moo", join(pending->begin(), pending->end(), " "));
+}
@@ -6,17 +6,30 @@ cd repository_name_cache_TEST_dir || exit 1
 
 mkdir -p not_generated
 mkdir -p generated
+mkdir -p updated
+mkdir -p journal
+mkdir -p table_names
+mkdir -p pending
 
 mkdir -p old_format/repo
 echo "paludis-1" > old_format/repo/_VERSION_
 
+mkdir -p paludis_2_format/repo
+echo "paludis-2" > paludis_2_format/repo/_VERSION_
+echo "repo" >> paludis_2_format/repo/_VERSION_
+echo "bar" > paludis_2_format/repo/foo
+echo "baz" >> paludis_2_format/repo/foo
+
 mkdir -p bad_repo/repo
-echo "paludis-2" > bad_repo/repo/_VERSION_
+echo "paludis-3" > bad_repo/repo/_VERSION_
 echo "monkey" >> bad_repo/repo/_VERSION_
 
-mkdir -p good_repo/repo
-echo "paludis-2" > good_repo/repo/_VERSION_
-echo "repo" >> good_repo/repo/_VERSION_
-echo "bar" > good_repo/repo/foo
-echo "baz" >> good_repo/repo/foo
+mkdir -p no_names/repo
+echo "paludis-3" > no_names/repo/_VERSION_
+echo "repo" >> no_names/repo/_VERSION_
 
+mkdir -p corrupt_names/repo
+echo "paludis-3" > corrupt_names/repo/_VERSION_
+echo "repo" >> corrupt_names/repo/_VERSION_
+echo "paludis-names-3" > corrupt_names/repo/_NAMES_
+echo "rubbish" >> corrupt_names/repo/_NAMES_
@@ -20,6 +20,8 @@
 #include <paludis/resolver/can_use_helper.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/options.hh>
+#include <paludis/util/profiler.hh>
+#include <paludis/util/stringify.hh>
 #include <paludis/dep_spec.hh>
 #include <paludis/package_id.hh>
 #include <paludis/package_dep_spec_collection.hh>
@@ -59,6 +61,7 @@ CanUseHelper::add_cannot_use_spec(const PackageDepSpec & spec)
 bool
 CanUseHelper::operator() (const std::shared_ptr<const PackageID> & id) const
 {
+    ProfileScope profile_scope("CanUseHelper", "resolver.helper", [&] { return stringify(*id); });
     return ! _imp->cannot_use_specs.match_any(_imp->env, id, { });
 }
 
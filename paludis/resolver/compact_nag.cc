@@ -0,0 +1,331 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/resolver/compact_nag.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/tribool.hh>
+#include <paludis/util/profiler.hh>
+#include <paludis/util/stringify.hh>
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+using namespace paludis;
+using namespace paludis::resolver;
+
+namespace
+{
+    struct CompareEdgesByTarget
+    {
+        bool operator() (const CompactNAGEdge & a, const CompactNAGEdge & b) const
+        {
+            return a.to() < b.to();
+        }
+    };
+
+    void sort_edges(std::vector<std::size_t> & offsets, std::vector<CompactNAGEdge> & edges)
+    {
+        for (std::size_t n(0), n_end(offsets.size() - 1) ; n != n_end ; ++n)
+            std::sort(edges.begin() + offsets[n], edges.begin() + offsets[n + 1], CompareEdgesByTarget());
+    }
+}
+
+CompactNAG::CompactNAG(const NAG & nag)
+{
+    ProfileScope profile_scope("CompactNAG::CompactNAG", "resolver");
+
+    _nodes.assign(nag.begin_nodes(), nag.end_nodes());
+    std::sort(_nodes.begin(), _nodes.end());
+
+    std::unordered_map<NAGIndex, int, Hash<NAGIndex> > numbers;
+    numbers.reserve(_nodes.size());
+    _originals.reserve(_nodes.size());
+    for (int n(0), n_end(_nodes.size()) ; n != n_end ; ++n)
+    {
+        numbers.insert(std::make_pair(_nodes[n], n));
+        _originals.push_back(n);
+    }
+
+    _edge_offsets.reserve(_nodes.size() + 1);
+    for (const auto & node : _nodes)
+    {
+        _edge_offsets.push_back(_edges.size());
+        for (NAG::EdgesFromConstIterator e(nag.begin_edges_from(node)), e_end(nag.end_edges_from(node)) ;
+                e != e_end ; ++e)
+        {
+            auto to(numbers.find(e->first));
+            if (to == numbers.end())
+                throw InternalError(PALUDIS_HERE, "Missing node for edge '" + stringify(node) + "' -> '" + stringify(e->first) + "'");
+
+            _edges.push_back(make_named_values<CompactNAGEdge>(
+                        n::properties() = e->second,
+                        n::to() = to->second
+                        ));
+        }
+    }
+    _edge_offsets.push_back(_edges.size());
+
+    sort_edges(_edge_offsets, _edges);
+}
+
+CompactNAG::CompactNAG(const CompactNAG & parent, const std::vector<int> & parent_nodes,
+        const std::function<bool (NAGEdgeProperties &)> & keep_edge)
+{
+    /* keep the parent's order, which is NAGIndex order */
+    std::vector<int> sorted_parent_nodes(parent_nodes);
+    std::sort(sorted_parent_nodes.begin(), sorted_parent_nodes.end());
+
+    std::vector<int> numbers(parent.size(), -1);
+    _nodes.reserve(sorted_parent_nodes.size());
+    _originals.reserve(sorted_parent_nodes.size());
+    for (const auto & p : sorted_parent_nodes)
+    {
+        numbers[p] = _nodes.size();
+        _nodes.push_back(parent.node(p));
+        _originals.push_back(parent.original(p));
+    }
+
+    _edge_offsets.reserve(_nodes.size() + 1);
+    for (const auto & p : sorted_parent_nodes)
+    {
+        _edge_offsets.push_back(_edges.size());
+        for (const CompactNAGEdge * e(parent.begin_edges_from(p)), * e_end(parent.end_edges_from(p)) ;
+                e != e_end ; ++e)
+        {
+            if (-1 == numbers[e->to()])
+                continue;
+
+            NAGEdgeProperties properties(e->properties());
+            if (! keep_edge(properties))
+                continue;
+
+            _edges.push_back(make_named_values<CompactNAGEdge>(
+                        n::properties() = properties,
+                        n::to() = numbers[e->to()]
+                        ));
+        }
+    }
+    _edge_offsets.push_back(_edges.size());
+}
+
+namespace
+{
+    /* Tarjan's algorithm, without recursion, so long dependency chains
+     * can't run us out of stack. Components are numbered in the order
+     * they are completed. */
+    int tarjan(const CompactNAG & nag, std::vector<int> & component_of)
+    {
+        const int size(nag.size());
+        std::vector<int> index(size, -1), lowlink(size, 0);
+        std::vector<bool> on_stack(size, false);
+        std::vector<int> stack;
+        std::vector<std::pair<int, const CompactNAGEdge *> > calls;
+        int next_index(0), next_component(0);
+
+        component_of.assign(size, -1);
+
+        for (int root(0) ; root != size ; ++root)
+        {
+            if (-1 != index[root])
+                continue;
+
+            calls.push_back(std::make_pair(root, nag.begin_edges_from(root)));
+            index[root] = lowlink[root] = next_index++;
+            stack.push_back(root);
+            on_stack[root] = true;
+
+            while (! calls.empty())
+            {
+                int node(calls.back().first);
+                const CompactNAGEdge * & e(calls.back().second);
+
+                if (e != nag.end_edges_from(node))
+                {
+                    int to(e->to());
+                    ++e;
+
+                    if (-1 == index[to])
+                    {
+                        index[to] = lowlink[to] = next_index++;
+                        stack.push_back(to);
+                        on_stack[to] = true;
+                        calls.push_back(std::make_pair(to, nag.begin_edges_from(to)));
+                    }
+                    else if (on_stack[to])
+                        lowlink[node] = std::min(lowlink[node], index[to]);
+
+                    continue;
+                }
+
+                calls.pop_back();
+                if (! calls.empty())
+                    lowlink[calls.back().first] = std::min(lowlink[calls.back().first], lowlink[node]);
+
+                if (index[node] == lowlink[node])
+                {
+                    int member;
+                    do
+                    {
+                        member = stack.back();
+                        stack.pop_back();
+                        on_stack[member] = false;
+                        component_of[member] = next_component;
+                    }
+                    while (member != node);
+
+                    ++next_component;
+                }
+            }
+        }
+
+        return next_component;
+    }
+
+    int order_score_one(const NAGIndex & n, const std::function<Tribool (const NAGIndex &)> & order_early_fn)
+    {
+        /* lower scores are 'better' and mean 'order earlier' */
+        Tribool order_early(order_early_fn(n));
+        int bias(0);
+        if (order_early.is_indeterminate())
+            bias = 1;
+        else if (order_early.is_false())
+            bias = 2;
+
+        switch (n.role())
+        {
+            case nir_fetched:
+                return 10 + bias;
+
+            case nir_done:
+                return 20 + bias;
+
+            case last_nir:
+                break;
+        }
+
+        throw InternalError(PALUDIS_HERE, "bad nir");
+    }
+}
+
+CompactNAG::Components
+CompactNAG::sorted_strongly_connected_components(
+        const std::function<Tribool (const NAGIndex &)> & order_early_fn
+        ) const
+{
+    ProfileScope profile_scope("CompactNAG::sorted_strongly_connected_components", "resolver",
+            [&] () { return stringify(size()); });
+
+    /* find our strongly connected components. since nodes are numbered in
+     * NAGIndex order, filling them in by node number keeps each one sorted,
+     * and its first node is the one NAG uses as its representative. */
+    std::vector<int> component_of;
+    Components components(tarjan(*this, component_of));
+    for (int n(0), n_end(size()) ; n != n_end ; ++n)
+        components[component_of[n]].push_back(n);
+
+    /* build edges between components, ordered by representative */
+    std::vector<std::vector<int> > component_edges(components.size()), component_edges_backwards(components.size());
+    for (int n(0), n_end(size()) ; n != n_end ; ++n)
+        for (const CompactNAGEdge * e(begin_edges_from(n)), * e_end(end_edges_from(n)) ; e != e_end ; ++e)
+            if (component_of[n] != component_of[e->to()])
+            {
+                component_edges[component_of[n]].push_back(component_of[e->to()]);
+                component_edges_backwards[component_of[e->to()]].push_back(component_of[n]);
+            }
+
+    auto by_representative([&] (const int a, const int b) { return components[a].front() < components[b].front(); });
+    std::vector<int> remaining_edges(components.size());
+    for (std::size_t c(0) ; c != components.size() ; ++c)
+    {
+        std::sort(component_edges[c].begin(), component_edges[c].end(), by_representative);
+        component_edges[c].erase(std::unique(component_edges[c].begin(), component_edges[c].end()), component_edges[c].end());
+        std::sort(component_edges_backwards[c].begin(), component_edges_backwards[c].end());
+        component_edges_backwards[c].erase(std::unique(component_edges_backwards[c].begin(), component_edges_backwards[c].end()),
+                component_edges_backwards[c].end());
+        remaining_edges[c] = component_edges[c].size();
+    }
+
+    auto order_score([&] (const int c) {
+            int best_score(-1);
+            for (const auto & n : components[c])
+            {
+                int score(order_score_one(node(n), order_early_fn));
+                if (best_score == -1 || score < best_score)
+                    best_score = score;
+            }
+            return std::make_pair(best_score, components[c].front());
+            });
+
+    /* topological sort with consistent ordering (mostly to make test cases
+     * easier). we know there're no cycles. */
+    Components result;
+    result.reserve(components.size());
+
+    typedef std::set<std::pair<int, int> > OrderableNow;
+    OrderableNow orderable_now;
+    std::vector<bool> pending_fetches(components.size(), false);
+    std::size_t done(0), number_of_pending_fetches(0);
+
+    for (std::size_t c(0) ; c != components.size() ; ++c)
+        if (0 == remaining_edges[c])
+            orderable_now.insert(order_score(c));
+
+    while (! orderable_now.empty())
+    {
+        OrderableNow::iterator ordering_now(orderable_now.begin());
+        int c(component_of[ordering_now->second]);
+
+        if (components[c].size() == 1 && node(components[c].front()).role() == nir_fetched)
+        {
+            pending_fetches[c] = true;
+            ++number_of_pending_fetches;
+        }
+        else
+        {
+            for (const auto & e : component_edges[c])
+                if (pending_fetches[e])
+                {
+                    result.push_back(components[e]);
+                    pending_fetches[e] = false;
+                    --number_of_pending_fetches;
+                }
+
+            result.push_back(components[c]);
+        }
+        ++done;
+
+        for (const auto & e : component_edges_backwards[c])
+            if (0 == --remaining_edges[e])
+                orderable_now.insert(order_score(e));
+
+        orderable_now.erase(ordering_now);
+    }
+
+    if (0 != number_of_pending_fetches)
+        throw InternalError(PALUDIS_HERE, "still have pending fetches");
+
+    if (done != components.size())
+        throw InternalError(PALUDIS_HERE, "mismatch");
+
+    return result;
+}
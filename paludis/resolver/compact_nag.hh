@@ -0,0 +1,130 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_RESOLVER_COMPACT_NAG_HH
+#define PALUDIS_GUARD_PALUDIS_RESOLVER_COMPACT_NAG_HH 1
+
+#include <paludis/resolver/compact_nag-fwd.hh>
+#include <paludis/resolver/nag.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/named_value.hh>
+#include <paludis/util/tribool-fwd.hh>
+#include <functional>
+#include <vector>
+
+namespace paludis
+{
+    namespace n
+    {
+        typedef Name<struct name_properties> properties;
+        typedef Name<struct name_to> to;
+    }
+
+    namespace resolver
+    {
+        struct CompactNAGEdge
+        {
+            NamedValue<n::properties, NAGEdgeProperties> properties;
+            NamedValue<n::to, int> to;
+        };
+
+        /**
+         * A dense, integer indexed copy of a NAG, or of part of one.
+         *
+         * Nodes are numbered from zero in NAGIndex order, and each node's
+         * edges are stored together, sorted by target, so walking the graph
+         * never needs to hash a resolvent. This is built once the NAG is
+         * complete; changing the NAG afterwards does not change us.
+         *
+         * The accessors are inline, because ordering calls them a great many
+         * times.
+         *
+         * \since 3.0
+         */
+        class PALUDIS_VISIBLE CompactNAG
+        {
+            private:
+                std::vector<NAGIndex> _nodes;
+                std::vector<int> _originals;
+                std::vector<std::size_t> _edge_offsets;
+                std::vector<CompactNAGEdge> _edges;
+
+            public:
+                ///\name Basic operations
+                ///\{
+
+                explicit CompactNAG(const NAG &);
+
+                /**
+                 * Take the given nodes of another CompactNAG, and any edges
+                 * between them for which keep_edge returns true. keep_edge
+                 * may alter the edge's properties.
+                 */
+                CompactNAG(const CompactNAG & parent, const std::vector<int> & parent_nodes,
+                        const std::function<bool (NAGEdgeProperties &)> & keep_edge);
+
+                ///\}
+
+                typedef std::vector<std::vector<int> > Components;
+
+                int size() const
+                {
+                    return _nodes.size();
+                }
+
+                const NAGIndex & node(const int n) const
+                {
+                    return _nodes[n];
+                }
+
+                /**
+                 * The number of node n in the CompactNAG that was made
+                 * directly from a NAG, however many times we have taken
+                 * parts of it since.
+                 */
+                int original(const int n) const
+                {
+                    return _originals[n];
+                }
+
+                const CompactNAGEdge * begin_edges_from(const int n) const
+                {
+                    return _edges.data() + _edge_offsets[n];
+                }
+
+                const CompactNAGEdge * end_edges_from(const int n) const
+                {
+                    return _edges.data() + _edge_offsets[n + 1];
+                }
+
+                /**
+                 * Our strongly connected components, in an order in which
+                 * they can be installed. Each component's nodes are in
+                 * NAGIndex order.
+                 *
+                 * This is the same order as NAG::sorted_strongly_connected_components.
+                 */
+                Components sorted_strongly_connected_components(
+                        const std::function<Tribool (const NAGIndex &)> & order_early_fn
+                        ) const PALUDIS_ATTRIBUTE((warn_unused_result));
+        };
+    }
+}
+
+#endif
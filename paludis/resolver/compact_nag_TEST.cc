@@ -0,0 +1,536 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/resolver/compact_nag.hh>
+#include <paludis/resolver/nag.hh>
+#include <paludis/resolver/resolvent.hh>
+#include <paludis/resolver/destination_types.hh>
+
+#include <paludis/util/exception.hh>
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/tribool.hh>
+
+#include <paludis/name.hh>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+using namespace paludis::resolver;
+
+namespace
+{
+    NAGIndex make_index(const std::string & name, const NAGIndexRole role)
+    {
+        return make_named_values<NAGIndex>(
+                n::resolvent() = Resolvent(QualifiedPackageName("cat/" + name), SlotName("0"), dt_install_to_slash),
+                n::role() = role
+                );
+    }
+
+    NAGEdgeProperties make_properties(const bool build, const bool build_all_met, const bool run, const bool run_all_met)
+    {
+        return make_named_values<NAGEdgeProperties>(
+                n::always() = false,
+                n::build() = build,
+                n::build_all_met() = build_all_met,
+                n::run() = run,
+                n::run_all_met() = run_all_met
+                );
+    }
+
+    typedef std::vector<std::vector<NAGIndex> > Ordering;
+
+    /* A graph held in ordered containers, from which we can build a NAG, and
+     * which we can order the way NAG::sorted_strongly_connected_components
+     * did before it used CompactNAG. */
+    struct Graph
+    {
+        std::set<NAGIndex> nodes;
+        std::map<NAGIndex, std::map<NAGIndex, NAGEdgeProperties> > edges;
+
+        void add_edge(const NAGIndex & a, const NAGIndex & b, const NAGEdgeProperties & p)
+        {
+            nodes.insert(a);
+            nodes.insert(b);
+            edges[a].insert(std::make_pair(b, p)).first->second |= p;
+        }
+
+        void fill(NAG & nag) const
+        {
+            for (const auto & n : nodes)
+                nag.add_node(n);
+            for (const auto & e : edges)
+                for (const auto & f : e.second)
+                    nag.add_edge(e.first, f.first, f.second);
+        }
+
+        /* the sub-NAG that _order_sub_ssccs used to build by hand */
+        Graph subset(const std::set<NAGIndex> & keep, const std::function<bool (NAGEdgeProperties &)> & keep_edge) const
+        {
+            Graph result;
+            for (const auto & n : keep)
+                result.nodes.insert(n);
+
+            for (const auto & e : edges)
+                if (keep.count(e.first))
+                    for (const auto & f : e.second)
+                        if (keep.count(f.first))
+                        {
+                            NAGEdgeProperties p(f.second);
+                            if (keep_edge(p))
+                                result.add_edge(e.first, f.first, p);
+                        }
+
+            return result;
+        }
+    };
+
+    struct TarjanData
+    {
+        int index;
+        int lowlink;
+    };
+
+    void tarjan(const NAGIndex & node, const Graph & graph, std::map<NAGIndex, TarjanData> & data,
+            std::list<NAGIndex> & stack, int & index, std::map<NAGIndex, std::set<NAGIndex> > & result)
+    {
+        data[node] = TarjanData{ index, index };
+        ++index;
+
+        auto top_of_stack_before_node(stack.begin());
+        stack.push_front(node);
+
+        auto e(graph.edges.find(node));
+        if (e != graph.edges.end())
+            for (const auto & n : e->second)
+            {
+                if (! data.count(n.first))
+                {
+                    tarjan(n.first, graph, data, stack, index, result);
+                    data[node].lowlink = std::min(data[node].lowlink, data[n.first].lowlink);
+                }
+                else if (stack.end() != std::find(stack.begin(), stack.end(), n.first))
+                    data[node].lowlink = std::min(data[node].lowlink, data[n.first].index);
+            }
+
+        if (data[node].index == data[node].lowlink)
+        {
+            std::set<NAGIndex> scc(stack.begin(), top_of_stack_before_node);
+            stack.erase(stack.begin(), top_of_stack_before_node);
+            result.insert(std::make_pair(*scc.begin(), scc));
+        }
+    }
+
+    int order_score_one(const NAGIndex & n, const std::function<Tribool (const NAGIndex &)> & order_early_fn)
+    {
+        Tribool order_early(order_early_fn(n));
+        int bias(order_early.is_indeterminate() ? 1 : order_early.is_false() ? 2 : 0);
+        return (n.role() == nir_fetched ? 10 : 20) + bias;
+    }
+
+    Ordering reference_order(const Graph & graph, const std::function<Tribool (const NAGIndex &)> & order_early_fn)
+    {
+        std::map<NAGIndex, std::set<NAGIndex> > sccs;
+        std::map<NAGIndex, TarjanData> data;
+        std::list<NAGIndex> stack;
+        int index(0);
+        for (const auto & n : graph.nodes)
+            if (! data.count(n))
+                tarjan(n, graph, data, stack, index, sccs);
+
+        std::map<NAGIndex, NAGIndex> representatives;
+        for (const auto & s : sccs)
+            for (const auto & n : s.second)
+                representatives.insert(std::make_pair(n, s.first));
+
+        std::map<NAGIndex, std::set<NAGIndex> > all_scc_edges, scc_edges, scc_edges_backwards;
+        for (const auto & e : graph.edges)
+            for (const auto & f : e.second)
+            {
+                const NAGIndex & from(representatives.find(e.first)->second), & to(representatives.find(f.first)->second);
+                if (! (from == to))
+                {
+                    all_scc_edges[from].insert(to);
+                    scc_edges[from].insert(to);
+                    scc_edges_backwards[to].insert(from);
+                }
+            }
+
+        auto order_score([&] (const NAGIndex & r) {
+                int best_score(-1);
+                for (const auto & n : sccs.find(r)->second)
+                {
+                    int score(order_score_one(n, order_early_fn));
+                    if (best_score == -1 || score < best_score)
+                        best_score = score;
+                }
+                return std::make_pair(best_score, r);
+                });
+
+        Ordering result;
+        std::set<std::pair<int, NAGIndex> > orderable_now;
+        std::set<NAGIndex> pending_fetches;
+
+        for (const auto & s : sccs)
+            if (! scc_edges.count(s.first))
+                orderable_now.insert(order_score(s.first));
+
+        while (! orderable_now.empty())
+        {
+            auto ordering_now(orderable_now.begin());
+            const std::set<NAGIndex> & scc(sccs.find(ordering_now->second)->second);
+
+            if (scc.size() == 1 && scc.begin()->role() == nir_fetched)
+                pending_fetches.insert(ordering_now->second);
+            else
+            {
+                for (const auto & e : all_scc_edges[ordering_now->second])
+                    if (pending_fetches.erase(e))
+                    {
+                        const std::set<NAGIndex> & fetch(sccs.find(e)->second);
+                        result.push_back(std::vector<NAGIndex>(fetch.begin(), fetch.end()));
+                    }
+
+                result.push_back(std::vector<NAGIndex>(scc.begin(), scc.end()));
+            }
+
+            for (const auto & e : scc_edges_backwards[ordering_now->second])
+            {
+                auto & reverse_edges(scc_edges.find(e)->second);
+                reverse_edges.erase(ordering_now->second);
+                if (reverse_edges.empty())
+                    orderable_now.insert(order_score(e));
+            }
+
+            orderable_now.erase(ordering_now);
+        }
+
+        if (! pending_fetches.empty())
+            throw InternalError(PALUDIS_HERE, "still have pending fetches");
+
+        return result;
+    }
+
+    Ordering compact_order(const CompactNAG & nag, const std::function<Tribool (const NAGIndex &)> & order_early_fn)
+    {
+        Ordering result;
+        for (const auto & component : nag.sorted_strongly_connected_components(order_early_fn))
+        {
+            result.push_back(std::vector<NAGIndex>());
+            for (const auto & n : component)
+                result.back().push_back(nag.node(n));
+        }
+        return result;
+    }
+
+    /* either ordering, or an empty one if we can't order, which happens
+     * when a fetch is left with nothing after it to go before */
+    Ordering or_nothing(const std::function<Ordering ()> & f)
+    {
+        try
+        {
+            return f();
+        }
+        catch (const InternalError &)
+        {
+            return Ordering();
+        }
+    }
+
+    Tribool no_preference(const NAGIndex &)
+    {
+        return indeterminate;
+    }
+
+    /* the same filter that _order_sub_ssccs uses to drop met dependencies */
+    bool without_met_deps(NAGEdgeProperties & p)
+    {
+        if (p.build_all_met() && p.run_all_met())
+            return false;
+
+        p.build() = p.build() && ! p.build_all_met();
+        p.run() = p.run() && ! p.run_all_met();
+        return true;
+    }
+
+    /* a tangle of fetched and done nodes, with a three node cycle, a two
+     * node cycle, a self loop and edges of every kind between them */
+    Graph make_tangle()
+    {
+        const NAGEdgeProperties build(make_properties(true, false, false, false)),
+              met_build(make_properties(true, true, false, false)),
+              run(make_properties(false, false, true, false)),
+              met_run(make_properties(false, false, true, true)),
+              met_both(make_properties(true, true, true, true));
+
+        Graph graph;
+        for (const auto & p : { "a", "b", "c", "d", "e", "f", "g", "h" })
+        {
+            graph.nodes.insert(make_index(p, nir_fetched));
+            graph.nodes.insert(make_index(p, nir_done));
+            graph.add_edge(make_index(p, nir_done), make_index(p, nir_fetched), build);
+        }
+
+        graph.add_edge(make_index("a", nir_done), make_index("b", nir_done), build);
+        graph.add_edge(make_index("b", nir_done), make_index("c", nir_done), met_run);
+        graph.add_edge(make_index("c", nir_done), make_index("a", nir_done), met_both);
+
+        graph.add_edge(make_index("d", nir_done), make_index("e", nir_done), run);
+        graph.add_edge(make_index("e", nir_done), make_index("d", nir_done), met_build);
+
+        graph.add_edge(make_index("f", nir_done), make_index("f", nir_done), met_both);
+
+        graph.add_edge(make_index("g", nir_done), make_index("a", nir_done), build);
+        graph.add_edge(make_index("g", nir_done), make_index("d", nir_done), run);
+        graph.add_edge(make_index("h", nir_done), make_index("g", nir_done), met_run);
+        graph.add_edge(make_index("h", nir_done), make_index("f", nir_done), build);
+        graph.add_edge(make_index("e", nir_done), make_index("a", nir_fetched), build);
+
+        return graph;
+    }
+}
+
+TEST(CompactNAG, SelfLoop)
+{
+    Graph graph;
+    graph.add_edge(make_index("a", nir_done), make_index("a", nir_done), make_properties(true, false, false, false));
+    graph.add_edge(make_index("a", nir_done), make_index("b", nir_done), make_properties(true, false, false, false));
+    graph.add_edge(make_index("b", nir_done), make_index("b", nir_fetched), make_properties(true, false, false, false));
+    graph.add_edge(make_index("b", nir_fetched), make_index("b", nir_fetched), make_properties(true, false, false, false));
+
+    NAG nag;
+    graph.fill(nag);
+    CompactNAG compact(nag);
+
+    Ordering ordering(compact_order(compact, no_preference));
+    ASSERT_EQ(3u, ordering.size());
+    for (const auto & c : ordering)
+        EXPECT_EQ(1u, c.size());
+    EXPECT_EQ(make_index("b", nir_fetched), ordering[0].front());
+    EXPECT_EQ(make_index("b", nir_done), ordering[1].front());
+    EXPECT_EQ(make_index("a", nir_done), ordering[2].front());
+    EXPECT_EQ(reference_order(graph, no_preference), ordering);
+}
+
+TEST(CompactNAG, MultiNodeSCCs)
+{
+    Graph graph(make_tangle());
+    NAG nag;
+    graph.fill(nag);
+    CompactNAG compact(nag);
+
+    Ordering ordering(compact_order(compact, no_preference));
+    EXPECT_EQ(reference_order(graph, no_preference), ordering);
+
+    auto component_of([&] (const NAGIndex & n) {
+            return std::find_if(ordering.begin(), ordering.end(), [&] (const std::vector<NAGIndex> & c) {
+                    return c.end() != std::find(c.begin(), c.end(), n);
+                    });
+            });
+
+    EXPECT_EQ(3u, component_of(make_index("a", nir_done))->size());
+    EXPECT_EQ(component_of(make_index("a", nir_done)), component_of(make_index("c", nir_done)));
+    EXPECT_EQ(2u, component_of(make_index("d", nir_done))->size());
+    EXPECT_EQ(1u, component_of(make_index("f", nir_done))->size());
+    EXPECT_LT(component_of(make_index("a", nir_done)), component_of(make_index("g", nir_done)));
+    EXPECT_LT(component_of(make_index("g", nir_done)), component_of(make_index("h", nir_done)));
+
+    auto order_early([] (const NAGIndex & n) -> Tribool {
+            if (n.resolvent().package().package() == PackageNamePart("f"))
+                return true;
+            else if (n.resolvent().package().package() == PackageNamePart("d"))
+                return false;
+            else
+                return indeterminate;
+            });
+    EXPECT_EQ(reference_order(graph, order_early), compact_order(compact, order_early));
+}
+
+TEST(CompactNAG, Subset)
+{
+    Graph graph(make_tangle());
+    NAG nag;
+    graph.fill(nag);
+    CompactNAG compact(nag);
+
+    /* take each component with more than one node, and order it again
+     * without its met dependencies, as _order_sub_ssccs does */
+    int multi_node_components(0);
+    for (const auto & component : compact.sorted_strongly_connected_components(no_preference))
+    {
+        if (component.size() < 2)
+            continue;
+        ++multi_node_components;
+
+        CompactNAG sub(compact, component, without_met_deps);
+        ASSERT_EQ(int(component.size()), sub.size());
+        for (int n(0) ; n != sub.size() ; ++n)
+            EXPECT_EQ(sub.node(n), compact.node(sub.original(n)));
+
+        std::set<NAGIndex> keep;
+        for (const auto & n : component)
+            keep.insert(compact.node(n));
+        Graph sub_graph(graph.subset(keep, without_met_deps));
+
+        Ordering ordering(compact_order(sub, no_preference));
+        EXPECT_EQ(reference_order(sub_graph, no_preference), ordering);
+
+        /* and again, to check that original() survives being taken twice */
+        std::vector<int> all;
+        for (int n(0) ; n != sub.size() ; ++n)
+            all.push_back(n);
+        CompactNAG sub_sub(sub, all, [] (NAGEdgeProperties &) { return true; });
+        for (int n(0) ; n != sub_sub.size() ; ++n)
+            EXPECT_EQ(sub_sub.node(n), compact.node(sub_sub.original(n)));
+        EXPECT_EQ(ordering, compact_order(sub_sub, no_preference));
+    }
+
+    EXPECT_EQ(2, multi_node_components);
+}
+
+TEST(CompactNAG, SubsetDropsEdges)
+{
+    Graph graph(make_tangle());
+    NAG nag;
+    graph.fill(nag);
+    CompactNAG compact(nag);
+
+    /* a --build--> b --met run--> c --met both--> a: the edge back to a is
+     * dropped entirely, so the three nodes get ordered c, b, a */
+    const std::set<std::string> names{ "a", "b", "c" };
+    std::vector<int> abc;
+    for (int n(0) ; n != compact.size() ; ++n)
+        if (compact.node(n).role() == nir_done && names.count(stringify(compact.node(n).resolvent().package().package())))
+            abc.push_back(n);
+    ASSERT_EQ(3u, abc.size());
+
+    CompactNAG sub(compact, abc, without_met_deps);
+    Ordering ordering(compact_order(sub, no_preference));
+    ASSERT_EQ(3u, ordering.size());
+    EXPECT_EQ(make_index("c", nir_done), ordering[0].front());
+    EXPECT_EQ(make_index("b", nir_done), ordering[1].front());
+    EXPECT_EQ(make_index("a", nir_done), ordering[2].front());
+
+    std::set<NAGIndex> keep;
+    for (const auto & n : abc)
+        keep.insert(compact.node(n));
+    EXPECT_EQ(reference_order(graph.subset(keep, without_met_deps), no_preference), ordering);
+
+    for (int n(0) ; n != sub.size() ; ++n)
+        for (const CompactNAGEdge * e(sub.begin_edges_from(n)), * e_end(sub.end_edges_from(n)) ; e != e_end ; ++e)
+            EXPECT_FALSE(e->properties().run() && e->properties().run_all_met());
+}
+
+TEST(CompactNAG, Random)
+{
+    /* a fixed sequence, so that any failure can be reproduced */
+    unsigned seed(12345);
+    auto next([&] (const unsigned limit) {
+            seed = seed * 1103515245 + 12345;
+            return (seed / 65536) % limit;
+            });
+
+    for (int round(0) ; round != 50 ; ++round)
+    {
+        Graph graph;
+        const unsigned size(2 + next(20));
+        for (unsigned n(0) ; n != size ; ++n)
+        {
+            graph.nodes.insert(make_index("p" + stringify(n), nir_fetched));
+            graph.nodes.insert(make_index("p" + stringify(n), nir_done));
+            graph.add_edge(make_index("p" + stringify(n), nir_done), make_index("p" + stringify(n), nir_fetched),
+                    make_properties(true, false, false, false));
+        }
+
+        const unsigned edges(next(size * 3));
+        for (unsigned e(0) ; e != edges ; ++e)
+            graph.add_edge(
+                    make_index("p" + stringify(next(size)), next(4) ? nir_done : nir_fetched),
+                    make_index("p" + stringify(next(size)), nir_done),
+                    make_properties(next(2), next(2), next(2), next(2)));
+
+        NAG nag;
+        graph.fill(nag);
+        CompactNAG compact(nag);
+        EXPECT_EQ(reference_order(graph, no_preference), compact_order(compact, no_preference));
+
+        for (const auto & component : compact.sorted_strongly_connected_components(no_preference))
+        {
+            std::set<NAGIndex> keep;
+            for (const auto & n : component)
+                keep.insert(compact.node(n));
+
+            CompactNAG sub(compact, component, without_met_deps);
+            const Graph sub_graph(graph.subset(keep, without_met_deps));
+            EXPECT_EQ(or_nothing([&] () { return reference_order(sub_graph, no_preference); }),
+                    or_nothing([&] () { return compact_order(sub, no_preference); }));
+        }
+    }
+}
+
+TEST(CompactNAG, LongChain)
+{
+    const int length(100000);
+
+    NAG nag;
+    std::vector<NAGIndex> indices;
+    indices.reserve(length);
+    for (int n(0) ; n != length ; ++n)
+    {
+        indices.push_back(make_index("p" + stringify(n), nir_done));
+        nag.add_node(indices.back());
+    }
+    for (int n(0) ; n != length - 1 ; ++n)
+        nag.add_edge(indices[n], indices[n + 1], make_properties(true, false, false, false));
+
+    {
+        CompactNAG compact(nag);
+        Ordering ordering(compact_order(compact, no_preference));
+        ASSERT_EQ(std::size_t(length), ordering.size());
+        for (int n(0) ; n != length ; ++n)
+        {
+            ASSERT_EQ(1u, ordering[n].size());
+            EXPECT_EQ(indices[length - 1 - n], ordering[n].front());
+        }
+    }
+
+    /* closing the loop makes the whole chain one component */
+    nag.add_edge(indices[length - 1], indices[0], make_properties(false, false, true, false));
+
+    CompactNAG compact(nag);
+    CompactNAG::Components components(compact.sorted_strongly_connected_components(no_preference));
+    ASSERT_EQ(1u, components.size());
+    ASSERT_EQ(std::size_t(length), components[0].size());
+
+    /* taking all of it, without the closing run edge, gives the chain back */
+    CompactNAG sub(compact, components[0], [] (NAGEdgeProperties & p) { return p.build(); });
+    ASSERT_EQ(length, sub.size());
+    CompactNAG::Components sub_components(sub.sorted_strongly_connected_components(no_preference));
+    ASSERT_EQ(std::size_t(length), sub_components.size());
+    EXPECT_EQ(indices[length - 1], sub.node(sub_components.front().front()));
+    EXPECT_EQ(indices[0], sub.node(sub_components.back().front()));
+}
@@ -53,6 +53,12 @@
 #include <paludis/util/tribool.hh>
 #include <paludis/util/log.hh>
 #include <paludis/util/visitor_cast.hh>
+#include <paludis/util/hashes.hh>
+#include <paludis/util/thread_pool.hh>
+#include <paludis/util/save.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/env_var_names.hh>
 #include <paludis/environment.hh>
 #include <paludis/notifier_callback.hh>
 #include <paludis/repository.hh>
@@ -75,15 +81,140 @@
 #include <paludis/slot.hh>
 
 #include <paludis/util/pimp-impl.hh>
+#include <paludis/util/profiler.hh>
 
 #include <list>
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <map>
+#include <mutex>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace paludis;
 using namespace paludis::resolver;
 
+namespace
+{
+    unsigned resolver_jobs()
+    {
+        Context context("When working out how many resolver jobs to use:");
+
+        try
+        {
+            unsigned jobs(destringify<unsigned>(getenv_with_default(env_vars::resolver_jobs, "1")));
+            return 0 == jobs ? 1 : jobs;
+        }
+        catch (const DestringifyError & e)
+        {
+            Log::get_instance()->message("resolver.decider.bad_jobs", ll_warning, lc_context)
+                << "Ignoring bad value for " << env_vars::resolver_jobs << ": '" << e.message() << "'";
+            return 1;
+        }
+    }
+
+    /* Threads that live for a whole resolve, so that each batch of
+     * prefetches or candidate checks doesn't start its own. The thread
+     * calling run() works through its own batch too, so a batch always
+     * finishes even if every worker is busy with another one. */
+    class DeciderWorkers
+    {
+        private:
+            struct Batch
+            {
+                const std::function<void (std::size_t)> * job;
+                std::size_t count;
+                std::size_t next;
+                std::size_t finished;
+            };
+
+            std::mutex _mutex;
+            std::condition_variable _work_condition;
+            std::condition_variable _finished_condition;
+            std::list<Batch *> _batches;
+            bool _stopping;
+
+            ThreadPool _pool;
+
+            void _work()
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (true)
+                {
+                    Batch * batch(nullptr);
+                    _work_condition.wait(lock, [&] () {
+                            if (_stopping)
+                                return true;
+                            for (auto & b : _batches)
+                                if (b->next < b->count)
+                                {
+                                    batch = b;
+                                    return true;
+                                }
+                            return false;
+                            });
+
+                    if (_stopping)
+                        return;
+
+                    std::size_t n(batch->next++);
+                    lock.unlock();
+                    (*batch->job)(n);
+                    lock.lock();
+
+                    if (++batch->finished == batch->count)
+                        _finished_condition.notify_all();
+                }
+            }
+
+        public:
+            explicit DeciderWorkers(const unsigned threads) :
+                _stopping(false)
+            {
+                for (unsigned n(0) ; n != threads ; ++n)
+                    _pool.create_thread([this] () noexcept { _work(); });
+            }
+
+            ~DeciderWorkers()
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _stopping = true;
+                }
+                _work_condition.notify_all();
+            }
+
+            DeciderWorkers(const DeciderWorkers &) = delete;
+            DeciderWorkers & operator= (const DeciderWorkers &) = delete;
+
+            /* job must not throw */
+            void run(const std::size_t count, const std::function<void (std::size_t)> & job)
+            {
+                Batch batch{ &job, count, 0, 0 };
+
+                std::unique_lock<std::mutex> lock(_mutex);
+                _batches.push_back(&batch);
+                _work_condition.notify_all();
+
+                while (batch.next < batch.count)
+                {
+                    std::size_t n(batch.next++);
+                    lock.unlock();
+                    job(n);
+                    lock.lock();
+                    ++batch.finished;
+                }
+
+                _finished_condition.wait(lock, [&] () { return batch.finished == batch.count; });
+                _batches.remove(&batch);
+            }
+    };
+}
+
 namespace paludis
 {
     template <>
@@ -94,13 +225,35 @@ namespace paludis
 
         const std::shared_ptr<ResolutionsByResolvent> resolutions_by_resolvent;
 
+        /* once we start looking at vias, dependents or purges, constraints
+         * can come from the state of every resolution at once, so we can no
+         * longer tell which ones a restart affects. */
+        bool can_undo_for_restart;
+
+        /* how many candidates to check, and resolutions to prefetch, at
+         * once, and the threads to do it with whilst resolving. */
+        const unsigned jobs;
+        DeciderWorkers * workers;
+
         Imp(const Environment * const e, const ResolverFunctions & f,
                 const std::shared_ptr<ResolutionsByResolvent> & l) :
             env(e),
             fns(f),
-            resolutions_by_resolvent(l)
+            resolutions_by_resolvent(l),
+            can_undo_for_restart(true),
+            jobs(resolver_jobs()),
+            workers(nullptr)
         {
         }
+
+        void run_jobs(const std::size_t count, const std::function<void (std::size_t)> & job) const
+        {
+            if (workers)
+                workers->run(count, job);
+            else
+                for (std::size_t n(0) ; n != count ; ++n)
+                    job(n);
+        }
     };
 }
 
@@ -116,9 +269,11 @@ void
 Decider::_resolve_decide_with_dependencies()
 {
     Context context("When resolving and adding dependencies recursively:");
+    ProfileScope profile_scope("Decider::_resolve_decide_with_dependencies", "resolver");
 
     enum State { deciding_non_suggestions, deciding_nothings, deciding_suggestions, finished } state = deciding_non_suggestions;
     bool changed(true);
+    std::unordered_set<Resolvent, Hash<Resolvent> > prefetched;
     while (true)
     {
         if (! changed)
@@ -126,23 +281,45 @@ Decider::_resolve_decide_with_dependencies()
         if (state == finished)
             break;
 
+        auto want_to_decide([&] (const std::shared_ptr<const Resolution> & resolution) -> bool {
+                /* we've already decided */
+                if (resolution->decision())
+                    return false;
+
+                /* we're only being suggested. don't do this on the first pass, so
+                 * we don't have to do restarts for suggestions later becoming hard
+                 * deps. */
+                if (state < deciding_suggestions && resolution->constraints()->all_untaken())
+                    return false;
+
+                /* avoid deciding nothings until after we've decided things we've
+                 * taken, so adding extra destinations doesn't get messy. */
+                if (state < deciding_nothings && resolution->constraints()->nothing_is_fine_too())
+                    return false;
+
+                return true;
+                });
+
         changed = false;
-        for (const auto & resolution : *_imp->resolutions_by_resolvent)
+        for (ResolutionsByResolvent::ConstIterator r(_imp->resolutions_by_resolvent->begin()), r_end(_imp->resolutions_by_resolvent->end()) ;
+                r != r_end ; ++r)
         {
-            /* we've already decided */
-            if (resolution->decision())
+            const std::shared_ptr<Resolution> resolution(*r);
+            if (! want_to_decide(resolution))
                 continue;
 
-            /* we're only being suggested. don't do this on the first pass, so
-             * we don't have to do restarts for suggestions later becoming hard
-             * deps. */
-            if (state < deciding_suggestions && resolution->constraints()->all_untaken())
-                continue;
-
-            /* avoid deciding nothings until after we've decided things we've
-             * taken, so adding extra destinations doesn't get messy. */
-            if (state < deciding_nothings && resolution->constraints()->nothing_is_fine_too())
-                continue;
+            /* deciding and adding dependencies has to happen in order, since
+             * each can change the constraints on later resolutions. what we
+             * can do is load the metadata that the next few will need at
+             * once. */
+            if (_imp->jobs > 1 && prefetched.insert(resolution->resolvent()).second)
+            {
+                std::vector<std::shared_ptr<const Resolution> > batch{ resolution };
+                for (ResolutionsByResolvent::ConstIterator n(std::next(r)) ; n != r_end && batch.size() < _imp->jobs * 4 ; ++n)
+                    if (want_to_decide(*n) && prefetched.insert((*n)->resolvent()).second)
+                        batch.push_back(*n);
+                _prefetch_for_deciding(batch);
+            }
 
             _imp->env->trigger_notifier_callback(NotifierCallbackResolverStepEvent());
 
@@ -154,10 +331,61 @@ Decider::_resolve_decide_with_dependencies()
     }
 }
 
+void
+Decider::_prefetch_for_deciding(const std::vector<std::shared_ptr<const Resolution> > & resolutions) const
+{
+    ProfileScope profile_scope("Decider::_prefetch_for_deciding", "resolver", [&] () { return stringify(resolutions.size()); });
+
+    _imp->run_jobs(resolutions.size(), [&] (std::size_t i) {
+            /* anything that goes wrong here will go wrong again when we
+             * decide for real, with a better context */
+            try
+            {
+                _prefetch_one_for_deciding(resolutions[i]);
+            }
+            catch (...)
+            {
+            }
+            });
+}
+
+void
+Decider::_prefetch_one_for_deciding(const std::shared_ptr<const Resolution> & resolution) const
+{
+    Context context("When prefetching for '" + stringify(resolution->resolvent()) + "':");
+
+    const std::shared_ptr<const PackageIDSequence> installed_ids(_installed_ids(resolution));
+
+    const std::shared_ptr<const PackageIDSequence> ids(_find_installable_id_candidates_for(
+                resolution->resolvent().package(),
+                make_slot_filter(resolution->resolvent()),
+                make_destination_type_filter(resolution->resolvent().destination_type()),
+                false, false));
+    if (ids->empty())
+        return;
+
+    const std::shared_ptr<const PackageID> best(*ids->rbegin());
+    if (best->choices_key())
+        auto choices(best->choices_key()->parse_value());
+
+    if (best->dependencies_key())
+        auto dependencies(best->dependencies_key()->parse_value());
+    else
+    {
+        if (best->build_dependencies_key())
+            auto build_dependencies(best->build_dependencies_key()->parse_value());
+        if (best->run_dependencies_key())
+            auto run_dependencies(best->run_dependencies_key()->parse_value());
+        if (best->post_dependencies_key())
+            auto post_dependencies(best->post_dependencies_key()->parse_value());
+    }
+}
+
 bool
 Decider::_resolve_vias()
 {
     Context context("When finding vias:");
+    ProfileScope profile_scope("Decider::_resolve_vias", "resolver");
 
     bool changed(false);
 
@@ -202,6 +430,7 @@ bool
 Decider::_resolve_dependents()
 {
     Context context("When finding dependents:");
+    ProfileScope profile_scope("Decider::_resolve_dependents", "resolver");
 
     bool changed(false);
     const std::pair<
@@ -375,6 +604,7 @@ void
 Decider::_resolve_confirmations()
 {
     Context context("When resolving confirmations:");
+    ProfileScope profile_scope("Decider::_resolve_confirmations", "resolver");
 
     for (const auto & resolution : *_imp->resolutions_by_resolvent)
         _confirm(resolution);
@@ -1718,101 +1948,133 @@ Decider::_find_installable_id_for(const std::shared_ptr<const Resolution> & reso
             include_option_changes, false);
 }
 
-const Decider::FoundID
-Decider::_find_id_for_from(
+const std::shared_ptr<WhyChangedChoices>
+Decider::_check_candidate(
         const std::shared_ptr<const Resolution> & resolution,
-        const std::shared_ptr<const PackageIDSequence> & ids,
-        const bool try_changing_choices,
+        const std::shared_ptr<const PackageID> & id,
         const bool trying_changing_choices) const
 {
     MatchPackageOptions opts;
     if (trying_changing_choices)
         opts += mpo_ignore_additional_requirements;
 
-    std::shared_ptr<const PackageID> best_version;
-    for (PackageIDSequence::ReverseConstIterator i(ids->rbegin()), i_end(ids->rend()) ;
-            i != i_end ; ++i)
+    bool ok(true);
+    for (const auto & constraint : *resolution->constraints())
     {
-        if (! best_version)
-            best_version = *i;
+        if (constraint->spec().if_package())
+            ok = ok && match_package(*_imp->env, *constraint->spec().if_package(), id, constraint->from_id(), opts);
+        else
+            ok = ok && ! match_package(*_imp->env, constraint->spec().if_block()->blocking(), id, constraint->from_id(), opts);
 
-        bool ok(true);
+        if (! ok)
+            return nullptr;
+    }
+
+    auto why_changed_choices(std::make_shared<WhyChangedChoices>(WhyChangedChoices(make_named_values<WhyChangedChoices>(
+                        n::changed_choices() = std::make_shared<ChangedChoices>(),
+                        n::reasons() = std::make_shared<Reasons>()
+                        ))));
+    if (trying_changing_choices)
+    {
         for (const auto & constraint : *resolution->constraints())
         {
-            if (constraint->spec().if_package())
-                ok = ok && match_package(*_imp->env, *constraint->spec().if_package(), *i, constraint->from_id(), opts);
-            else
-                ok = ok && ! match_package(*_imp->env, constraint->spec().if_block()->blocking(), *i, constraint->from_id(), opts);
-
             if (! ok)
                 break;
-        }
 
-        if (ok)
-        {
-            auto why_changed_choices(std::make_shared<WhyChangedChoices>(WhyChangedChoices(make_named_values<WhyChangedChoices>(
-                                n::changed_choices() = std::make_shared<ChangedChoices>(),
-                                n::reasons() = std::make_shared<Reasons>()
-                                ))));
-            if (trying_changing_choices)
+            if (! constraint->spec().if_package())
             {
-                for (const auto & constraint : *resolution->constraints())
+                if (constraint->spec().if_block()->blocking().additional_requirements_ptr() &&
+                        ! constraint->spec().if_block()->blocking().additional_requirements_ptr()->empty())
                 {
-                    if (! ok)
-                        break;
+                    /* too complicated for now */
+                    ok = false;
+                }
+                break;
+            }
 
-                    if (! constraint->spec().if_package())
-                    {
-                        if (constraint->spec().if_block()->blocking().additional_requirements_ptr() &&
-                                ! constraint->spec().if_block()->blocking().additional_requirements_ptr()->empty())
-                        {
-                            /* too complicated for now */
-                            ok = false;
-                        }
-                        break;
-                    }
+            if (! constraint->spec().if_package()->additional_requirements_ptr())
+            {
+                /* no additional requirements, so no tinkering required */
+                continue;
+            }
 
-                    if (! constraint->spec().if_package()->additional_requirements_ptr())
+            for (const auto & requirement : *constraint->spec().if_package()->additional_requirements_ptr())
+            {
+                auto b(requirement->accumulate_changes_to_make_met(_imp->env,
+                            get_changed_choices_for(constraint).get(), id, constraint->from_id(),
+                            *why_changed_choices->changed_choices()));
+                if (b.is_false())
+                {
+                    ok = false;
+                    break;
+                }
+                else if (b.is_true())
+                    why_changed_choices->reasons()->push_back(constraint->reason());
+            }
+        }
+    }
+
+    /* might have an early requirement of [x], and a later [-x], and
+     * chosen to change because of the latter */
+    for (const auto & constraint : *resolution->constraints())
+    {
+        if (! ok)
+            break;
+
+        if (constraint->spec().if_package())
+            ok = ok && match_package_with_maybe_changes(*_imp->env, *constraint->spec().if_package(),
+                    get_changed_choices_for(constraint).get(), id, constraint->from_id(), why_changed_choices->changed_choices().get(), { });
+        else
+            ok = ok && ! match_package_with_maybe_changes(*_imp->env, constraint->spec().if_block()->blocking(),
+                    get_changed_choices_for(constraint).get(), id, constraint->from_id(), why_changed_choices->changed_choices().get(), { });
+    }
+
+    return ok ? why_changed_choices : nullptr;
+}
+
+const Decider::FoundID
+Decider::_find_id_for_from(
+        const std::shared_ptr<const Resolution> & resolution,
+        const std::shared_ptr<const PackageIDSequence> & ids,
+        const bool try_changing_choices,
+        const bool trying_changing_choices) const
+{
+    std::vector<std::shared_ptr<const PackageID> > candidates(ids->rbegin(), ids->rend());
+
+    /* candidates are checked best first, and the first suitable one wins. if
+     * we're allowed more than one job, check a few at once and then look at
+     * the results in the same order, so we pick what we'd have picked
+     * anyway. */
+    const unsigned jobs(candidates.size() > 1 ? std::min<std::size_t>(_imp->jobs, candidates.size()) : 1);
+    for (std::size_t window(0) ; window < candidates.size() ; window += jobs)
+    {
+        const std::size_t window_end(std::min(window + jobs, candidates.size()));
+        std::vector<std::shared_ptr<WhyChangedChoices> > results(window_end - window);
+        std::vector<std::exception_ptr> exceptions(window_end - window);
+
+        if (1 == jobs)
+            results[0] = _check_candidate(resolution, candidates[window], trying_changing_choices);
+        else
+            _imp->run_jobs(window_end - window, [&] (std::size_t c) {
+                    try
                     {
-                        /* no additional requirements, so no tinkering required */
-                        continue;
+                        results[c] = _check_candidate(resolution, candidates[window + c], trying_changing_choices);
                     }
-
-                    for (const auto & requirement : *constraint->spec().if_package()->additional_requirements_ptr())
+                    catch (...)
                     {
-                        auto b(requirement->accumulate_changes_to_make_met(_imp->env,
-                                    get_changed_choices_for(constraint).get(), *i, constraint->from_id(),
-                                    *why_changed_choices->changed_choices()));
-                        if (b.is_false())
-                        {
-                            ok = false;
-                            break;
-                        }
-                        else if (b.is_true())
-                            why_changed_choices->reasons()->push_back(constraint->reason());
+                        exceptions[c] = std::current_exception();
                     }
-                }
-            }
-
-            /* might have an early requirement of [x], and a later [-x], and
-             * chosen to change because of the latter */
-            for (const auto & constraint : *resolution->constraints())
-            {
-                if (! ok)
-                    break;
+                    });
 
-                if (constraint->spec().if_package())
-                    ok = ok && match_package_with_maybe_changes(*_imp->env, *constraint->spec().if_package(),
-                            get_changed_choices_for(constraint).get(), *i, constraint->from_id(), why_changed_choices->changed_choices().get(), { });
-                else
-                    ok = ok && ! match_package_with_maybe_changes(*_imp->env, constraint->spec().if_block()->blocking(),
-                            get_changed_choices_for(constraint).get(), *i, constraint->from_id(), why_changed_choices->changed_choices().get(), { });
-            }
+        for (std::size_t c(window) ; c != window_end ; ++c)
+        {
+            if (exceptions[c - window])
+                std::rethrow_exception(exceptions[c - window]);
 
-            if (ok)
-                return FoundID(*i,
-                        why_changed_choices->changed_choices()->empty() ? nullptr : why_changed_choices,
-                        (*i)->version() == best_version->version());
+            if (results[c - window])
+                return FoundID(candidates[c],
+                        results[c - window]->changed_choices()->empty() ? nullptr : results[c - window],
+                        candidates[c]->version() == candidates[0]->version());
         }
     }
 
@@ -1899,6 +2161,8 @@ Decider::purge()
 {
     Context context("When purging everything:");
 
+    _imp->can_undo_for_restart = false;
+
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Collecting Unused"));
 
     const std::shared_ptr<const PackageIDSet> have_now(collect_installed(_imp->env));
@@ -1945,11 +2209,19 @@ Decider::purge()
 void
 Decider::resolve()
 {
+    ProfileScope profile_scope("Decider::resolve", "resolver");
+
+    /* we help out with our own batches, so one fewer thread will do */
+    std::unique_ptr<DeciderWorkers> workers(_imp->jobs > 1 ? new DeciderWorkers(_imp->jobs - 1) : nullptr);
+    Save<DeciderWorkers *> save_workers(&_imp->workers, workers.get());
+
     while (true)
     {
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Deciding"));
         _resolve_decide_with_dependencies();
 
+        _imp->can_undo_for_restart = false;
+
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Vialating"));
         if (_resolve_vias())
             continue;
@@ -1969,6 +2241,141 @@ Decider::resolve()
     _resolve_confirmations();
 }
 
+namespace
+{
+    struct ConstraintOriginVisitor
+    {
+        std::shared_ptr<const Resolvent> visit(const DependencyReason & r) const
+        {
+            return std::make_shared<Resolvent>(r.from_resolvent());
+        }
+
+        std::shared_ptr<const Resolvent> visit(const LikeOtherDestinationTypeReason & r) const
+        {
+            return std::make_shared<Resolvent>(r.other_resolvent());
+        }
+
+        std::shared_ptr<const Resolvent> visit(const ViaBinaryReason & r) const
+        {
+            return std::make_shared<Resolvent>(r.other_resolvent());
+        }
+
+        std::shared_ptr<const Resolvent> visit(const TargetReason &) const
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<const Resolvent> visit(const DependentReason &) const
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<const Resolvent> visit(const WasUsedByReason &) const
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<const Resolvent> visit(const PresetReason &) const
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<const Resolvent> visit(const SetReason &) const
+        {
+            return nullptr;
+        }
+    };
+
+    std::shared_ptr<const Resolvent> constraint_origin(const Constraint & c)
+    {
+        return c.reason()->accept_returning<std::shared_ptr<const Resolvent> >(ConstraintOriginVisitor());
+    }
+}
+
+bool
+Decider::undo_for_restart(const SuggestRestart & e)
+{
+    Context context("When undoing decisions for a restart because of '" + stringify(e.resolvent()) + "':");
+    ProfileScope profile_scope("Decider::undo_for_restart", "resolver");
+
+    if (! _imp->can_undo_for_restart)
+        return false;
+
+    /* which resolutions got constraints because of which other resolutions'
+     * decisions? */
+    std::unordered_multimap<Resolvent, Resolvent, Hash<Resolvent> > constrained_by;
+    for (const auto & resolution : *_imp->resolutions_by_resolvent)
+        for (const auto & constraint : *resolution->constraints())
+        {
+            auto origin(constraint_origin(*constraint));
+            if (origin)
+                constrained_by.emplace(*origin, resolution->resolvent());
+        }
+
+    /* the decision that was wrong has to go, and so does the one whose
+     * dependencies we were part way through adding, along with anything
+     * they caused. */
+    std::unordered_set<Resolvent, Hash<Resolvent> > undo;
+    std::list<Resolvent> todo{ e.resolvent() };
+    auto problematic_origin(constraint_origin(*e.problematic_constraint()));
+    if (problematic_origin)
+        todo.push_back(*problematic_origin);
+
+    while (! todo.empty())
+    {
+        Resolvent r(todo.front());
+        todo.pop_front();
+
+        if (! undo.insert(r).second)
+            continue;
+
+        auto affected(constrained_by.equal_range(r));
+        for (auto a(affected.first) ; a != affected.second ; ++a)
+            todo.push_back(a->second);
+    }
+
+    /* anything left with only presets wouldn't have been created if we'd
+     * started again from scratch, so forget it entirely. */
+    std::list<Resolvent> unneeded;
+    for (const auto & resolution : *_imp->resolutions_by_resolvent)
+    {
+        if (undo.end() == undo.find(resolution->resolvent()))
+            continue;
+
+        auto constraints(std::make_shared<Constraints>());
+        bool needed(false);
+        for (const auto & constraint : *resolution->constraints())
+        {
+            auto origin(constraint_origin(*constraint));
+            if (origin && undo.end() != undo.find(*origin))
+                continue;
+
+            constraints->add(constraint);
+            if (! visitor_cast<const PresetReason>(*constraint->reason()))
+                needed = true;
+        }
+
+        if (needed)
+        {
+            resolution->constraints() = constraints;
+            resolution->decision() = nullptr;
+        }
+        else
+            unneeded.push_back(resolution->resolvent());
+    }
+
+    for (const auto & r : unneeded)
+        _imp->resolutions_by_resolvent->erase(r);
+
+    /* if the restarted resolution is still around, it was created before
+     * the preset was known about, so it needs adding by hand. */
+    auto restarted(_resolution_for_resolvent(e.resolvent(), indeterminate));
+    if (restarted)
+        restarted->constraints()->add(e.suggested_preset());
+
+    return true;
+}
+
 bool
 Decider::_package_dep_spec_already_met(const PackageDepSpec & spec, const std::shared_ptr<const PackageID> & from_id) const
 {
@@ -2099,6 +2506,7 @@ bool
 Decider::_resolve_purges()
 {
     Context context("When finding things to purge:");
+    ProfileScope profile_scope("Decider::_resolve_purges", "resolver");
 
     const std::pair<
         std::shared_ptr<const ChangeByResolventSequence>,
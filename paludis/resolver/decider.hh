@@ -38,6 +38,7 @@
 #include <paludis/resolver/resolutions_by_resolvent-fwd.hh>
 #include <paludis/resolver/change_by_resolvent-fwd.hh>
 #include <paludis/resolver/why_changed_choices-fwd.hh>
+#include <paludis/resolver/suggest_restart-fwd.hh>
 #include <paludis/util/attributes.hh>
 #include <paludis/util/pimp.hh>
 #include <paludis/util/tribool-fwd.hh>
@@ -49,6 +50,7 @@
 #include <paludis/changed_choices-fwd.hh>
 #include <paludis/name-fwd.hh>
 #include <tuple>
+#include <vector>
 
 namespace paludis
 {
@@ -133,6 +135,8 @@ namespace paludis
                         const std::shared_ptr<const ChangedChoices> &) const;
 
                 void _resolve_decide_with_dependencies();
+                void _prefetch_for_deciding(const std::vector<std::shared_ptr<const Resolution> > &) const;
+                void _prefetch_one_for_deciding(const std::shared_ptr<const Resolution> &) const;
                 bool _resolve_vias() PALUDIS_ATTRIBUTE((warn_unused_result));
                 bool _resolve_dependents() PALUDIS_ATTRIBUTE((warn_unused_result));
                 bool _resolve_purges() PALUDIS_ATTRIBUTE((warn_unused_result));
@@ -185,6 +189,11 @@ namespace paludis
                         const bool include_option_changes,
                         const bool include_unmaskable) const;
 
+                const std::shared_ptr<WhyChangedChoices> _check_candidate(
+                        const std::shared_ptr<const Resolution> &,
+                        const std::shared_ptr<const PackageID> &,
+                        const bool trying_changing_choices) const;
+
                 const FoundID _find_id_for_from(
                         const std::shared_ptr<const Resolution> &,
                         const std::shared_ptr<const PackageIDSequence> &,
@@ -243,6 +252,19 @@ namespace paludis
 
                 void purge();
 
+                /**
+                 * Undo only those decisions that a SuggestRestart affects,
+                 * keeping everything else, so that resolve can be called
+                 * again with the suggested preset in place.
+                 *
+                 * Returns false, without changing anything, if the restart
+                 * happened somewhere that we can't undo selectively, in
+                 * which case a new Decider must be used.
+                 *
+                 * \since 3.0
+                 */
+                bool undo_for_restart(const SuggestRestart &);
+
                 std::pair<AnyChildScore, OperatorScore> find_any_score(
                         const std::shared_ptr<const Resolution> &,
                         const std::shared_ptr<const PackageID> &,
@@ -23,6 +23,7 @@
 #include <paludis/util/make_shared_copy.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/profiler.hh>
 #include <paludis/package_id.hh>
 #include <paludis/partially_made_package_dep_spec.hh>
 #include <paludis/elike_slot_requirement.hh>
@@ -72,6 +73,7 @@ FindReplacingHelper::operator()(const std::shared_ptr<const PackageID> & id,
                                 const std::shared_ptr<const Repository> & repo) const
 {
     Context context("When working out what is replaced by '" + stringify(*id) + "' when it is installed to '" + stringify(repo->name()) + "':");
+    ProfileScope profile_scope("FindReplacingHelper", "resolver.helper", [&] { return stringify(repo->name()); });
 
     std::set<RepositoryName> repos;
 
@@ -26,6 +26,7 @@
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/exception.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/profiler.hh>
 #include <paludis/dep_spec.hh>
 #include <paludis/package_id.hh>
 #include <paludis/metadata_key.hh>
@@ -73,6 +74,8 @@ FindRepositoryForHelper::operator() (
         const std::shared_ptr<const Resolution> & resolution,
         const ChangesToMakeDecision & decision) const
 {
+    ProfileScope profile_scope("FindRepositoryForHelper", "resolver.helper");
+
     std::shared_ptr<const Repository> result;
 
     for (const auto & repository : _imp->env->repositories())
@@ -28,6 +28,7 @@
 #include <paludis/util/make_shared_copy.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/profiler.hh>
 #include <paludis/dep_spec.hh>
 #include <paludis/package_id.hh>
 #include <paludis/package_dep_spec_collection.hh>
@@ -71,6 +72,7 @@ GetConstraintsForDependentHelper::operator()(const std::shared_ptr<const Resolut
                                              const std::shared_ptr<const PackageID> & id,
                                              const std::shared_ptr<const DependentPackageIDSequence> & dependent_upon_ids) const
 {
+    ProfileScope profile_scope("GetConstraintsForDependentHelper", "resolver.helper", [&] { return stringify(*id); });
     auto result(std::make_shared<ConstraintSequence>());
 
     std::shared_ptr<PackageDepSpec> spec;
@@ -138,7 +138,13 @@ GetInitialConstraintsForHelper::operator() (const Resolvent & resolvent) const
     auto i(_imp->initial_constraints.find(resolvent));
     if (i == _imp->initial_constraints.end())
         return _make_initial_constraints_for(resolvent);
-    return i->second;
+
+    /* the resolution will add to its constraints, and those additions
+     * mustn't leak into resolutions made after a restart. */
+    auto result(std::make_shared<Constraints>());
+    for (const auto & c : *i->second)
+        result->add(c);
+    return result;
 }
 
 namespace
@@ -32,6 +32,7 @@
 #include <paludis/util/enum_iterator.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/hashes.hh>
+#include <paludis/util/profiler.hh>
 
 #include <paludis/dep_spec.hh>
 #include <paludis/environment.hh>
@@ -290,6 +291,7 @@ GetResolventsForHelper::operator() (
         const std::shared_ptr<const Reason> & reason) const
 {
     Context context("When determining resolvents for '" + stringify(spec) + "':");
+    ProfileScope profile_scope("GetResolventsForHelper", "resolver.helper", [&] { return stringify(spec); });
 
     auto target(is_target(reason));
     auto want_installed(target ? _imp->want_installed_slots_for_targets : _imp->want_installed_slots_otherwise);
@@ -28,6 +28,7 @@
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/tribool.hh>
+#include <paludis/util/profiler.hh>
 #include <paludis/dep_spec.hh>
 #include <paludis/selection.hh>
 #include <paludis/generator.hh>
@@ -252,6 +253,7 @@ InterestInSpecHelper::operator() (const std::shared_ptr<const Resolution> & reso
                                   const SanitisedDependency & dep) const
 {
     Context context("When determining interest in '" + stringify(dep.spec()) + "':");
+    ProfileScope profile_scope("InterestInSpecHelper", "resolver.helper");
 
     CareAboutDepFnVisitor v{_imp->env, _imp->no_blockers_from_specs, _imp->no_dependencies_from_specs,
         _imp->follow_installed_build_dependencies, _imp->follow_installed_dependencies, dep};
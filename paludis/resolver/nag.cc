@@ -20,6 +20,7 @@
 #include <paludis/resolver/nag.hh>
 #include <paludis/resolver/resolvent.hh>
 #include <paludis/resolver/strongly_connected_component.hh>
+#include <paludis/resolver/compact_nag.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/hashes.hh>
 #include <paludis/util/exception.hh>
@@ -36,8 +37,6 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
-#include <list>
-#include <set>
 
 using namespace paludis;
 using namespace paludis::resolver;
@@ -47,7 +46,6 @@ using namespace paludis::resolver;
 typedef std::unordered_set<NAGIndex, Hash<NAGIndex> > Nodes;
 typedef std::unordered_map<NAGIndex, NAGEdgeProperties, Hash<NAGIndex> > NodesWithProperties;
 typedef std::unordered_map<NAGIndex, NodesWithProperties, Hash<NAGIndex> > Edges;
-typedef std::unordered_map<NAGIndex, Nodes, Hash<NAGIndex> > PlainEdges;
 
 std::size_t
 NAGIndex::hash() const
@@ -100,12 +98,6 @@ NAGIndex::deserialise(Deserialisation & d)
 
 namespace paludis
 {
-    namespace n
-    {
-        typedef Name<struct name_index> index;
-        typedef Name<struct name_lowlink> lowlink;
-    }
-
     template <>
     struct Imp<NAG>
     {
@@ -167,215 +159,26 @@ NAG::verify_edges() const
     }
 }
 
-namespace
-{
-    struct TarjanData
-    {
-        NamedValue<n::index, int> index;
-        NamedValue<n::lowlink, int> lowlink;
-    };
-
-    typedef std::unordered_map<NAGIndex, TarjanData, Hash<NAGIndex> > TarjanDataMap;
-    typedef std::list<NAGIndex> TarjanStack;
-    typedef std::unordered_map<NAGIndex, StronglyConnectedComponent, Hash<NAGIndex> > StronglyConnectedComponentsByRepresentative;
-    typedef std::unordered_map<NAGIndex, NAGIndex, Hash<NAGIndex> > RepresentativeNodes;
-
-    TarjanDataMap::iterator tarjan(const NAGIndex & node, const Edges & edges, TarjanDataMap & data, TarjanStack & stack, int & index,
-            StronglyConnectedComponentsByRepresentative & result)
-    {
-        TarjanDataMap::iterator node_data(data.insert(std::make_pair(node, make_named_values<TarjanData>(
-                            n::index() = index,
-                            n::lowlink() = index
-                            ))).first);
-        ++index;
-
-        TarjanStack::iterator top_of_stack_before_node(stack.begin());
-        stack.push_front(node);
-
-        Edges::const_iterator e(edges.find(node));
-        if (e != edges.end())
-        {
-            for (const auto & n : e->second)
-            {
-                TarjanDataMap::iterator n_data(data.find(n.first));
-                if (data.end() == n_data)
-                {
-                    n_data = tarjan(n.first, edges, data, stack, index, result);
-                    node_data->second.lowlink() = std::min(node_data->second.lowlink(), n_data->second.lowlink());
-                }
-                else if (stack.end() != std::find(stack.begin(), stack.end(), n.first))
-                    node_data->second.lowlink() = std::min(node_data->second.lowlink(), n_data->second.index());
-            }
-        }
-
-        if (node_data->second.index() == node_data->second.lowlink())
-        {
-            StronglyConnectedComponent scc(make_named_values<StronglyConnectedComponent>(
-                        n::nodes() = std::make_shared<Set<NAGIndex>>(),
-                        n::requirements() = std::make_shared<Set<NAGIndex>>()
-                        ));
-
-            std::copy(stack.begin(), top_of_stack_before_node, scc.nodes()->inserter());
-            stack.erase(stack.begin(), top_of_stack_before_node);
-
-            if (scc.nodes()->empty())
-                throw InternalError(PALUDIS_HERE, "empty scc");
-            result.insert(std::make_pair(*scc.nodes()->begin(), scc));
-        }
-
-        return node_data;
-    }
-
-    int order_score_one(const NAGIndex & n, const std::function<Tribool (const NAGIndex &)> & order_early_fn)
-    {
-        /* lower scores are 'better' and mean 'order earlier' */
-        Tribool order_early(order_early_fn(n));
-        int bias(0);
-        if (order_early.is_indeterminate())
-            bias = 1;
-        else if (order_early.is_false())
-            bias = 2;
-
-        switch (n.role())
-        {
-            case nir_fetched:
-                return 10 + bias;
-
-            case nir_done:
-                return 20 + bias;
-
-            case last_nir:
-                break;
-        }
-
-        throw InternalError(PALUDIS_HERE, "bad nir");
-    }
-
-    std::pair<int, NAGIndex> order_score(const NAGIndex & r, const StronglyConnectedComponent & scc,
-            const std::function<Tribool (const NAGIndex &)> & order_early_fn)
-    {
-        int best_score(-1);
-
-        for (Set<NAGIndex>::ConstIterator e(scc.nodes()->begin()), e_end(scc.nodes()->end()) ;
-                e != e_end ; ++e)
-        {
-            int score(order_score_one(*e, order_early_fn));
-            if (best_score == -1 || score < best_score)
-                best_score = score;
-        }
-
-        return std::make_pair(best_score, r);
-    }
-}
-
 const std::shared_ptr<const SortedStronglyConnectedComponents>
 NAG::sorted_strongly_connected_components(
         const std::function<Tribool (const NAGIndex &)> & order_early_fn
         ) const
 {
-    StronglyConnectedComponentsByRepresentative sccs;
-    TarjanDataMap data;
-    TarjanStack stack;
-
-    /* find our strongly connected components */
-    int index(0);
-    for (Nodes::const_iterator n(_imp->nodes.begin()), n_end(_imp->nodes.end()) ;
-            n != n_end ; ++n)
-        if (data.end() == data.find(*n))
-            tarjan(*n, _imp->edges, data, stack, index, sccs);
-
-    /* find the 'representative' scc node for every node */
-    RepresentativeNodes representative_nodes;
-    for (StronglyConnectedComponentsByRepresentative::const_iterator s(sccs.begin()), s_end(sccs.end()) ;
-            s != s_end ; ++s)
-        for (Set<NAGIndex>::ConstIterator r(s->second.nodes()->begin()), r_end(s->second.nodes()->end()) ;
-                r != r_end ; ++r)
-            if (! representative_nodes.insert(std::make_pair(*r, s->first)).second)
-                throw InternalError(PALUDIS_HERE, "node in multiple sccs");
-
-    /* sanity check, to avoid us much weirdness if there's a bug */
-    if (representative_nodes.size() != _imp->nodes.size())
-        throw InternalError(PALUDIS_HERE, "mismatch");
-
-    /* build edges between SCCs */
-    PlainEdges all_scc_edges, scc_edges, scc_edges_backwards;
-    for (const auto & edge : _imp->edges)
-    {
-        RepresentativeNodes::const_iterator from(representative_nodes.find(edge.first));
-        for (const auto & n : edge.second)
-        {
-            RepresentativeNodes::const_iterator to(representative_nodes.find(n.first));
-            if (! (to->second == from->second))
-            {
-                all_scc_edges.insert(std::make_pair(from->second, Nodes())).first->second.insert(to->second);
-                scc_edges.insert(std::make_pair(from->second, Nodes())).first->second.insert(to->second);
-                scc_edges_backwards.insert(std::make_pair(to->second, Nodes())).first->second.insert(from->second);
-            }
-        }
-    }
+    CompactNAG compact(*this);
 
-    /* topological sort with consistent ordering (mostly to make test cases
-     * easier). we know there're no cycles. */
     std::shared_ptr<SortedStronglyConnectedComponents> result(std::make_shared<SortedStronglyConnectedComponents>());
-
-    typedef std::set<std::pair<int, NAGIndex> > OrderableNow;
-    OrderableNow orderable_now;
-    Nodes done, pending_fetches;
-
-    for (StronglyConnectedComponentsByRepresentative::const_iterator c(sccs.begin()), c_end(sccs.end()) ;
-            c != c_end ; ++c)
-        if (scc_edges.end() == scc_edges.find(c->first))
-            orderable_now.insert(order_score(c->first, c->second, order_early_fn));
-
-    while (! orderable_now.empty())
+    for (const auto & component : compact.sorted_strongly_connected_components(order_early_fn))
     {
-        OrderableNow::iterator ordering_now(orderable_now.begin());
-        StronglyConnectedComponentsByRepresentative::const_iterator ordering_now_scc(sccs.find(ordering_now->second));
-
-        if (ordering_now_scc->second.nodes()->size() == 1 && ordering_now_scc->second.nodes()->begin()->role() == nir_fetched)
-            pending_fetches.insert(ordering_now->second);
-        else
-        {
-            auto this_scc_edges(all_scc_edges.find(ordering_now->second));
-            if (this_scc_edges != all_scc_edges.end())
-            {
-                for (const auto & e : this_scc_edges->second)
-                {
-                    auto p(pending_fetches.find(e));
-                    if (p != pending_fetches.end())
-                    {
-                        result->push_back(sccs.find(e)->second);
-                        pending_fetches.erase(p);
-                    }
-                }
-            }
-
-            result->push_back(ordering_now_scc->second);
-        }
-        done.insert(ordering_now->second);
-
-        PlainEdges::iterator ordering_now_edges(scc_edges_backwards.find(ordering_now->second));
-        if (ordering_now_edges != scc_edges_backwards.end())
-            for (Nodes::iterator e(ordering_now_edges->second.begin()), e_end(ordering_now_edges->second.end()) ;
-                    e != e_end ; )
-            {
-                PlainEdges::iterator reverse_edges(scc_edges.find(*e));
-                if (reverse_edges == scc_edges.end())
-                    throw InternalError(PALUDIS_HERE, "huh?");
-                reverse_edges->second.erase(ordering_now->second);
-                if (reverse_edges->second.empty())
-                    orderable_now.insert(order_score(*e, sccs.find(*e)->second, order_early_fn));
-                ordering_now_edges->second.erase(e++);
-            }
-
-        orderable_now.erase(ordering_now);
-    }
+        StronglyConnectedComponent scc(make_named_values<StronglyConnectedComponent>(
+                    n::nodes() = std::make_shared<Set<NAGIndex>>(),
+                    n::requirements() = std::make_shared<Set<NAGIndex>>()
+                    ));
 
-    if (! pending_fetches.empty())
-        throw InternalError(PALUDIS_HERE, "still have pending fetches");
+        for (const auto & n : component)
+            scc.nodes()->insert(compact.node(n));
 
-    if (done.size() != sccs.size())
-        throw InternalError(PALUDIS_HERE, "mismatch");
+        result->push_back(scc);
+    }
 
     return result;
 }
@@ -22,6 +22,7 @@
 #include <paludis/resolver/decisions.hh>
 #include <paludis/resolver/resolution.hh>
 #include <paludis/resolver/nag.hh>
+#include <paludis/resolver/compact_nag.hh>
 #include <paludis/resolver/reason.hh>
 #include <paludis/resolver/constraint.hh>
 #include <paludis/resolver/strongly_connected_component.hh>
@@ -48,6 +49,7 @@
 #include <paludis/util/visitor_cast.hh>
 #include <paludis/util/tribool.hh>
 #include <paludis/util/enum_iterator.hh>
+#include <paludis/util/profiler.hh>
 
 #include <paludis/partially_made_package_dep_spec.hh>
 #include <paludis/environment.hh>
@@ -65,14 +67,38 @@
 #include <unordered_map>
 #include <algorithm>
 #include <list>
+#include <vector>
 
 using namespace paludis;
 using namespace paludis::resolver;
 
 typedef std::unordered_map<NAGIndex, std::shared_ptr<const ChangeOrRemoveDecision>, Hash<NAGIndex> > ChangeOrRemoveIndices;
-typedef std::unordered_map<NAGIndex, JobNumber, Hash<NAGIndex> > ChangeOrRemoveJobNumbers;
 typedef std::unordered_map<Resolvent, JobNumber, Hash<Resolvent> > FetchJobNumbers;
 
+namespace
+{
+    /* which CompactNAG nodes we've already looked at when working out a
+     * job's requirements. bumping the generation forgets them all at once. */
+    struct RecursedRequirements
+    {
+        std::vector<unsigned> generations;
+        unsigned generation;
+
+        RecursedRequirements() :
+            generation(0)
+        {
+        }
+
+        bool insert(const int n)
+        {
+            if (generations[n] == generation)
+                return false;
+            generations[n] = generation;
+            return true;
+        }
+    };
+}
+
 namespace paludis
 {
     template <>
@@ -83,7 +109,12 @@ namespace paludis
         const std::shared_ptr<Resolved> resolved;
         ChangeOrRemoveIndices change_or_remove_indices;
         FetchJobNumbers fetch_job_numbers;
-        ChangeOrRemoveJobNumbers change_or_remove_job_numbers;
+
+        /* once the NAG is complete, these are all by CompactNAG node */
+        std::shared_ptr<const CompactNAG> compact_nag;
+        std::vector<std::shared_ptr<const ChangeOrRemoveDecision> > change_or_remove_decisions;
+        std::vector<JobNumber> change_or_remove_job_numbers;
+        RecursedRequirements recursed;
 
         Imp(
                 const Environment * const e,
@@ -505,14 +536,13 @@ namespace
     };
 
     bool no_build_dependencies(
-            const Set<NAGIndex> & indices,
-            const NAG & nag)
+            const std::vector<int> & indices,
+            const CompactNAG & nag)
     {
-        for (Set<NAGIndex>::ConstIterator r(indices.begin()), r_end(indices.end()) ;
-                r != r_end ; ++r)
-            for (NAG::EdgesFromConstIterator e(nag.begin_edges_from(*r)), e_end(nag.end_edges_from(*r)) ;
+        for (const auto & r : indices)
+            for (const CompactNAGEdge * e(nag.begin_edges_from(r)), * e_end(nag.end_edges_from(r)) ;
                     e != e_end ; ++e)
-                if (e->second.build())
+                if (e->properties().build())
                     return false;
 
         return true;
@@ -529,6 +559,7 @@ void
 Orderer::resolve()
 {
     Context context("When resolving ordering:");
+    ProfileScope profile_scope("Orderer::resolve", "resolver");
 
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Nodifying Decisions"));
 
@@ -579,13 +610,22 @@ Orderer::resolve()
 
     const std::function<Tribool (const NAGIndex &)> order_early_fn(std::bind(&Orderer::_order_early, this, std::placeholders::_1));
 
+    _imp->compact_nag = std::make_shared<CompactNAG>(*_imp->resolved->nag());
+    _imp->change_or_remove_decisions.resize(_imp->compact_nag->size());
+    _imp->change_or_remove_job_numbers.assign(_imp->compact_nag->size(), -1);
+    _imp->recursed.generations.assign(_imp->compact_nag->size(), 0);
+    for (int n(0), n_end(_imp->compact_nag->size()) ; n != n_end ; ++n)
+    {
+        auto d(_imp->change_or_remove_indices.find(_imp->compact_nag->node(n)));
+        if (d != _imp->change_or_remove_indices.end())
+            _imp->change_or_remove_decisions[n] = d->second;
+    }
+
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Finding NAG SCCs"));
-    const std::shared_ptr<const SortedStronglyConnectedComponents> ssccs(
-            _imp->resolved->nag()->sorted_strongly_connected_components(order_early_fn));
+    const CompactNAG::Components ssccs(_imp->compact_nag->sorted_strongly_connected_components(order_early_fn));
 
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Ordering SCCs"));
-    for (SortedStronglyConnectedComponents::ConstIterator scc(ssccs->begin()), scc_end(ssccs->end()) ;
-            scc != scc_end ; ++scc)
+    for (const auto & scc : ssccs)
     {
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStepEvent());
 
@@ -593,13 +633,10 @@ Orderer::resolve()
          * nodes. this matters for cycle resolution. we identify them now, even
          * though our scc might just contain a single install, rather than
          * adding in extra useless code for the special easy case. */
-        typedef std::unordered_set<NAGIndex, Hash<NAGIndex> > ChangesInSCC;
-        ChangesInSCC changes_in_scc;
-
-        for (Set<NAGIndex>::ConstIterator r(scc->nodes()->begin()), r_end(scc->nodes()->end()) ;
-                r != r_end ; ++r)
-            if (_imp->change_or_remove_indices.end() != _imp->change_or_remove_indices.find(*r))
-                changes_in_scc.insert(*r);
+        std::vector<int> changes_in_scc;
+        for (const auto & r : scc)
+            if (_imp->change_or_remove_decisions[r])
+                changes_in_scc.push_back(r);
 
         if (changes_in_scc.empty())
         {
@@ -610,8 +647,8 @@ Orderer::resolve()
         {
             /* there's only one real package in the component, so there's no
              * need to try anything clever */
-            _check_self_deps_and_schedule(*changes_in_scc.begin(),
-                    _imp->change_or_remove_indices.find(*changes_in_scc.begin())->second,
+            _check_self_deps_and_schedule(changes_in_scc.front(),
+                    _imp->change_or_remove_decisions[changes_in_scc.front()],
                     make_shared_copy(make_named_values<OrdererNotes>(
                             n::cycle_breaking() = ""
                             )));
@@ -621,25 +658,13 @@ Orderer::resolve()
             Context sub_context("When considering only changes:");
 
             /* whoop de doo. what do our SCCs look like if we only count change
-             * or remove nodes? */
-            NAG scc_nag;
-            for (ChangesInSCC::const_iterator r(changes_in_scc.begin()), r_end(changes_in_scc.end()) ;
-                    r != r_end ; ++r)
-            {
-                scc_nag.add_node(*r);
-                /* we only need edges inside our SCC, and only those to other
-                 * change or remove nodes */
-                for (NAG::EdgesFromConstIterator e(_imp->resolved->nag()->begin_edges_from(*r)), e_end(_imp->resolved->nag()->end_edges_from(*r)) ;
-                        e != e_end ; ++e)
-                    if (changes_in_scc.end() != changes_in_scc.find(e->first))
-                        scc_nag.add_edge(*r, e->first, e->second);
-            }
-
-            scc_nag.verify_edges();
+             * or remove nodes? we only need edges inside our SCC, and only
+             * those to other change or remove nodes. */
+            CompactNAG scc_nag(*_imp->compact_nag, changes_in_scc, [] (NAGEdgeProperties &) { return true; });
 
             /* now we try again, hopefully with lots of small SCCs now */
-            const std::shared_ptr<const SortedStronglyConnectedComponents> sub_ssccs(scc_nag.sorted_strongly_connected_components(order_early_fn));
-            _order_sub_ssccs(scc_nag, *scc, sub_ssccs, true, order_early_fn);
+            const CompactNAG::Components sub_ssccs(scc_nag.sorted_strongly_connected_components(order_early_fn));
+            _order_sub_ssccs(scc_nag, scc, sub_ssccs, true, order_early_fn);
         }
     }
 }
@@ -705,95 +730,107 @@ namespace
             result = result + " (fetch)";
         return result;
     }
+
+    std::string nice_indices(const CompactNAG & nag, const std::vector<int> & indices)
+    {
+        std::string result;
+        for (const auto & i : indices)
+        {
+            if (! result.empty())
+                result.append(", ");
+            result.append(nice_index(nag.node(i)));
+        }
+        return result;
+    }
+
+    std::string nice_indices(const CompactNAG & nag)
+    {
+        std::string result;
+        for (int i(0), i_end(nag.size()) ; i != i_end ; ++i)
+        {
+            if (! result.empty())
+                result.append(", ");
+            result.append(nice_index(nag.node(i)));
+        }
+        return result;
+    }
 }
 
 void
 Orderer::_order_sub_ssccs(
-        const NAG & scc_nag,
-        const StronglyConnectedComponent & top_scc,
-        const std::shared_ptr<const SortedStronglyConnectedComponents> & sub_ssccs,
+        const CompactNAG & scc_nag,
+        const std::vector<int> & top_scc,
+        const CompactNAG::Components & sub_ssccs,
         const bool can_recurse,
         const std::function<Tribool (const NAGIndex &)> & order_early_fn)
 {
     Context context("When ordering SSCCs" + std::string(can_recurse ? " for the first time" : " for the second time") + ":");
 
-    for (SortedStronglyConnectedComponents::ConstIterator sub_scc(sub_ssccs->begin()), sub_scc_end(sub_ssccs->end()) ;
-            sub_scc != sub_scc_end ; ++sub_scc)
+    for (const auto & sub_scc : sub_ssccs)
     {
         _imp->env->trigger_notifier_callback(NotifierCallbackResolverStepEvent());
 
-        if (sub_scc->nodes()->size() == 1)
+        if (sub_scc.size() == 1)
         {
             /* yay. it's all on its own. */
-            _check_self_deps_and_schedule(*sub_scc->nodes()->begin(),
-                    _imp->change_or_remove_indices.find(*sub_scc->nodes()->begin())->second,
+            int index(scc_nag.original(sub_scc.front()));
+            _check_self_deps_and_schedule(index,
+                    _imp->change_or_remove_decisions[index],
                     make_shared_copy(make_named_values<OrdererNotes>(
                             n::cycle_breaking() = (can_recurse ?
-                                "In dependency cycle with existing packages: " + join(scc_nag.begin_nodes(), scc_nag.end_nodes(), ", ", nice_index) :
-                                "In dependency cycle with: " + join(top_scc.nodes()->begin(), top_scc.nodes()->end(), ", ", nice_index))
+                                "In dependency cycle with existing packages: " + nice_indices(scc_nag) :
+                                "In dependency cycle with: " + nice_indices(*_imp->compact_nag, top_scc))
                             )));
         }
-        else if (no_build_dependencies(*sub_scc->nodes(), scc_nag))
+        else if (no_build_dependencies(sub_scc, scc_nag))
         {
             /* what's that, timmy? we have directly codependent nodes?
              * well i'm jolly glad that's because they're run
              * dependency cycles which we can order however we like! */
-            for (Set<NAGIndex>::ConstIterator r(sub_scc->nodes()->begin()), r_end(sub_scc->nodes()->end()) ;
-                    r != r_end ; ++r)
-                _check_self_deps_and_schedule(*r,
-                        _imp->change_or_remove_indices.find(*r)->second,
+            for (const auto & r : sub_scc)
+            {
+                int index(scc_nag.original(r));
+                _check_self_deps_and_schedule(index,
+                        _imp->change_or_remove_decisions[index],
                         make_shared_copy(make_named_values<OrdererNotes>(
-                                n::cycle_breaking() = "In run dependency cycle with: " + join(
-                                    sub_scc->nodes()->begin(), sub_scc->nodes()->end(), ", ", nice_index) + (can_recurse ?
-                                    " in dependency cycle with " + join(top_scc.nodes()->begin(), top_scc.nodes()->end(), ", ", nice_index) : "")
+                                n::cycle_breaking() = "In run dependency cycle with: " + nice_indices(scc_nag, sub_scc) + (can_recurse ?
+                                    " in dependency cycle with " + nice_indices(*_imp->compact_nag, top_scc) : "")
                                 )));
+            }
         }
         else if (can_recurse)
         {
             /* no, at least one of the deps is a build dep. let's try
              * this whole mess again, except without any edges for
              * dependencies that're already met */
-            NAG scc_nag_without_met_deps;
-            for (Set<NAGIndex>::ConstIterator r(sub_scc->nodes()->begin()), r_end(sub_scc->nodes()->end()) ;
-                    r != r_end ; ++r)
-            {
-                scc_nag_without_met_deps.add_node(*r);
-                for (NAG::EdgesFromConstIterator e(scc_nag.begin_edges_from(*r)), e_end(scc_nag.end_edges_from(*r)) ;
-                        e != e_end ; ++e)
-                    if (sub_scc->nodes()->end() != sub_scc->nodes()->find(e->first))
-                        if ((! e->second.build_all_met()) || (! e->second.run_all_met()))
-                            scc_nag_without_met_deps.add_edge(*r, e->first, make_named_values<NAGEdgeProperties>(
-                                        n::always() = e->second.always(),
-                                        n::build() = e->second.build() && ! e->second.build_all_met(),
-                                        n::build_all_met() = e->second.build_all_met(),
-                                        n::run() = e->second.run() && ! e->second.run_all_met(),
-                                        n::run_all_met() = e->second.run_all_met()
-                                        ));
-            }
+            CompactNAG scc_nag_without_met_deps(scc_nag, sub_scc, [] (NAGEdgeProperties & p) -> bool {
+                    if (p.build_all_met() && p.run_all_met())
+                        return false;
 
-            scc_nag_without_met_deps.verify_edges();
+                    p.build() = p.build() && ! p.build_all_met();
+                    p.run() = p.run() && ! p.run_all_met();
+                    return true;
+                    });
 
-            const std::shared_ptr<const SortedStronglyConnectedComponents> sub_ssccs_without_met_deps(
+            const CompactNAG::Components sub_ssccs_without_met_deps(
                     scc_nag_without_met_deps.sorted_strongly_connected_components(order_early_fn));
             _order_sub_ssccs(scc_nag_without_met_deps, top_scc, sub_ssccs_without_met_deps, false, order_early_fn);
         }
         else
         {
-            for (Set<NAGIndex>::ConstIterator r(sub_scc->nodes()->begin()), r_end(sub_scc->nodes()->end()) ;
-                    r != r_end ; ++r)
+            for (const auto & r : sub_scc)
             {
-                if (r->role() == nir_fetched && sub_scc->nodes()->end() != std::find(sub_scc->nodes()->begin(),
-                            sub_scc->nodes()->end(), make_named_values<NAGIndex>(
-                                n::resolvent() = r->resolvent(),
-                                n::role() = nir_done
-                                )))
+                const NAGIndex & r_index(scc_nag.node(r));
+                if (r_index.role() == nir_fetched && sub_scc.end() != std::find_if(sub_scc.begin(), sub_scc.end(),
+                            [&] (const int o) {
+                                return scc_nag.node(o).role() == nir_done && scc_nag.node(o).resolvent() == r_index.resolvent();
+                            }))
                     continue;
 
                 _imp->resolved->taken_unorderable_decisions()->push_back(
-                        _imp->change_or_remove_indices.find(*r)->second,
+                        _imp->change_or_remove_decisions[scc_nag.original(r)],
                         make_shared_copy(make_named_values<OrdererNotes>(
-                                n::cycle_breaking() = "In unsolvable cycle with " + join(
-                                    top_scc.nodes()->begin(), top_scc.nodes()->end(), ", ", nice_index))));
+                                n::cycle_breaking() = "In unsolvable cycle with " + nice_indices(*_imp->compact_nag, top_scc))));
             }
         }
     }
@@ -801,12 +838,10 @@ Orderer::_order_sub_ssccs(
 
 namespace
 {
-    typedef std::unordered_set<NAGIndex, Hash<NAGIndex> > RecursedRequirements;
-
     void populate_requirements(
-            const std::shared_ptr<const NAG> & nag,
-            const ChangeOrRemoveJobNumbers & change_or_remove_job_numbers,
-            const NAGIndex & index,
+            const CompactNAG & nag,
+            const std::vector<JobNumber> & change_or_remove_job_numbers,
+            const int index,
             const std::shared_ptr<JobRequirements> & requirements,
             const bool is_uninstall,
             const bool is_fetch,
@@ -818,43 +853,37 @@ namespace
             basic_required_ifs += jri_fetching;
 
         if (! recursing)
-            for (NAG::EdgesFromConstIterator e(nag->begin_edges_from(index)),
-                    e_end(nag->end_edges_from(index)) ;
+            for (const CompactNAGEdge * e(nag.begin_edges_from(index)), * e_end(nag.end_edges_from(index)) ;
                     e != e_end ; ++e)
             {
-                if ((! e->second.build_all_met()) || (! e->second.run_all_met()) || is_uninstall)
-                {
-                    ChangeOrRemoveJobNumbers::const_iterator n(change_or_remove_job_numbers.find(e->first));
-                    if (n != change_or_remove_job_numbers.end())
-                        requirements->push_back(make_named_values<JobRequirement>(
-                                    n::job_number() = n->second,
-                                    n::required_if() = basic_required_ifs + jri_require_for_satisfied + jri_require_for_independent
-                                    ));
-                }
+                JobNumber n(change_or_remove_job_numbers[e->to()]);
+                if (-1 == n)
+                    continue;
 
-                if (e->second.always())
-                {
-                    ChangeOrRemoveJobNumbers::const_iterator n(change_or_remove_job_numbers.find(e->first));
-                    if (n != change_or_remove_job_numbers.end())
-                        requirements->push_back(make_named_values<JobRequirement>(
-                                    n::job_number() = n->second,
-                                    n::required_if() = basic_required_ifs + jri_require_always
-                                    ));
-                }
+                if ((! e->properties().build_all_met()) || (! e->properties().run_all_met()) || is_uninstall)
+                    requirements->push_back(make_named_values<JobRequirement>(
+                                n::job_number() = n,
+                                n::required_if() = basic_required_ifs + jri_require_for_satisfied + jri_require_for_independent
+                                ));
+
+                if (e->properties().always())
+                    requirements->push_back(make_named_values<JobRequirement>(
+                                n::job_number() = n,
+                                n::required_if() = basic_required_ifs + jri_require_always
+                                ));
             }
 
-        if ((! is_uninstall) && recursed.insert(index).second)
-            for (NAG::EdgesFromConstIterator e(nag->begin_edges_from(index)),
-                    e_end(nag->end_edges_from(index)) ;
+        if ((! is_uninstall) && recursed.insert(index))
+            for (const CompactNAGEdge * e(nag.begin_edges_from(index)), * e_end(nag.end_edges_from(index)) ;
                     e != e_end ; ++e)
             {
-                ChangeOrRemoveJobNumbers::const_iterator n(change_or_remove_job_numbers.find(e->first));
-                if (n != change_or_remove_job_numbers.end())
+                JobNumber n(change_or_remove_job_numbers[e->to()]);
+                if (-1 != n)
                     requirements->push_back(make_named_values<JobRequirement>(
-                                n::job_number() = n->second,
+                                n::job_number() = n,
                                 n::required_if() = basic_required_ifs + jri_require_for_independent
                                 ));
-                populate_requirements(nag, change_or_remove_job_numbers, e->first, requirements,
+                populate_requirements(nag, change_or_remove_job_numbers, e->to(), requirements,
                         is_uninstall, is_fetch, true, recursed);
             }
     }
@@ -862,21 +891,20 @@ namespace
 
 void
 Orderer::_check_self_deps_and_schedule(
-        const NAGIndex & index,
+        const int index,
         const std::shared_ptr<const ChangeOrRemoveDecision> & d,
         const std::shared_ptr<OrdererNotes> & n)
 {
     /* do we dep directly upon ourself? */
     bool direct_self_dep(false), self_dep_is_met(true), self_dep_is_not_build(true);
-    for (NAG::EdgesFromConstIterator e(_imp->resolved->nag()->begin_edges_from(index)),
-            e_end(_imp->resolved->nag()->end_edges_from(index)) ;
+    for (const CompactNAGEdge * e(_imp->compact_nag->begin_edges_from(index)), * e_end(_imp->compact_nag->end_edges_from(index)) ;
             e != e_end ; ++e)
     {
-        if (e->first == index)
+        if (e->to() == index)
         {
             direct_self_dep = true;
-            self_dep_is_met = self_dep_is_met && e->second.build_all_met() && e->second.run_all_met();
-            self_dep_is_not_build = self_dep_is_not_build && ! e->second.build();
+            self_dep_is_met = self_dep_is_met && e->properties().build_all_met() && e->properties().run_all_met();
+            self_dep_is_not_build = self_dep_is_not_build && ! e->properties().build();
         }
     }
 
@@ -896,7 +924,7 @@ Orderer::_check_self_deps_and_schedule(
     if (direct_self_dep && ! self_dep_is_met && ! self_dep_is_not_build)
     {
         _imp->resolved->taken_unorderable_decisions()->push_back(
-                _imp->change_or_remove_indices.find(index)->second,
+                _imp->change_or_remove_decisions[index],
                 n);
     }
     else
@@ -934,19 +962,27 @@ namespace
     struct ExtraScheduler
     {
         const std::shared_ptr<const Resolved> resolved;
+        const CompactNAG & nag;
         FetchJobNumbers & fetch_job_numbers;
-        ChangeOrRemoveJobNumbers & change_or_remove_job_numbers;
-        const NAGIndex index;
+        std::vector<JobNumber> & change_or_remove_job_numbers;
+        RecursedRequirements & recursed;
+        const int number;
+        const NAGIndex & index;
 
         ExtraScheduler(
                 const std::shared_ptr<const Resolved> & r,
+                const CompactNAG & g,
                 FetchJobNumbers & f,
-                ChangeOrRemoveJobNumbers & i,
-                const NAGIndex & v) :
+                std::vector<JobNumber> & i,
+                RecursedRequirements & q,
+                const int v) :
             resolved(r),
+            nag(g),
             fetch_job_numbers(f),
             change_or_remove_job_numbers(i),
-            index(v)
+            recursed(q),
+            number(v),
+            index(g.node(v))
         {
         }
 
@@ -972,11 +1008,11 @@ namespace
                                         + jri_require_always + jri_fetching
                                     ));
 
-                        RecursedRequirements recursed;
+                        ++recursed.generation;
                         populate_requirements(
-                                resolved->nag(),
+                                nag,
                                 change_or_remove_job_numbers,
-                                index,
+                                number,
                                 requirements,
                                 false,
                                 false,
@@ -1001,7 +1037,7 @@ namespace
                                             was_target(resolved, changes_to_make_decision)
                                             )));
 
-                        change_or_remove_job_numbers.insert(std::make_pair(index, install_job_n));
+                        change_or_remove_job_numbers[number] = install_job_n;
                     }
                     return;
 
@@ -1009,11 +1045,11 @@ namespace
                     {
                         std::shared_ptr<JobRequirements> requirements(std::make_shared<JobRequirements>());
 
-                        RecursedRequirements recursed;
+                        ++recursed.generation;
                         populate_requirements(
-                                resolved->nag(),
+                                nag,
                                 change_or_remove_job_numbers,
-                                index,
+                                number,
                                 requirements,
                                 false,
                                 true,
@@ -1047,11 +1083,11 @@ namespace
                 removing->push_back((*i)->uniquely_identifying_spec());
 
             std::shared_ptr<JobRequirements> requirements(std::make_shared<JobRequirements>());
-            RecursedRequirements recursed;
+            ++recursed.generation;
             populate_requirements(
-                    resolved->nag(),
+                    nag,
                     change_or_remove_job_numbers,
-                    index,
+                    number,
                     requirements,
                     true,
                     false,
@@ -1067,20 +1103,20 @@ namespace
                                 was_target(resolved, remove_decision)
                                 )));
 
-            change_or_remove_job_numbers.insert(std::make_pair(index, uninstall_job_n));
+            change_or_remove_job_numbers[number] = uninstall_job_n;
         }
     };
 }
 
 void
 Orderer::_schedule(
-        const NAGIndex & index,
+        const int index,
         const std::shared_ptr<const ChangeOrRemoveDecision> & d,
         const std::shared_ptr<const OrdererNotes> & n)
 {
     do
     {
-        switch (index.role())
+        switch (_imp->compact_nag->node(index).role())
         {
             case nir_done:
                 _imp->resolved->taken_change_or_remove_decisions()->push_back(d, n);
@@ -1098,7 +1134,8 @@ Orderer::_schedule(
         throw InternalError(PALUDIS_HERE, "bad index.role");
     } while (false);
 
-    d->accept(ExtraScheduler(_imp->resolved, _imp->fetch_job_numbers, _imp->change_or_remove_job_numbers, index));
+    d->accept(ExtraScheduler(_imp->resolved, *_imp->compact_nag, _imp->fetch_job_numbers, _imp->change_or_remove_job_numbers,
+                _imp->recursed, index));
 }
 
 namespace
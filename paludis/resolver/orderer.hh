@@ -26,6 +26,7 @@
 #include <paludis/resolver/decision-fwd.hh>
 #include <paludis/resolver/strongly_connected_component-fwd.hh>
 #include <paludis/resolver/nag-fwd.hh>
+#include <paludis/resolver/compact_nag-fwd.hh>
 #include <paludis/resolver/resolvent-fwd.hh>
 #include <paludis/resolver/resolver_functions-fwd.hh>
 #include <paludis/resolver/resolution-fwd.hh>
@@ -33,6 +34,7 @@
 #include <paludis/util/tribool-fwd.hh>
 #include <paludis/environment-fwd.hh>
 #include <functional>
+#include <vector>
 
 namespace paludis
 {
@@ -45,19 +47,19 @@ namespace paludis
 
             private:
                 void _check_self_deps_and_schedule(
-                        const NAGIndex &,
+                        const int,
                         const std::shared_ptr<const ChangeOrRemoveDecision> &,
                         const std::shared_ptr<OrdererNotes> &);
 
                 void _schedule(
-                        const NAGIndex &,
+                        const int,
                         const std::shared_ptr<const ChangeOrRemoveDecision> &,
                         const std::shared_ptr<const OrdererNotes> &);
 
                 void _order_sub_ssccs(
-                        const NAG &,
-                        const StronglyConnectedComponent & top_scc,
-                        const std::shared_ptr<const SortedStronglyConnectedComponents> & sub_ssccs,
+                        const CompactNAG &,
+                        const std::vector<int> & top_scc,
+                        const std::vector<std::vector<int> > & sub_ssccs,
                         const bool can_recurse,
                         const std::function<Tribool (const NAGIndex &)> & order_early_fn);
 
@@ -49,6 +49,14 @@ namespace paludis
 
                 ConstIterator insert_new(const std::shared_ptr<Resolution> &);
 
+                /**
+                 * Forget the resolution for a resolvent, if there is one. Any
+                 * iterators to it become invalid.
+                 *
+                 * \since 3.0
+                 */
+                void erase(const Resolvent &);
+
                 void serialise(Serialiser &) const;
 
                 static const std::shared_ptr<ResolutionsByResolvent> deserialise(
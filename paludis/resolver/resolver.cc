@@ -173,6 +173,12 @@ Resolver::resolve()
     _imp->env->trigger_notifier_callback(NotifierCallbackResolverStageEvent("Done"));
 }
 
+bool
+Resolver::undo_for_restart(const SuggestRestart & e)
+{
+    return _imp->decider->undo_for_restart(e);
+}
+
 const std::shared_ptr<const Resolved>
 Resolver::resolved() const
 {
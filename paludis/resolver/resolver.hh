@@ -27,6 +27,7 @@
 #include <paludis/resolver/resolved-fwd.hh>
 #include <paludis/resolver/sanitised_dependencies-fwd.hh>
 #include <paludis/resolver/package_or_block_dep_spec-fwd.hh>
+#include <paludis/resolver/suggest_restart-fwd.hh>
 #include <paludis/util/pimp.hh>
 #include <paludis/package_id-fwd.hh>
 #include <paludis/dep_spec-fwd.hh>
@@ -59,6 +60,15 @@ namespace paludis
 
                 void resolve();
 
+                /**
+                 * Undo only those decisions that a SuggestRestart affects, so
+                 * that resolve can be called again. Returns false if that
+                 * isn't possible, in which case a new Resolver must be used.
+                 *
+                 * \since 3.0
+                 */
+                bool undo_for_restart(const SuggestRestart &);
+
                 const std::shared_ptr<const Resolved> resolved() const PALUDIS_ATTRIBUTE((warn_unused_result));
         };
     }
@@ -0,0 +1,115 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/resolver/resolver.hh>
+#include <paludis/resolver/resolver_functions.hh>
+#include <paludis/resolver/resolution.hh>
+#include <paludis/resolver/resolutions_by_resolvent.hh>
+#include <paludis/resolver/resolved.hh>
+#include <paludis/resolver/decision.hh>
+#include <paludis/resolver/decision_utils.hh>
+#include <paludis/resolver/suggest_restart.hh>
+
+#include <paludis/environments/test/test_environment.hh>
+
+#include <paludis/util/make_named_values.hh>
+#include <paludis/util/wrapped_forward_iterator-impl.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/stringify.hh>
+
+#include <paludis/package_id.hh>
+
+#include <paludis/resolver/resolver_test.hh>
+
+#include <set>
+#include <cstdlib>
+#include <string>
+
+using namespace paludis;
+using namespace paludis::resolver;
+using namespace paludis::resolver::resolver_test;
+
+namespace
+{
+    struct ResolverRestartsTestCase : ResolverTestCase
+    {
+        std::shared_ptr<ResolverTestData> data;
+
+        void SetUp() override
+        {
+            data = std::make_shared<ResolverTestData>("restarts", "exheres-0", "exheres");
+        }
+
+        void TearDown() override
+        {
+            data.reset();
+        }
+    };
+
+    std::string decided_ids(const std::shared_ptr<const Resolved> & resolved)
+    {
+        std::set<std::string> result;
+        for (const auto & resolution : *resolved->resolutions_by_resolvent())
+        {
+            auto id(get_decided_id_or_null(resolution->decision()));
+            if (id)
+                result.insert(stringify(id->name()) + "-" + stringify(id->version()));
+        }
+        return join(result.begin(), result.end(), " ");
+    }
+}
+
+/* older/unrelated is decided before older/beta's dependency on older/alpha
+ * forces a restart, and older/under afterwards, so a full restart decides
+ * older/target and older/unrelated twice */
+TEST_F(ResolverRestartsTestCase, Full)
+{
+    std::shared_ptr<const Resolved> resolved(data->get_resolved("older/target"));
+    EXPECT_EQ(1, data->restarts);
+    EXPECT_EQ("older/alpha-1 older/beta-1 older/target-1 older/under-1 older/unrelated-1", decided_ids(resolved));
+
+    EXPECT_EQ(2, data->decisions["older/target"]);
+    EXPECT_EQ(2, data->decisions["older/unrelated"]);
+    EXPECT_EQ(1, data->decisions["older/under"]);
+}
+
+/* an incremental restart only undoes older/alpha and what depends on it, so
+ * the decisions outside that have to be kept rather than made again */
+TEST_F(ResolverRestartsTestCase, Incremental)
+{
+    data->incremental_restarts = true;
+    std::shared_ptr<const Resolved> resolved(data->get_resolved("older/target"));
+    EXPECT_EQ(1, data->restarts);
+    EXPECT_EQ("older/alpha-1 older/beta-1 older/target-1 older/under-1 older/unrelated-1", decided_ids(resolved));
+
+    EXPECT_EQ(1, data->decisions["older/target"]);
+    EXPECT_EQ(1, data->decisions["older/unrelated"]);
+    EXPECT_EQ(1, data->decisions["older/under"]);
+    EXPECT_LE(2, data->decisions["older/alpha"]);
+}
+
+TEST_F(ResolverRestartsTestCase, Jobs)
+{
+    ::setenv("PALUDIS_RESOLVER_JOBS", "4", 1);
+    std::shared_ptr<const Resolved> resolved(data->get_resolved("older/target"));
+    ::unsetenv("PALUDIS_RESOLVER_JOBS");
+
+    EXPECT_EQ(1, data->restarts);
+    EXPECT_EQ("older/alpha-1 older/beta-1 older/target-1 older/under-1 older/unrelated-1", decided_ids(resolved));
+}
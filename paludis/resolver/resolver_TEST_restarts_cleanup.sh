@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+if [ -d resolver_TEST_restarts_dir ] ; then
+    rm -fr resolver_TEST_restarts_dir
+else
+    true
+fi
+
@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir resolver_TEST_restarts_dir || exit 1
+cd resolver_TEST_restarts_dir || exit 1
+
+mkdir -p build
+mkdir -p distdir
+mkdir -p installed
+
+mkdir -p repo/{profiles/profile,metadata}
+
+cd repo
+echo "repo" > profiles/repo_name
+:> metadata/categories.conf
+
+# older
+echo 'older' >> metadata/categories.conf
+
+mkdir -p 'packages/older/target'
+cat <<END > packages/older/target/target-1.exheres-0
+SUMMARY="target"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: older/unrelated older/alpha older/beta"
+END
+
+mkdir -p 'packages/older/alpha'
+cat <<END > packages/older/alpha/alpha-1.exheres-0
+SUMMARY="alpha"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+cat <<END > packages/older/alpha/alpha-2.exheres-0
+SUMMARY="alpha"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: older/extra"
+END
+
+mkdir -p 'packages/older/beta'
+cat <<END > packages/older/beta/beta-1.exheres-0
+SUMMARY="beta"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: older/alpha[<2]"
+END
+
+mkdir -p 'packages/older/unrelated'
+cat <<END > packages/older/unrelated/unrelated-1.exheres-0
+SUMMARY="unrelated"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES="run: older/under"
+END
+
+mkdir -p 'packages/older/under'
+cat <<END > packages/older/under/under-1.exheres-0
+SUMMARY="under"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+mkdir -p 'packages/older/extra'
+cat <<END > packages/older/extra/extra-1.exheres-0
+SUMMARY="extra"
+PLATFORMS="test"
+SLOT="0"
+DEPENDENCIES=""
+END
+
+cd ..
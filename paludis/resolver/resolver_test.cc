@@ -99,7 +99,9 @@ ResolverTestData::ResolverTestData(const std::string & t, const std::string & e,
     promote_binaries_helper(&env),
     remove_hidden_helper(&env),
     remove_if_dependent_helper(&env),
-    get_resolvents_for_helper(&env, std::cref(remove_hidden_helper))
+    get_resolvents_for_helper(&env, std::cref(remove_hidden_helper)),
+    incremental_restarts(false),
+    restarts(0)
 {
     std::shared_ptr<Map<std::string, std::string> > keys(std::make_shared<Map<std::string, std::string>>());
     keys->insert("format", "e");
@@ -166,7 +168,10 @@ ResolverFunctions
 ResolverTestData::get_resolver_functions()
 {
     return make_named_values<ResolverFunctions>(
-            n::allow_choice_changes_fn() = std::cref(allow_choice_changes_helper),
+            n::allow_choice_changes_fn() = [this] (const std::shared_ptr<const Resolution> & r) {
+                ++decisions[stringify(r->resolvent().package())];
+                return allow_choice_changes_helper(r);
+            },
             n::allowed_to_remove_fn() = std::cref(allowed_to_remove_helper),
             n::allowed_to_restart_fn() = std::cref(allowed_to_restart_helper),
             n::always_via_binary_fn() = std::cref(always_via_binary_helper),
@@ -197,18 +202,25 @@ ResolverTestData::get_resolver_functions()
 const std::shared_ptr<const Resolved>
 ResolverTestData::get_resolved(const PackageOrBlockDepSpec & target)
 {
+    std::shared_ptr<Resolver> resolver;
     while (true)
     {
         try
         {
-            Resolver resolver(&env, get_resolver_functions());
-            resolver.add_target(target, "");
-            resolver.resolve();
-            return resolver.resolved();
+            if (! resolver)
+            {
+                resolver = std::make_shared<Resolver>(&env, get_resolver_functions());
+                resolver->add_target(target, "");
+            }
+            resolver->resolve();
+            return resolver->resolved();
         }
         catch (const SuggestRestart & e)
         {
+            ++restarts;
             get_initial_constraints_for_helper.add_suggested_restart(e);
+            if (! (incremental_restarts && resolver->undo_for_restart(e)))
+                resolver.reset();
         }
     }
 }
@@ -120,6 +120,14 @@ namespace paludis
                 RemoveIfDependentHelper remove_if_dependent_helper;
                 GetResolventsForHelper get_resolvents_for_helper;
 
+                bool incremental_restarts;
+                int restarts;
+
+                /* how many times we have decided for each package. this
+                 * counts calls to allow_choice_changes_fn, which the
+                 * decider makes once per attempt at a decision */
+                std::map<std::string, int> decisions;
+
                 ResolverTestData(const std::string & group, const std::string & eapi, const std::string & layout);
 
                 ResolverFunctions get_resolver_functions();
@@ -19,6 +19,7 @@
 
 #include <paludis/selection.hh>
 #include <paludis/selection_handler.hh>
+#include <paludis/package_id_stream.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/sequence-impl.hh>
 #include <paludis/util/set-impl.hh>
@@ -28,6 +29,7 @@
 #include <paludis/util/iterator_funcs.hh>
 #include <paludis/util/indirect_iterator-impl.hh>
 #include <paludis/util/join.hh>
+#include <paludis/util/profiler.hh>
 #include <paludis/name.hh>
 #include <paludis/version_spec.hh>
 #include <paludis/package_id.hh>
@@ -88,6 +90,7 @@ std::shared_ptr<PackageIDSequence>
 Selection::perform_select(const Environment * const env) const
 {
     Context context("When finding " + _imp->handler->as_string() + ":");
+    ProfileScope profile_scope("Selection", "query", [&] { return _imp->handler->as_string(); });
     return _imp->handler->perform_select(env);
 }
 
@@ -119,31 +122,11 @@ namespace
             std::shared_ptr<PackageIDSequence> perform_select(const Environment * const env) const override
             {
                 std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
-                RepositoryContentMayExcludes may_excludes(_fg.filter().may_excludes());
 
-                std::shared_ptr<const RepositoryNameSet> r(_fg.filter().repositories(env, _fg.generator().repositories(env, may_excludes)));
-                if (r->empty())
-                    return result;
-
-                std::shared_ptr<const CategoryNamePartSet> c(_fg.filter().categories(env, r, _fg.generator().categories(env, r, may_excludes)));
-                if (c->empty())
-                    return result;
-
-                std::shared_ptr<const QualifiedPackageNameSet> p(_fg.filter().packages(env, r, _fg.generator().packages(env, r, c, may_excludes)));
-                if (p->empty())
-                    return result;
-
-                for (QualifiedPackageNameSet::ConstIterator q(p->begin()), q_end(p->end()) ; q != q_end ; ++q)
-                {
-                    std::shared_ptr<QualifiedPackageNameSet> s(std::make_shared<QualifiedPackageNameSet>());
-                    s->insert(*q);
-                    std::shared_ptr<const PackageIDSet> i(_fg.filter().ids(env, _fg.generator().ids(env, r, s, may_excludes)));
-                    if (! i->empty())
-                    {
-                        result->push_back(*i->begin());
-                        break;
-                    }
-                }
+                PackageIDStream stream(env, _fg);
+                std::shared_ptr<const PackageIDSequence> ids(stream.next_package());
+                if (ids)
+                    result->push_back(*ids->begin());
 
                 return result;
             }
@@ -165,31 +148,11 @@ namespace
 
             std::shared_ptr<PackageIDSequence> perform_select(const Environment * const env) const override
             {
-                using namespace std::placeholders;
-
                 std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
-                RepositoryContentMayExcludes may_excludes(_fg.filter().may_excludes());
-
-                std::shared_ptr<const RepositoryNameSet> r(_fg.filter().repositories(env, _fg.generator().repositories(env, may_excludes)));
-                if (r->empty())
-                    return result;
-
-                std::shared_ptr<const CategoryNamePartSet> c(_fg.filter().categories(env, r, _fg.generator().categories(env, r, may_excludes)));
-                if (c->empty())
-                    return result;
-
-                std::shared_ptr<const QualifiedPackageNameSet> p(_fg.filter().packages(env, r, _fg.generator().packages(env, r, c, may_excludes)));
-                if (p->empty())
-                    return result;
 
-                for (QualifiedPackageNameSet::ConstIterator q(p->begin()), q_end(p->end()) ; q != q_end ; ++q)
-                {
-                    std::shared_ptr<QualifiedPackageNameSet> s(std::make_shared<QualifiedPackageNameSet>());
-                    s->insert(*q);
-                    std::shared_ptr<const PackageIDSet> i(_fg.filter().ids(env, _fg.generator().ids(env, r, s, may_excludes)));
-                    if (! i->empty())
-                        result->push_back(*std::max_element(i->begin(), i->end(), PackageIDComparator(env)));
-                }
+                PackageIDStream stream(env, _fg);
+                while (std::shared_ptr<const PackageIDSequence> ids = stream.next_package())
+                    result->push_back(*ids->last());
 
                 return result;
             }
@@ -211,26 +174,13 @@ namespace
 
             std::shared_ptr<PackageIDSequence> perform_select(const Environment * const env) const override
             {
-                using namespace std::placeholders;
-
                 std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
-                RepositoryContentMayExcludes may_excludes(_fg.filter().may_excludes());
 
-                std::shared_ptr<const RepositoryNameSet> r(_fg.filter().repositories(env, _fg.generator().repositories(env, may_excludes)));
-                if (r->empty())
-                    return result;
-
-                std::shared_ptr<const CategoryNamePartSet> c(_fg.filter().categories(env, r, _fg.generator().categories(env, r, may_excludes)));
-                if (c->empty())
-                    return result;
-
-                std::shared_ptr<const QualifiedPackageNameSet> p(_fg.filter().packages(env, r, _fg.generator().packages(env, r, c, may_excludes)));
-                if (p->empty())
-                    return result;
-
-                std::shared_ptr<const PackageIDSet> i(_fg.filter().ids(env, _fg.generator().ids(env, r, p, may_excludes)));
-                std::copy(i->begin(), i->end(), result->back_inserter());
-                result->sort(PackageIDComparator(env));
+                /* packages come in name order, and PackageIDComparator
+                 * orders by name first, so there's nothing more to sort */
+                PackageIDStream stream(env, _fg);
+                while (std::shared_ptr<const PackageIDSequence> ids = stream.next_package())
+                    std::copy(ids->begin(), ids->end(), result->back_inserter());
 
                 return result;
             }
@@ -424,29 +374,23 @@ namespace
 
             std::shared_ptr<PackageIDSequence> perform_select(const Environment * const env) const override
             {
-                using namespace std::placeholders;
-
                 std::shared_ptr<PackageIDSequence> result(std::make_shared<PackageIDSequence>());
-                RepositoryContentMayExcludes may_excludes(_fg.filter().may_excludes());
-
-                std::shared_ptr<const RepositoryNameSet> r(_fg.filter().repositories(env, _fg.generator().repositories(env, may_excludes)));
-                if (r->empty())
-                    throw DidNotGetExactlyOneError(as_string(), std::make_shared<PackageIDSet>());
-
-                std::shared_ptr<const CategoryNamePartSet> c(_fg.filter().categories(env, r, _fg.generator().categories(env, r, may_excludes)));
-                if (c->empty())
-                    throw DidNotGetExactlyOneError(as_string(), std::make_shared<PackageIDSet>());
-
-                std::shared_ptr<const QualifiedPackageNameSet> p(_fg.filter().packages(env, r, _fg.generator().packages(env, r, c, may_excludes)));
-                if (p->empty())
-                    throw DidNotGetExactlyOneError(as_string(), std::make_shared<PackageIDSet>());
 
-                std::shared_ptr<const PackageIDSet> i(_fg.filter().ids(env, _fg.generator().ids(env, r, p, may_excludes)));
+                /* stop as soon as we know there's more than one, rather than
+                 * loading every candidate just to complain about them */
+                std::shared_ptr<PackageIDSet> found(std::make_shared<PackageIDSet>());
+                PackageIDStream stream(env, _fg);
+                while (std::shared_ptr<const PackageIDSequence> ids = stream.next_package())
+                {
+                    std::copy(ids->begin(), ids->end(), found->inserter());
+                    if (next(found->begin()) != found->end())
+                        break;
+                }
 
-                if (i->empty() || next(i->begin()) != i->end())
-                    throw DidNotGetExactlyOneError(as_string(), i);
+                if (found->empty() || next(found->begin()) != found->end())
+                    throw DidNotGetExactlyOneError(as_string(), found);
 
-                result->push_back(*i->begin());
+                result->push_back(*found->begin());
 
                 return result;
             }
@@ -31,10 +31,15 @@
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/env_var_names.hh>
 #include <paludis/util/sequence.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/fs_error.hh>
 
 #include <paludis/output_manager.hh>
 
 #include <list>
+#include <vector>
+#include <cstdlib>
 
 using namespace paludis;
 
@@ -91,8 +96,58 @@ DefaultSyncer::DefaultSyncer(const SyncerParams & params) :
     _syncer = stringify(syncer);
 }
 
+namespace
+{
+    /* The syncer program gets a path inside a private temporary directory,
+     * so that we can tell "nothing changed" (an empty file) apart from "I
+     * don't know what changed" (no file at all). */
+    struct ChangedPathsDir
+    {
+        FSPath dir;
+
+        ChangedPathsDir() :
+            dir("/var/empty")
+        {
+            std::string pattern(getenv_with_default("TMPDIR", "/tmp") + "/paludis-sync-XXXXXX");
+            std::vector<char> buf(pattern.begin(), pattern.end());
+            buf.push_back('\0');
+            if (::mkdtemp(&buf[0]))
+                dir = FSPath(&buf[0]);
+            else
+                Log::get_instance()->message("syncer.changed_paths.no_tmpdir", ll_debug, lc_context)
+                    << "Couldn't create a temporary directory from '" << pattern << "', so changed paths will not be collected";
+        }
+
+        ~ChangedPathsDir()
+        {
+            if (dir == FSPath("/var/empty"))
+                return;
+
+            try
+            {
+                file().unlink();
+                dir.rmdir();
+            }
+            catch (const FSError &)
+            {
+            }
+        }
+
+        FSPath file() const
+        {
+            return dir / "changed_paths";
+        }
+    };
+}
+
 void
 DefaultSyncer::sync(const SyncOptions & opts) const
+{
+    sync_reporting_changes(opts);
+}
+
+std::shared_ptr<const Set<std::string> >
+DefaultSyncer::sync_reporting_changes(const SyncOptions & opts) const
 {
     std::shared_ptr<const FSPathSequence> bashrc_files(_environment->bashrc_files());
     std::shared_ptr<const FSPathSequence> fetchers_dirs(_environment->fetchers_dirs());
@@ -102,6 +157,8 @@ DefaultSyncer::sync(const SyncOptions & opts) const
     if (! _revision.empty())
         revision = " --revision='" + _revision + "'";
 
+    ChangedPathsDir changed_paths_dir;
+
     Process process(ProcessCommand(stringify(_syncer) + " " + opts.options() + revision + " '" + _local + "' '" + _remote + "'"));
 
     process
@@ -111,12 +168,40 @@ DefaultSyncer::sync(const SyncOptions & opts) const
         .setenv("PALUDIS_SYNCERS_DIRS", join(syncers_dirs->begin(), syncers_dirs->end(), " "))
         .setenv("PALUDIS_EBUILD_DIR", getenv_with_default(env_vars::ebuild_dir, LIBEXECDIR "/paludis"))
         .setenv("PALUDIS_SYNC_FILTER_FILE", stringify(opts.filter_file()))
+        .setenv("PALUDIS_SYNC_CHANGED_PATHS_FILE", changed_paths_dir.dir == FSPath("/var/empty") ? "" :
+                stringify(changed_paths_dir.file()))
         .capture_stderr(opts.output_manager()->stderr_stream())
         .capture_stdout(opts.output_manager()->stdout_stream())
         .use_ptys();
 
     if (0 != process.run().wait())
         throw SyncFailedError(_local, _remote);
+
+    if (changed_paths_dir.dir == FSPath("/var/empty") || ! changed_paths_dir.file().stat().exists())
+        return nullptr;
+
+    auto result(std::make_shared<Set<std::string> >());
+    SafeIFStream f(changed_paths_dir.file());
+    std::string line;
+    while (std::getline(f, line))
+    {
+        while ((! line.empty()) && '/' == line.at(line.length() - 1))
+            line.erase(line.length() - 1);
+        if (! line.empty())
+            result->insert(line);
+    }
+
+    Log::get_instance()->message("syncer.changed_paths", ll_debug, lc_context)
+        << "Syncer '" << _syncer << "' reported " << result->size() << " changed paths";
+
+    return result;
+}
+
+std::shared_ptr<const Set<std::string> >
+Syncer::sync_reporting_changes(const SyncOptions & opts) const
+{
+    sync(opts);
+    return nullptr;
 }
 
 Syncer::Syncer() = default;
@@ -23,6 +23,7 @@
 #include <paludis/util/exception.hh>
 #include <paludis/output_manager-fwd.hh>
 #include <paludis/repository.hh>
+#include <paludis/util/set-fwd.hh>
 #include <string>
 
 /** \file
@@ -115,6 +116,18 @@ namespace paludis
              * Perform the sync.
              */
             virtual void sync(const SyncOptions &) const = 0;
+
+            /**
+             * Perform the sync, and return the paths, relative to the local
+             * directory, that were added, modified or removed.
+             *
+             * Returns a zero pointer if the syncer cannot tell what changed,
+             * in which case callers must assume that anything could have. The
+             * default implementation calls sync and returns a zero pointer.
+             *
+             * \since 3.0
+             */
+            virtual std::shared_ptr<const Set<std::string> > sync_reporting_changes(const SyncOptions &) const;
     };
 
     /**
@@ -146,6 +159,14 @@ namespace paludis
              * Perform the sync.
              */
             virtual void sync(const SyncOptions &) const;
+
+            /**
+             * Perform the sync, collecting the changed paths from the syncer
+             * program via PALUDIS_SYNC_CHANGED_PATHS_FILE.
+             *
+             * \since 3.0
+             */
+            virtual std::shared_ptr<const Set<std::string> > sync_reporting_changes(const SyncOptions &) const;
     };
 
     /**
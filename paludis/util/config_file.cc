@@ -25,15 +25,20 @@
 #include <paludis/util/wrapped_forward_iterator-impl.hh>
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/options.hh>
-#include <paludis/util/simple_parser.hh>
 #include <paludis/util/log.hh>
-#include <paludis/util/safe_ifstream.hh>
 #include <paludis/util/system.hh>
 
+#include <algorithm>
+#include <cstring>
 #include <istream>
 #include <list>
 #include <map>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 using namespace paludis;
 
 #include <paludis/util/config_file-se.cc>
@@ -77,17 +82,36 @@ namespace paludis
         Imp(const FSPath & f) :
             filename(stringify(f))
         {
-            try
-            {
-                SafeIFStream ff(f);
-                std::shared_ptr<std::string> t(std::make_shared<std::string>());
-                std::copy((std::istreambuf_iterator<char>(ff)), std::istreambuf_iterator<char>(), std::back_inserter(*t));
-                text = t;
-            }
-            catch (const SafeIFStreamError & e)
+            /* files are read rather than mapped, since some (the VDB's
+             * caches, for example) are rewritten in place, and truncating a
+             * mapped file under us would kill us with SIGBUS */
+            int fd(::open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+            if (-1 == fd)
+                throw ConfigFileError(filename, "Error reading file: '" + std::string(std::strerror(errno)) + "'");
+
+            std::shared_ptr<std::string> t(std::make_shared<std::string>());
+            struct stat st;
+            if (0 == ::fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0)
+                t->reserve(st.st_size);
+
+            char buf[64 * 1024];
+            while (true)
             {
-                throw ConfigFileError(filename, "Error reading file: '" + e.message() + "' (" + e.what() + ")");
+                ssize_t n(::read(fd, buf, sizeof(buf)));
+                if (n > 0)
+                    t->append(buf, n);
+                else if (0 == n)
+                    break;
+                else if (EINTR != errno)
+                {
+                    int read_errno(errno);
+                    ::close(fd);
+                    throw ConfigFileError(filename, "Error reading file: '" + std::string(std::strerror(read_errno)) + "'");
+                }
             }
+
+            ::close(fd);
+            text = t;
         }
 
         Imp(const std::string & s) :
@@ -149,6 +173,18 @@ ConfigFile::Source::text() const
     return *_imp->text;
 }
 
+const char *
+ConfigFile::Source::data() const
+{
+    return _imp->text->data();
+}
+
+std::size_t
+ConfigFile::Source::size() const
+{
+    return _imp->text->size();
+}
+
 const std::string &
 ConfigFile::Source::filename() const
 {
@@ -174,11 +210,223 @@ namespace paludis
 
 namespace
 {
-    void parse_after_continuation(const ConfigFile::Source & sr, SimpleParser & parser, const bool recognise_comments)
+    /* A set of characters, as a lookup table, so that runs of ordinary text
+     * can be skipped with a single load and test per character. */
+    class CharacterClass
+    {
+        private:
+            bool _members[256];
+
+        public:
+            explicit CharacterClass(const char * const members)
+            {
+                std::fill(_members, _members + 256, false);
+                for (const char * m(members) ; *m ; ++m)
+                    _members[static_cast<unsigned char>(*m)] = true;
+            }
+
+            bool operator[] (const char c) const
+            {
+                return _members[static_cast<unsigned char>(c)];
+            }
+    };
+
+    const CharacterClass blanks(" \t");
+    const CharacterClass variable_name_characters(
+            "abcdefghijklmnopqrstuvwxyz"
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+            "0123456789_");
+
+    const CharacterClass line_word_stops(" \t\n\\#");
+    const CharacterClass key_stops(" \t\n$#\"'=\\?");
+    const CharacterClass section_type_stops(" \t\n$#\"'=\\]");
+    const CharacterClass section_name_stops(" \t\n$#\"\\]");
+    const CharacterClass single_quoted_stops("\\'");
+    const CharacterClass double_quoted_stops("\\\"$\t\n");
+    const CharacterClass unquoted_stops("\\\"$#\n\t ");
+
+    /* Part of the text being parsed, which is only copied if it's wanted. */
+    struct Token
+    {
+        const char * begin;
+        const char * end;
+
+        bool empty() const
+        {
+            return begin == end;
+        }
+    };
+
+    /* Walks over a Source's text once, without copying it. Each consume
+     * function either moves past what it matched, or leaves the position
+     * alone and returns false. */
+    class ConfigFileScanner
+    {
+        private:
+            const char * const _begin;
+            const char * const _end;
+            const char * _pos;
+
+            bool matches_at(const char * const p, const char * const s, const std::size_t n) const
+            {
+                return std::size_t(_end - p) >= n && (0 == n || 0 == std::memcmp(p, s, n));
+            }
+
+            const char * skip(const char * p, const CharacterClass & c) const
+            {
+                while (p != _end && c[*p])
+                    ++p;
+                return p;
+            }
+
+            const char * skip_until(const char * p, const CharacterClass & c) const
+            {
+                while (p != _end && ! c[*p])
+                    ++p;
+                return p;
+            }
+
+        public:
+            explicit ConfigFileScanner(const ConfigFile::Source & sr) :
+                _begin(sr.data()),
+                _end(sr.data() + sr.size()),
+                _pos(_begin)
+            {
+            }
+
+            bool eof() const
+            {
+                return _pos == _end;
+            }
+
+            std::size_t remaining() const
+            {
+                return _end - _pos;
+            }
+
+            /* only needed for error messages, so we don't keep count as we go */
+            unsigned current_line_number() const
+            {
+                return 1 + std::count(_begin, _pos, '\n');
+            }
+
+            bool lookahead(const char c) const
+            {
+                return _pos != _end && c == *_pos;
+            }
+
+            template <std::size_t n_>
+            bool lookahead(const char (& s)[n_]) const
+            {
+                return matches_at(_pos, s, n_ - 1);
+            }
+
+            /* zero or more blanks, then c */
+            bool lookahead_after_blanks(const char c) const
+            {
+                const char * const p(skip(_pos, blanks));
+                return p != _end && c == *p;
+            }
+
+            bool consume(const char c)
+            {
+                if (! lookahead(c))
+                    return false;
+                ++_pos;
+                return true;
+            }
+
+            template <std::size_t n_>
+            bool consume(const char (& s)[n_])
+            {
+                if (! lookahead(s))
+                    return false;
+                _pos += n_ - 1;
+                return true;
+            }
+
+            /* s, then one or more blanks */
+            template <std::size_t n_>
+            bool consume_command(const char (& s)[n_])
+            {
+                if (! lookahead(s))
+                    return false;
+                const char * const p(skip(_pos + n_ - 1, blanks));
+                if (p == _pos + n_ - 1)
+                    return false;
+                _pos = p;
+                return true;
+            }
+
+            /* zero or more blanks */
+            Token consume_blanks()
+            {
+                Token result{_pos, skip(_pos, blanks)};
+                _pos = result.end;
+                return result;
+            }
+
+            /* everything up to, but not including, the next newline */
+            void consume_rest_of_line()
+            {
+                if (_pos == _end)
+                    return;
+                const void * const p(std::memchr(_pos, '\n', _end - _pos));
+                _pos = p ? static_cast<const char *>(p) : _end;
+            }
+
+            /* one or more characters, none of them in stops */
+            bool consume_word(const CharacterClass & stops, Token & t)
+            {
+                const char * const p(skip_until(_pos, stops));
+                if (p == _pos)
+                    return false;
+                t = Token{_pos, p};
+                _pos = p;
+                return true;
+            }
+
+            /* any character, then zero or more characters that aren't in stops */
+            bool consume_run(const CharacterClass & stops, Token & t)
+            {
+                if (_pos == _end)
+                    return false;
+                t = Token{_pos, skip_until(_pos + 1, stops)};
+                _pos = t.end;
+                return true;
+            }
+
+            /* a backslash, then any character, which is returned */
+            bool consume_escape(char & c)
+            {
+                if (std::size_t(_end - _pos) < 2 || '\\' != *_pos)
+                    return false;
+                c = _pos[1];
+                _pos += 2;
+                return true;
+            }
+
+            /* open, then one or more variable name characters, then close */
+            template <std::size_t open_n_, std::size_t close_n_>
+            bool consume_variable_name(const char (& open)[open_n_], const char (& close)[close_n_], std::string & var)
+            {
+                if (! lookahead(open))
+                    return false;
+                const char * const name_begin(_pos + open_n_ - 1);
+                const char * const name_end(skip(name_begin, variable_name_characters));
+                if (name_begin == name_end || ! matches_at(name_end, close, close_n_ - 1))
+                    return false;
+                var.assign(name_begin, name_end);
+                _pos = name_end + close_n_ - 1;
+                return true;
+            }
+    };
+
+    void parse_after_continuation(const ConfigFile::Source & sr, const ConfigFileScanner & parser, const bool recognise_comments)
     {
         if (parser.eof())
             throw ConfigFileError(sr.filename(), "EOF after continuation near line " + stringify(parser.current_line_number()));
-        else if (recognise_comments && parser.lookahead(*simple_parser::any_of(" \t") & simple_parser::exact("#")))
+        else if (recognise_comments && parser.lookahead_after_blanks('#'))
             throw ConfigFileError(sr.filename(),
                     "Comment not allowed immediately after after continuation near line " + stringify(parser.current_line_number()));
     }
@@ -189,35 +437,29 @@ LineConfigFile::LineConfigFile(const Source & sr, const LineConfigFileOptions &
 {
     Context context("When parsing line-based configuration file '" + (sr.filename().empty() ? "?" : sr.filename()) + "':");
 
-    SimpleParser parser(sr.text());
+    ConfigFileScanner parser(sr);
     while (! parser.eof())
     {
         /* is it a comment? */
         if (! _imp->options[lcfo_disallow_comments])
         {
-            if (parser.consume(*simple_parser::any_of(" \t") & simple_parser::exact("#") &
-                        *simple_parser::any_except("\n")))
+            if (parser.lookahead_after_blanks('#'))
             {
+                parser.consume_rest_of_line();
+
                 /* expect newline, but handle eof without final newline */
-                if (! parser.consume(simple_parser::exact("\n")))
+                if (! parser.consume('\n'))
                 {
-                    if (parser.eof())
-                    {
-                        Log::get_instance()->message("line_config_file.no_trailing_newline", ll_debug, lc_context)
-                            << "No newline at end of file";
-                        break;
-                    }
-                    else
-                        throw ConfigFileError(sr.filename(),
-                                "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                    Log::get_instance()->message("line_config_file.no_trailing_newline", ll_debug, lc_context)
+                        << "No newline at end of file";
+                    break;
                 }
                 continue;
             }
         }
 
         if (! _imp->options[lcfo_preserve_whitespace])
-            if (! parser.consume(*simple_parser::any_of(" \t")))
-                throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+            parser.consume_blanks();
 
         if (parser.eof())
         {
@@ -229,12 +471,12 @@ LineConfigFile::LineConfigFile(const Source & sr, const LineConfigFileOptions &
         /* is it a blank line? */
         if (! _imp->options[lcfo_no_skip_blank_lines])
         {
-            if (parser.consume(simple_parser::exact("\n")))
+            if (parser.consume('\n'))
                 continue;
         }
 
         /* normal line, or lines with continuation */
-        std::string line, word, space;
+        std::string line;
         bool need_single_space_unless_eol(false);
         while (true)
         {
@@ -244,54 +486,36 @@ LineConfigFile::LineConfigFile(const Source & sr, const LineConfigFileOptions &
                     << "No newline at end of file";
                 break;
             }
-            else if (parser.consume(+simple_parser::any_of(" \t") >> space))
+
+            Token space(parser.consume_blanks()), word;
+            if (! space.empty())
             {
                 if (_imp->options[lcfo_preserve_whitespace])
-                    line.append(space);
+                    line.append(space.begin, space.end);
                 else if (! line.empty())
                     need_single_space_unless_eol = true;
             }
-            else if (parser.consume(simple_parser::exact("\n") >> space))
+            else if (parser.consume('\n'))
                 break;
-            else if ((! _imp->options[lcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+            else if ((! _imp->options[lcfo_disallow_continuations]) && parser.consume("\\\n"))
             {
                 parse_after_continuation(sr, parser, ! _imp->options[lcfo_disallow_comments]);
             }
-            else if (parser.consume(simple_parser::exact("\\") >> word))
-            {
-                if (need_single_space_unless_eol)
-                {
-                    need_single_space_unless_eol = false;
-                    line.append(" ");
-                }
-                line.append(word);
-            }
-            else if ((! line.empty()) && (_imp->options[lcfo_allow_inline_comments]) && parser.consume(simple_parser::exact("#") &
-                        *simple_parser::any_except("\n")))
+            else if ((! line.empty()) && (_imp->options[lcfo_allow_inline_comments]) && parser.lookahead('#'))
             {
-                if (! parser.consume(simple_parser::exact("\n")))
-                    if (! parser.eof())
-                        throw ConfigFileError(sr.filename(),
-                                "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                parser.consume_rest_of_line();
+                parser.consume('\n');
                 break;
             }
-            else if (parser.consume(simple_parser::exact("#") >> word))
-            {
-                if (need_single_space_unless_eol)
-                {
-                    need_single_space_unless_eol = false;
-                    line.append(" ");
-                }
-                line.append(word);
-            }
-            else if (parser.consume(+simple_parser::any_except(" \t\n\\#") >> word))
+            /* a word, or a lone backslash or hash and whatever follows it */
+            else if (parser.consume_run(line_word_stops, word))
             {
                 if (need_single_space_unless_eol)
                 {
                     need_single_space_unless_eol = false;
                     line.append(" ");
                 }
-                line.append(word);
+                line.append(word.begin, word.end);
             }
             else
                 throw ConfigFileError(sr.filename(), "Unparsable text in line " + stringify(parser.current_line_number()));
@@ -341,26 +565,55 @@ namespace paludis
 
 namespace
 {
-    bool parse_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    bool parse_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
         PALUDIS_ATTRIBUTE((warn_unused_result));
-    bool parse_single_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    bool parse_single_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
         PALUDIS_ATTRIBUTE((warn_unused_result));
-    bool parse_double_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    bool parse_double_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
         PALUDIS_ATTRIBUTE((warn_unused_result));
-    bool parse_unquoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    bool parse_unquoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
         PALUDIS_ATTRIBUTE((warn_unused_result));
-    bool parse_variable(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & var, bool &)
+    bool parse_variable(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & var, bool &)
         PALUDIS_ATTRIBUTE((warn_unused_result));
 
-    bool parse_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    char unescape(const char c)
     {
-        if ((k.options()[kvcfo_allow_inline_comments] && parser.lookahead(simple_parser::exact("#"))))
+        switch (c)
+        {
+            case 'n':
+                return '\n';
+            case 't':
+                return '\t';
+            case 'e':
+                return '\033';
+            case 'a':
+                return '\007';
+        }
+
+        return c;
+    }
+
+    void append_variable(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
+    {
+        std::string var;
+        bool is_env;
+        if (! parse_variable(k, sr, parser, var, is_env))
+            throw ConfigFileError(sr.filename(), "Bad variable at line " + stringify(parser.current_line_number()));
+        if (is_env)
+            result.append(getenv_with_default(var, ""));
+        else
+            result.append(k.get(var));
+    }
+
+    bool parse_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
+    {
+        if ((k.options()[kvcfo_allow_inline_comments] && parser.lookahead('#')))
             return true;
 
-        if ((! k.options()[kvcfo_disallow_single_quoted_strings]) && parser.consume(simple_parser::exact("'")))
+        if ((! k.options()[kvcfo_disallow_single_quoted_strings]) && parser.consume('\''))
             return parse_single_quoted_value(k, sr, parser, result);
 
-        if ((! k.options()[kvcfo_disallow_double_quoted_strings]) && parser.consume(simple_parser::exact("\"")))
+        if ((! k.options()[kvcfo_disallow_double_quoted_strings]) && parser.consume('"'))
             return parse_double_quoted_value(k, sr, parser, result);
 
         if (! k.options()[kvcfo_disallow_unquoted_values])
@@ -369,31 +622,29 @@ namespace
         return false;
     }
 
-    bool parse_single_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    bool parse_single_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
     {
         while (true)
         {
             if (parser.eof())
                 throw ConfigFileError(sr.filename(), "Unterminated single quote at line " + stringify(parser.current_line_number()));
 
-            std::string s;
+            Token s;
 
-            if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+            if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume("\\\n"))
             {
                 parse_after_continuation(sr, parser, ! k.options()[kvcfo_disallow_comments]);
                 continue;
             }
-            else if ((! k.options()[kvcfo_ignore_single_quotes_inside_strings]) && parser.consume(simple_parser::exact("'")))
+            else if ((! k.options()[kvcfo_ignore_single_quotes_inside_strings]) && parser.consume('\''))
                 break;
-            else if ((k.options()[kvcfo_ignore_single_quotes_inside_strings]) && parser.lookahead(simple_parser::exact("'\n"))
-                    && parser.consume(simple_parser::exact("'")))
+            /* when ignoring quotes inside strings, only a quote at the end of a line ends the string */
+            else if ((k.options()[kvcfo_ignore_single_quotes_inside_strings])
+                    && (parser.lookahead("'\n") || (1 == parser.remaining() && parser.lookahead('\'')))
+                    && parser.consume('\''))
                 break;
-            else if ((k.options()[kvcfo_ignore_single_quotes_inside_strings]) && parser.lookahead(simple_parser::exact("'"))
-                    && ! parser.lookahead(simple_parser::exact("'") & simple_parser::any_except(""))
-                    && parser.consume(simple_parser::exact("'")))
-                break;
-            else if (parser.consume((simple_parser::any_except("") & *simple_parser::any_except("\\'")) >> s))
-                result.append(s);
+            else if (parser.consume_run(single_quoted_stops, s))
+                result.append(s.begin, s.end);
             else
                 throw ConfigFileError(sr.filename(), "Can't parse single quoted string at line " + stringify(parser.current_line_number()));
         }
@@ -401,45 +652,29 @@ namespace
         return true;
     }
 
-    bool parse_double_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    bool parse_double_quoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
     {
         while (true)
         {
             if (parser.eof())
                 throw ConfigFileError(sr.filename(), "Unterminated double quote at line " + stringify(parser.current_line_number()));
 
-            std::string s;
+            Token s;
+            char c;
 
-            if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+            if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume("\\\n"))
             {
                 parse_after_continuation(sr, parser, ! k.options()[kvcfo_disallow_comments]);
                 continue;
             }
-            else if (parser.consume(simple_parser::exact("\\t")))
-                result.append("\t");
-            else if (parser.consume(simple_parser::exact("\\n")))
-                result.append("\n");
-            else if (parser.consume(simple_parser::exact("\\e")))
-                result.append("\033");
-            else if (parser.consume(simple_parser::exact("\\a")))
-                result.append("\007");
-            else if (parser.consume(simple_parser::exact("\\") & simple_parser::any_except("") >> s))
-                result.append(s);
-            else if ((! k.options()[kvcfo_disallow_variables]) && parser.consume(simple_parser::exact("$")))
-            {
-                std::string var;
-                bool is_env;
-                if (! parse_variable(k, sr, parser, var, is_env))
-                    throw ConfigFileError(sr.filename(), "Bad variable at line " + stringify(parser.current_line_number()));
-                if (is_env)
-                    result.append(getenv_with_default(var, ""));
-                else
-                    result.append(k.get(var));
-            }
-            else if (parser.consume(simple_parser::exact("\"")))
+            else if (parser.consume_escape(c))
+                result.append(1, unescape(c));
+            else if ((! k.options()[kvcfo_disallow_variables]) && parser.consume('$'))
+                append_variable(k, sr, parser, result);
+            else if (parser.consume('"'))
                 break;
-            else if (parser.consume((simple_parser::any_except("") & *simple_parser::any_except("\\\"$\t\n")) >> s))
-                result.append(s);
+            else if (parser.consume_run(double_quoted_stops, s))
+                result.append(s.begin, s.end);
             else
                 throw ConfigFileError(sr.filename(), "Can't parse double quoted string at line " + stringify(parser.current_line_number()));
         }
@@ -447,44 +682,41 @@ namespace
         return true;
     }
 
-    bool parse_variable(const KeyValueConfigFile & k, const ConfigFile::Source &, SimpleParser & parser, std::string & var, bool & is_env)
+    bool parse_variable(const KeyValueConfigFile & k, const ConfigFile::Source &, ConfigFileScanner & parser, std::string & var, bool & is_env)
     {
-        const std::string var_name_chars(
-                "abcdefghijklmnopqrstuvwxyz"
-                "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                "0123456789_"
-                );
-
         if (k.options()[kvcfo_allow_env])
         {
             is_env = true;
 
-            if (parser.consume(simple_parser::exact("{ENV{") & +simple_parser::any_of(var_name_chars) >> var & simple_parser::exact("}}")))
+            if (parser.consume_variable_name("{ENV{", "}}", var))
                 return true;
-            if (parser.consume(simple_parser::exact("ENV{") & +simple_parser::any_of(var_name_chars) >> var & simple_parser::exact("}")))
+            if (parser.consume_variable_name("ENV{", "}", var))
                 return true;
         }
 
         is_env = false;
 
-        if (parser.consume(simple_parser::exact("{") & +simple_parser::any_of(var_name_chars) >> var & simple_parser::exact("}")))
+        if (parser.consume_variable_name("{", "}", var))
             return true;
 
-        if (parser.consume(+simple_parser::any_of(var_name_chars) >> var))
+        if (parser.consume_variable_name("", "", var))
             return true;
 
         return false;
     }
 
-    bool parse_unquoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+    bool parse_unquoted_value(const KeyValueConfigFile & k, const ConfigFile::Source & sr, ConfigFileScanner & parser, std::string & result)
     {
         bool need_single_space_unless_eol(false);
         while (true)
         {
-            std::string w;
-            if (parser.eof() || parser.lookahead(simple_parser::exact("\n")))
+            if (parser.eof() || parser.lookahead('\n'))
                 break;
-            else if (parser.consume(+simple_parser::any_of(" \t") >> w))
+
+            Token w(parser.consume_blanks());
+            char c;
+
+            if (! w.empty())
             {
                 if (k.options()[kvcfo_disallow_space_inside_unquoted_values])
                 {
@@ -495,66 +727,35 @@ namespace
                                 + stringify(parser.current_line_number()));
                 }
                 else if (k.options()[kvcfo_preserve_whitespace])
-                    result.append(w);
+                    result.append(w.begin, w.end);
                 else
                     need_single_space_unless_eol = true;
+
+                continue;
             }
-            else if ((k.options()[kvcfo_allow_inline_comments]) && parser.consume(simple_parser::exact("#")))
+            else if ((k.options()[kvcfo_allow_inline_comments]) && parser.consume('#'))
             {
-                if (! parser.consume(*simple_parser::any_except("\n")))
-                    throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+                parser.consume_rest_of_line();
                 break;
             }
-            else if ((! k.options()[kvcfo_disallow_variables]) && parser.consume(simple_parser::exact("$")))
-            {
-                if (need_single_space_unless_eol)
-                {
-                    result.append(" ");
-                    need_single_space_unless_eol = false;
-                }
-
-                std::string var;
-                bool is_env;
-                if (! parse_variable(k, sr, parser, var, is_env))
-                    throw ConfigFileError(sr.filename(), "Bad variable at line " + stringify(parser.current_line_number()));
-                if (is_env)
-                    result.append(getenv_with_default(var, ""));
-                else
-                    result.append(k.get(var));
-            }
-            else if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+            else if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume("\\\n"))
             {
                 parse_after_continuation(sr, parser, ! k.options()[kvcfo_disallow_comments]);
+                continue;
             }
-            else if (parser.consume(simple_parser::exact("\\") & simple_parser::any_except("") >> w))
-            {
-                if (need_single_space_unless_eol)
-                {
-                    result.append(" ");
-                    need_single_space_unless_eol = false;
-                }
 
-                if (w == "n")
-                    result.append("\n");
-                else if (w == "t")
-                    result.append("\t");
-                else if (w == "e")
-                    result.append("\033");
-                else if (w == "a")
-                    result.append("\007");
-                else
-                    result.append(w);
-            }
-            else if (parser.consume((simple_parser::any_except("") & *simple_parser::any_except("\\\"$#\n\t ")) >> w))
+            if (need_single_space_unless_eol)
             {
-                if (need_single_space_unless_eol)
-                {
-                    result.append(" ");
-                    need_single_space_unless_eol = false;
-                }
-
-                result.append(w);
+                result.append(" ");
+                need_single_space_unless_eol = false;
             }
+
+            if ((! k.options()[kvcfo_disallow_variables]) && parser.consume('$'))
+                append_variable(k, sr, parser, result);
+            else if (parser.consume_escape(c))
+                result.append(1, unescape(c));
+            else if (parser.consume_run(unquoted_stops, w))
+                result.append(w.begin, w.end);
             else
                 throw ConfigFileError(sr.filename(), "Can't parse unquoted string at line " + stringify(parser.current_line_number()));
         }
@@ -577,34 +778,28 @@ KeyValueConfigFile::KeyValueConfigFile(
 {
     Context context("When parsing key=value-based configuration file '" + (sr.filename().empty() ? "?" : sr.filename()) + "':");
 
-    SimpleParser parser(sr.text());
+    ConfigFileScanner parser(sr);
     while (! parser.eof())
     {
         /* is it a comment? */
         if (! _imp->options[kvcfo_disallow_comments])
         {
-            if (parser.consume(*simple_parser::any_of(" \t") & simple_parser::exact("#") &
-                        *simple_parser::any_except("\n")))
+            if (parser.lookahead_after_blanks('#'))
             {
+                parser.consume_rest_of_line();
+
                 /* expect newline, but handle eof without final newline */
-                if (! parser.consume(simple_parser::exact("\n")))
+                if (! parser.consume('\n'))
                 {
-                    if (parser.eof())
-                    {
-                        Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
-                            << "No newline at end of file";
-                        break;
-                    }
-                    else
-                        throw ConfigFileError(sr.filename(),
-                                "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                    Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
+                        << "No newline at end of file";
+                    break;
                 }
                 continue;
             }
         }
 
-        if (! parser.consume(*simple_parser::any_of(" \t")))
-            throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+        parser.consume_blanks();
 
         if (parser.eof())
         {
@@ -614,28 +809,11 @@ KeyValueConfigFile::KeyValueConfigFile(
         }
 
         /* is it a blank line? */
-        if (parser.consume(simple_parser::exact("\n")))
-            continue;
-
-        /* is it a comment? */
-        if ((! _imp->options[kvcfo_disallow_comments]) && parser.consume(simple_parser::exact("#") &
-                    *simple_parser::any_except("\n")))
-        {
-            if (! parser.consume(simple_parser::exact("\n")))
-            {
-                if (parser.eof())
-                    Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
-                        << "No newline at end of file";
-                else
-                    throw ConfigFileError(sr.filename(),
-                            "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
-            }
+        if (parser.consume('\n'))
             continue;
-        }
 
         /* is it a source command? */
-        if ((! _imp->options[kvcfo_disallow_source]) && parser.consume(simple_parser::exact("source") &
-                    +simple_parser::any_of(" \t")))
+        if ((! _imp->options[kvcfo_disallow_source]) && parser.consume_command("source"))
         {
             std::string filename;
             if (! parse_value(*this, sr, parser, filename))
@@ -644,16 +822,12 @@ KeyValueConfigFile::KeyValueConfigFile(
             if (filename.empty())
                 throw ConfigFileError(sr.filename(), "Empty filename for 'source' command in line " + stringify(parser.current_line_number()));
 
-            if (! parser.consume(*simple_parser::any_of(" \t")))
-                throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+            parser.consume_blanks();
 
-            if (_imp->options[kvcfo_allow_inline_comments] && parser.consume(simple_parser::exact("#") &
-                        *simple_parser::any_except("\n")))
-            {
-                /* skippity skippity */
-            }
+            if (_imp->options[kvcfo_allow_inline_comments] && parser.lookahead('#'))
+                parser.consume_rest_of_line();
 
-            if (! parser.consume(simple_parser::exact("\n")))
+            if (! parser.consume('\n'))
             {
                 if (parser.eof())
                     Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
@@ -674,66 +848,59 @@ KeyValueConfigFile::KeyValueConfigFile(
         }
 
         /* is it a section? */
-        if (_imp->options[kvcfo_allow_sections] && parser.consume(simple_parser::exact("[")))
+        if (_imp->options[kvcfo_allow_sections] && parser.consume('['))
         {
-            std::string sec_t, sec_s;
-            if (! parser.consume(+simple_parser::any_except(" \t\n$#\"'=\\]") >> sec_t))
+            Token sec_t{nullptr, nullptr}, sec_s{nullptr, nullptr};
+            if (! parser.consume_word(section_type_stops, sec_t))
                 throw ConfigFileError(sr.filename(), "Expected section name on line " + stringify(parser.current_line_number()));
 
-            if (! parser.consume(*simple_parser::any_of(" \t")))
-                throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+            parser.consume_blanks();
 
-            if (! parser.consume(simple_parser::exact("]")))
+            if (! parser.consume(']'))
             {
-                if (! parser.consume(+simple_parser::any_except(" \t\n$#\"\\]") >> sec_s))
+                if (! parser.consume_word(section_name_stops, sec_s))
                     throw ConfigFileError(sr.filename(), "Expected section name value on line "
                             + stringify(parser.current_line_number()));
-                if (! parser.consume(*simple_parser::any_of(" \t")))
-                    throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
-                if (! parser.consume(simple_parser::exact("]")))
+                parser.consume_blanks();
+                if (! parser.consume(']'))
                     throw ConfigFileError(sr.filename(), "Expected ] on line "
                             + stringify(parser.current_line_number()));
             }
 
-            if (! parser.consume(*simple_parser::any_of(" \t")))
-                throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
-            if (! parser.consume(*simple_parser::exact("\n")))
+            parser.consume_blanks();
+            while (parser.consume('\n'))
             {
-                if (parser.eof())
-                    Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
-                        << "No newline at end of file";
-                else
-                    throw ConfigFileError(sr.filename(), "Expected newline after ']' at line "
-                            + stringify(parser.current_line_number()) + "'");
             }
 
-            if (sec_s.empty())
-                _imp->active_key_prefix = sec_t + "/";
-            else
-                _imp->active_key_prefix = sec_t + "/" + sec_s + "/";
+            _imp->active_key_prefix.assign(sec_t.begin, sec_t.end);
+            _imp->active_key_prefix.append("/");
+            if (! sec_s.empty())
+            {
+                _imp->active_key_prefix.append(sec_s.begin, sec_s.end);
+                _imp->active_key_prefix.append("/");
+            }
 
             continue;
         }
 
         /* ignore export, if appropriate */
-        if (_imp->options[kvcfo_ignore_export] && parser.consume(simple_parser::exact("export") &
-                    +simple_parser::any_of(" \t")))
+        if (_imp->options[kvcfo_ignore_export] && parser.consume_command("export"))
         {
         }
 
         /* is it superman? */
-        std::string key, value;
+        Token key_name;
+        std::string value;
 
-        if (! parser.consume(+simple_parser::any_except(" \t\n$#\"'=\\?") >> key))
+        if (! parser.consume_word(key_stops, key_name))
             throw ConfigFileError(sr.filename(), "Couldn't find a key in line " + stringify(parser.current_line_number()));
 
         while (! parser.eof())
         {
             if (! _imp->options[kvcfo_disallow_space_around_equals])
-                if (! parser.consume(*simple_parser::any_of(" \t")))
-                    throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+                parser.consume_blanks();
 
-            if ((! _imp->options[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+            if ((! _imp->options[kvcfo_disallow_continuations]) && parser.consume("\\\n"))
             {
                 parse_after_continuation(sr, parser, ! _imp->options[kvcfo_disallow_comments]);
             }
@@ -742,9 +909,9 @@ KeyValueConfigFile::KeyValueConfigFile(
         }
 
         bool question_assign(false);
-        if (parser.consume(simple_parser::exact("?=")))
+        if (parser.consume("?="))
             question_assign = true;
-        else if (! parser.consume(simple_parser::exact("=")))
+        else if (! parser.consume('='))
             throw ConfigFileError(sr.filename(), "Expected an = at line " + stringify(parser.current_line_number()));
 
         if (question_assign && ! _imp->options[kvcfo_allow_fancy_assigns])
@@ -752,11 +919,11 @@ KeyValueConfigFile::KeyValueConfigFile(
 
         while (! parser.eof())
         {
-            if (parser.consume(+simple_parser::any_of(" \t")))
+            if (! parser.consume_blanks().empty())
                 if (_imp->options[kvcfo_disallow_space_around_equals])
                     throw ConfigFileError(sr.filename(), "Space not allowed after = at line " + stringify(parser.current_line_number()));
 
-            if ((! _imp->options[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+            if ((! _imp->options[kvcfo_disallow_continuations]) && parser.consume("\\\n"))
             {
                 parse_after_continuation(sr, parser, ! _imp->options[kvcfo_disallow_comments]);
             }
@@ -769,27 +936,20 @@ KeyValueConfigFile::KeyValueConfigFile(
 
         while (! parser.eof())
         {
-            std::string s;
-            if (parser.consume(+simple_parser::any_of(" \t") >> s))
-                if (_imp->options[kvcfo_preserve_whitespace])
-                    value += s;
+            Token s(parser.consume_blanks());
+            if (_imp->options[kvcfo_preserve_whitespace])
+                value.append(s.begin, s.end);
 
-            if ((_imp->options[kvcfo_allow_inline_comments]) && parser.consume(
-                        simple_parser::exact("#") & *simple_parser::any_except("\n")))
+            if ((_imp->options[kvcfo_allow_inline_comments]) && parser.lookahead('#'))
             {
-                if (! parser.consume(simple_parser::exact("\n")))
-                {
-                    if (parser.eof())
-                        Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
-                            << "No newline at end of file";
-                    else
-                        throw ConfigFileError(sr.filename(),
-                                "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
-                }
+                parser.consume_rest_of_line();
+                if (! parser.consume('\n'))
+                    Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
+                        << "No newline at end of file";
                 break;
             }
 
-            if ((! _imp->options[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+            if ((! _imp->options[kvcfo_disallow_continuations]) && parser.consume("\\\n"))
             {
                 parse_after_continuation(sr, parser, ! _imp->options[kvcfo_disallow_comments]);
             }
@@ -797,7 +957,8 @@ KeyValueConfigFile::KeyValueConfigFile(
                 break;
         }
 
-        key = _imp->active_key_prefix + key;
+        std::string key(_imp->active_key_prefix);
+        key.append(key_name.begin, key_name.end);
 
         bool want(true);
         if (question_assign && ! get(key).empty())
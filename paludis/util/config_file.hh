@@ -125,6 +125,20 @@ namespace paludis
                      */
                     const std::string & text() const PALUDIS_ATTRIBUTE((warn_unused_result));
 
+                    /**
+                     * Our text, as a pointer for the parser.
+                     *
+                     * \since 3.0
+                     */
+                    const char * data() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                    /**
+                     * The length of data().
+                     *
+                     * \since 3.0
+                     */
+                    std::size_t size() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
                     /**
                      * Our filename (may be empty), for use by ConfigFile.
                      */
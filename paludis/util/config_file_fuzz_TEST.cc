@@ -0,0 +1,897 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/config_file.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/is_file_with_extension.hh>
+#include <paludis/util/options.hh>
+#include <paludis/util/simple_parser.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/system.hh>
+#include <paludis/util/log.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+/* Checks the ConfigFile parsers against the SimpleParser based parsers they
+ * replaced, which are kept here, on every option combination we can think
+ * of and on lots of randomly generated text. */
+
+namespace
+{
+    namespace reference
+    {
+        class KeyValues
+        {
+            private:
+                const KeyValueConfigFileOptions _options;
+
+            public:
+                std::map<std::string, std::string> values;
+                std::string active_key_prefix;
+
+                KeyValues(const ConfigFile::Source &, const KeyValueConfigFileOptions &);
+
+                const KeyValueConfigFileOptions & options() const
+                {
+                    return _options;
+                }
+
+                std::string get(const std::string & s) const
+                {
+                    std::map<std::string, std::string>::const_iterator f(values.find(active_key_prefix + s));
+                    if (values.end() == f)
+                        f = values.find(s);
+
+                    if (values.end() == f)
+                        return "";
+                    else
+                        return f->second;
+                }
+        };
+
+        void parse_after_continuation(const ConfigFile::Source & sr, SimpleParser & parser, const bool recognise_comments)
+        {
+            if (parser.eof())
+                throw ConfigFileError(sr.filename(), "EOF after continuation near line " + stringify(parser.current_line_number()));
+            else if (recognise_comments && parser.lookahead(*simple_parser::any_of(" \t") & simple_parser::exact("#")))
+                throw ConfigFileError(sr.filename(),
+                        "Comment not allowed immediately after after continuation near line " + stringify(parser.current_line_number()));
+        }
+
+        std::list<std::string> line_config_file(const ConfigFile::Source & sr, const LineConfigFileOptions & o)
+        {
+            std::list<std::string> result;
+            Context context("When parsing line-based configuration file '" + (sr.filename().empty() ? "?" : sr.filename()) + "':");
+
+            SimpleParser parser(sr.text());
+            while (! parser.eof())
+            {
+                /* is it a comment? */
+                if (! o[lcfo_disallow_comments])
+                {
+                    if (parser.consume(*simple_parser::any_of(" \t") & simple_parser::exact("#") &
+                                *simple_parser::any_except("\n")))
+                    {
+                        /* expect newline, but handle eof without final newline */
+                        if (! parser.consume(simple_parser::exact("\n")))
+                        {
+                            if (parser.eof())
+                            {
+                                Log::get_instance()->message("line_config_file.no_trailing_newline", ll_debug, lc_context)
+                                    << "No newline at end of file";
+                                break;
+                            }
+                            else
+                                throw ConfigFileError(sr.filename(),
+                                        "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                        }
+                        continue;
+                    }
+                }
+
+                if (! o[lcfo_preserve_whitespace])
+                    if (! parser.consume(*simple_parser::any_of(" \t")))
+                        throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+
+                if (parser.eof())
+                {
+                    Log::get_instance()->message("line_config_file.no_trailing_newline", ll_debug, lc_context)
+                        << "No newline at end of file";
+                    break;
+                }
+
+                /* is it a blank line? */
+                if (! o[lcfo_no_skip_blank_lines])
+                {
+                    if (parser.consume(simple_parser::exact("\n")))
+                        continue;
+                }
+
+                /* normal line, or lines with continuation */
+                std::string line, word, space;
+                bool need_single_space_unless_eol(false);
+                while (true)
+                {
+                    if (parser.eof())
+                    {
+                        Log::get_instance()->message("line_config_file.no_trailing_newline", ll_debug, lc_context)
+                            << "No newline at end of file";
+                        break;
+                    }
+                    else if (parser.consume(+simple_parser::any_of(" \t") >> space))
+                    {
+                        if (o[lcfo_preserve_whitespace])
+                            line.append(space);
+                        else if (! line.empty())
+                            need_single_space_unless_eol = true;
+                    }
+                    else if (parser.consume(simple_parser::exact("\n") >> space))
+                        break;
+                    else if ((! o[lcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+                    {
+                        parse_after_continuation(sr, parser, ! o[lcfo_disallow_comments]);
+                    }
+                    else if (parser.consume(simple_parser::exact("\\") >> word))
+                    {
+                        if (need_single_space_unless_eol)
+                        {
+                            need_single_space_unless_eol = false;
+                            line.append(" ");
+                        }
+                        line.append(word);
+                    }
+                    else if ((! line.empty()) && (o[lcfo_allow_inline_comments]) && parser.consume(simple_parser::exact("#") &
+                                *simple_parser::any_except("\n")))
+                    {
+                        if (! parser.consume(simple_parser::exact("\n")))
+                            if (! parser.eof())
+                                throw ConfigFileError(sr.filename(),
+                                        "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                        break;
+                    }
+                    else if (parser.consume(simple_parser::exact("#") >> word))
+                    {
+                        if (need_single_space_unless_eol)
+                        {
+                            need_single_space_unless_eol = false;
+                            line.append(" ");
+                        }
+                        line.append(word);
+                    }
+                    else if (parser.consume(+simple_parser::any_except(" \t\n\\#") >> word))
+                    {
+                        if (need_single_space_unless_eol)
+                        {
+                            need_single_space_unless_eol = false;
+                            line.append(" ");
+                        }
+                        line.append(word);
+                    }
+                    else
+                        throw ConfigFileError(sr.filename(), "Unparsable text in line " + stringify(parser.current_line_number()));
+                }
+                result.push_back(line);
+            }
+
+            return result;
+        }
+
+        bool parse_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+            PALUDIS_ATTRIBUTE((warn_unused_result));
+        bool parse_single_quoted_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+            PALUDIS_ATTRIBUTE((warn_unused_result));
+        bool parse_double_quoted_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+            PALUDIS_ATTRIBUTE((warn_unused_result));
+        bool parse_unquoted_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+            PALUDIS_ATTRIBUTE((warn_unused_result));
+        bool parse_variable(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & var, bool &)
+            PALUDIS_ATTRIBUTE((warn_unused_result));
+
+        bool parse_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+        {
+            if ((k.options()[kvcfo_allow_inline_comments] && parser.lookahead(simple_parser::exact("#"))))
+                return true;
+
+            if ((! k.options()[kvcfo_disallow_single_quoted_strings]) && parser.consume(simple_parser::exact("'")))
+                return parse_single_quoted_value(k, sr, parser, result);
+
+            if ((! k.options()[kvcfo_disallow_double_quoted_strings]) && parser.consume(simple_parser::exact("\"")))
+                return parse_double_quoted_value(k, sr, parser, result);
+
+            if (! k.options()[kvcfo_disallow_unquoted_values])
+                return parse_unquoted_value(k, sr, parser, result);
+
+            return false;
+        }
+
+        bool parse_single_quoted_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+        {
+            while (true)
+            {
+                if (parser.eof())
+                    throw ConfigFileError(sr.filename(), "Unterminated single quote at line " + stringify(parser.current_line_number()));
+
+                std::string s;
+
+                if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+                {
+                    parse_after_continuation(sr, parser, ! k.options()[kvcfo_disallow_comments]);
+                    continue;
+                }
+                else if ((! k.options()[kvcfo_ignore_single_quotes_inside_strings]) && parser.consume(simple_parser::exact("'")))
+                    break;
+                else if ((k.options()[kvcfo_ignore_single_quotes_inside_strings]) && parser.lookahead(simple_parser::exact("'\n"))
+                        && parser.consume(simple_parser::exact("'")))
+                    break;
+                else if ((k.options()[kvcfo_ignore_single_quotes_inside_strings]) && parser.lookahead(simple_parser::exact("'"))
+                        && ! parser.lookahead(simple_parser::exact("'") & simple_parser::any_except(""))
+                        && parser.consume(simple_parser::exact("'")))
+                    break;
+                else if (parser.consume((simple_parser::any_except("") & *simple_parser::any_except("\\'")) >> s))
+                    result.append(s);
+                else
+                    throw ConfigFileError(sr.filename(), "Can't parse single quoted string at line " + stringify(parser.current_line_number()));
+            }
+
+            return true;
+        }
+
+        bool parse_double_quoted_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+        {
+            while (true)
+            {
+                if (parser.eof())
+                    throw ConfigFileError(sr.filename(), "Unterminated double quote at line " + stringify(parser.current_line_number()));
+
+                std::string s;
+
+                if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+                {
+                    parse_after_continuation(sr, parser, ! k.options()[kvcfo_disallow_comments]);
+                    continue;
+                }
+                else if (parser.consume(simple_parser::exact("\\t")))
+                    result.append("\t");
+                else if (parser.consume(simple_parser::exact("\\n")))
+                    result.append("\n");
+                else if (parser.consume(simple_parser::exact("\\e")))
+                    result.append("\033");
+                else if (parser.consume(simple_parser::exact("\\a")))
+                    result.append("\007");
+                else if (parser.consume(simple_parser::exact("\\") & simple_parser::any_except("") >> s))
+                    result.append(s);
+                else if ((! k.options()[kvcfo_disallow_variables]) && parser.consume(simple_parser::exact("$")))
+                {
+                    std::string var;
+                    bool is_env;
+                    if (! parse_variable(k, sr, parser, var, is_env))
+                        throw ConfigFileError(sr.filename(), "Bad variable at line " + stringify(parser.current_line_number()));
+                    if (is_env)
+                        result.append(getenv_with_default(var, ""));
+                    else
+                        result.append(k.get(var));
+                }
+                else if (parser.consume(simple_parser::exact("\"")))
+                    break;
+                else if (parser.consume((simple_parser::any_except("") & *simple_parser::any_except("\\\"$\t\n")) >> s))
+                    result.append(s);
+                else
+                    throw ConfigFileError(sr.filename(), "Can't parse double quoted string at line " + stringify(parser.current_line_number()));
+            }
+
+            return true;
+        }
+
+        bool parse_variable(const KeyValues & k, const ConfigFile::Source &, SimpleParser & parser, std::string & var, bool & is_env)
+        {
+            const std::string var_name_chars(
+                    "abcdefghijklmnopqrstuvwxyz"
+                    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                    "0123456789_"
+                    );
+
+            if (k.options()[kvcfo_allow_env])
+            {
+                is_env = true;
+
+                if (parser.consume(simple_parser::exact("{ENV{") & +simple_parser::any_of(var_name_chars) >> var & simple_parser::exact("}}")))
+                    return true;
+                if (parser.consume(simple_parser::exact("ENV{") & +simple_parser::any_of(var_name_chars) >> var & simple_parser::exact("}")))
+                    return true;
+            }
+
+            is_env = false;
+
+            if (parser.consume(simple_parser::exact("{") & +simple_parser::any_of(var_name_chars) >> var & simple_parser::exact("}")))
+                return true;
+
+            if (parser.consume(+simple_parser::any_of(var_name_chars) >> var))
+                return true;
+
+            return false;
+        }
+
+        bool parse_unquoted_value(const KeyValues & k, const ConfigFile::Source & sr, SimpleParser & parser, std::string & result)
+        {
+            bool need_single_space_unless_eol(false);
+            while (true)
+            {
+                std::string w;
+                if (parser.eof() || parser.lookahead(simple_parser::exact("\n")))
+                    break;
+                else if (parser.consume(+simple_parser::any_of(" \t") >> w))
+                {
+                    if (k.options()[kvcfo_disallow_space_inside_unquoted_values])
+                    {
+                        if (k.options()[kvcfo_allow_multiple_assigns_per_line])
+                            break;
+                        else
+                            throw ConfigFileError(sr.filename(), "Not allowed space inside unquoted values at line "
+                                    + stringify(parser.current_line_number()));
+                    }
+                    else if (k.options()[kvcfo_preserve_whitespace])
+                        result.append(w);
+                    else
+                        need_single_space_unless_eol = true;
+                }
+                else if ((k.options()[kvcfo_allow_inline_comments]) && parser.consume(simple_parser::exact("#")))
+                {
+                    if (! parser.consume(*simple_parser::any_except("\n")))
+                        throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+                    break;
+                }
+                else if ((! k.options()[kvcfo_disallow_variables]) && parser.consume(simple_parser::exact("$")))
+                {
+                    if (need_single_space_unless_eol)
+                    {
+                        result.append(" ");
+                        need_single_space_unless_eol = false;
+                    }
+
+                    std::string var;
+                    bool is_env;
+                    if (! parse_variable(k, sr, parser, var, is_env))
+                        throw ConfigFileError(sr.filename(), "Bad variable at line " + stringify(parser.current_line_number()));
+                    if (is_env)
+                        result.append(getenv_with_default(var, ""));
+                    else
+                        result.append(k.get(var));
+                }
+                else if ((! k.options()[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+                {
+                    parse_after_continuation(sr, parser, ! k.options()[kvcfo_disallow_comments]);
+                }
+                else if (parser.consume(simple_parser::exact("\\") & simple_parser::any_except("") >> w))
+                {
+                    if (need_single_space_unless_eol)
+                    {
+                        result.append(" ");
+                        need_single_space_unless_eol = false;
+                    }
+
+                    if (w == "n")
+                        result.append("\n");
+                    else if (w == "t")
+                        result.append("\t");
+                    else if (w == "e")
+                        result.append("\033");
+                    else if (w == "a")
+                        result.append("\007");
+                    else
+                        result.append(w);
+                }
+                else if (parser.consume((simple_parser::any_except("") & *simple_parser::any_except("\\\"$#\n\t ")) >> w))
+                {
+                    if (need_single_space_unless_eol)
+                    {
+                        result.append(" ");
+                        need_single_space_unless_eol = false;
+                    }
+
+                    result.append(w);
+                }
+                else
+                    throw ConfigFileError(sr.filename(), "Can't parse unquoted string at line " + stringify(parser.current_line_number()));
+            }
+
+            return true;
+        }
+
+        KeyValues::KeyValues(const ConfigFile::Source & sr, const KeyValueConfigFileOptions & o) :
+            _options(o)
+        {
+            Context context("When parsing key=value-based configuration file '" + (sr.filename().empty() ? "?" : sr.filename()) + "':");
+
+            SimpleParser parser(sr.text());
+            while (! parser.eof())
+            {
+                /* is it a comment? */
+                if (! _options[kvcfo_disallow_comments])
+                {
+                    if (parser.consume(*simple_parser::any_of(" \t") & simple_parser::exact("#") &
+                                *simple_parser::any_except("\n")))
+                    {
+                        /* expect newline, but handle eof without final newline */
+                        if (! parser.consume(simple_parser::exact("\n")))
+                        {
+                            if (parser.eof())
+                            {
+                                Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
+                                    << "No newline at end of file";
+                                break;
+                            }
+                            else
+                                throw ConfigFileError(sr.filename(),
+                                        "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                        }
+                        continue;
+                    }
+                }
+
+                if (! parser.consume(*simple_parser::any_of(" \t")))
+                    throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+
+                if (parser.eof())
+                {
+                    Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
+                        << "No newline at end of file";
+                    break;
+                }
+
+                /* is it a blank line? */
+                if (parser.consume(simple_parser::exact("\n")))
+                    continue;
+
+                /* is it a comment? */
+                if ((! _options[kvcfo_disallow_comments]) && parser.consume(simple_parser::exact("#") &
+                            *simple_parser::any_except("\n")))
+                {
+                    if (! parser.consume(simple_parser::exact("\n")))
+                    {
+                        if (parser.eof())
+                            Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
+                                << "No newline at end of file";
+                        else
+                            throw ConfigFileError(sr.filename(),
+                                    "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                    }
+                    continue;
+                }
+
+                /* is it a section? */
+                if (_options[kvcfo_allow_sections] && parser.consume(simple_parser::exact("[")))
+                {
+                    std::string sec_t, sec_s;
+                    if (! parser.consume(+simple_parser::any_except(" \t\n$#\"'=\\]") >> sec_t))
+                        throw ConfigFileError(sr.filename(), "Expected section name on line " + stringify(parser.current_line_number()));
+
+                    if (! parser.consume(*simple_parser::any_of(" \t")))
+                        throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+
+                    if (! parser.consume(simple_parser::exact("]")))
+                    {
+                        if (! parser.consume(+simple_parser::any_except(" \t\n$#\"\\]") >> sec_s))
+                            throw ConfigFileError(sr.filename(), "Expected section name value on line "
+                                    + stringify(parser.current_line_number()));
+                        if (! parser.consume(*simple_parser::any_of(" \t")))
+                            throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+                        if (! parser.consume(simple_parser::exact("]")))
+                            throw ConfigFileError(sr.filename(), "Expected ] on line "
+                                    + stringify(parser.current_line_number()));
+                    }
+
+                    if (! parser.consume(*simple_parser::any_of(" \t")))
+                        throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+                    if (! parser.consume(*simple_parser::exact("\n")))
+                    {
+                        if (parser.eof())
+                            Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
+                                << "No newline at end of file";
+                        else
+                            throw ConfigFileError(sr.filename(), "Expected newline after ']' at line "
+                                    + stringify(parser.current_line_number()) + "'");
+                    }
+
+                    if (sec_s.empty())
+                        active_key_prefix = sec_t + "/";
+                    else
+                        active_key_prefix = sec_t + "/" + sec_s + "/";
+
+                    continue;
+                }
+
+                /* ignore export, if appropriate */
+                if (_options[kvcfo_ignore_export] && parser.consume(simple_parser::exact("export") &
+                            +simple_parser::any_of(" \t")))
+                {
+                }
+
+                /* is it superman? */
+                std::string key, value;
+
+                if (! parser.consume(+simple_parser::any_except(" \t\n$#\"'=\\?") >> key))
+                    throw ConfigFileError(sr.filename(), "Couldn't find a key in line " + stringify(parser.current_line_number()));
+
+                while (! parser.eof())
+                {
+                    if (! _options[kvcfo_disallow_space_around_equals])
+                        if (! parser.consume(*simple_parser::any_of(" \t")))
+                            throw InternalError(PALUDIS_HERE, "failed to consume a zero width match");
+
+                    if ((! _options[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+                    {
+                        parse_after_continuation(sr, parser, ! _options[kvcfo_disallow_comments]);
+                    }
+                    else
+                        break;
+                }
+
+                bool question_assign(false);
+                if (parser.consume(simple_parser::exact("?=")))
+                    question_assign = true;
+                else if (! parser.consume(simple_parser::exact("=")))
+                    throw ConfigFileError(sr.filename(), "Expected an = at line " + stringify(parser.current_line_number()));
+
+                if (question_assign && ! _options[kvcfo_allow_fancy_assigns])
+                    throw ConfigFileError(sr.filename(), "Not allowed to use ?= on line " + stringify(parser.current_line_number()));
+
+                while (! parser.eof())
+                {
+                    if (parser.consume(+simple_parser::any_of(" \t")))
+                        if (_options[kvcfo_disallow_space_around_equals])
+                            throw ConfigFileError(sr.filename(), "Space not allowed after = at line " + stringify(parser.current_line_number()));
+
+                    if ((! _options[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+                    {
+                        parse_after_continuation(sr, parser, ! _options[kvcfo_disallow_comments]);
+                    }
+                    else
+                        break;
+                }
+
+                if (! parse_value(*this, sr, parser, value))
+                    throw ConfigFileError(sr.filename(), "Couldn't find a value at line " + stringify(parser.current_line_number()));
+
+                while (! parser.eof())
+                {
+                    std::string s;
+                    if (parser.consume(+simple_parser::any_of(" \t") >> s))
+                        if (_options[kvcfo_preserve_whitespace])
+                            value += s;
+
+                    if ((_options[kvcfo_allow_inline_comments]) && parser.consume(
+                                simple_parser::exact("#") & *simple_parser::any_except("\n")))
+                    {
+                        if (! parser.consume(simple_parser::exact("\n")))
+                        {
+                            if (parser.eof())
+                                Log::get_instance()->message("key_value_config_file.no_trailing_newline", ll_debug, lc_context)
+                                    << "No newline at end of file";
+                            else
+                                throw ConfigFileError(sr.filename(),
+                                        "Something is very strange at line '" + stringify(parser.current_line_number()) + "'");
+                        }
+                        break;
+                    }
+
+                    if ((! _options[kvcfo_disallow_continuations]) && parser.consume(simple_parser::exact("\\\n")))
+                    {
+                        parse_after_continuation(sr, parser, ! _options[kvcfo_disallow_comments]);
+                    }
+                    else
+                        break;
+                }
+
+                key = active_key_prefix + key;
+
+                bool want(true);
+                if (question_assign && ! get(key).empty())
+                    want = false;
+
+                if (want)
+                {
+                    values[key] = value;
+                }
+            }
+
+            active_key_prefix = "";
+        }
+    }
+}
+
+namespace
+{
+    struct Outcome
+    {
+        std::string error;
+        std::list<std::string> lines;
+        std::map<std::string, std::string> values;
+    };
+
+    template <typename E_>
+    std::string describe(const Options<E_> & o, const E_ last)
+    {
+        std::string result;
+        for (int i(0) ; i != last ; ++i)
+            if (o[static_cast<E_>(i)])
+                result.append((result.empty() ? "" : " ") + stringify(static_cast<E_>(i)));
+        return result;
+    }
+
+    Outcome reference_lines(const ConfigFile::Source & sr, const LineConfigFileOptions & o)
+    {
+        Outcome result;
+        try
+        {
+            result.lines = reference::line_config_file(sr, o);
+        }
+        catch (const ConfigFileError & e)
+        {
+            result.error = e.message();
+        }
+        return result;
+    }
+
+    Outcome current_lines(const ConfigFile::Source & sr, const LineConfigFileOptions & o)
+    {
+        Outcome result;
+        try
+        {
+            LineConfigFile f(sr, o);
+            result.lines.assign(f.begin(), f.end());
+        }
+        catch (const ConfigFileError & e)
+        {
+            result.error = e.message();
+        }
+        return result;
+    }
+
+    Outcome reference_values(const ConfigFile::Source & sr, const KeyValueConfigFileOptions & o)
+    {
+        Outcome result;
+        try
+        {
+            reference::KeyValues f(sr, o);
+            result.values = f.values;
+        }
+        catch (const ConfigFileError & e)
+        {
+            result.error = e.message();
+        }
+        return result;
+    }
+
+    Outcome current_values(const ConfigFile::Source & sr, const KeyValueConfigFileOptions & o)
+    {
+        Outcome result;
+        try
+        {
+            KeyValueConfigFile f(sr, o, &KeyValueConfigFile::no_defaults, &KeyValueConfigFile::no_transformation);
+            result.values.insert(f.begin(), f.end());
+        }
+        catch (const ConfigFileError & e)
+        {
+            result.error = e.message();
+        }
+        return result;
+    }
+
+    void check_lines(const ConfigFile::Source & sr, const LineConfigFileOptions & o)
+    {
+        SCOPED_TRACE("text '" + sr.text() + "', options '" + describe(o, last_lcfo) + "'");
+
+        Outcome expected(reference_lines(sr, o)), got(current_lines(sr, o));
+        EXPECT_EQ(expected.error, got.error);
+        EXPECT_EQ(expected.lines, got.lines);
+    }
+
+    void check_values(const ConfigFile::Source & sr, const KeyValueConfigFileOptions & o)
+    {
+        SCOPED_TRACE("text '" + sr.text() + "', options '" + describe(o, last_kvcfo) + "'");
+
+        Outcome expected(reference_values(sr, o)), got(current_values(sr, o));
+        EXPECT_EQ(expected.error, got.error);
+        EXPECT_EQ(expected.values, got.values);
+    }
+
+    template <typename E_>
+    std::vector<Options<E_> > interesting_options(const E_ last)
+    {
+        std::vector<Options<E_> > result;
+        result.push_back(Options<E_>());
+        for (int i(0) ; i != last ; ++i)
+            result.push_back(Options<E_>() + static_cast<E_>(i));
+
+        Options<E_> all;
+        for (int i(0) ; i != last ; ++i)
+            all += static_cast<E_>(i);
+        result.push_back(all);
+
+        return result;
+    }
+
+    template <typename E_>
+    Options<E_> random_options(std::mt19937 & rng, const E_ last)
+    {
+        std::uniform_int_distribution<int> bit(0, 1);
+        Options<E_> result;
+        for (int i(0) ; i != last ; ++i)
+            if (bit(rng))
+                result += static_cast<E_>(i);
+        return result;
+    }
+
+    /* the reference parser can't follow source commands without a file to read */
+    KeyValueConfigFileOptions without_source(const KeyValueConfigFileOptions & o)
+    {
+        return o + kvcfo_disallow_source;
+    }
+
+    const std::vector<std::string> samples = {
+        "",
+        "\n",
+        "one\n  two    \t  \n   \t  \n\nthree\n# blah\n  # blah\n#\n  #  \t  \nfour  four\nfive \\\nsix\nseven\\\neight\nnine # ten\n",
+        "no trailing newline",
+        "a \\\n# comment after continuation\n",
+        "trailing continuation \\\n",
+        "a = b\n",
+        "a=b\nb=\"$a c\"\nc='$a d'\nd=${b}e\n",
+        "a='one\\\ntwo'\nb=\"one\\\ntwo\"\nc=one\\\ntwo\n",
+        "a=\"\\t\\n\\e\\a\\q\\\\\"\nb=x\\ty\\n\\q\n",
+        "a=\"unterminated\n",
+        "a='unterminated\n",
+        "a=\"$\"\n",
+        "a=$ENV{CONFIG_FILE_FUZZ_TEST} b=${ENV{CONFIG_FILE_FUZZ_TEST}}\n",
+        "a='b' c='d' e=f g=h\n",
+        "a=b c\n",
+        "a = b  \nc=\"d\"  # comment\ne=#\n",
+        "[section]\na=1\n[section name]\nb=$a\n[]\n",
+        "[section\n",
+        "[section name\n",
+        "export a=b\nexportb=c\n",
+        "a?=b\na?=c\nb?=d\n",
+        "a == b\n",
+        "=b\n",
+        "a b\n",
+        "libtool='it's a 'test''\nb='x'\n",
+        "a='b'y'\n",
+        "a=\"b\" c\n",
+        "source\n",
+        "a=b\\",
+        "a=\"b\\",
+        "a=b#c\n",
+        "\t  a\t=\t'b'\t\n",
+        "a=\\\n\\\n\\\nb\n"
+    };
+
+    const std::vector<std::string> pieces = {
+        "a", "b", "FOO", "x_1", " ", "  ", "\t", "\n", "\n\n", "=", "?=", "'", "\"", "\\", "\\\n",
+        "\\n", "\\t", "\\e", "\\a", "\\'", "\\\"", "$", "${", "{", "}", "$FOO", "${a}", "$a",
+        "$ENV{CONFIG_FILE_FUZZ_TEST}", "${ENV{CONFIG_FILE_FUZZ_TEST}}", "#", " # c", "[", "]", "[s]",
+        "[s t]", "export ", "source ", "a=b\n", "FOO='x y'\n", "b=\"$a\"\n", "\r", "\xff"
+    };
+
+    std::string random_text(std::mt19937 & rng)
+    {
+        std::uniform_int_distribution<int> length(0, 24);
+        std::uniform_int_distribution<std::size_t> piece(0, pieces.size() - 1);
+
+        std::string result;
+        for (int n(length(rng)) ; n > 0 ; --n)
+            result.append(pieces[piece(rng)]);
+        return result;
+    }
+
+    std::string random_bytes(std::mt19937 & rng)
+    {
+        std::uniform_int_distribution<int> length(0, 64), byte(0, 255);
+
+        std::string result;
+        for (int n(length(rng)) ; n > 0 ; --n)
+            result.append(1, static_cast<char>(byte(rng)));
+        return result;
+    }
+
+    struct ConfigFileDifferentialTest :
+        testing::Test
+    {
+        void SetUp() override
+        {
+            ::setenv("CONFIG_FILE_FUZZ_TEST", "from the environment", 1);
+        }
+    };
+}
+
+TEST_F(ConfigFileDifferentialTest, Samples)
+{
+    for (const auto & text : samples)
+    {
+        for (const auto & o : interesting_options(last_lcfo))
+            check_lines(ConfigFile::Source(text), o);
+        for (const auto & o : interesting_options(last_kvcfo))
+            check_values(ConfigFile::Source(text), without_source(o));
+    }
+}
+
+TEST_F(ConfigFileDifferentialTest, Random)
+{
+    std::mt19937 rng(0x5eed);
+    for (int n(0) ; n != 20000 && ! HasFailure() ; ++n)
+    {
+        std::string text(random_text(rng));
+        check_lines(ConfigFile::Source(text), random_options(rng, last_lcfo));
+        check_values(ConfigFile::Source(text), without_source(random_options(rng, last_kvcfo)));
+    }
+}
+
+TEST_F(ConfigFileDifferentialTest, RandomBytes)
+{
+    std::mt19937 rng(0xb17e5);
+    for (int n(0) ; n != 5000 && ! HasFailure() ; ++n)
+    {
+        std::string text(random_bytes(rng));
+        check_lines(ConfigFile::Source(text), random_options(rng, last_lcfo));
+        check_values(ConfigFile::Source(text), without_source(random_options(rng, last_kvcfo)));
+    }
+}
+
+TEST_F(ConfigFileDifferentialTest, Files)
+{
+    std::vector<FSPath> dirs;
+    for (const auto & v : { "PALUDIS_EAPIS_DIR", "PALUDIS_DISTRIBUTIONS_DIR" })
+        if (! getenv_with_default(v, "").empty())
+            dirs.push_back(FSPath(getenv_with_default(v, "")));
+
+    int files(0);
+    for (const auto & d : dirs)
+        for (FSIterator f(d, { }), f_end ; f != f_end ; ++f)
+        {
+            if (! is_file_with_extension(*f, ".conf", { }))
+                continue;
+
+            ++files;
+
+            /* a file should parse exactly as its text does */
+            ConfigFile::Source from_file(*f), copied(std::string(ConfigFile::Source(*f).text()));
+            for (const auto & o : interesting_options(last_kvcfo))
+            {
+                check_values(from_file, without_source(o));
+
+                Outcome m(current_values(from_file, without_source(o))), c(current_values(copied, without_source(o)));
+                EXPECT_EQ(c.error.empty() ? "" : "In file '" + stringify(*f) + "': " + c.error, m.error);
+                EXPECT_EQ(c.values, m.values);
+            }
+        }
+
+    EXPECT_TRUE(dirs.empty() || files > 0);
+}
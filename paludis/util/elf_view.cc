@@ -0,0 +1,393 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/util/elf_view.hh>
+#include <paludis/util/elf_types.hh>
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/byte_swap.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/stringify.hh>
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <string>
+
+using namespace paludis;
+
+namespace paludis
+{
+    template <typename ElfType_>
+    struct Imp<ElfView<ElfType_> >
+    {
+        const char * const data;
+        std::istream * const stream;
+        const std::size_t size;
+        bool need_byte_swap;
+        unsigned int number_of_sections;
+        unsigned int shstrndx;
+
+        Imp(const MappedFile & f) :
+            data(static_cast<const char *>(f.data())),
+            stream(nullptr),
+            size(f.size()),
+            need_byte_swap(false),
+            number_of_sections(0),
+            shstrndx(0)
+        {
+        }
+
+        Imp(std::istream & s) :
+            data(nullptr),
+            stream(&s),
+            size(stream_size(s)),
+            need_byte_swap(false),
+            number_of_sections(0),
+            shstrndx(0)
+        {
+        }
+
+        static std::size_t stream_size(std::istream & s)
+        {
+            s.clear();
+            s.seekg(0, std::ios::end);
+            std::streamoff result(s.tellg());
+            return result < 0 ? 0 : result;
+        }
+
+        /* we only ever read what is asked for from a stream, so a file
+         * which is truncated under us gives a short read rather than the
+         * SIGBUS it would give a mapping */
+        void copy_out(std::size_t offset, char * out, std::size_t n) const
+        {
+            if (! stream)
+            {
+                std::memcpy(out, data + offset, n);
+                return;
+            }
+
+            stream->clear();
+            stream->seekg(offset, std::ios::beg);
+            stream->read(out, n);
+            if (std::size_t(stream->gcount()) != n)
+                throw InvalidElfFileError("could not read " + stringify(n) + " bytes at offset " + stringify(offset));
+        }
+
+        /* the mapping is page aligned, but offsets in broken files needn't
+         * be, so copy each structure out rather than casting in place */
+        template <typename T_>
+        T_ read(std::size_t offset, const std::string & what) const
+        {
+            if (offset > size || size - offset < sizeof(T_))
+                throw InvalidElfFileError(what + " at offset " + stringify(offset) + " is past the end of the file");
+
+            T_ result;
+            copy_out(offset, reinterpret_cast<char *>(&result), sizeof(T_));
+            return result;
+        }
+
+        template <typename T_>
+        T_ swap(T_ x) const
+        {
+            return need_byte_swap ? byte_swap(x) : x;
+        }
+
+        std::string read_string(const typename ElfType_::SectionHeader & strtab, typename ElfType_::Word index) const
+        {
+            if (index >= strtab.sh_size || strtab.sh_offset > size || strtab.sh_size > size - strtab.sh_offset)
+                throw InvalidElfFileError("string index " + stringify(index) + " is out of range");
+
+            const std::size_t start(strtab.sh_offset + index);
+            const std::size_t max(strtab.sh_size - index);
+
+            if (! stream)
+                return std::string(data + start, ::strnlen(data + start, max));
+
+            std::string result;
+            char buf[256];
+            for (std::size_t done(0) ; done < max ; )
+            {
+                std::size_t n(std::min(sizeof(buf), max - done));
+                copy_out(start + done, buf, n);
+                std::size_t len(::strnlen(buf, n));
+                result.append(buf, len);
+                if (len != n)
+                    break;
+                done += n;
+            }
+            return result;
+        }
+    };
+}
+
+namespace
+{
+    enum {
+        native_byte_order =
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        ELFDATA2MSB
+#else
+        ELFDATA2LSB
+#endif
+    };
+}
+
+namespace
+{
+    template <typename ElfType_>
+    bool is_valid_ident(const unsigned char * const ident)
+    {
+        // Check the magic \177ELF bytes
+        if ( ! (    (   ident[EI_MAG0] == ELFMAG0)
+                    && (ident[EI_MAG1] == ELFMAG1)
+                    && (ident[EI_MAG2] == ELFMAG2)
+                    && (ident[EI_MAG3] == ELFMAG3)
+                    ) )
+            return false;
+
+        // Check the ELF file version
+        if (ident[EI_VERSION] != EV_CURRENT)
+            return false;
+
+        // Check whether the endianness is valid
+        if ((ident[EI_DATA] != ELFDATA2LSB) && (ident[EI_DATA] != ELFDATA2MSB))
+            return false;
+
+        return (ident[EI_CLASS] == ElfType_::elf_class);
+    }
+}
+
+template <typename ElfType_>
+bool
+ElfView<ElfType_>::is_valid_elf(const MappedFile & f)
+{
+    if (f.size() < EI_NIDENT)
+        return false;
+
+    return is_valid_ident<ElfType_>(reinterpret_cast<const unsigned char *>(f.data()));
+}
+
+template <typename ElfType_>
+bool
+ElfView<ElfType_>::is_valid_elf(std::istream & s)
+{
+    unsigned char ident[EI_NIDENT];
+    s.clear();
+    s.seekg(0, std::ios::beg);
+    if (! s.read(reinterpret_cast<char *>(ident), EI_NIDENT))
+        return false;
+
+    return is_valid_ident<ElfType_>(ident);
+}
+
+template <typename ElfType_>
+ElfView<ElfType_>::ElfView(const MappedFile & f) :
+    _imp(f)
+{
+    _read_header();
+}
+
+template <typename ElfType_>
+ElfView<ElfType_>::ElfView(std::istream & s) :
+    _imp(s)
+{
+    _read_header();
+}
+
+template <typename ElfType_>
+void
+ElfView<ElfType_>::_read_header()
+{
+    _hdr = _imp->template read<typename ElfType_::Header>(0, "ELF header");
+    _imp->need_byte_swap = _hdr.e_ident[EI_DATA] != native_byte_order;
+
+    _hdr.e_type      = _imp->swap(_hdr.e_type);
+    _hdr.e_machine   = _imp->swap(_hdr.e_machine);
+    _hdr.e_version   = _imp->swap(_hdr.e_version);
+    _hdr.e_entry     = _imp->swap(_hdr.e_entry);
+    _hdr.e_phoff     = _imp->swap(_hdr.e_phoff);
+    _hdr.e_shoff     = _imp->swap(_hdr.e_shoff);
+    _hdr.e_flags     = _imp->swap(_hdr.e_flags);
+    _hdr.e_ehsize    = _imp->swap(_hdr.e_ehsize);
+    _hdr.e_phentsize = _imp->swap(_hdr.e_phentsize);
+    _hdr.e_phnum     = _imp->swap(_hdr.e_phnum);
+    _hdr.e_shentsize = _imp->swap(_hdr.e_shentsize);
+    _hdr.e_shnum     = _imp->swap(_hdr.e_shnum);
+    _hdr.e_shstrndx  = _imp->swap(_hdr.e_shstrndx);
+
+    if (! _hdr.e_shoff)
+        return;
+
+    if (sizeof(typename ElfType_::SectionHeader) != _hdr.e_shentsize)
+        throw InvalidElfFileError(
+            "bad e_shentsize: got " + stringify(_hdr.e_shentsize) + ", expected " +
+            stringify(sizeof(typename ElfType_::SectionHeader)));
+
+    if (_hdr.e_shoff > _imp->size)
+        throw InvalidElfFileError("e_shoff points past the end of the file");
+    typename ElfType_::Word max_shdrs((_imp->size - _hdr.e_shoff) / sizeof(typename ElfType_::SectionHeader));
+
+    /* more than SHN_LORESERVE sections means e_shnum and e_shstrndx live in
+     * the first section header instead */
+    _imp->number_of_sections = _hdr.e_shnum;
+    _imp->shstrndx = _hdr.e_shstrndx;
+    if (0 == _hdr.e_shnum || SHN_XINDEX == _hdr.e_shstrndx)
+    {
+        if (0 == max_shdrs)
+            throw InvalidElfFileError("file is truncated, or an offset points past the end of the file");
+
+        _imp->number_of_sections = 1;
+        typename ElfType_::SectionHeader first_shdr(get_section_header(0));
+
+        if (0 == _hdr.e_shnum)
+        {
+            if (0 == first_shdr.sh_size)
+                throw InvalidElfFileError("got non-zero e_shoff and zero e_shnum, but sh_size of the first section is zero");
+            _imp->number_of_sections = first_shdr.sh_size;
+        }
+        else
+            _imp->number_of_sections = _hdr.e_shnum;
+
+        if (SHN_XINDEX == _hdr.e_shstrndx)
+            _imp->shstrndx = first_shdr.sh_link;
+    }
+
+    if (_imp->number_of_sections > max_shdrs)
+        throw InvalidElfFileError(
+            "file claims to contain " + stringify(_imp->number_of_sections) +
+            " section headers, but is only big enough to contain " + stringify(max_shdrs));
+
+    if (_imp->shstrndx && _imp->number_of_sections <= _imp->shstrndx)
+        throw InvalidElfFileError(
+            "section name table has index " + stringify(_imp->shstrndx) +
+            ", but only found " + stringify(_imp->number_of_sections) + " sections");
+}
+
+template <typename ElfType_>
+ElfView<ElfType_>::~ElfView() = default;
+
+template <typename ElfType_>
+unsigned int
+ElfView<ElfType_>::get_number_of_sections() const
+{
+    return _imp->number_of_sections;
+}
+
+template <typename ElfType_>
+typename ElfType_::SectionHeader
+ElfView<ElfType_>::get_section_header(unsigned int index) const
+{
+    if (index >= _imp->number_of_sections)
+        throw InvalidElfFileError("section index " + stringify(index) + " is out of range");
+
+    auto shdr(_imp->template read<typename ElfType_::SectionHeader>(
+                _hdr.e_shoff + index * sizeof(typename ElfType_::SectionHeader),
+                "section header " + stringify(index)));
+
+    shdr.sh_name      = _imp->swap(shdr.sh_name);
+    shdr.sh_type      = _imp->swap(shdr.sh_type);
+    shdr.sh_flags     = _imp->swap(shdr.sh_flags);
+    shdr.sh_addr      = _imp->swap(shdr.sh_addr);
+    shdr.sh_offset    = _imp->swap(shdr.sh_offset);
+    shdr.sh_size      = _imp->swap(shdr.sh_size);
+    shdr.sh_link      = _imp->swap(shdr.sh_link);
+    shdr.sh_info      = _imp->swap(shdr.sh_info);
+    shdr.sh_addralign = _imp->swap(shdr.sh_addralign);
+    shdr.sh_entsize   = _imp->swap(shdr.sh_entsize);
+
+    return shdr;
+}
+
+template <typename ElfType_>
+std::string
+ElfView<ElfType_>::get_section_name(unsigned int index) const
+{
+    if (! _imp->shstrndx)
+        return "";
+
+    return _imp->read_string(get_section_header(_imp->shstrndx), get_section_header(index).sh_name);
+}
+
+template <typename ElfType_>
+void
+ElfView<ElfType_>::for_each_dynamic_entry(
+        const std::function<bool (typename ElfType_::DynamicTag, typename ElfType_::DynamicValue)> & f) const
+{
+    for (unsigned int s(0) ; s < _imp->number_of_sections ; ++s)
+    {
+        typename ElfType_::SectionHeader shdr(get_section_header(s));
+        if (SHT_DYNAMIC != shdr.sh_type)
+            continue;
+
+        for (typename ElfType_::SectionSize i(0) ; i + sizeof(typename ElfType_::DynamicEntry) <= shdr.sh_size ;
+                i += sizeof(typename ElfType_::DynamicEntry))
+        {
+            auto entry(_imp->template read<typename ElfType_::DynamicEntry>(shdr.sh_offset + i,
+                        "dynamic entry in section " + stringify(s)));
+            typename ElfType_::DynamicTag tag(_imp->swap(entry.d_tag));
+            if (DT_NULL == tag)
+                break;
+
+            if (! f(tag, _imp->swap(entry.d_un.d_val)))
+                return;
+        }
+    }
+}
+
+template <typename ElfType_>
+std::shared_ptr<const Sequence<std::string> >
+ElfView<ElfType_>::get_dynamic_strings(typename ElfType_::DynamicTag tag) const
+{
+    auto result(std::make_shared<Sequence<std::string> >());
+
+    for (unsigned int s(0) ; s < _imp->number_of_sections ; ++s)
+    {
+        typename ElfType_::SectionHeader shdr(get_section_header(s));
+        if (SHT_DYNAMIC != shdr.sh_type)
+            continue;
+
+        if (shdr.sh_link >= _imp->number_of_sections)
+            throw InvalidElfFileError("dynamic section " + stringify(s) +
+                    " references non-existent section " + stringify(shdr.sh_link) + " in sh_link");
+        typename ElfType_::SectionHeader strtab(get_section_header(shdr.sh_link));
+
+        for (typename ElfType_::SectionSize i(0) ; i + sizeof(typename ElfType_::DynamicEntry) <= shdr.sh_size ;
+                i += sizeof(typename ElfType_::DynamicEntry))
+        {
+            auto entry(_imp->template read<typename ElfType_::DynamicEntry>(shdr.sh_offset + i,
+                        "dynamic entry in section " + stringify(s)));
+            typename ElfType_::DynamicTag entry_tag(_imp->swap(entry.d_tag));
+            if (DT_NULL == entry_tag)
+                break;
+
+            if (tag == entry_tag)
+                result->push_back(_imp->read_string(strtab, _imp->swap(entry.d_un.d_val)));
+        }
+    }
+
+    return result;
+}
+
+namespace paludis
+{
+    template class PALUDIS_VISIBLE ElfView<Elf32Type>;
+    template class PALUDIS_VISIBLE ElfView<Elf64Type>;
+}
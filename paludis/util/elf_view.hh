@@ -0,0 +1,160 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_ELF_VIEW_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_ELF_VIEW_HH 1
+
+#include <paludis/util/elf.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/sequence-fwd.hh>
+#include <paludis/util/mapped_file-fwd.hh>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+#include <elf.h>
+
+namespace paludis
+{
+    /**
+     * A read-only view of an ELF object in a MappedFile or a seekable stream.
+     *
+     * Unlike ElfObject, nothing is read up front except the ELF header.
+     * Section headers, dynamic entries and strings are decoded only when
+     * asked for, so looking at the dynamic section of a large library
+     * doesn't mean copying its symbol tables.
+     *
+     * Only map files which are replaced rather than rewritten in place:
+     * touching a mapping of a file that has since been truncated raises
+     * SIGBUS, whereas a stream just gives a short read, which becomes an
+     * InvalidElfFileError.
+     *
+     * The MappedFile or stream must outlive the view.
+     *
+     * \since 3.0
+     */
+    template <typename ElfType_>
+    class PALUDIS_VISIBLE ElfView
+    {
+        private:
+            Pimp<ElfView> _imp;
+
+            typename ElfType_::Header _hdr;
+
+            void _read_header();
+
+        public:
+            static bool is_valid_elf(const MappedFile &);
+            static bool is_valid_elf(std::istream &);
+
+            /**
+             * \exception InvalidElfFileError if the header or section
+             * header table is broken.
+             */
+            explicit ElfView(const MappedFile &);
+            explicit ElfView(std::istream &);
+            ~ElfView();
+
+            ElfView(const ElfView &) = delete;
+            ElfView & operator= (const ElfView &) = delete;
+
+            /**
+             * Returns e_type from the ELF header
+             */
+            unsigned int get_type() const
+            {
+                return _hdr.e_type;
+            }
+
+            /**
+             * Returns e_machine from the ELF header
+             */
+            unsigned int get_arch() const
+            {
+                return _hdr.e_machine;
+            }
+
+            /**
+             * Returns the OS ABI field from the ident field
+             */
+            unsigned char get_os_abi() const
+            {
+                return _hdr.e_ident[EI_OSABI];
+            }
+
+            /**
+             * Returns the OS ABI Version field from the ident field
+             */
+            unsigned char get_os_abi_version() const
+            {
+                return _hdr.e_ident[EI_ABIVERSION];
+            }
+
+            /**
+             * Returns the processor-specific flags
+             */
+            unsigned int get_flags() const
+            {
+                return _hdr.e_flags;
+            }
+
+            /**
+             * Returns whether this ELF file uses big-endian or little-endian
+             */
+            unsigned int is_big_endian() const
+            {
+                return (_hdr.e_ident[EI_DATA] == ELFDATA2MSB);
+            }
+
+            unsigned int get_number_of_sections() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Returns the (byte swapped, if necessary) header of a section.
+             *
+             * \exception InvalidElfFileError if the index is out of range.
+             */
+            typename ElfType_::SectionHeader get_section_header(unsigned int index) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Returns the name of a section, from the section name string
+             * table, or an empty string if there isn't one.
+             */
+            std::string get_section_name(unsigned int index) const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Calls the function with the tag and value of each entry in each
+             * dynamic section, in order, stopping at DT_NULL or as soon as the
+             * function returns false.
+             */
+            void for_each_dynamic_entry(
+                    const std::function<bool (typename ElfType_::DynamicTag, typename ElfType_::DynamicValue)> &) const;
+
+            /**
+             * Returns the strings referenced by every dynamic entry with the
+             * given tag (for example DT_NEEDED or DT_SONAME), in order.
+             */
+            std::shared_ptr<const Sequence<std::string> > get_dynamic_strings(typename ElfType_::DynamicTag) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+}
+
+#endif
@@ -0,0 +1,176 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <paludis/util/elf_view.hh>
+#include <paludis/util/elf.hh>
+#include <paludis/util/elf_types.hh>
+#include <paludis/util/elf_dynamic_section.hh>
+#include <paludis/util/elf_relocation_section.hh>
+#include <paludis/util/elf_symbol_section.hh>
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/visitor_cast.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/stringify.hh>
+
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    /* the test binary itself is a handy dynamically linked ELF object */
+    FSPath self()
+    {
+        return FSPath("/proc/self/exe").realpath();
+    }
+
+    template <typename ElfType_>
+    void compare_with_elf_object(const FSPath & f)
+    {
+        MappedFile mapped(f);
+        ASSERT_TRUE(ElfView<ElfType_>::is_valid_elf(mapped));
+        ElfView<ElfType_> view(mapped);
+
+        SafeIFStream stream(f);
+        ASSERT_TRUE(ElfObject<ElfType_>::is_valid_elf(stream));
+        ElfObject<ElfType_> object(stream);
+        object.resolve_all_strings();
+
+        EXPECT_EQ(object.get_type(), view.get_type());
+        EXPECT_EQ(object.get_arch(), view.get_arch());
+        EXPECT_EQ(object.get_flags(), view.get_flags());
+        EXPECT_EQ(object.is_big_endian(), view.is_big_endian());
+        ASSERT_EQ(object.get_number_of_sections(), view.get_number_of_sections());
+
+        unsigned n(0);
+        std::vector<std::string> object_needed;
+        for (const auto & section : object.sections())
+        {
+            EXPECT_EQ(section.get_name(), view.get_section_name(n));
+            EXPECT_EQ(section.get_data_offset(), view.get_section_header(n).sh_offset);
+            ++n;
+
+            if (const auto * dyn_sec = visitor_cast<const DynamicSection<ElfType_> >(section))
+                for (const auto & entry : dyn_sec->entries())
+                    if (const auto * ent_str = visitor_cast<const DynamicEntryString<ElfType_> >(entry))
+                        if ("NEEDED" == ent_str->tag_name())
+                            object_needed.push_back((*ent_str)());
+        }
+
+        auto view_needed(view.get_dynamic_strings(DT_NEEDED));
+        EXPECT_FALSE(object_needed.empty());
+        EXPECT_EQ(join(object_needed.begin(), object_needed.end(), " "), join(view_needed->begin(), view_needed->end(), " "));
+
+        SafeIFStream view_stream(f);
+        ASSERT_TRUE(ElfView<ElfType_>::is_valid_elf(view_stream));
+        ElfView<ElfType_> stream_view(view_stream);
+        ASSERT_EQ(view.get_number_of_sections(), stream_view.get_number_of_sections());
+        for (unsigned i(0) ; i < view.get_number_of_sections() ; ++i)
+            EXPECT_EQ(view.get_section_name(i), stream_view.get_section_name(i));
+
+        auto stream_needed(stream_view.get_dynamic_strings(DT_NEEDED));
+        EXPECT_EQ(join(view_needed->begin(), view_needed->end(), " "), join(stream_needed->begin(), stream_needed->end(), " "));
+    }
+
+    template <typename ElfType_>
+    void check_truncated()
+    {
+        MappedFile full(self());
+        FSPath truncated(FSPath::cwd() / "elf_view_TEST_dir" / "truncated");
+        {
+            SafeOFStream s(truncated, -1, true);
+            s << std::string(full.data(), sizeof(typename ElfType_::Header) + 16);
+        }
+
+        MappedFile mapped(truncated);
+        ASSERT_TRUE(ElfView<ElfType_>::is_valid_elf(mapped));
+        EXPECT_THROW(ElfView<ElfType_> view(mapped), InvalidElfFileError);
+
+        SafeIFStream stream(truncated);
+        ASSERT_TRUE(ElfView<ElfType_>::is_valid_elf(stream));
+        EXPECT_THROW(ElfView<ElfType_> view(stream), InvalidElfFileError);
+    }
+
+    template <typename ElfType_>
+    void check_truncated_while_open()
+    {
+        MappedFile full(self());
+        FSPath copy(FSPath::cwd() / "elf_view_TEST_dir" / "rewritten");
+        {
+            SafeOFStream s(copy, -1, true);
+            s << std::string(full.data(), full.size());
+        }
+
+        SafeIFStream stream(copy);
+        ElfView<ElfType_> view(stream);
+        ASSERT_EQ(0, ::truncate(stringify(copy).c_str(), sizeof(typename ElfType_::Header)));
+        EXPECT_THROW(view.get_dynamic_strings(DT_NEEDED), InvalidElfFileError);
+    }
+}
+
+TEST(ElfView, MatchesElfObject)
+{
+    if (sizeof(void *) == 8)
+        compare_with_elf_object<Elf64Type>(self());
+    else
+        compare_with_elf_object<Elf32Type>(self());
+}
+
+TEST(ElfView, NotElf)
+{
+    MappedFile mapped(FSPath::cwd() / "elf_view_TEST_dir" / "notelf");
+    EXPECT_FALSE(ElfView<Elf32Type>::is_valid_elf(mapped));
+    EXPECT_FALSE(ElfView<Elf64Type>::is_valid_elf(mapped));
+}
+
+TEST(ElfView, WrongClass)
+{
+    MappedFile mapped(self());
+    if (sizeof(void *) == 8)
+        EXPECT_FALSE(ElfView<Elf32Type>::is_valid_elf(mapped));
+    else
+        EXPECT_FALSE(ElfView<Elf64Type>::is_valid_elf(mapped));
+}
+
+TEST(ElfView, Truncated)
+{
+    if (sizeof(void *) == 8)
+        check_truncated<Elf64Type>();
+    else
+        check_truncated<Elf32Type>();
+}
+
+TEST(ElfView, TruncatedWhileOpen)
+{
+    if (sizeof(void *) == 8)
+        check_truncated_while_open<Elf64Type>();
+    else
+        check_truncated_while_open<Elf32Type>();
+}
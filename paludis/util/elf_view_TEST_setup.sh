@@ -0,0 +1,7 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir elf_view_TEST_dir || exit 2
+cd elf_view_TEST_dir || exit 3
+
+echo "not an elf file" > notelf
@@ -27,7 +27,9 @@ namespace paludis
 {
     namespace env_vars
     {
+        const std::string bash_conf_is_pure("PALUDIS_BASH_CONF_IS_PURE");
         const std::string bypass_userpriv_checks("PALUDIS_BYPASS_USERPRIV_CHECKS");
+        const std::string config_snapshot("PALUDIS_CONFIG_SNAPSHOT");
         const std::string default_output_conf("PALUDIS_DEFAULT_OUTPUT_CONF");
         const std::string distribution("PALUDIS_DISTRIBUTION");
         const std::string distributions_dir("PALUDIS_DISTRIBUTIONS_DIR");
@@ -36,6 +38,7 @@ namespace paludis
         const std::string ebuild_dir("PALUDIS_EBUILD_DIR");
         const std::string fetchers_dir("PALUDIS_FETCHERS_DIR");
         const std::string home("PALUDIS_HOME");
+        const std::string hook_jobs("PALUDIS_HOOK_JOBS");
         const std::string hooker_dir("PALUDIS_HOOKER_DIR");
         const std::string ignore_hooks_named("PALUDIS_IGNORE_HOOKS_NAMED");
         const std::string no_chown("PALUDIS_NO_CHOWN");
@@ -44,11 +47,14 @@ namespace paludis
         const std::string no_global_sets("PALUDIS_NO_GLOBAL_SETS");
         const std::string no_global_syncers("PALUDIS_NO_GLOBAL_SYNCERS");
         const std::string no_xml("PALUDIS_NO_XML");
+        const std::string parallel_merge("PALUDIS_PARALLEL_MERGE");
+        const std::string parallel_merge_scan("PALUDIS_PARALLEL_MERGE_SCAN");
         const std::string portage_bashrc("PALUDIS_PORTAGE_BASHRC");
         const std::string python_dir("PALUDIS_PYTHON_DIR");
         const std::string reduced_gid("PALUDIS_REDUCED_GID");
         const std::string reduced_uid("PALUDIS_REDUCED_UID");
         const std::string reduced_username("PALUDIS_REDUCED_USERNAME");
+        const std::string resolver_jobs("PALUDIS_RESOLVER_JOBS");
         const std::string suffixes_file("PALUDIS_SUFFIXES_FILE");
     }
 }
@@ -16,6 +16,7 @@ add(`channel',                           `hh', `cc')
 add(`checked_delete',                    `hh')
 add(`clone',                             `hh', `impl')
 add(`config_file',                       `hh', `cc', `fwd', `se', `gtest', `testscript')
+add(`config_file_fuzz',                  `gtest')
 add(`cookie',                            `hh', `cc')
 add(`create_iterator',                   `hh', `fwd', `impl', `gtest')
 add(`damerau_levenshtein',               `hh', `cc', `gtest')
@@ -29,6 +30,7 @@ add(`elf_relocation_section',            `hh', `cc')
 add(`elf_sections',                      `hh', `cc')
 add(`elf_symbol_section',                `hh', `cc')
 add(`elf_types',                         `hh')
+add(`elf_view',                          `hh', `cc', `gtest', `testscript')
 add(`enum_iterator',                     `hh', `cc', `fwd', `gtest')
 add(`env_var_names',                     `hh', `cc')
 add(`exception',                         `hh', `cc')
@@ -46,10 +48,12 @@ add(`iterator_range',                    `hh')
 add(`indirect_iterator',                 `hh', `fwd', `impl', `gtest')
 add(`is_file_with_extension',            `hh', `cc', `se', `gtest', `testscript')
 add(`join',                              `hh', `gtest')
-add(`log',                               `hh', `cc', `se', `gtest')
+add(`json_quote',                        `hh', `cc', `gtest')
+add(`log',                               `hh', `cc', `se', `gtest', `testscript')
 add(`make_named_values',                 `hh', `cc')
 add(`make_shared_copy',                  `hh', `fwd')
 add(`map',                               `hh', `fwd', `impl', `cc')
+add(`mapped_file',                       `hh', `cc', `fwd', `gtest', `testscript')
 add(`member_iterator',                   `hh', `fwd', `impl', `gtest')
 add(`md5',                               `hh', `cc', `gtest')
 add(`named_value',                       `hh', `cc', `fwd')
@@ -62,6 +66,7 @@ add(`pipe',                              `hh', `cc')
 add(`pool',                              `hh', `cc', `impl', `gtest', `fwd')
 add(`pretty_print',                      `hh', `cc', `gtest')
 add(`process',                           `hh', `cc', `fwd', `gtest', `testscript')
+add(`profiler',                          `hh', `cc', `gtest')
 add(`pty',                               `hh', `cc', `gtest')
 add(`realpath',                          `hh', `cc', `gtest', `testscript')
 add(`remove_shared_ptr',                 `hh')
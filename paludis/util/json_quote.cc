@@ -0,0 +1,66 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/json_quote.hh>
+#include <cstdio>
+
+using namespace paludis;
+
+std::string
+paludis::json_quote(const std::string & s)
+{
+    std::string result;
+    result.reserve(s.length() + 2);
+
+    result.append(1, '"');
+    for (const char c : s)
+    {
+        switch (c)
+        {
+            case '"':
+                result.append("\\\"");
+                break;
+
+            case '\\':
+                result.append("\\\\");
+                break;
+
+            case '\n':
+                result.append("\\n");
+                break;
+
+            case '\t':
+                result.append("\\t");
+                break;
+
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[7];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                    result.append(buf);
+                }
+                else
+                    result.append(1, c);
+        }
+    }
+    result.append(1, '"');
+
+    return result;
+}
@@ -0,0 +1,48 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_JSON_QUOTE_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_JSON_QUOTE_HH 1
+
+#include <string>
+#include <paludis/util/attributes.hh>
+
+/** \file
+ * Declarations for json_quote.
+ *
+ * \ingroup g_strings
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    /**
+     * Return s as a quoted JSON string, escaping anything that needs it.
+     *
+     * \ingroup g_strings
+     * \since 3.0
+     */
+    std::string json_quote(const std::string & s) PALUDIS_VISIBLE
+        PALUDIS_ATTRIBUTE((warn_unused_result));
+}
+
+#endif
@@ -0,0 +1,34 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/json_quote.hh>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+TEST(JSONQuote, Works)
+{
+    EXPECT_EQ("\"\"", json_quote(""));
+    EXPECT_EQ("\"monkey\"", json_quote("monkey"));
+    EXPECT_EQ("\"a \\\"b\\\" \\\\c\"", json_quote("a \"b\" \\c"));
+    EXPECT_EQ("\"one\\ntwo\\tthree\"", json_quote("one\ntwo\tthree"));
+    EXPECT_EQ("\"\\u0001\"", json_quote(std::string(1, '\x01')));
+    EXPECT_EQ("\"caf\xc3\xa9\"", json_quote("caf\xc3\xa9"));
+}
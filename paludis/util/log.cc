@@ -21,9 +21,16 @@
 #include <paludis/util/pimp-impl.hh>
 #include <paludis/util/singleton-impl.hh>
 #include <paludis/util/exception.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/json_quote.hh>
 #include <iostream>
 #include <exception>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "config.h"
 
@@ -38,14 +45,42 @@ using namespace paludis;
 
 #include <paludis/util/log-se.cc>
 
+namespace
+{
+    const char * level_name(const LogLevel l)
+    {
+        switch (l)
+        {
+            case ll_debug:
+                return "DEBUG";
+
+            case ll_qa:
+                return "QA";
+
+            case ll_warning:
+                return "WARNING";
+
+            case ll_silent:
+                throw InternalError(PALUDIS_HERE, "ll_silent used for a message");
+
+            case last_ll:
+                break;
+        }
+
+        throw InternalError(PALUDIS_HERE, "Bad value for log_level");
+    }
+}
+
 namespace paludis
 {
     template<>
     struct Imp<Log>
     {
-        std::mutex mutex;
-        LogLevel log_level;
+        mutable std::mutex mutex;
+        std::atomic<LogLevel> log_level;
         std::ostream * stream;
+        std::unique_ptr<SafeOFStream> structured_stream;
+        std::string structured_file;
         std::string program_name;
         std::string previous_context;
 
@@ -56,69 +91,44 @@ namespace paludis
         {
         }
 
-        void message(const std::string id, const LogLevel l, const LogContext c, const std::string cs, const std::string s)
+        /* must hold mutex. the whole line is written at once, since the
+         * stream is usually unbuffered and would otherwise cost a write for
+         * every piece. */
+        void message(const std::string & id, const LogLevel l, const LogContext c, const std::string & cs, const std::string & s)
         {
-            if (l >= log_level)
+            std::string line(program_name + "@" + stringify(::time(nullptr)) + ": [" + level_name(l) + " " + id + "] ");
+
+            if (lc_context == c)
             {
-                *stream << program_name << "@" << ::time(nullptr) << ": ";
-                do
-                {
-                    switch (l)
-                    {
-                        case ll_debug:
-                            *stream << "[DEBUG " << id << "] ";
-                            continue;
-
-                        case ll_qa:
-                            *stream << "[QA " << id << "] ";
-                            continue;
-
-                        case ll_warning:
-                            *stream << "[WARNING " << id << "] ";
-                            continue;
-
-                        case ll_silent:
-                            throw InternalError(PALUDIS_HERE, "ll_silent used for a message");
-
-                        case last_ll:
-                            break;
-                    }
-
-                    throw InternalError(PALUDIS_HERE, "Bad value for log_level");
-
-                } while (false);
-
-                if (lc_context == c)
-                {
-                    if (previous_context == cs)
-                        *stream << "(same context) " << s << std::endl;
-                    else
-                        *stream << cs << s << std::endl;
-                    previous_context = cs;
-                }
+                if (previous_context == cs)
+                    line.append("(same context) ");
                 else
-                    *stream << s << std::endl;
+                    line.append(cs);
+                previous_context = cs;
             }
-        }
-
-        void set_log_level(const LogLevel l)
-        {
-            log_level = l;
-        }
 
-        void get_log_level(LogLevel & l) const
-        {
-            l = log_level;
-        }
+            line.append(s);
+            line.append(1, '\n');
 
-        void set_program_name(const std::string & s)
-        {
-            program_name = s;
+            stream->write(line.data(), line.length());
+            stream->flush();
         }
 
-        void set_log_stream(std::ostream * const s)
+        /* must hold mutex */
+        void structured_message(const std::string & id, const LogLevel l, const LogContext c, const std::string & cs, const std::string & s)
         {
-            stream = s;
+            std::string line("{\"program\":" + json_quote(program_name));
+            line.append(",\"time\":" + stringify(::time(nullptr)));
+            line.append(",\"pid\":" + stringify(::getpid()));
+            line.append(",\"level\":" + json_quote(level_name(l)));
+            line.append(",\"id\":" + json_quote(id));
+            if (lc_context == c)
+                line.append(",\"context\":" + json_quote(cs));
+            line.append(",\"message\":" + json_quote(s));
+            line.append("}\n");
+
+            /* one write per line, so appending processes don't interleave */
+            *structured_stream << line;
         }
     };
 }
@@ -133,38 +143,50 @@ Log::~Log() = default;
 void
 Log::set_log_level(const LogLevel l)
 {
-    std::unique_lock<std::mutex> lock(_imp->mutex);
-    _imp->log_level = l;
+    _imp->log_level.store(l);
 }
 
 LogLevel
 Log::log_level() const
 {
-    return _imp->log_level;
+    return _imp->log_level.load();
+}
+
+bool
+Log::enabled(const LogLevel l) const
+{
+    return l >= _imp->log_level.load(std::memory_order_relaxed);
 }
 
 void
 Log::_message(const std::string & id, const LogLevel l, const LogContext c, const std::string & s)
 {
-    std::unique_lock<std::mutex> lock(_imp->mutex);
+    if (! enabled(l))
+        return;
 
+    std::string cs;
     if (lc_context == c)
-        _imp->message(id, l, c,
+        cs =
 #ifdef __linux__
                 "In thread ID '" + stringify(syscall(SYS_gettid)) + "':\n  ... " +
 #else
 #  warning "Don't know how to get a thread ID on your platform"
 #endif
-                Context::backtrace("\n  ... "), s);
-    else
-        _imp->message(id, l, c, "", s);
+                Context::backtrace("\n  ... ");
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    _imp->message(id, l, c, cs, s);
+    if (_imp->structured_stream)
+        _imp->structured_message(id, l, c, cs, s);
 }
 
 LogMessageHandler::LogMessageHandler(const LogMessageHandler & o) :
+    _log(o._log),
     _id(o._id),
     _message(o._message),
     _log_level(o._log_level),
-    _log_context(o._log_context)
+    _log_context(o._log_context),
+    _enabled(o._enabled)
 {
 }
 
@@ -181,6 +203,32 @@ Log::set_log_stream(std::ostream * const s)
     _imp->stream = s;
 }
 
+void
+Log::set_structured_log_file(const FSPath & f)
+{
+    std::unique_ptr<SafeOFStream> stream(new SafeOFStream(f, O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, false));
+    std::string file(stringify(f.realpath()));
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    _imp->structured_stream = std::move(stream);
+    _imp->structured_file = file;
+}
+
+void
+Log::unset_structured_log_file()
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    _imp->structured_stream.reset();
+    _imp->structured_file.clear();
+}
+
+std::string
+Log::structured_log_file() const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    return _imp->structured_file;
+}
+
 void
 Log::set_program_name(const std::string & s)
 {
@@ -192,7 +240,8 @@ LogMessageHandler::LogMessageHandler(Log * const ll, const std::string & id, con
     _log(ll),
     _id(id),
     _log_level(l),
-    _log_context(c)
+    _log_context(c),
+    _enabled(ll->enabled(l))
 {
 }
 
@@ -23,6 +23,7 @@
 #include <paludis/util/stringify.hh>
 #include <paludis/util/singleton.hh>
 #include <paludis/util/pimp.hh>
+#include <paludis/util/fs_path-fwd.hh>
 #include <iosfwd>
 #include <string>
 
@@ -77,6 +78,18 @@ namespace paludis
             LogLevel log_level() const
                 PALUDIS_ATTRIBUTE((warn_unused_result));
 
+            /**
+             * Would a message of this level be displayed?
+             *
+             * Log::message() already checks this before doing any
+             * formatting, so this is only needed to avoid working out
+             * something expensive to pass to it.
+             *
+             * \since 3.0
+             */
+            bool enabled(const LogLevel) const
+                PALUDIS_ATTRIBUTE((warn_unused_result));
+
             /**
              * Log a message.
              *
@@ -93,6 +106,30 @@ namespace paludis
              */
             void set_log_stream(std::ostream * const);
 
+            /**
+             * Also write messages to this file, one JSON object per line.
+             *
+             * The file is appended to, so that child processes can share it.
+             *
+             * \since 3.0
+             */
+            void set_structured_log_file(const FSPath &);
+
+            /**
+             * Stop writing messages to a structured log file.
+             *
+             * \since 3.0
+             */
+            void unset_structured_log_file();
+
+            /**
+             * The full path of the structured log file, or an empty string
+             * if there isn't one.
+             *
+             * \since 3.0
+             */
+            std::string structured_log_file() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
             /**
              * Set our program name.
              */
@@ -115,6 +152,7 @@ namespace paludis
             std::string _message;
             LogLevel _log_level;
             LogContext _log_context;
+            bool _enabled;
 
             LogMessageHandler(const LogMessageHandler &);
             LogMessageHandler(Log * const, const std::string &, const LogLevel, const LogContext);
@@ -132,12 +170,15 @@ namespace paludis
 
             /**
              * Append some text to our message.
+             *
+             * Nothing is stringified if the message won't be displayed.
              */
             template <typename T_>
             LogMessageHandler &
             operator<< (const T_ & t)
             {
-                _append(stringify(t));
+                if (_enabled)
+                    _append(stringify(t));
                 return *this;
             }
     };
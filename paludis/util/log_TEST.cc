@@ -18,8 +18,14 @@
  */
 
 #include <paludis/util/log.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/safe_ifstream.hh>
+#include <paludis/util/stringify.hh>
 
+#include <iterator>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -104,3 +110,61 @@ TEST(Log, Exceptions)
     EXPECT_TRUE(s.str().empty());
 }
 
+
+TEST(Log, NotEnabled)
+{
+    Log::destroy_instance();
+
+    std::stringstream s;
+    Log::get_instance()->set_log_stream(&s);
+    Log::get_instance()->set_log_level(ll_warning);
+
+    EXPECT_TRUE(Log::get_instance()->enabled(ll_warning));
+    EXPECT_TRUE(! Log::get_instance()->enabled(ll_qa));
+    EXPECT_TRUE(! Log::get_instance()->enabled(ll_debug));
+
+    /* nothing should be stringified, so nothing throws */
+    Log::get_instance()->message("test.log", ll_debug, lc_context) << throws_a_monkey_when_stringified();
+    EXPECT_TRUE(s.str().empty());
+}
+
+TEST(Log, Structured)
+{
+    Log::destroy_instance();
+
+    std::stringstream s;
+    Log::get_instance()->set_log_stream(&s);
+    Log::get_instance()->set_log_level(ll_qa);
+    Log::get_instance()->set_program_name("test");
+    Log::get_instance()->set_structured_log_file(FSPath("log_TEST_dir/structured"));
+
+    Log::get_instance()->message("test.one", ll_qa, lc_no_context) << "one \"quoted\"";
+    Log::get_instance()->message("test.two", ll_debug, lc_no_context) << "two";
+    Log::get_instance()->message("test.three", ll_warning, lc_context) << "three\nlines";
+
+    SafeIFStream f(FSPath("log_TEST_dir/structured"));
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(f, line))
+        lines.push_back(line);
+
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_EQ("{\"program\":\"test\",\"time\":", lines[0].substr(0, 25));
+    EXPECT_TRUE(std::string::npos != lines[0].find(",\"level\":\"QA\",\"id\":\"test.one\",\"message\":\"one \\\"quoted\\\"\"}"));
+    EXPECT_TRUE(std::string::npos != lines[1].find(",\"level\":\"WARNING\",\"id\":\"test.three\",\"context\":"));
+    EXPECT_TRUE(std::string::npos != lines[1].find(",\"message\":\"three\\nlines\"}"));
+
+    /* the ordinary log is still written */
+    EXPECT_TRUE(std::string::npos != s.str().find("one \"quoted\""));
+    EXPECT_TRUE(std::string::npos == s.str().find("two"));
+
+    EXPECT_EQ(stringify(FSPath("log_TEST_dir/structured").realpath()), Log::get_instance()->structured_log_file());
+    Log::get_instance()->unset_structured_log_file();
+    EXPECT_EQ("", Log::get_instance()->structured_log_file());
+    Log::get_instance()->message("test.four", ll_warning, lc_no_context) << "four";
+    SafeIFStream g(FSPath("log_TEST_dir/structured"));
+    std::string all((std::istreambuf_iterator<char>(g)), std::istreambuf_iterator<char>());
+    EXPECT_TRUE(std::string::npos == all.find("four"));
+
+    Log::destroy_instance();
+}
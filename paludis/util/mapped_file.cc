@@ -0,0 +1,137 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/fd_holder.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/stringify.hh>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <errno.h>
+
+using namespace paludis;
+
+namespace paludis
+{
+    template <>
+    struct Imp<MappedFile>
+    {
+        void * data;
+        std::size_t size;
+
+        Imp() :
+            data(nullptr),
+            size(0)
+        {
+        }
+    };
+}
+
+MappedFileError::MappedFileError(const std::string & s) noexcept :
+    Exception(s)
+{
+}
+
+MappedFile::MappedFile(const FSPath & f) :
+    _imp()
+{
+    Context context("When mapping '" + stringify(f) + "' for read:");
+
+    FDHolder fd(::open(stringify(f).c_str(), O_RDONLY | O_CLOEXEC), false);
+    if (-1 == fd)
+        throw MappedFileError("Could not open '" + stringify(f) + "': " + ::strerror(errno));
+
+    struct ::stat st;
+    if (0 != ::fstat(fd, &st))
+        throw MappedFileError("Could not stat '" + stringify(f) + "': " + ::strerror(errno));
+
+    if (! S_ISREG(st.st_mode))
+        throw MappedFileError("Cannot map '" + stringify(f) + "' because it is not a regular file");
+
+    if (0 == st.st_size)
+        return;
+
+    void * data(::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    if (MAP_FAILED == data)
+        throw MappedFileError("Could not map '" + stringify(f) + "': " + ::strerror(errno));
+
+    _imp->data = data;
+    _imp->size = st.st_size;
+}
+
+MappedFile::~MappedFile()
+{
+    if (_imp->data)
+        ::munmap(_imp->data, _imp->size);
+}
+
+const char *
+MappedFile::data() const
+{
+    return static_cast<const char *>(_imp->data);
+}
+
+std::size_t
+MappedFile::size() const
+{
+    return _imp->size;
+}
+
+MappedFileStreamBuf::MappedFileStreamBuf(const MappedFile & f)
+{
+    char * begin(const_cast<char *>(f.data()));
+    setg(begin, begin, begin + f.size());
+}
+
+MappedFileStreamBuf::pos_type
+MappedFileStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode)
+{
+    off_type base;
+    if (dir == std::ios_base::beg)
+        base = 0;
+    else if (dir == std::ios_base::cur)
+        base = gptr() - eback();
+    else if (dir == std::ios_base::end)
+        base = egptr() - eback();
+    else
+        return pos_type(off_type(-1));
+
+    return seekpos(pos_type(base + off), std::ios_base::in);
+}
+
+MappedFileStreamBuf::pos_type
+MappedFileStreamBuf::seekpos(pos_type p, std::ios_base::openmode)
+{
+    off_type off(p);
+    if (off < 0 || off > egptr() - eback())
+        return pos_type(off_type(-1));
+
+    setg(eback(), eback() + off, egptr());
+    return p;
+}
+
+namespace paludis
+{
+    template class Pimp<MappedFile>;
+}
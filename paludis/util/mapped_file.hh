@@ -0,0 +1,126 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_MAPPED_FILE_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_MAPPED_FILE_HH 1
+
+#include <paludis/util/mapped_file-fwd.hh>
+#include <paludis/util/attributes.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/fs_path-fwd.hh>
+#include <istream>
+#include <cstddef>
+
+/** \file
+ * Declarations for MappedFile and MappedFileStreamBuf.
+ *
+ * \ingroup g_fs
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    /**
+     * Thrown by MappedFile if a file cannot be mapped.
+     *
+     * \ingroup g_fs
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE MappedFileError :
+        public Exception
+    {
+        public:
+            MappedFileError(const std::string &) noexcept;
+    };
+
+    /**
+     * A read-only memory mapping of an entire regular file.
+     *
+     * Only regular files can be mapped. Callers that may be handed pipes or
+     * devices should fall back to SafeIFStream.
+     *
+     * Only map files which are replaced rather than rewritten in place.
+     * Touching a page past the end of a file that has been truncated since
+     * it was mapped raises SIGBUS, so use SafeIFStream for anything another
+     * process might be writing to.
+     *
+     * \ingroup g_fs
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE MappedFile
+    {
+        private:
+            Pimp<MappedFile> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            explicit MappedFile(const FSPath &);
+            ~MappedFile();
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile & operator= (const MappedFile &) = delete;
+
+            ///\}
+
+            /**
+             * The start of our data. May be null for an empty file.
+             */
+            const char * data() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * The size of our data.
+             */
+            std::size_t size() const PALUDIS_ATTRIBUTE((warn_unused_result));
+    };
+
+    /**
+     * Input stream buffer class that reads directly from a MappedFile.
+     *
+     * Seeking is just pointer arithmetic, so code that does lots of small
+     * seek-then-read operations is much cheaper than with SafeIFStreamBuf.
+     *
+     * \ingroup g_fs
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE MappedFileStreamBuf :
+        public std::streambuf
+    {
+        protected:
+            virtual pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode);
+            virtual pos_type seekpos(pos_type, std::ios_base::openmode);
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            MappedFileStreamBuf(const MappedFile &);
+
+            ///\}
+    };
+
+    extern template class Pimp<MappedFile>;
+}
+
+#endif
@@ -0,0 +1,76 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/mapped_file.hh>
+#include <paludis/util/fs_path.hh>
+
+#include <istream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+TEST(MappedFile, Existing)
+{
+    MappedFile f(FSPath::cwd() / "mapped_file_TEST_dir" / "existing");
+    ASSERT_EQ(1007u, f.size());
+    EXPECT_EQ("first\n", std::string(f.data(), 6));
+    EXPECT_EQ('x', f.data()[1005]);
+}
+
+TEST(MappedFile, Empty)
+{
+    MappedFile f(FSPath::cwd() / "mapped_file_TEST_dir" / "empty");
+    EXPECT_EQ(0u, f.size());
+}
+
+TEST(MappedFile, ExistingDir)
+{
+    EXPECT_THROW(MappedFile(FSPath::cwd() / "mapped_file_TEST_dir" / "existing_dir"), MappedFileError);
+}
+
+TEST(MappedFile, ExistingNoEnt)
+{
+    EXPECT_THROW(MappedFile(FSPath::cwd() / "mapped_file_TEST_dir" / "noent"), MappedFileError);
+}
+
+TEST(MappedFileStreamBuf, Seeking)
+{
+    MappedFile f(FSPath::cwd() / "mapped_file_TEST_dir" / "existing");
+    MappedFileStreamBuf buf(f);
+    std::istream s(&buf);
+    std::string t;
+    s >> t;
+    ASSERT_TRUE(bool(s));
+    EXPECT_EQ("first", t);
+    s >> t;
+    EXPECT_EQ(std::string(1000, 'x'), t);
+
+    s.clear();
+    s.seekg(0, std::ios::end);
+    EXPECT_EQ(1007, s.tellg());
+
+    s.seekg(2, std::ios::beg);
+    s >> t;
+    EXPECT_EQ("rst", t);
+
+    s.seekg(2000, std::ios::beg);
+    EXPECT_TRUE(s.fail());
+}
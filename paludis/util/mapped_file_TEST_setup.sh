@@ -0,0 +1,14 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir mapped_file_TEST_dir || exit 2
+cd mapped_file_TEST_dir || exit 3
+
+echo first > existing
+for (( a = 0 ; a < 1000 ; ++a )) ; do
+    echo -n x >> existing
+done
+echo >> existing
+
+touch empty
+mkdir existing_dir
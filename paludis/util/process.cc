@@ -38,6 +38,7 @@
 #include <cstring>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 #include <errno.h>
 #include <unistd.h>
@@ -1399,6 +1400,9 @@ namespace paludis
     template <>
     struct Imp<RunningProcessHandle>
     {
+        /* held whilst reaping the child and whilst signalling it, so that
+         * we never signal a pid which has been reaped and reused */
+        std::mutex pid_mutex;
         pid_t pid;
         std::unique_ptr<RunningProcessThread> thread;
 
@@ -1440,9 +1444,24 @@ RunningProcessHandle::wait()
 
     int status(0);
     if (actually_wait)
+    {
+        /* wait for the child to exit without reaping it, so that its pid
+         * can't be reused until we're holding the lock */
+        siginfo_t info;
+        while (-1 == ::waitid(P_PID, _imp->pid, &info, WEXITED | WNOWAIT))
+            if (EINTR != errno)
+                throw ProcessError("waitid() returned -1");
+
+        std::unique_lock<std::mutex> lock(_imp->pid_mutex);
         if (-1 == ::waitpid(_imp->pid, &status, 0))
             throw ProcessError("waitpid() returned -1");
-    _imp->pid = -1;
+        _imp->pid = -1;
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lock(_imp->pid_mutex);
+        _imp->pid = -1;
+    }
 
     if (_imp->thread)
     {
@@ -1459,3 +1478,13 @@ RunningProcessHandle::wait()
         return status;
 }
 
+bool
+RunningProcessHandle::signal(int sig)
+{
+    std::unique_lock<std::mutex> lock(_imp->pid_mutex);
+    if (_imp->pid <= 0)
+        return false;
+
+    return 0 == ::kill(_imp->pid, sig);
+}
+
@@ -147,6 +147,19 @@ namespace paludis
             RunningProcessHandle & operator= (const RunningProcessHandle &) = delete;
 
             int wait() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Send a signal to the process. It stays in our process group,
+             * so anything it starts must be passed the signal on by it.
+             *
+             * May be called from another thread whilst wait() is blocking.
+             * Returns false if the process has already been waited for; the
+             * child is only reaped whilst no signal() is in progress, so its
+             * pid can never have been reused by the time we kill() it.
+             *
+             * \since 3.0
+             */
+            bool signal(int);
     };
 }
 
@@ -24,8 +24,11 @@
 #include <paludis/util/stringify.hh>
 
 #include <sstream>
+#include <thread>
+#include <chrono>
 #include <sys/types.h>
 #include <pwd.h>
+#include <signal.h>
 
 #include <gtest/gtest.h>
 
@@ -66,6 +69,32 @@ TEST(Process, NoWait)
     EXPECT_THROW({ RunningProcessHandle handle(true_process.run()); }, ProcessError);
 }
 
+TEST(Process, Signal)
+{
+    Process sleep_process(ProcessCommand({"sleep", "30"}));
+
+    RunningProcessHandle handle(sleep_process.run());
+    EXPECT_TRUE(handle.signal(SIGTERM));
+    EXPECT_EQ(128 + SIGTERM, handle.wait());
+    EXPECT_FALSE(handle.signal(SIGTERM));
+}
+
+TEST(Process, SignalWhilstWaiting)
+{
+    Process sleep_process(ProcessCommand({"sleep", "30"}));
+
+    RunningProcessHandle handle(sleep_process.run());
+    int status(0);
+    std::thread waiter([&] () { status = handle.wait(); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_TRUE(handle.signal(SIGTERM));
+    waiter.join();
+
+    EXPECT_EQ(128 + SIGTERM, status);
+    EXPECT_FALSE(handle.signal(SIGTERM));
+}
+
 TEST(Process, TwoWait)
 {
     Process true_process(ProcessCommand({"true"}));
@@ -0,0 +1,275 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/profiler.hh>
+#include <paludis/util/pimp-impl.hh>
+#include <paludis/util/singleton-impl.hh>
+#include <paludis/util/json_quote.hh>
+#include <paludis/util/stringify.hh>
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace paludis;
+
+namespace
+{
+    /* beyond this many we stop keeping individual events for the trace, but
+     * still include them in the summary */
+    const std::size_t max_events(1000000);
+
+    /* how many details to show for each name in the summary */
+    const unsigned details_to_show(5);
+
+    struct Event
+    {
+        const char * name;
+        const char * category;
+        std::string detail;
+        long long start;
+        long long duration;
+        int thread;
+    };
+
+    struct Stats
+    {
+        unsigned long long calls = 0;
+        long long total = 0;
+        long long max = 0;
+
+        void add(const long long duration)
+        {
+            ++calls;
+            total += duration;
+            max = std::max(max, duration);
+        }
+    };
+
+    int this_thread_number()
+    {
+        static std::atomic<int> next(0);
+        thread_local int number(++next);
+        return number;
+    }
+
+    std::string ms(const long long us)
+    {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(3) << (us / 1000.0);
+        return s.str();
+    }
+}
+
+std::atomic<bool> Profiler::_enabled(false);
+
+namespace paludis
+{
+    template <>
+    struct Imp<Profiler>
+    {
+        mutable std::mutex mutex;
+        std::chrono::steady_clock::time_point epoch;
+
+        std::vector<Event> events;
+        unsigned long long dropped_events;
+
+        std::map<std::string, Stats> stats;
+        std::map<std::string, std::map<std::string, Stats> > detail_stats;
+        std::map<std::string, std::map<std::string, unsigned long long> > counts;
+
+        Imp() :
+            epoch(std::chrono::steady_clock::now()),
+            dropped_events(0)
+        {
+        }
+    };
+}
+
+Profiler::Profiler() = default;
+
+Profiler::~Profiler() = default;
+
+void
+Profiler::set_enabled(const bool e)
+{
+    _enabled.store(e);
+}
+
+void
+Profiler::clear()
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    _imp->epoch = std::chrono::steady_clock::now();
+    _imp->events.clear();
+    _imp->dropped_events = 0;
+    _imp->stats.clear();
+    _imp->detail_stats.clear();
+    _imp->counts.clear();
+}
+
+void
+Profiler::_add(const char * const name, const char * const category, const std::string & detail,
+        const std::chrono::steady_clock::time_point & start,
+        const std::chrono::steady_clock::time_point & end)
+{
+    int thread(this_thread_number());
+
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    long long start_us(std::chrono::duration_cast<std::chrono::microseconds>(start - _imp->epoch).count());
+    long long duration_us(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+
+    _imp->stats[name].add(duration_us);
+    if (! detail.empty())
+        _imp->detail_stats[name][detail].add(duration_us);
+
+    if (_imp->events.size() < max_events)
+        _imp->events.push_back(Event{ name, category, detail, start_us, duration_us, thread });
+    else
+        ++_imp->dropped_events;
+}
+
+void
+Profiler::_count(const char * const name, const std::string & detail)
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+    ++_imp->counts[name][detail];
+}
+
+void
+Profiler::write_trace(std::ostream & s) const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    std::string pid(stringify(::getpid()));
+    long long last(0);
+
+    s << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first(true);
+    for (const auto & e : _imp->events)
+    {
+        s << (first ? "\n" : ",\n");
+        first = false;
+
+        s << "{\"name\":" << json_quote(e.name) << ",\"cat\":" << json_quote(e.category)
+            << ",\"ph\":\"X\",\"ts\":" << e.start << ",\"dur\":" << e.duration
+            << ",\"pid\":" << pid << ",\"tid\":" << e.thread;
+        if (! e.detail.empty())
+            s << ",\"args\":{\"detail\":" << json_quote(e.detail) << "}";
+        s << "}";
+
+        last = std::max(last, e.start + e.duration);
+    }
+
+    /* counters only have final values, so show them at the end */
+    for (const auto & c : _imp->counts)
+    {
+        unsigned long long total(0);
+        for (const auto & d : c.second)
+            total += d.second;
+
+        s << (first ? "\n" : ",\n");
+        first = false;
+        s << "{\"name\":" << json_quote(c.first) << ",\"ph\":\"C\",\"ts\":" << last
+            << ",\"pid\":" << pid << ",\"args\":{\"count\":" << total << "}}";
+    }
+
+    s << "\n]}\n";
+}
+
+void
+Profiler::write_summary(std::ostream & s) const
+{
+    std::unique_lock<std::mutex> lock(_imp->mutex);
+
+    std::vector<std::pair<std::string, Stats> > by_total(_imp->stats.begin(), _imp->stats.end());
+    std::stable_sort(by_total.begin(), by_total.end(), [] (
+                const std::pair<std::string, Stats> & a, const std::pair<std::string, Stats> & b) {
+            return a.second.total > b.second.total;
+            });
+
+    s << "Timings (ms, including anything nested inside):" << std::endl;
+    s << std::left << std::setw(50) << "  name" << std::right << std::setw(12) << "calls"
+        << std::setw(14) << "total" << std::setw(12) << "max" << std::endl;
+
+    for (const auto & t : by_total)
+    {
+        s << std::left << std::setw(50) << ("  " + t.first) << std::right << std::setw(12) << t.second.calls
+            << std::setw(14) << ms(t.second.total) << std::setw(12) << ms(t.second.max) << std::endl;
+
+        auto d(_imp->detail_stats.find(t.first));
+        if (d == _imp->detail_stats.end())
+            continue;
+
+        std::vector<std::pair<std::string, Stats> > details(d->second.begin(), d->second.end());
+        std::stable_sort(details.begin(), details.end(), [] (
+                    const std::pair<std::string, Stats> & a, const std::pair<std::string, Stats> & b) {
+                return a.second.total > b.second.total;
+                });
+        if (details.size() > details_to_show)
+            details.resize(details_to_show);
+
+        for (const auto & detail : details)
+            s << "      " << detail.first << ": " << detail.second.calls << " calls, " << ms(detail.second.total)
+                << " total" << std::endl;
+    }
+
+    if (! _imp->counts.empty())
+    {
+        s << std::endl << "Counts:" << std::endl;
+        for (const auto & c : _imp->counts)
+        {
+            unsigned long long total(0);
+            for (const auto & d : c.second)
+                total += d.second;
+            s << std::left << std::setw(50) << ("  " + c.first) << std::right << std::setw(12) << total << std::endl;
+
+            std::vector<std::pair<std::string, unsigned long long> > details;
+            for (const auto & d : c.second)
+                if (! d.first.empty())
+                    details.push_back(d);
+            std::stable_sort(details.begin(), details.end(), [] (
+                        const std::pair<std::string, unsigned long long> & a,
+                        const std::pair<std::string, unsigned long long> & b) {
+                    return a.second > b.second;
+                    });
+            if (details.size() > details_to_show)
+                details.resize(details_to_show);
+
+            for (const auto & detail : details)
+                s << "      " << detail.first << ": " << detail.second << std::endl;
+        }
+    }
+
+    if (0 != _imp->dropped_events)
+        s << std::endl << "(" << _imp->dropped_events << " events were left out of the trace to save space)" << std::endl;
+}
+
+namespace paludis
+{
+    template class Pimp<Profiler>;
+    template class Singleton<Profiler>;
+}
@@ -0,0 +1,191 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_PALUDIS_UTIL_PROFILER_HH
+#define PALUDIS_GUARD_PALUDIS_UTIL_PROFILER_HH 1
+
+#include <paludis/util/attributes.hh>
+#include <paludis/util/pimp.hh>
+#include <paludis/util/singleton.hh>
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <string>
+
+/** \file
+ * Declarations for Profiler and ProfileScope.
+ *
+ * \ingroup g_log
+ *
+ * \section Examples
+ *
+ * - None at this time.
+ */
+
+namespace paludis
+{
+    class ProfileScope;
+
+    /**
+     * Collects timings and counts, so that we can see where the time goes.
+     *
+     * Nothing is collected unless the profiler has been enabled, and checking
+     * whether it has is cheap, so ProfileScope and Profiler::count can be
+     * left in hot code.
+     *
+     * \ingroup g_log
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE Profiler :
+        public Singleton<Profiler>
+    {
+        friend class Singleton<Profiler>;
+        friend class ProfileScope;
+
+        private:
+            Pimp<Profiler> _imp;
+
+            static std::atomic<bool> _enabled;
+
+            Profiler();
+
+            void _add(const char * const name, const char * const category, const std::string & detail,
+                    const std::chrono::steady_clock::time_point & start,
+                    const std::chrono::steady_clock::time_point & end);
+
+            void _count(const char * const name, const std::string & detail);
+
+        public:
+            ~Profiler();
+
+            /**
+             * Are we collecting anything?
+             */
+            static bool enabled()
+            {
+                return _enabled.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * Start or stop collecting. Anything already collected is kept.
+             */
+            void set_enabled(const bool);
+
+            /**
+             * Forget anything collected so far.
+             */
+            void clear();
+
+            /**
+             * Count something happening.
+             */
+            static void count(const char * const name)
+            {
+                if (enabled())
+                    get_instance()->_count(name, "");
+            }
+
+            /**
+             * Count something happening. The detail function is only called
+             * if we are collecting, and is used to break the count down in
+             * the summary.
+             */
+            template <typename F_>
+            static void count(const char * const name, const F_ & detail)
+            {
+                if (enabled())
+                    get_instance()->_count(name, detail());
+            }
+
+            /**
+             * Write what we have collected in Chrome's trace event format.
+             */
+            void write_trace(std::ostream &) const;
+
+            /**
+             * Write a human readable summary of what we have collected.
+             */
+            void write_summary(std::ostream &) const;
+    };
+
+    /**
+     * Times a scope, if the Profiler is enabled.
+     *
+     * The name and category must be string literals, or otherwise outlive
+     * the Profiler.
+     *
+     * \ingroup g_log
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE ProfileScope
+    {
+        private:
+            const char * const _name;
+            const char * const _category;
+            const bool _active;
+            std::string _detail;
+            std::chrono::steady_clock::time_point _start;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            ProfileScope(const char * const name, const char * const category) :
+                _name(name),
+                _category(category),
+                _active(Profiler::enabled())
+            {
+                if (_active)
+                    _start = std::chrono::steady_clock::now();
+            }
+
+            /**
+             * The detail function is only called if we are collecting, and
+             * is used to say what in particular the time was spent on.
+             */
+            template <typename F_>
+            ProfileScope(const char * const name, const char * const category, const F_ & detail) :
+                _name(name),
+                _category(category),
+                _active(Profiler::enabled())
+            {
+                if (_active)
+                {
+                    _detail = detail();
+                    _start = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~ProfileScope()
+            {
+                if (_active)
+                    Profiler::get_instance()->_add(_name, _category, _detail, _start, std::chrono::steady_clock::now());
+            }
+
+            ProfileScope(const ProfileScope &) = delete;
+            ProfileScope & operator= (const ProfileScope &) = delete;
+
+            ///\}
+    };
+
+    extern template class Pimp<Profiler>;
+    extern template class Singleton<Profiler>;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <paludis/util/profiler.hh>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace paludis;
+
+namespace
+{
+    int detail_calls(0);
+
+    std::string detail()
+    {
+        ++detail_calls;
+        return "some \"detail\"";
+    }
+}
+
+TEST(Profiler, Disabled)
+{
+    Profiler::get_instance()->set_enabled(false);
+    Profiler::get_instance()->clear();
+    detail_calls = 0;
+
+    {
+        ProfileScope scope("test.disabled", "test", detail);
+        Profiler::count("test.disabled.count", detail);
+    }
+
+    EXPECT_EQ(0, detail_calls);
+
+    std::stringstream s;
+    Profiler::get_instance()->write_trace(s);
+    EXPECT_EQ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n]}\n", s.str());
+}
+
+TEST(Profiler, Trace)
+{
+    Profiler::get_instance()->clear();
+    Profiler::get_instance()->set_enabled(true);
+    detail_calls = 0;
+
+    {
+        ProfileScope outer("test.outer", "test");
+        for (int i(0) ; i < 3 ; ++i)
+        {
+            ProfileScope inner("test.inner", "test", detail);
+            Profiler::count("test.count");
+        }
+    }
+
+    Profiler::get_instance()->set_enabled(false);
+    EXPECT_EQ(3, detail_calls);
+
+    std::stringstream s;
+    Profiler::get_instance()->write_trace(s);
+    std::string trace(s.str());
+
+    EXPECT_EQ(0u, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_TRUE(std::string::npos != trace.find("{\"name\":\"test.outer\",\"cat\":\"test\",\"ph\":\"X\",\"ts\":"));
+    EXPECT_TRUE(std::string::npos != trace.find(",\"args\":{\"detail\":\"some \\\"detail\\\"\"}}"));
+    EXPECT_TRUE(std::string::npos != trace.find("{\"name\":\"test.count\",\"ph\":\"C\""));
+    EXPECT_TRUE(std::string::npos != trace.find("\"args\":{\"count\":3}}"));
+
+    std::string::size_type p(0);
+    int inners(0);
+    while (std::string::npos != ((p = trace.find("\"test.inner\"", p))))
+    {
+        ++inners;
+        ++p;
+    }
+    EXPECT_EQ(3, inners);
+}
+
+TEST(Profiler, Summary)
+{
+    Profiler::get_instance()->clear();
+    Profiler::get_instance()->set_enabled(true);
+
+    {
+        ProfileScope outer("test.outer", "test");
+        ProfileScope inner("test.inner", "test", [] { return std::string("cat/pkg"); });
+        Profiler::count("test.count", [] { return std::string("repo"); });
+        Profiler::count("test.count", [] { return std::string("repo"); });
+    }
+
+    Profiler::get_instance()->set_enabled(false);
+
+    std::stringstream s;
+    Profiler::get_instance()->write_summary(s);
+    std::string summary(s.str());
+
+    EXPECT_TRUE(std::string::npos != summary.find("  test.outer "));
+    EXPECT_TRUE(std::string::npos != summary.find("      cat/pkg: 1 calls, "));
+    EXPECT_TRUE(std::string::npos != summary.find("      repo: 2\n"));
+
+    /* outer includes inner, so it comes first */
+    EXPECT_LT(summary.find("test.outer"), summary.find("test.inner"));
+}
@@ -20,6 +20,9 @@
 #include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/stringify.hh>
 #include <paludis/util/pimp-impl.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_error.hh>
+#include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -147,6 +150,110 @@ SafeOFStream::~SafeOFStream() noexcept(false)
         throw SafeOFStreamError("Write to fd " + stringify(buf.fd) + " failed");
 }
 
+namespace paludis
+{
+    template <>
+    struct Imp<AtomicOFStream>
+    {
+        const std::string target;
+        std::string temporary;
+        int fd;
+
+        /* not a unique_ptr, because ~SafeOFStream can throw */
+        SafeOFStream * stream;
+
+        Imp(const FSPath & t) :
+            target(stringify(t)),
+            fd(-1),
+            stream(nullptr)
+        {
+        }
+
+        void abandon()
+        {
+            ::close(fd);
+            ::unlink(temporary.c_str());
+        }
+    };
+}
+
+AtomicOFStream::AtomicOFStream(const FSPath & f) :
+    _imp(f)
+{
+    std::string pattern(_imp->target + ".tmp.XXXXXX");
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+
+    _imp->fd = ::mkstemp(&name[0]);
+    if (-1 == _imp->fd)
+        throw SafeOFStreamError("Could not create a temporary file to replace '" + _imp->target + "': " + ::strerror(errno));
+    _imp->temporary = &name[0];
+
+    /* mkstemp creates 0600, but we want what open would have given us */
+    ::fcntl(_imp->fd, F_SETFD, FD_CLOEXEC);
+    ::fchmod(_imp->fd, 0644);
+
+    _imp->stream = new SafeOFStream(_imp->fd, true);
+}
+
+AtomicOFStream::~AtomicOFStream()
+{
+    if (! _imp->stream)
+        return;
+
+    try
+    {
+        delete _imp->stream;
+    }
+    catch (...)
+    {
+    }
+
+    _imp->abandon();
+}
+
+std::ostream &
+AtomicOFStream::stream()
+{
+    return *_imp->stream;
+}
+
+void
+AtomicOFStream::commit()
+{
+    Context context("When replacing '" + _imp->target + "':");
+
+    if (! _imp->stream)
+        throw InternalError(PALUDIS_HERE, "AtomicOFStream for '" + _imp->target + "' already committed");
+
+    SafeOFStream * const s(_imp->stream);
+    _imp->stream = nullptr;
+
+    try
+    {
+        delete s;
+    }
+    catch (...)
+    {
+        _imp->abandon();
+        throw;
+    }
+
+    if (0 != ::close(_imp->fd))
+    {
+        int e(errno);
+        ::unlink(_imp->temporary.c_str());
+        throw SafeOFStreamError("Write to '" + _imp->temporary + "' failed: " + ::strerror(e));
+    }
+
+    if (0 != ::rename(_imp->temporary.c_str(), _imp->target.c_str()))
+    {
+        int e(errno);
+        ::unlink(_imp->temporary.c_str());
+        throw FSError("Rename '" + _imp->temporary + "' to '" + _imp->target + "' failed: " + ::strerror(e));
+    }
+}
+
 SafeOFStreamError::SafeOFStreamError(const std::string & s) noexcept :
     Exception(s)
 {
@@ -155,4 +262,5 @@ SafeOFStreamError::SafeOFStreamError(const std::string & s) noexcept :
 namespace paludis
 {
     template class Pimp<SafeOFStreamBuf>;
+    template class Pimp<AtomicOFStream>;
 }
@@ -28,7 +28,7 @@
 #include <ostream>
 
 /** \file
- * Declarations for SafeOFStream.
+ * Declarations for SafeOFStream and AtomicOFStream.
  *
  * \ingroup g_fs
  *
@@ -123,6 +123,51 @@ namespace paludis
             ///\}
     };
 
+    /**
+     * Writes a file by writing a new, uniquely named file alongside it, and
+     * renaming that over it when commit() is called. Readers never see a
+     * partly written file, and concurrent writers never share a temporary
+     * file.
+     *
+     * If commit() is not called, the temporary file is removed again.
+     *
+     * \ingroup g_fs
+     * \since 3.0
+     */
+    class PALUDIS_VISIBLE AtomicOFStream
+    {
+        private:
+            Pimp<AtomicOFStream> _imp;
+
+        public:
+            ///\name Basic operations
+            ///\{
+
+            /**
+             * \exception SafeOFStreamError If the temporary file cannot be created.
+             */
+            explicit AtomicOFStream(const FSPath &);
+            ~AtomicOFStream();
+
+            AtomicOFStream(const AtomicOFStream &) = delete;
+            AtomicOFStream & operator= (const AtomicOFStream &) = delete;
+
+            ///\}
+
+            /**
+             * The stream to write to, until commit() is called.
+             */
+            std::ostream & stream() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+            /**
+             * Finish writing, and replace the real file.
+             *
+             * \exception SafeOFStreamError If writing failed.
+             * \exception FSError If the rename failed.
+             */
+            void commit();
+    };
+
     /**
      * Thrown by SafeOFStream if an error occurs.
      *
@@ -137,6 +182,7 @@ namespace paludis
     };
 
     extern template class Pimp<SafeOFStreamBuf>;
+    extern template class Pimp<AtomicOFStream>;
 }
 
 #endif
@@ -19,12 +19,18 @@
 
 #include <paludis/util/safe_ofstream.hh>
 #include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/options.hh>
+#include <paludis/util/safe_ifstream.hh>
 
 #include <unistd.h>
 #include <sys/types.h>
 
 #include <gtest/gtest.h>
 
+#include <iterator>
+
 using namespace paludis;
 
 TEST(SafeOFStream, New)
@@ -82,3 +88,61 @@ TEST(SafeOFStream, WriteFailure)
     ASSERT_TRUE(threw);
 }
 
+
+namespace
+{
+    std::string contents(const FSPath & f)
+    {
+        SafeIFStream s(f);
+        return std::string((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+    }
+
+    int count_files(const FSPath & d)
+    {
+        int result(0);
+        for (FSIterator f(d, { fsio_include_dotfiles }), f_end ; f != f_end ; ++f)
+            ++result;
+        return result;
+    }
+}
+
+TEST(AtomicOFStream, Replaces)
+{
+    FSPath dir(FSPath::cwd() / "safe_ofstream_TEST_dir" / "atomic");
+    {
+        AtomicOFStream s(dir / "replaced");
+        s.stream() << "new";
+        EXPECT_EQ("old", contents(dir / "replaced"));
+        EXPECT_EQ(2, count_files(dir));
+        s.commit();
+    }
+
+    EXPECT_EQ("new", contents(dir / "replaced"));
+    EXPECT_EQ(1, count_files(dir));
+
+    {
+        AtomicOFStream s(dir / "created");
+        s.stream() << "created";
+        s.commit();
+    }
+
+    EXPECT_EQ("created", contents(dir / "created"));
+    EXPECT_EQ(2, count_files(dir));
+}
+
+TEST(AtomicOFStream, NotCommitted)
+{
+    FSPath dir(FSPath::cwd() / "safe_ofstream_TEST_dir" / "atomic_abandoned");
+    {
+        AtomicOFStream s(dir / "replaced");
+        s.stream() << "new";
+    }
+
+    EXPECT_EQ("old", contents(dir / "replaced"));
+    EXPECT_EQ(1, count_files(dir));
+}
+
+TEST(AtomicOFStream, MissingDir)
+{
+    EXPECT_THROW(AtomicOFStream(FSPath::cwd() / "safe_ofstream_TEST_dir" / "missing" / "file"), SafeOFStreamError);
+}
@@ -11,3 +11,6 @@ ln -s existing_sym_target existing_sym
 touch existing_perm
 chmod a-rw existing_perm
 
+mkdir atomic atomic_abandoned
+echo -n old > atomic/replaced
+echo -n old > atomic_abandoned/replaced
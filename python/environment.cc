@@ -20,6 +20,7 @@
 #include <python/paludis_python.hh>
 #include <python/exception.hh>
 #include <python/iterable.hh>
+#include <python/mutex.hh>
 
 #include <paludis/environments/paludis/paludis_environment.hh>
 #include <paludis/environments/paludis/paludis_config.hh>
@@ -36,10 +37,25 @@
 #include <paludis/environment_factory.hh>
 #include <paludis/mask.hh>
 #include <paludis/repository.hh>
+#include <paludis/generator.hh>
+#include <paludis/filtered_generator.hh>
+#include <paludis/package_id_stream.hh>
+#include <paludis/metadata_key.hh>
+#include <paludis/unformatted_pretty_printer.hh>
+#include <paludis/slot.hh>
+#include <paludis/name.hh>
 
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/tribool.hh>
 #include <paludis/util/make_named_values.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/map.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/stringify.hh>
+
+#include <sstream>
+#include <vector>
 
 using namespace paludis;
 using namespace paludis::python;
@@ -56,7 +72,7 @@ class EnvironmentImplementationWrapper :
 
         virtual void populate_sets() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("populate_sets"))
                 f();
@@ -67,7 +83,7 @@ class EnvironmentImplementationWrapper :
         virtual bool accept_license(const std::string & s, const std::shared_ptr<const PackageID> & p) const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("accept_license"))
                 return f(s, p);
@@ -78,7 +94,7 @@ class EnvironmentImplementationWrapper :
         virtual bool accept_keywords(const std::shared_ptr<const KeywordNameSet> & k, const std::shared_ptr<const PackageID> & p) const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("accept_keywords"))
                 return f(k, p);
@@ -89,7 +105,7 @@ class EnvironmentImplementationWrapper :
         virtual const std::shared_ptr<const Mask> mask_for_user(const std::shared_ptr<const PackageID> & p, const bool b) const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("mask_for_user"))
                 return f(p, b);
@@ -100,7 +116,7 @@ class EnvironmentImplementationWrapper :
         virtual bool unmasked_by_user(const std::shared_ptr<const PackageID> & p, const std::string & s) const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("unmasked_by_user"))
                 return f(p, s);
@@ -111,7 +127,7 @@ class EnvironmentImplementationWrapper :
         virtual std::shared_ptr<const FSPathSequence> bashrc_files() const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("bashrc_files"))
                 return f();
@@ -127,7 +143,7 @@ class EnvironmentImplementationWrapper :
         virtual std::shared_ptr<const FSPathSequence> syncers_dirs() const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("syncers_dirs"))
                 return f();
@@ -143,7 +159,7 @@ class EnvironmentImplementationWrapper :
         virtual std::shared_ptr<const FSPathSequence> fetchers_dirs() const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("fetchers_dirs"))
                 return f();
@@ -159,7 +175,7 @@ class EnvironmentImplementationWrapper :
         virtual std::shared_ptr<const FSPathSequence> hook_dirs() const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("hook_dirs"))
                 return f();
@@ -169,7 +185,7 @@ class EnvironmentImplementationWrapper :
 
         virtual std::string reduced_username() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("reduced_username"))
                 return f();
@@ -179,7 +195,7 @@ class EnvironmentImplementationWrapper :
 
         virtual uid_t reduced_uid() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("reduced_uid"))
                 return f();
@@ -189,7 +205,7 @@ class EnvironmentImplementationWrapper :
 
         virtual gid_t reduced_gid() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("reduced_gid"))
                 return f();
@@ -201,7 +217,7 @@ class EnvironmentImplementationWrapper :
         virtual std::shared_ptr<const MirrorsSequence> mirrors(const std::string & s) const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("mirrors"))
                 return f(s);
@@ -212,7 +228,7 @@ class EnvironmentImplementationWrapper :
         virtual std::shared_ptr<const SetNameSet> set_names() const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("set_names"))
                 return f();
@@ -228,7 +244,7 @@ class EnvironmentImplementationWrapper :
         virtual const std::shared_ptr<const SetSpecTree> set(const SetName & s) const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("set"))
                 return f(boost::cref(s));
@@ -251,7 +267,7 @@ class EnvironmentImplementationWrapper :
         virtual std::string distribution() const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("distribution"))
                 return f();
@@ -266,7 +282,7 @@ class EnvironmentImplementationWrapper :
 
         virtual bool add_to_world(const QualifiedPackageName & s) const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
             if (bp::override f = get_override("add_to_world"))
                 return f(s);
             else
@@ -275,7 +291,7 @@ class EnvironmentImplementationWrapper :
 
         virtual bool add_to_world(const SetName & s) const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
             if (bp::override f = get_override("add_to_world"))
                 return f(s);
             else
@@ -284,7 +300,7 @@ class EnvironmentImplementationWrapper :
 
         virtual bool remove_from_world(const QualifiedPackageName & s) const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
             if (bp::override f = get_override("remove_from_world"))
                 return f(s);
             else
@@ -293,7 +309,7 @@ class EnvironmentImplementationWrapper :
 
         virtual bool remove_from_world(const SetName & s) const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
             if (bp::override f = get_override("remove_from_world"))
                 return f(s);
             else
@@ -303,7 +319,7 @@ class EnvironmentImplementationWrapper :
         virtual std::shared_ptr<PackageIDSequence> operator[] (const Selection & fg) const
             PALUDIS_ATTRIBUTE((warn_unused_result))
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("__getitem__"))
                 return f(fg);
@@ -318,7 +334,7 @@ class EnvironmentImplementationWrapper :
 
         virtual void need_keys_added() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("need_keys_added"))
                 f();
@@ -328,7 +344,7 @@ class EnvironmentImplementationWrapper :
 
         virtual const std::shared_ptr<const MetadataValueKey<std::string> > format_key() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("format_key"))
                 return f();
@@ -338,7 +354,7 @@ class EnvironmentImplementationWrapper :
 
         virtual const std::shared_ptr<const MetadataValueKey<FSPath> > config_location_key() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("config_location_key"))
                 return f();
@@ -348,7 +364,7 @@ class EnvironmentImplementationWrapper :
 
         virtual const std::shared_ptr<const MetadataValueKey<FSPath> > preferred_root_key() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("preferred_root_key"))
                 return f();
@@ -358,7 +374,7 @@ class EnvironmentImplementationWrapper :
 
         virtual const std::shared_ptr<const MetadataValueKey<FSPath> > system_root_key() const
         {
-            std::unique_lock<std::recursive_mutex> l(get_mutex());
+            PythonLock l;
 
             if (bp::override f = get_override("system_root_key"))
                 return f();
@@ -424,6 +440,153 @@ class EnvironmentImplementationWrapper :
         }
 };
 
+namespace
+{
+    /**
+     * Turns a key's value into a string, without needing Python, so that we
+     * can do it with the GIL released.
+     */
+    struct KeyValueStringifier
+    {
+        std::stringstream s;
+        bool printable = true;
+
+        void visit(const MetadataTimeKey & k)
+        {
+            s << k.parse_value().seconds();
+        }
+
+        void visit(const MetadataValueKey<std::shared_ptr<const Choices> > &)
+        {
+            printable = false;
+        }
+
+        void visit(const MetadataValueKey<std::shared_ptr<const PackageID> > & k)
+        {
+            s << *k.parse_value();
+        }
+
+        void visit(const MetadataValueKey<FSPath> & k)
+        {
+            s << k.parse_value();
+        }
+
+        void visit(const MetadataValueKey<bool> & k)
+        {
+            s << (k.parse_value() ? "true" : "false");
+        }
+
+        void visit(const MetadataValueKey<long> & k)
+        {
+            s << k.parse_value();
+        }
+
+        void visit(const MetadataValueKey<std::string> & k)
+        {
+            s << k.parse_value();
+        }
+
+        void visit(const MetadataValueKey<Slot> & k)
+        {
+            s << k.parse_value().raw_value();
+        }
+
+        template <typename T_>
+        void visit(const MetadataSpecTreeKey<T_> & k)
+        {
+            s << k.pretty_print_value(UnformattedPrettyPrinter(), { });
+        }
+
+        template <typename T_>
+        void visit(const MetadataCollectionKey<T_> & k)
+        {
+            s << k.pretty_print_value(UnformattedPrettyPrinter(), { });
+        }
+
+        void visit(const MetadataSectionKey &)
+        {
+            printable = false;
+        }
+    };
+
+    struct SelectedMetadata
+    {
+        std::shared_ptr<const PackageID> id;
+        std::vector<std::pair<bool, std::string> > values;
+    };
+
+    bp::list environment_select_metadata(const Environment & env, const Selection & selection, const bp::object & key_names)
+    {
+        std::vector<std::string> names;
+        for (bp::stl_input_iterator<std::string> k(key_names), k_end ; k != k_end ; ++k)
+            names.push_back(*k);
+
+        std::vector<SelectedMetadata> selected;
+        {
+            /* a Python environment or key will take the GIL back as needed */
+            GILReleaser r;
+
+            auto ids(env[selection]);
+            for (const auto & id : *ids)
+            {
+                SelectedMetadata m{ id, { } };
+                m.values.reserve(names.size());
+                for (const auto & n : names)
+                {
+                    auto k(id->find_metadata(n));
+                    if (k == id->end_metadata())
+                        m.values.emplace_back(false, "");
+                    else
+                    {
+                        KeyValueStringifier v;
+                        (*k)->accept(v);
+                        m.values.emplace_back(v.printable, v.printable ? v.s.str() : "");
+                    }
+                }
+                selected.push_back(std::move(m));
+            }
+        }
+
+        bp::list result;
+        for (const auto & m : selected)
+        {
+            bp::list values;
+            for (const auto & v : m.values)
+                values.append(v.first ? bp::object(v.second) : bp::object());
+            result.append(bp::make_tuple(m.id, bp::tuple(values)));
+        }
+
+        return result;
+    }
+
+    std::shared_ptr<PackageIDStream> environment_iter_ids(const Environment & env, const FilteredGenerator & fg)
+    {
+        return std::make_shared<PackageIDStream>(&env, fg);
+    }
+
+    std::shared_ptr<const PackageID> package_id_stream_next(PackageIDStream & self)
+    {
+        std::shared_ptr<const PackageID> result;
+        {
+            GILReleaser r;
+            result = self.next();
+        }
+
+        if (! result)
+        {
+            PyErr_SetNone(PyExc_StopIteration);
+            bp::throw_error_already_set();
+        }
+
+        return result;
+    }
+
+    bp::object package_id_stream_iter(const bp::object & self)
+    {
+        return self;
+    }
+}
+
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(fetch_unique_qualified_package_name_overloads, fetch_unique_qualified_package_name, 1, 3)
 
 void expose_environment()
@@ -496,6 +659,21 @@ void expose_environment()
                 "Return PackageID instances matching a given selection."
             )
 
+        .def("select_metadata", &environment_select_metadata,
+                "select_metadata(Selection, iterable of str) -> list of (PackageID, tuple)\n"
+                "Run a selection, and fetch the named metadata keys' values as strings for\n"
+                "each resulting PackageID. A value is None if the ID has no such key, or if\n"
+                "it cannot be represented as a string. Other Python threads may run whilst\n"
+                "this works."
+            )
+
+        .def("iter_ids", &environment_iter_ids, bp::with_custodian_and_ward_postcall<0, 1>(),
+                "iter_ids(FilteredGenerator) -> iterator of PackageID\n"
+                "Lazily yield the PackageID instances matching a FilteredGenerator, in the\n"
+                "same order as Selection.AllVersionsSorted, working out one package's IDs\n"
+                "at a time. Other Python threads may run whilst this works."
+            )
+
         .def("fetch_repository", fetch_repository_ptr, bp::with_custodian_and_ward_postcall<0, 1>(),
                 "fetch_repository(RepositoryName) -> Repository\n"
                 "Fetch a named repository."
@@ -536,6 +714,23 @@ void expose_environment()
                 )
         ;
 
+    /**
+     * PackageIDStream
+     */
+    bp::class_<PackageIDStream, std::shared_ptr<PackageIDStream>, boost::noncopyable>
+        (
+         "PackageIDStream",
+         "Lazily yields PackageID instances. Returned by Environment.iter_ids.",
+         bp::no_init
+        )
+
+        .def("__iter__", &package_id_stream_iter)
+
+        .def("__next__", &package_id_stream_next)
+
+        .def("next", &package_id_stream_next)
+        ;
+
     /**
      * EnvironmentImplementation
      */
@@ -62,6 +62,21 @@ class TestCase_01_Environments(unittest.TestCase):
         self.assert_(self.e.reduced_uid() >= 0)
         self.assert_(self.e.reduced_gid() >= 0)
 
+    def test_26_select_metadata(self):
+        s = Selection.AllVersionsSorted(Generator.Package("foo/bar"))
+        r = self.e.select_metadata(s, ["DESCRIPTION", "SLOT", "NOT_A_KEY"])
+        self.assertEqual([str(i) for i in self.e[s]], [str(i) for (i, v) in r])
+        self.assert_(len(r) >= 2)
+        for (i, v) in r:
+            self.assertEqual(v, ("Test package", "0", None))
+
+    def test_27_iter_ids(self):
+        fg = FilteredGenerator(Generator.All(), Filter.All())
+        ids = self.e.iter_ids(fg)
+        self.assert_(isinstance(ids, PackageIDStream))
+        self.assertEqual([str(i) for i in self.e[Selection.AllVersionsSorted(fg)]], [str(i) for i in ids])
+        self.assertEqual([], list(self.e.iter_ids(Generator.Package("foo/baz"))))
+
 class TestCase_03_TestEnvironment(unittest.TestCase):
     def test_01_create(self):
         e = TestEnvironment()
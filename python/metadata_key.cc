@@ -184,7 +184,7 @@ struct MetadataPackageIDKeyWrapper :
     virtual const std::shared_ptr<const PackageID> parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("parse_value"))
             return f();
@@ -194,7 +194,7 @@ struct MetadataPackageIDKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -204,7 +204,7 @@ struct MetadataPackageIDKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -214,7 +214,7 @@ struct MetadataPackageIDKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -237,7 +237,7 @@ struct MetadataStringKeyWrapper :
     virtual const std::string parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("parse_value"))
             return f();
@@ -247,7 +247,7 @@ struct MetadataStringKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -257,7 +257,7 @@ struct MetadataStringKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -267,7 +267,7 @@ struct MetadataStringKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -283,7 +283,7 @@ struct MetadataSlotNameKeyWrapper :
     virtual const Slot parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("parse_value"))
             return f();
@@ -293,7 +293,7 @@ struct MetadataSlotNameKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -303,7 +303,7 @@ struct MetadataSlotNameKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -313,7 +313,7 @@ struct MetadataSlotNameKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -338,7 +338,7 @@ struct MetadataSectionKeyWrapper :
 
     virtual void need_keys_added() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("need_keys_added"))
             f();
@@ -348,7 +348,7 @@ struct MetadataSectionKeyWrapper :
 
     virtual const std::shared_ptr<const MetadataValueKey<std::string> > title_key() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("title_key"))
             return f();
@@ -358,7 +358,7 @@ struct MetadataSectionKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -368,7 +368,7 @@ struct MetadataSectionKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -378,7 +378,7 @@ struct MetadataSectionKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -394,7 +394,7 @@ struct MetadataTimeKeyWrapper :
     virtual Timestamp parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("parse_value"))
             return Timestamp(f(), 0);
@@ -404,7 +404,7 @@ struct MetadataTimeKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -414,7 +414,7 @@ struct MetadataTimeKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -424,7 +424,7 @@ struct MetadataTimeKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -440,7 +440,7 @@ struct MetadataChoicesKeyWrapper :
     virtual const std::shared_ptr<const Choices> parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("parse_value"))
             return f();
@@ -450,7 +450,7 @@ struct MetadataChoicesKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -460,7 +460,7 @@ struct MetadataChoicesKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -470,7 +470,7 @@ struct MetadataChoicesKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -486,7 +486,7 @@ struct MetadataFSPathKeyWrapper :
     virtual const FSPath parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("parse_value"))
             return f();
@@ -496,7 +496,7 @@ struct MetadataFSPathKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -506,7 +506,7 @@ struct MetadataFSPathKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -516,7 +516,7 @@ struct MetadataFSPathKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -533,7 +533,7 @@ struct MetadataCollectionKeyWrapper :
     virtual const std::shared_ptr<const C_> parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("parse_value"))
             return f();
@@ -543,7 +543,7 @@ struct MetadataCollectionKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("raw_name"))
             return f();
@@ -553,7 +553,7 @@ struct MetadataCollectionKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("human_name"))
             return f();
@@ -563,7 +563,7 @@ struct MetadataCollectionKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("type"))
             return f();
@@ -587,7 +587,7 @@ struct MetadataSpecTreeKeyWrapper :
     virtual const std::shared_ptr<const C_> parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("parse_value"))
             return f();
@@ -597,7 +597,7 @@ struct MetadataSpecTreeKeyWrapper :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("raw_name"))
             return f();
@@ -607,7 +607,7 @@ struct MetadataSpecTreeKeyWrapper :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("human_name"))
             return f();
@@ -617,7 +617,7 @@ struct MetadataSpecTreeKeyWrapper :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("type"))
             return f();
@@ -641,7 +641,7 @@ struct MetadataSpecTreeKeyWrapper<FetchableURISpecTree> :
     virtual const std::shared_ptr<const FetchableURISpecTree> parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("parse_value"))
             return f();
@@ -652,7 +652,7 @@ struct MetadataSpecTreeKeyWrapper<FetchableURISpecTree> :
     virtual const std::shared_ptr<const URILabel> initial_label() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("initial_label"))
             return f();
@@ -662,7 +662,7 @@ struct MetadataSpecTreeKeyWrapper<FetchableURISpecTree> :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -672,7 +672,7 @@ struct MetadataSpecTreeKeyWrapper<FetchableURISpecTree> :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -682,7 +682,7 @@ struct MetadataSpecTreeKeyWrapper<FetchableURISpecTree> :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -706,7 +706,7 @@ struct MetadataSpecTreeKeyWrapper<DependencySpecTree> :
     virtual const std::shared_ptr<const DependencySpecTree> parse_value() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("parse_value"))
             return f();
@@ -717,7 +717,7 @@ struct MetadataSpecTreeKeyWrapper<DependencySpecTree> :
     virtual const std::shared_ptr<const DependenciesLabelSequence> initial_labels() const
         PALUDIS_ATTRIBUTE((warn_unused_result))
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = this->get_override("initial_labels"))
             return f();
@@ -727,7 +727,7 @@ struct MetadataSpecTreeKeyWrapper<DependencySpecTree> :
 
     virtual const std::string raw_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("raw_name"))
             return f();
@@ -737,7 +737,7 @@ struct MetadataSpecTreeKeyWrapper<DependencySpecTree> :
 
     virtual const std::string human_name() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("human_name"))
             return f();
@@ -747,7 +747,7 @@ struct MetadataSpecTreeKeyWrapper<DependencySpecTree> :
 
     virtual MetadataKeyType type() const
     {
-        std::unique_lock<std::recursive_mutex> l(get_mutex());
+        PythonLock l;
 
         if (bp::override f = get_override("type"))
             return f();
@@ -18,6 +18,7 @@
  */
 
 #include "mutex.hh"
+#include <Python.h>
 
 namespace paludis
 {
@@ -28,5 +29,32 @@ namespace paludis
             static std::recursive_mutex mutex;
             return mutex;
         }
+
+        PythonLock::PythonLock() :
+            _gil_state(PyGILState_Ensure())
+        {
+            if (! get_mutex().try_lock())
+            {
+                Py_BEGIN_ALLOW_THREADS
+                get_mutex().lock();
+                Py_END_ALLOW_THREADS
+            }
+        }
+
+        PythonLock::~PythonLock()
+        {
+            get_mutex().unlock();
+            PyGILState_Release(static_cast<PyGILState_STATE>(_gil_state));
+        }
+
+        GILReleaser::GILReleaser() :
+            _thread_state(PyEval_SaveThread())
+        {
+        }
+
+        GILReleaser::~GILReleaser()
+        {
+            PyEval_RestoreThread(static_cast<PyThreadState *>(_thread_state));
+        }
     } // namespace paludis::python
 } // namespace paludis
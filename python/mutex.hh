@@ -29,6 +29,46 @@ namespace paludis
     {
         //global mutex for thread safety.
         std::recursive_mutex & get_mutex() PALUDIS_VISIBLE;
+
+        /**
+         * Held whilst calling into Python from C++.
+         *
+         * Takes the GIL, since we may be on a thread that doesn't have it,
+         * either because C++ started it or because a GILReleaser gave it up,
+         * and then the global mutex. Whoever holds the mutex may need the GIL
+         * to finish, so we don't hold the GIL whilst waiting for it.
+         */
+        class PALUDIS_VISIBLE PythonLock
+        {
+            private:
+                int _gil_state;
+
+            public:
+                PythonLock();
+                ~PythonLock();
+
+                PythonLock(const PythonLock &) = delete;
+                PythonLock & operator= (const PythonLock &) = delete;
+        };
+
+        /**
+         * Gives up the GIL for as long as we exist, so that other Python
+         * threads can run whilst we do something slow in C++.
+         *
+         * Anything that might call back into Python must use a PythonLock.
+         */
+        class PALUDIS_VISIBLE GILReleaser
+        {
+            private:
+                void * _thread_state;
+
+            public:
+                GILReleaser();
+                ~GILReleaser();
+
+                GILReleaser(const GILReleaser &) = delete;
+                GILReleaser & operator= (const GILReleaser &) = delete;
+        };
     }
 }
 
@@ -21,6 +21,8 @@
 #include <paludis/util/join.hh>
 #include <paludis/util/wrapped_output_iterator.hh>
 #include <paludis/util/iterator_funcs.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/log.hh>
 #include <paludis/args/do_help.hh>
 #include <paludis/environment_factory.hh>
 #include <paludis/environment.hh>
@@ -34,6 +36,7 @@
 #include "command_factory.hh"
 #include "command_line.hh"
 #include "format_user_config.hh"
+#include "server.hh"
 
 using namespace paludis;
 using std::endl;
@@ -81,13 +84,24 @@ int main(int argc, char * argv[])
         if (cmdline.begin_parameters() == cmdline.end_parameters())
             throw args::DoHelp();
 
+        Log::get_instance()->set_program_name(argv[0]);
+        Log::get_instance()->set_log_level(cmdline.a_log_level.option());
+        if (cmdline.a_structured_log.specified())
+            Log::get_instance()->set_structured_log_file(FSPath(cmdline.a_structured_log.argument()));
+
         std::string cave_var(argv[0]);
         if (cmdline.a_environment.specified())
             cave_var = cave_var + " --" + cmdline.a_environment.long_name() + " " + cmdline.a_environment.argument();
         if (cmdline.a_log_level.specified())
             cave_var = cave_var + " --" + cmdline.a_log_level.long_name() + " " + cmdline.a_log_level.argument();
+        /* things run via $CAVE may be in another directory, so give them
+         * the full path to the structured log */
+        if (cmdline.a_structured_log.specified())
+            cave_var = cave_var + " --" + cmdline.a_structured_log.long_name() + " " + Log::get_instance()->structured_log_file();
         if (cmdline.a_colour.specified())
             cave_var = cave_var + " --" + cmdline.a_colour.long_name() + " " + cmdline.a_colour.argument();
+        if (cmdline.a_server.specified())
+            cave_var = cave_var + " --" + cmdline.a_server.long_name() + " " + cmdline.a_server.argument();
         setenv("CAVE", cave_var.c_str(), 1);
 
         if (cmdline.a_colour.argument() == "yes")
@@ -95,8 +109,18 @@ int main(int argc, char * argv[])
         else if (cmdline.a_colour.argument() == "no")
             cave::set_want_colours(false);
 
-        Log::get_instance()->set_program_name(argv[0]);
-        Log::get_instance()->set_log_level(cmdline.a_log_level.option());
+        if (cmdline.a_server.specified())
+        {
+            cave::set_server_options(cmdline.a_server.argument(), cmdline.a_environment.argument());
+
+            std::shared_ptr<Sequence<std::string> > all_args(std::make_shared<Sequence<std::string>>());
+            std::copy(cmdline.begin_parameters(), cmdline.end_parameters(), all_args->back_inserter());
+
+            int exit_status(EXIT_FAILURE);
+            if (cave::run_on_server(cmdline.a_log_level.option(), cave::get_want_colours(), all_args, exit_status))
+                return exit_status;
+        }
+
         std::shared_ptr<Environment> env(EnvironmentFactory::get_instance()->create(cmdline.a_environment.argument()));
 
         std::shared_ptr<Sequence<std::string> > seq(std::make_shared<Sequence<std::string>>());
@@ -39,7 +39,7 @@
 #include <paludis/filtered_generator.hh>
 #include <paludis/filter.hh>
 #include <paludis/filter_handler.hh>
-#include <paludis/selection.hh>
+#include <paludis/package_id_stream.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/package_id.hh>
 #include <paludis/mask.hh>
@@ -76,12 +76,15 @@ namespace
 
         std::string app_description() const override
         {
-            return "Generates a digest file for a particular package in a particular repository.";
+            return "Generates a digest file for a particular package in a particular repository. If the package "
+                "is given as a wildcard, such as 'cat/*' or '*/*', digests are generated for every matching "
+                "package in the repository in one go, which is much quicker than doing them one at a time.";
         }
 
         DigestCommandLine()
         {
             add_usage_line("cat/pkg repository");
+            add_usage_line("cat/* repository");
         }
     };
 
@@ -94,6 +97,22 @@ namespace
     {
         return wp_yes;
     }
+
+    Generator make_generator(
+            const std::shared_ptr<Environment> & env,
+            const std::string & target,
+            const RepositoryName & repo,
+            const Filter & repo_filter)
+    {
+        if (std::string::npos != target.find('*'))
+            return generator::Matches(parse_user_package_dep_spec(target, env.get(), { updso_allow_wildcards }), nullptr, { })
+                & generator::InRepository(repo);
+
+        QualifiedPackageName pkg(std::string::npos == target.find('/') ?
+                env->fetch_unique_qualified_package_name(PackageNamePart(target), repo_filter) :
+                QualifiedPackageName(target));
+        return generator::Package(pkg) & generator::InRepository(repo);
+    }
 }
 
 int
@@ -116,19 +135,13 @@ DigestCommand::run(
 
     RepositoryName repo(*next(cmdline.begin_parameters()));
     Filter repo_filter(filter::Matches(make_package_dep_spec({ }).in_repository(repo), nullptr, { }));
-    QualifiedPackageName pkg(std::string::npos == cmdline.begin_parameters()->find('/') ?
-            env->fetch_unique_qualified_package_name(PackageNamePart(*cmdline.begin_parameters()), repo_filter) :
-            QualifiedPackageName(*cmdline.begin_parameters()));
-
-    auto ids((*env)[selection::AllVersionsSorted(generator::Package(pkg) & generator::InRepository(repo))]);
 
-    if (ids->empty())
-        nothing_matching_error(env.get(), *cmdline.begin_parameters(), repo_filter);
-
-    for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
-            i != i_end ; ++i)
+    auto pkgs(std::make_shared<QualifiedPackageNameSet>());
+    PackageIDStream ids(env.get(), make_generator(env, *cmdline.begin_parameters(), repo, repo_filter));
+    while (const std::shared_ptr<const PackageID> id = ids.next())
     {
-        Context i_context("When fetching ID '" + stringify(**i) + "':");
+        Context i_context("When fetching ID '" + stringify(*id) + "':");
+        pkgs->insert(id->name());
 
         FetchAction a(make_named_values<FetchActionOptions>(
                     n::errors() = std::make_shared<Sequence<FetchActionFailure>>(),
@@ -141,22 +154,28 @@ DigestCommand::run(
                     n::want_phase() = &want_all_phases
                     ));
 
-        if ((*i)->supports_action(SupportsActionTest<FetchAction>()))
+        if (id->supports_action(SupportsActionTest<FetchAction>()))
         {
-            cout << "Fetching " << **i << "..." << endl;
-            (*i)->perform_action(a);
+            cout << "Fetching " << *id << "..." << endl;
+            id->perform_action(a);
         }
         else
-            cout << "No fetching supported for " << **i << endl;
+            cout << "No fetching supported for " << *id << endl;
 
         cout << endl;
     }
 
+    if (pkgs->empty())
+        nothing_matching_error(env.get(), *cmdline.begin_parameters(), repo_filter);
+
     auto r(env->fetch_repository(repo));
     if (r->manifest_interface())
     {
-        cout << "Making manifest..." << endl;
-        r->manifest_interface()->make_manifest(pkg);
+        if (1 == std::distance(pkgs->begin(), pkgs->end()))
+            cout << "Making manifest..." << endl;
+        else
+            cout << "Making manifests for " << std::distance(pkgs->begin(), pkgs->end()) << " packages..." << endl;
+        r->manifest_interface()->make_manifests(pkgs);
     }
     else
     {
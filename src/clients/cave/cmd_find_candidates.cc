@@ -31,12 +31,14 @@
 #include <paludis/filter.hh>
 #include <paludis/filter_handler.hh>
 #include <paludis/selection.hh>
+#include <paludis/package_id_stream.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/package_id.hh>
 #include <paludis/mask.hh>
 #include <paludis/match_package.hh>
 
 #include <paludis/util/set.hh>
+#include <paludis/util/sequence.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 #include <paludis/util/wrapped_output_iterator.hh>
 #include <paludis/util/make_shared_copy.hh>
@@ -311,17 +313,19 @@ FindCandidatesCommand::run_hosted(
                 match_generator = make_shared_copy(m);
         }
 
-        if (search_options.a_all_versions.specified())
+        /* a wildcard can match much of the tree, so only load one package's
+         * IDs at a time */
+        PackageIDStream stream(env.get(), *match_generator | *mask_filter);
+        while (const std::shared_ptr<const PackageIDSequence> ids = stream.next_package())
         {
-            const std::shared_ptr<const PackageIDSequence> ids((*env)[selection::AllVersionsUnsorted(
-                        *match_generator | *mask_filter)]);
-            check_candidates(yield, step, ids);
-        }
-        else
-        {
-            const std::shared_ptr<const PackageIDSequence> ids((*env)[selection::BestVersionOnly(
-                        *match_generator | *mask_filter)]);
-            check_candidates(yield, step, ids);
+            if (search_options.a_all_versions.specified())
+                check_candidates(yield, step, ids);
+            else
+            {
+                const std::shared_ptr<PackageIDSequence> best(std::make_shared<PackageIDSequence>());
+                best->push_back(*ids->last());
+                check_candidates(yield, step, best);
+            }
         }
     }
 
@@ -28,6 +28,7 @@
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/create_iterator-impl.hh>
 #include <paludis/util/log.hh>
+#include <paludis/util/fs_path.hh>
 #include <paludis/broken_linkage_finder.hh>
 #include <paludis/package_id.hh>
 #include <paludis/name.hh>
@@ -61,13 +62,16 @@ namespace
         args::ArgsGroup g_linkage_options;
         args::StringSetArg a_libraries;
         args::SwitchArg a_exact;
+        args::StringArg a_cache;
 
         FixLinkageCommandLine() :
             g_execution_options(main_options_section(), "Execution Options", "Control execution."),
             a_execute(&g_execution_options, "execute", 'x', "Execute the suggested actions", true),
             g_linkage_options(main_options_section(), "Linkage options", "Options relating to linkage"),
             a_libraries(&g_linkage_options, "library", 'l', "Only rebuild packages linked against this library, even if it exists. May be specified multiple times."),
-            a_exact(&g_linkage_options, "exact", 'e', "Rebuild the same package version that is currently installed", true)
+            a_exact(&g_linkage_options, "exact", 'e', "Rebuild the same package version that is currently installed", true),
+            a_cache(&g_linkage_options, "cache", '\0', "Remember information about each ELF file in the specified file, so "
+                    "that later runs only need to re-read files which have changed")
         {
             add_usage_line("[ -x|--execute ] [ --library foo.so.1 ] [ -- options for 'cave resolve' ]");
 
@@ -180,7 +184,10 @@ FixLinkageCommand::run(const std::shared_ptr<Environment> & env,
     {
         DisplayCallback display_callback("Searching: ");
         ScopedNotifierCallback display_callback_holder(env.get(), NotifierCallbackFunction(std::cref(display_callback)));
-        finder = std::make_shared<BrokenLinkageFinder>(env.get(), libraries);
+        if (cmdline.a_cache.specified())
+            finder = std::make_shared<BrokenLinkageFinder>(env.get(), libraries, FSPath(cmdline.a_cache.argument()));
+        else
+            finder = std::make_shared<BrokenLinkageFinder>(env.get(), libraries);
     }
 
     if (finder->begin_broken_packages() == finder->end_broken_packages())
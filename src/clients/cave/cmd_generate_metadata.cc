@@ -34,7 +34,7 @@
 #include <paludis/filtered_generator.hh>
 #include <paludis/filter.hh>
 #include <paludis/filter_handler.hh>
-#include <paludis/selection.hh>
+#include <paludis/package_id_stream.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/package_id.hh>
 #include <paludis/mask.hh>
@@ -228,16 +228,27 @@ namespace
         }
     };
 
-    void worker(std::mutex & mutex, PackageIDSequence::ConstIterator & i, const PackageIDSequence::ConstIterator & i_end, bool & fail,
-            DisplayCallback & display_callback)
+    void worker(std::mutex & mutex, PackageIDStream & ids, bool & fail, DisplayCallback & display_callback)
     {
         while (true)
         {
             std::shared_ptr<const PackageID> id;
             {
                 std::unique_lock<std::mutex> lock(mutex);
-                if (i != i_end)
-                    id = *i++;
+                try
+                {
+                    id = ids.next();
+                }
+                catch (const InternalError &)
+                {
+                    throw;
+                }
+                catch (const Exception & e)
+                {
+                    std::cerr << "When finding IDs got exception '" << e.message() << "' (" << e.what() << ")" << std::endl;
+                    fail = true;
+                    return;
+                }
             }
 
             if (! id)
@@ -256,7 +267,7 @@ namespace
                 catch (const Exception & e)
                 {
                     std::unique_lock<std::mutex> lock(mutex);
-                    std::cerr << "When processing '" << **i << "' got exception '" << e.message() << "' (" << e.what() << ")" << std::endl;
+                    std::cerr << "When processing '" << *id << "' got exception '" << e.message() << "' (" << e.what() << ")" << std::endl;
                     fail = true;
                     break;
                 }
@@ -296,14 +307,14 @@ GenerateMetadataCommand::run(
         }
     }
 
-    const std::shared_ptr<const PackageIDSequence> ids((*env)[selection::AllVersionsSorted(g)]);
+    /* IDs are found as the workers need them, so we don't hold every ID in
+     * the tree at once, at the cost of not knowing how many there are */
+    PackageIDStream ids(env.get(), g);
     bool fail(false);
     std::mutex mutex;
 
-    PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end());
     {
         DisplayCallback callback;
-        callback.total = std::distance(ids->begin(), ids->end());
         ScopedNotifierCallback display_callback_holder(env.get(), NotifierCallbackFunction(std::cref(callback)));
         ThreadPool pool;
 
@@ -312,7 +323,7 @@ GenerateMetadataCommand::run(
             n_procs = 1;
 
         for (int n(0), n_end(n_procs) ; n != n_end ; ++n)
-            pool.create_thread(std::bind(&worker, std::ref(mutex), std::ref(i), std::cref(i_end), std::ref(fail), std::ref(callback)));
+            pool.create_thread(std::bind(&worker, std::ref(mutex), std::ref(ids), std::ref(fail), std::ref(callback)));
     }
 
     return fail ? EXIT_FAILURE : EXIT_SUCCESS;
@@ -47,6 +47,7 @@
 #include <paludis/util/visitor_cast.hh>
 #include <paludis/util/iterator_funcs.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/fs_stat.hh>
 
 #include <cstdlib>
 #include <iostream>
@@ -193,11 +194,48 @@ namespace
         }
     };
 
+    void add_candidates(CaveSearchExtrasDB * const db, const DisplayCallback & display_callback,
+            const std::shared_ptr<const PackageIDSequence> & ids)
+    {
+        bool is_best(false), had_best_visible(false);
+        std::string old_name;
+        for (auto i(ids->rbegin()), i_end(ids->rend()) ;
+                i != i_end ; ++i)
+        {
+            display_callback(ManageStep{"Writing"});
+
+            std::string name(stringify((*i)->name())), short_desc, long_desc;
+            if ((*i)->short_description_key())
+                short_desc = (*i)->short_description_key()->parse_value();
+            if ((*i)->long_description_key())
+                long_desc = (*i)->long_description_key()->parse_value();
+
+            bool is_visible(! (*i)->masked());
+
+            if (name != old_name)
+            {
+                is_best = true;
+                had_best_visible = false;
+                old_name = name;
+            }
+
+            bool is_best_visible(is_visible && ! had_best_visible);
+            if (is_best_visible)
+                had_best_visible = true;
+
+            SearchExtrasHandle::get_instance()->add_candidate_function(db, stringify((*i)->uniquely_identifying_spec()),
+                    is_visible, is_best, is_best_visible, name, short_desc, long_desc);
+
+            is_best = false;
+        }
+    }
+
     struct ManageSearchIndexCommandLine :
         CaveCommandCommandLine
     {
         args::ArgsGroup g_actions;
         args::SwitchArg a_create;
+        args::SwitchArg a_update;
 
         std::string app_name() const override
         {
@@ -213,15 +251,19 @@ namespace
         {
             return "Manages a search index for use by cave search. A search index is only valid until "
                 "a package is installed or uninstalled, or a sync is performed, or configuration is "
-                "changed.";
+                "changed. When only a few packages are affected, their entries can be updated rather "
+                "than recreating the whole index.";
         }
 
         ManageSearchIndexCommandLine() :
             g_actions(main_options_section(), "Actions", "Specify which action to perform. Exactly one action must be specified."),
             a_create(&g_actions, "create", 'c', "Create a new search index. The existing search index is removed if "
-                    "it already exists", true)
+                    "it already exists", true),
+            a_update(&g_actions, "update", 'u', "Update the entries for the packages named by the remaining "
+                    "parameters in an existing search index", true)
         {
             add_usage_line("--create ~/cave-search-index");
+            add_usage_line("--update ~/cave-search-index cat/pkg [ cat/pkg ... ]");
         }
     };
 }
@@ -241,12 +283,51 @@ ManageSearchIndexCommand::run(
         return EXIT_SUCCESS;
     }
 
-    if (capped_distance(cmdline.begin_parameters(), cmdline.end_parameters(), 2) != 1)
-        throw args::DoHelp("manage-search-index requires exactly one parameter");
-
-    if (! cmdline.a_create.specified())
+    if (cmdline.a_create.specified() == cmdline.a_update.specified())
         throw args::DoHelp("exactly one action must be specified");
 
+    if (cmdline.a_update.specified())
+    {
+        if (cmdline.begin_parameters() == cmdline.end_parameters())
+            throw args::DoHelp("--update requires an index file parameter");
+
+        FSPath index_file(*cmdline.begin_parameters());
+        if (! index_file.stat().is_regular_file())
+            throw args::DoHelp("--update requires an existing index file");
+
+        std::list<QualifiedPackageName> names;
+        for (auto p(next(cmdline.begin_parameters())), p_end(cmdline.end_parameters()) ;
+                p != p_end ; ++p)
+            names.push_back(QualifiedPackageName(*p));
+
+        DisplayCallback display_callback;
+        ScopedNotifierCallback display_callback_holder(env.get(),
+                NotifierCallbackFunction(std::cref(display_callback)));
+
+        CaveSearchExtrasDB * db(SearchExtrasHandle::get_instance()->open_db_function(stringify(index_file).c_str()));
+        display_callback.total = names.size() + 1;
+
+        SearchExtrasHandle::get_instance()->starting_adds_function(db);
+        for (const auto & name : names)
+        {
+            display_callback(ManageStep{"Updating"});
+
+            /* the package may have gone away entirely, in which case
+             * removing its old entries is all there is to do */
+            SearchExtrasHandle::get_instance()->remove_candidates_function(db, stringify(name));
+            add_candidates(db, display_callback, (*env)[selection::AllVersionsSorted(generator::Package(name))]);
+        }
+
+        display_callback(ManageStep{"Finalising"});
+        SearchExtrasHandle::get_instance()->done_adds_function(db);
+        SearchExtrasHandle::get_instance()->cleanup_db_function(db);
+
+        return EXIT_SUCCESS;
+    }
+
+    if (capped_distance(cmdline.begin_parameters(), cmdline.end_parameters(), 2) != 1)
+        throw args::DoHelp("--create requires exactly one parameter");
+
     FSPath index_file(*cmdline.begin_parameters());
     index_file.unlink();
 
@@ -263,38 +344,7 @@ ManageSearchIndexCommand::run(
         display_callback.total = display_callback.steps + std::distance(ids->begin(), ids->end()) + 1;
 
         SearchExtrasHandle::get_instance()->starting_adds_function(db);
-
-        bool is_best(false), had_best_visible(false);
-        std::string old_name;
-        for (auto i(ids->rbegin()), i_end(ids->rend()) ;
-                i != i_end ; ++i)
-        {
-            display_callback(ManageStep{"Writing"});
-
-            std::string name(stringify((*i)->name())), short_desc, long_desc;
-            if ((*i)->short_description_key())
-                short_desc = (*i)->short_description_key()->parse_value();
-            if ((*i)->long_description_key())
-                long_desc = (*i)->long_description_key()->parse_value();
-
-            bool is_visible(! (*i)->masked());
-
-            if (name != old_name)
-            {
-                is_best = true;
-                had_best_visible = false;
-                old_name = name;
-            }
-
-            bool is_best_visible(is_visible && ! had_best_visible);
-            if (is_best_visible)
-                had_best_visible = true;
-
-            SearchExtrasHandle::get_instance()->add_candidate_function(db, stringify((*i)->uniquely_identifying_spec()),
-                    is_visible, is_best, is_best_visible, name, short_desc, long_desc);
-
-            is_best = false;
-        }
+        add_candidates(db, display_callback, ids);
 
         display_callback(ManageStep{"Finalising"});
         SearchExtrasHandle::get_instance()->done_adds_function(db);
@@ -32,6 +32,9 @@
 #include <paludis/util/map.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/stringify.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/sequence.hh>
 
 #include <paludis/name.hh>
 #include <paludis/environment.hh>
@@ -48,10 +51,12 @@
 #include <paludis/standard_output_manager.hh>
 #include <paludis/action.hh>
 #include <paludis/partially_made_package_dep_spec.hh>
+#include <paludis/distfile_index.hh>
 
 #include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <set>
 
 #include "command_command_line.hh"
 
@@ -83,12 +88,22 @@ namespace
         args::ArgsGroup g_filters;
         args::StringSetArg a_matching;
 
+        args::ArgsGroup g_mirror_options;
+        args::SwitchArg a_only_missing;
+        args::StringArg a_index;
+
         MirrorCommandLine() :
             g_filters(main_options_section(), "Filters", "Filter the output. Each filter may be specified more than once."),
             a_matching(&g_filters, "matching", 'm', "Consider only IDs matching this spec.",
-                    args::StringSetArg::StringSetArgOptions())
+                    args::StringSetArg::StringSetArgOptions()),
+            g_mirror_options(main_options_section(), "Mirror Options", "Alter how mirroring is done."),
+            a_only_missing(&g_mirror_options, "only-missing", '\0', "Only fetch for IDs that have a distfile which "
+                    "isn't in any distdir. Distfiles which are already there aren't checked against the Manifest.", true),
+            a_index(&g_mirror_options, "index", '\0', "With --only-missing, remember which distfiles each ID has in the "
+                    "specified file, so that later runs only need to re-read IDs whose metadata has changed")
         {
             add_usage_line("[ --matching spec ]");
+            add_usage_line("--only-missing [ --index file ] [ --matching spec ]");
         }
     };
 
@@ -121,6 +136,9 @@ MirrorCommand::run(
     if (cmdline.begin_parameters() != cmdline.end_parameters())
         throw args::DoHelp("mirror takes no parameters");
 
+    if (cmdline.a_index.specified() && ! cmdline.a_only_missing.specified())
+        throw args::DoHelp("--index requires --only-missing");
+
     Generator g((generator::All()));
     if (cmdline.a_matching.specified())
     {
@@ -135,11 +153,45 @@ MirrorCommand::run(
 
     const std::shared_ptr<const PackageIDSequence> ids((*env)[selection::AllVersionsSorted(g)]);
 
+    std::shared_ptr<DistfileIndex> index;
+    std::set<std::string> present;
+    if (cmdline.a_only_missing.specified())
+    {
+        std::shared_ptr<const FSPath> index_file;
+        if (cmdline.a_index.specified())
+            index_file = std::make_shared<FSPath>(cmdline.a_index.argument());
+        index = std::make_shared<DistfileIndex>(env.get(), index_file);
+
+        auto distdirs(std::make_shared<FSPathSequence>());
+        for (const auto & repository : env->repositories())
+        {
+            auto distdir_metadata(repository->find_metadata("distdir"));
+            if (distdir_metadata != repository->end_metadata())
+            {
+                auto path_key(visitor_cast<const MetadataValueKey<FSPath>>(**distdir_metadata));
+                if (path_key && path_key->parse_value().stat().is_directory())
+                    distdirs->push_back(path_key->parse_value());
+            }
+        }
+
+        auto files(scan_distdirs(distdirs));
+        for (const auto & file : *files)
+            present.insert(file.basename());
+    }
+
     for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
             i != i_end ; ++i)
     {
         Context i_context("When fetching ID '" + stringify(**i) + "':");
 
+        if (index)
+        {
+            auto files(index->all_distfiles(*i));
+            if (files->end() == std::find_if(files->begin(), files->end(),
+                        [&] (const std::string & f) { return present.end() == present.find(f); }))
+                continue;
+        }
+
         FetchAction a(make_named_values<FetchActionOptions>(
                     n::errors() = std::make_shared<Sequence<FetchActionFailure>>(),
                     n::exclude_unmirrorable() = true,
@@ -162,6 +214,9 @@ MirrorCommand::run(
         cout << endl;
     }
 
+    if (index)
+        index->save();
+
     return EXIT_SUCCESS;
 }
 
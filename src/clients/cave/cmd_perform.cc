@@ -22,6 +22,7 @@
 #include "exceptions.hh"
 #include "format_user_config.hh"
 #include "parse_spec_with_nice_error.hh"
+#include "server.hh"
 #include <paludis/args/args.hh>
 #include <paludis/args/do_help.hh>
 #include <paludis/name.hh>
@@ -558,6 +559,7 @@ PerformCommand::run(
                     ));
         InstallAction install_action(options);
         execute(env, cmdline, id, action, install_action, output_manager_holder);
+        notify_server_of_changes();
     }
     else if (action == "pretend")
     {
@@ -599,6 +601,7 @@ PerformCommand::run(
                     ));
         UninstallAction uninstall_action(options);
         execute(env, cmdline, id, action, uninstall_action, output_manager_holder);
+        notify_server_of_changes();
     }
     else
         throw args::DoHelp("action '" + action + "' unrecognised");
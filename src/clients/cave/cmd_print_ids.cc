@@ -34,7 +34,7 @@
 #include <paludis/filtered_generator.hh>
 #include <paludis/filter.hh>
 #include <paludis/filter_handler.hh>
-#include <paludis/selection.hh>
+#include <paludis/package_id_stream.hh>
 #include <paludis/user_dep_spec.hh>
 #include <paludis/package_id.hh>
 #include <paludis/mask.hh>
@@ -302,10 +302,9 @@ PrintIDsCommand::run(
         }
     }
 
-    const std::shared_ptr<const PackageIDSequence> ids((*env)[selection::AllVersionsSorted(fg)]);
-    for (PackageIDSequence::ConstIterator i(ids->begin()), i_end(ids->end()) ;
-            i != i_end ; ++i)
-        cout << format_package_id(*i, cmdline.a_format.argument());
+    PackageIDStream ids(env.get(), fg);
+    while (const std::shared_ptr<const PackageID> id = ids.next())
+        cout << format_package_id(id, cmdline.a_format.argument());
 
     return EXIT_SUCCESS;
 }
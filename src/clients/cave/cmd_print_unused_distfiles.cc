@@ -23,6 +23,7 @@
 
 #include <paludis/args/args.hh>
 #include <paludis/args/do_help.hh>
+#include <paludis/distfile_index.hh>
 #include <paludis/environment.hh>
 #include <paludis/filter.hh>
 #include <paludis/filter_handler.hh>
@@ -35,9 +36,10 @@
 #include <paludis/repository.hh>
 #include <paludis/selection.hh>
 #include <paludis/user_dep_spec.hh>
-#include <paludis/util/fs_iterator.hh>
-#include <paludis/util/indirect_iterator-impl.hh>
+#include <paludis/util/fs_path.hh>
 #include <paludis/util/map.hh>
+#include <paludis/util/set.hh>
+#include <paludis/util/sequence.hh>
 #include <paludis/util/visitor_cast.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
 
@@ -75,57 +77,19 @@ namespace
 
         args::ArgsGroup g_repository_options;
         args::StringSetArg a_include;
+        args::StringArg a_index;
 
         PrintUnusedDistfilesCommandLine() :
             g_repository_options(main_options_section(), "Repository Options", "Alter how repositories are handled."),
             a_include(&g_repository_options, "include", 'i', "Treat all distfiles from IDs in the specified repository "
                     "as used. May be specified multiple times. Typically this is used for binary repositories, to avoid "
-                    "treating non-installed binary distfiles as unused.")
+                    "treating non-installed binary distfiles as unused."),
+            a_index(&g_repository_options, "index", '\0', "Remember which distfiles each ID uses in the specified file, so "
+                    "that later runs only need to re-read IDs whose metadata or choices have changed")
         {
-            add_usage_line("[ --include mybinrepo ... ]");
+            add_usage_line("[ --include mybinrepo ... ] [ --index file ]");
         }
     };
-
-    /* This visitor finds all distfiles used by installed packages. */
-    class DistfilesFilter
-    {
-        private:
-            const Environment * const env;
-            const std::shared_ptr<const PackageID> id;
-            std::set<std::string> & files;
-
-        public:
-            DistfilesFilter(const Environment * const e,
-                    const std::shared_ptr<const PackageID> & i,
-                    std::set<std::string> & f) :
-                env(e),
-                id(i),
-                files(f)
-            {
-            }
-
-            void visit(const FetchableURISpecTree::NodeType<AllDepSpec>::Type & node)
-            {
-                std::for_each(indirect_iterator(node.begin()), indirect_iterator(node.end()), accept_visitor(*this));
-            }
-
-            void visit(const FetchableURISpecTree::NodeType<ConditionalDepSpec>::Type & node)
-            {
-                // recurse iff the conditions (e.g. useflags) are met
-                if (node.spec()->condition_met(env, id))
-                    std::for_each(indirect_iterator(node.begin()), indirect_iterator(node.end()), accept_visitor(*this));
-            }
-
-            void visit(const FetchableURISpecTree::NodeType<FetchableURIDepSpec>::Type & node)
-            {
-                // found used distfile
-                files.insert(node.spec()->filename());
-            }
-
-            void visit(const FetchableURISpecTree::NodeType<URILabelsDepSpec>::Type &)
-            {
-            }
-    };
 }
 
 int
@@ -156,6 +120,11 @@ PrintUnusedDistfilesCommand::run(
 
     std::set<std::string> used_distfiles;
 
+    std::shared_ptr<const FSPath> index_file;
+    if (cmdline.a_index.specified())
+        index_file = std::make_shared<FSPath>(cmdline.a_index.argument());
+    DistfileIndex index(env.get(), index_file);
+
     std::list<Selection> selections;
     selections.push_back(selection::AllVersionsUnsorted(generator::All() | filter::InstalledAtRoot(env->preferred_root_key()->parse_value())));
 
@@ -174,14 +143,13 @@ PrintUnusedDistfilesCommand::run(
             if (! already_done.insert(*iter).second)
                 continue;
 
-            if ((*iter)->fetches_key())
-            {
-                DistfilesFilter filter(env.get(), *iter, used_distfiles);
-                (*iter)->fetches_key()->parse_value()->top()->accept(filter);
-            }
+            auto files(index.used_distfiles(*iter));
+            used_distfiles.insert(files->begin(), files->end());
         }
     }
 
+    index.save();
+
     //
     // Find all distdirs
     //
@@ -200,17 +168,23 @@ PrintUnusedDistfilesCommand::run(
     }
 
     //
-    // Iterate through the distdirs and compare their contents with the used distfiles
+    // Read the distdirs and compare their contents with the used distfiles
     //
 
-    for (const auto & distdir : distdirs)
+    auto distdir_sequence(std::make_shared<FSPathSequence>());
+    std::copy(distdirs.begin(), distdirs.end(), distdir_sequence->back_inserter());
+
+    auto files(scan_distdirs(distdir_sequence));
+    for (const auto & file : *files)
     {
-        for (FSIterator file(distdir, {fsio_include_dotfiles, fsio_want_regular_files}), f_end ;
-            file != f_end ; ++file)
-        {
-            if (used_distfiles.find(file->basename()) == used_distfiles.end())
-                cout << *file << endl;
-        }
+        /* our own bookkeeping, not a distfile, including any temporary
+         * file left behind whilst saving it */
+        std::string basename(file.basename());
+        if (basename == ".paludis-mirror-health" || 0 == basename.compare(0, 27, ".paludis-mirror-health.tmp."))
+            continue;
+
+        if (used_distfiles.find(file.basename()) == used_distfiles.end())
+            cout << file << endl;
     }
 
     return EXIT_SUCCESS;
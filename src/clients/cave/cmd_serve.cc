@@ -0,0 +1,641 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "cmd_serve.hh"
+#include "command_factory.hh"
+#include "format_user_config.hh"
+#include "server.hh"
+
+#include <paludis/args/args.hh>
+#include <paludis/args/do_help.hh>
+#include <paludis/environment.hh>
+#include <paludis/environment_factory.hh>
+#include <paludis/repository.hh>
+#include <paludis/metadata_key.hh>
+#include <paludis/action.hh>
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/iterator_funcs.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/join.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/fs_stat.hh>
+#include <paludis/util/fs_iterator.hh>
+#include <paludis/util/timestamp.hh>
+#include <paludis/util/log.hh>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "command_command_line.hh"
+
+using namespace paludis;
+using namespace cave;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+    struct ServeCommandLine :
+        CaveCommandCommandLine
+    {
+        std::string app_name() const override
+        {
+            return "cave serve";
+        }
+
+        std::string app_synopsis() const override
+        {
+            return "Keeps an environment loaded, and runs read-only commands for other cave processes.";
+        }
+
+        std::string app_description() const override
+        {
+            return "Listens on the Unix socket named by the global --server option, and runs has-version, "
+                "match, print-best-version, print-categories, print-ids, print-packages, print-repositories, "
+                "print-set and print-sets for other cave processes given the same --server option, so that "
+                "they do not have to load their own environment. A client only uses the server if its "
+                "--environment and its PALUDIS_*, CAVE*_OPTIONS, HOME and ROOT environment variables are the "
+                "same as the server's; otherwise, or if no server is running, it runs the command itself. "
+                "The environment is reloaded if configuration files, the directories holding installed "
+                "packages, or the top level or metadata directory of any other repository change, or if a cave process using the same --server option installs, uninstalls, "
+                "syncs or updates the world set.";
+        }
+
+        args::ArgsGroup g_control_options;
+        args::SwitchArg a_invalidate;
+        args::SwitchArg a_stop;
+
+        ServeCommandLine() :
+            g_control_options(main_options_section(), "Control Options", "Control an already running server."),
+            a_invalidate(&g_control_options, "invalidate", '\0', "Tell the running server to reload its environment "
+                    "before running anything else", false),
+            a_stop(&g_control_options, "stop", '\0', "Tell the running server to exit", false)
+        {
+            add_usage_line("");
+            add_usage_line("--invalidate");
+            add_usage_line("--stop");
+        }
+    };
+
+    struct RedirectStream
+    {
+        std::ostream & stream;
+        std::streambuf * const old_buf;
+
+        RedirectStream(std::ostream & s, std::streambuf * const b) :
+            stream(s),
+            old_buf(s.rdbuf(b))
+        {
+        }
+
+        ~RedirectStream()
+        {
+            stream.flush();
+            stream.rdbuf(old_buf);
+            stream.clear();
+        }
+    };
+
+    /* Points one of our own file descriptors at a temporary file whilst we
+     * run a command, so that what child processes write there goes back to
+     * the client too, rather than to wherever the server's output goes. */
+    class RedirectFd
+    {
+        private:
+            const int _fd;
+            std::FILE * const _temp;
+            int _saved_fd;
+
+        public:
+            explicit RedirectFd(const int f) :
+                _fd(f),
+                _temp(std::tmpfile()),
+                _saved_fd(-1)
+            {
+                if (! _temp)
+                    throw ServerError("Cannot create a temporary file: " + std::string(std::strerror(errno)));
+
+                std::fflush(nullptr);
+                _saved_fd = ::fcntl(_fd, F_DUPFD_CLOEXEC, 0);
+                if (-1 == _saved_fd || -1 == ::dup2(::fileno(_temp), _fd))
+                {
+                    int e(errno);
+                    if (-1 != _saved_fd)
+                        ::close(_saved_fd);
+                    std::fclose(_temp);
+                    throw ServerError("Cannot redirect file descriptor " + stringify(_fd) + ": " + std::strerror(e));
+                }
+            }
+
+            ~RedirectFd()
+            {
+                restore();
+                std::fclose(_temp);
+            }
+
+            RedirectFd(const RedirectFd &) = delete;
+            RedirectFd & operator= (const RedirectFd &) = delete;
+
+            void restore()
+            {
+                if (-1 == _saved_fd)
+                    return;
+
+                std::fflush(nullptr);
+                ::dup2(_saved_fd, _fd);
+                ::close(_saved_fd);
+                _saved_fd = -1;
+            }
+
+            /* puts the descriptor back, and returns what was written to it */
+            std::string captured()
+            {
+                restore();
+
+                std::string result;
+                char buf[4096];
+                int temp_fd(::fileno(_temp));
+                if (-1 == ::lseek(temp_fd, 0, SEEK_SET))
+                    return result;
+
+                while (true)
+                {
+                    ssize_t n(::read(temp_fd, buf, sizeof(buf)));
+                    if (-1 == n && EINTR == errno)
+                        continue;
+                    else if (n <= 0)
+                        break;
+                    result.append(buf, n);
+                }
+
+                return result;
+            }
+    };
+
+    void add_to_stamp(std::vector<std::string> & lines, const FSPath & f, const int depth)
+    {
+        FSStat st(f);
+        if (! st.exists())
+        {
+            lines.push_back(stringify(f));
+            return;
+        }
+
+        lines.push_back(stringify(f) + " " + stringify(st.mtim().seconds()) + " " +
+                stringify(st.mtim().nanoseconds()) + " " + stringify(st.file_size()));
+
+        if (depth > 0 && st.is_directory())
+        {
+            std::vector<std::string> children;
+            for (FSIterator c(f, { fsio_include_dotfiles }), c_end ; c != c_end ; ++c)
+                children.push_back(stringify(*c));
+            std::sort(children.begin(), children.end());
+
+            for (const auto & c : children)
+                add_to_stamp(lines, FSPath(c), depth - 1);
+        }
+    }
+
+    /* everything we know of that can change what our environment would say
+     * without the environment noticing for itself */
+    std::string make_stamp(const std::shared_ptr<const Environment> & env)
+    {
+        std::vector<std::string> lines;
+
+        if (env->config_location_key())
+            add_to_stamp(lines, env->config_location_key()->parse_value(), 3);
+
+        for (const auto & repository : env->repositories())
+        {
+            if (! repository->location_key())
+                continue;
+
+            FSPath location(repository->location_key()->parse_value());
+            add_to_stamp(lines, location, 1);
+
+            /* a sync that we weren't told about changes the top level (.git,
+             * for one) or the timestamps in metadata/ */
+            if (! repository->installed_root_key())
+                add_to_stamp(lines, location / "metadata", 1);
+        }
+
+        return join(lines.begin(), lines.end(), "\n");
+    }
+
+    class Server
+    {
+        private:
+            const std::string _socket;
+            const std::string _socket_to_unlink;
+            const std::string _environment_spec;
+            const std::string _variables;
+            std::shared_ptr<Environment> _env;
+            std::string _stamp;
+            int _fd;
+            bool _stop;
+
+            void _ensure_environment()
+            {
+                if (_env)
+                {
+                    if (make_stamp(_env) == _stamp)
+                        return;
+
+                    Log::get_instance()->message("cave.serve.reloading", ll_debug, lc_no_context)
+                        << "Configuration or installed packages have changed, reloading the environment";
+                }
+
+                _env.reset();
+                _env = EnvironmentFactory::get_instance()->create(_environment_spec);
+                _stamp = make_stamp(_env);
+            }
+
+            int _run_command(const std::vector<std::string> & args)
+            {
+                Context context("When serving '" + join(args.begin(), args.end(), " ") + "':");
+
+                try
+                {
+                    std::shared_ptr<Sequence<std::string> > seq(std::make_shared<Sequence<std::string>>());
+                    std::copy(next(args.begin()), args.end(), seq->back_inserter());
+                    return CommandFactory::get_instance()->create(*args.begin())->run(_env, seq);
+                }
+                catch (const args::DoHelp & h)
+                {
+                    if (h.message.empty())
+                        cout << "Usage: cave COMMAND [ARGS]" << endl;
+                    else
+                        cerr << "Usage error: " << h.message << endl;
+                    return EXIT_FAILURE;
+                }
+                catch (const ActionAbortedError & e)
+                {
+                    cout << endl;
+                    cerr << "Action aborted:" << endl
+                        << "  * " << e.backtrace("\n  * ")
+                        << e.message() << " (" << e.what() << ")" << endl;
+                    return 42;
+                }
+                catch (const Exception & e)
+                {
+                    cerr << endl;
+                    cerr << "Error:" << endl;
+                    cerr << "  * " << e.backtrace("\n  * ") << e.message() << " (" << e.what() << ")" << endl;
+                    cerr << endl;
+                    return EXIT_FAILURE;
+                }
+                catch (const std::exception & e)
+                {
+                    cerr << endl;
+                    cerr << "Error:" << endl;
+                    cerr << "  * " << e.what() << endl;
+                    cerr << endl;
+                    return EXIT_FAILURE;
+                }
+            }
+
+            void _use_structured_log(const std::string & file)
+            {
+                if (file == Log::get_instance()->structured_log_file())
+                    return;
+
+                if (file.empty())
+                    Log::get_instance()->unset_structured_log_file();
+                else
+                    Log::get_instance()->set_structured_log_file(FSPath(file));
+            }
+
+            void _handle_run(ServerConnection & connection)
+            {
+                std::string environment_spec(connection.read_string());
+                LogLevel log_level(destringify<LogLevel>(connection.read_string()));
+                std::string structured_log(connection.read_string());
+                bool want_colours(connection.read_string() == "yes");
+                std::string cwd(connection.read_string());
+                std::string variables(connection.read_string());
+                auto args_count(destringify<std::vector<std::string>::size_type>(connection.read_string()));
+                if (args_count > 10000)
+                    throw ServerError("Too many arguments received");
+                std::vector<std::string> args(args_count);
+                for (auto & a : args)
+                    a = connection.read_string();
+
+                if (environment_spec != _environment_spec)
+                {
+                    connection.write_string("declined");
+                    connection.write_string("the server was started with a different --environment");
+                    return;
+                }
+
+                if (variables != _variables)
+                {
+                    connection.write_string("declined");
+                    connection.write_string("the server was started with different environment variables");
+                    return;
+                }
+
+                if (args.empty() || ! command_can_run_on_server(*args.begin()))
+                {
+                    connection.write_string("declined");
+                    connection.write_string("the server does not run this command");
+                    return;
+                }
+
+                if (0 != ::chdir(cwd.c_str()))
+                {
+                    connection.write_string("declined");
+                    connection.write_string("the server cannot change to directory '" + cwd + "'");
+                    return;
+                }
+
+                std::stringstream out, err;
+                int exit_status;
+                LogLevel old_log_level(Log::get_instance()->log_level());
+                std::string old_structured_log(Log::get_instance()->structured_log_file());
+                RedirectFd redirect_stdout(STDOUT_FILENO), redirect_stderr(STDERR_FILENO);
+                {
+                    RedirectStream redirect_cout(cout, out.rdbuf());
+                    RedirectStream redirect_cerr(cerr, err.rdbuf());
+                    Log::get_instance()->set_log_level(log_level);
+                    set_want_colours(want_colours);
+
+                    try
+                    {
+                        _use_structured_log(structured_log);
+                        _ensure_environment();
+                        exit_status = _run_command(args);
+                    }
+                    catch (const Exception & e)
+                    {
+                        /* most likely we couldn't load the environment */
+                        cerr << endl;
+                        cerr << "Error:" << endl;
+                        cerr << "  * " << e.backtrace("\n  * ") << e.message() << " (" << e.what() << ")" << endl;
+                        cerr << endl;
+                        exit_status = EXIT_FAILURE;
+                    }
+                    catch (const std::exception & e)
+                    {
+                        cerr << endl;
+                        cerr << "Error:" << endl;
+                        cerr << "  * " << e.what() << endl;
+                        cerr << endl;
+                        exit_status = EXIT_FAILURE;
+                    }
+
+                    Log::get_instance()->set_log_level(old_log_level);
+                }
+
+                try
+                {
+                    _use_structured_log(old_structured_log);
+                }
+                catch (const Exception & e)
+                {
+                    Log::get_instance()->unset_structured_log_file();
+                    Log::get_instance()->message("cave.serve.structured_log", ll_warning, lc_no_context)
+                        << "Cannot go back to structured log file '" << old_structured_log << "': " << e.message();
+                }
+
+                if (0 != ::chdir("/"))
+                    Log::get_instance()->message("cave.serve.chdir", ll_warning, lc_no_context)
+                        << "Cannot change to '/': " << std::strerror(errno);
+
+                /* anything child processes wrote comes after what we wrote
+                 * ourselves, since we can't tell how the two were interleaved */
+                out << redirect_stdout.captured();
+                err << redirect_stderr.captured();
+
+                connection.write_string("ok");
+                connection.write_string(stringify(exit_status));
+                connection.write_string(out.str());
+                connection.write_string(err.str());
+            }
+
+            void _handle(ServerConnection & connection)
+            {
+#ifdef SO_PEERCRED
+                /* the socket's permissions should already stop this */
+                struct ucred cred;
+                socklen_t cred_len(sizeof(cred));
+                if (0 != ::getsockopt(connection.fd(), SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) || cred.uid != ::getuid())
+                    throw ServerError("Client is running as a different user");
+#endif
+
+                std::string kind(connection.read_request());
+
+                if (kind == "run")
+                    _handle_run(connection);
+                else if (kind == "invalidate")
+                {
+                    _env.reset();
+                    connection.write_string("ok");
+                }
+                else if (kind == "stop")
+                {
+                    _stop = true;
+                    connection.write_string("ok");
+                }
+                else
+                {
+                    connection.write_string("declined");
+                    connection.write_string("unknown request '" + kind + "'");
+                }
+            }
+
+            /* one bad request shouldn't take the whole server down */
+            void _send_error(ServerConnection & connection, const std::string & message)
+            {
+                Log::get_instance()->message("cave.serve.request_failed", ll_warning, lc_no_context)
+                    << "Could not handle a request: " << message;
+
+                try
+                {
+                    connection.write_string("error");
+                    connection.write_string(message);
+                }
+                catch (const ServerError &)
+                {
+                }
+            }
+
+        public:
+            Server(const std::string & s, const std::string & e, const std::shared_ptr<Environment> & env) :
+                _socket(s),
+                _socket_to_unlink(s.empty() || '/' == s[0] ? s : stringify(FSPath::cwd() / s)),
+                _environment_spec(e),
+                _variables(server_relevant_environment_variables()),
+                _env(env),
+                _stamp(make_stamp(env)),
+                _fd(-1),
+                _stop(false)
+            {
+                struct sockaddr_un addr;
+                std::memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                if (_socket.length() >= sizeof(addr.sun_path))
+                    throw ServerError("Server socket name '" + _socket + "' is too long");
+                std::strncpy(addr.sun_path, _socket.c_str(), sizeof(addr.sun_path) - 1);
+
+                if (FSPath(_socket).stat().exists())
+                {
+                    bool running(false);
+                    try
+                    {
+                        ServerConnection connection(_socket);
+                        running = true;
+                    }
+                    catch (const ServerError &)
+                    {
+                    }
+
+                    if (running)
+                        throw ServerError("A server is already listening on '" + _socket + "'");
+
+                    /* left behind by a server that didn't exit cleanly */
+                    ::unlink(_socket.c_str());
+                }
+
+                _fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (-1 == _fd)
+                    throw ServerError("socket failed: " + std::string(std::strerror(errno)));
+
+                /* only we should be able to talk to us */
+                mode_t old_umask(::umask(0077));
+                int bind_result(::bind(_fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)));
+                int bind_errno(errno);
+                ::umask(old_umask);
+
+                if (-1 == bind_result || -1 == ::listen(_fd, 16))
+                {
+                    int listen_errno(-1 == bind_result ? bind_errno : errno);
+                    ::close(_fd);
+                    throw ServerError("Cannot listen on '" + _socket + "': " + std::strerror(listen_errno));
+                }
+            }
+
+            ~Server()
+            {
+                ::close(_fd);
+
+                /* we've changed directory since we created it */
+                ::unlink(_socket_to_unlink.c_str());
+            }
+
+            void serve()
+            {
+                if (0 != ::chdir("/"))
+                    throw ServerError("Cannot change to '/': " + std::string(std::strerror(errno)));
+
+                while (! _stop)
+                {
+                    int fd(::accept4(_fd, nullptr, nullptr, SOCK_CLOEXEC));
+                    if (-1 == fd)
+                    {
+                        if (EINTR == errno || ECONNABORTED == errno)
+                            continue;
+                        throw ServerError("accept failed: " + std::string(std::strerror(errno)));
+                    }
+
+                    ServerConnection connection(fd);
+                    try
+                    {
+                        _handle(connection);
+                    }
+                    catch (const ServerError & e)
+                    {
+                        Log::get_instance()->message("cave.serve.client_failed", ll_debug, lc_no_context)
+                            << "Giving up on a client: " << e.message();
+                    }
+                    catch (const Exception & e)
+                    {
+                        _send_error(connection, e.message() + " (" + e.what() + ")");
+                    }
+                    catch (const std::exception & e)
+                    {
+                        _send_error(connection, e.what());
+                    }
+                }
+            }
+    };
+}
+
+int
+ServeCommand::run(
+        const std::shared_ptr<Environment> & env,
+        const std::shared_ptr<const Sequence<std::string > > & args
+        )
+{
+    ServeCommandLine cmdline;
+    cmdline.run(args, "CAVE", "CAVE_SERVE_OPTIONS", "CAVE_SERVE_CMDLINE");
+
+    if (cmdline.a_help.specified())
+    {
+        cout << cmdline;
+        return EXIT_SUCCESS;
+    }
+
+    if (cmdline.begin_parameters() != cmdline.end_parameters())
+        throw args::DoHelp("serve takes no parameters");
+
+    if (server_socket().empty())
+        throw args::DoHelp("serve requires the global --server option");
+
+    if (cmdline.a_invalidate.specified() || cmdline.a_stop.specified())
+    {
+        ServerConnection connection(server_socket());
+        connection.write_request(cmdline.a_stop.specified() ? "stop" : "invalidate");
+        if (connection.read_string() != "ok")
+            throw ServerError("The server at '" + server_socket() + "' did not accept the request");
+        return EXIT_SUCCESS;
+    }
+
+    Server server(server_socket(), server_environment_spec(), env);
+    server.serve();
+
+    return EXIT_SUCCESS;
+}
+
+std::shared_ptr<args::ArgsHandler>
+ServeCommand::make_doc_cmdline()
+{
+    return std::make_shared<ServeCommandLine>();
+}
+
+CommandImportance
+ServeCommand::importance() const
+{
+    return ci_supplemental;
+}
+
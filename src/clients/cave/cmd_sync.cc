@@ -21,6 +21,7 @@
 #include "exceptions.hh"
 #include "colours.hh"
 #include "format_user_config.hh"
+#include "server.hh"
 #include <paludis/util/named_value.hh>
 #include <paludis/util/make_named_values.hh>
 #include <paludis/util/return_literal_function.hh>
@@ -404,6 +405,7 @@ SyncCommand::run(
         repository->invalidate();
         repository->purge_invalid_cache();
     }
+    notify_server_of_changes();
 
     if (0 != env->perform_hook(Hook("sync_all_post")
                 ("TARGETS", join(repos.begin(), repos.end(), " ")),
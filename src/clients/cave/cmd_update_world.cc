@@ -19,6 +19,7 @@
 
 #include "cmd_update_world.hh"
 #include "format_user_config.hh"
+#include "server.hh"
 #include <paludis/args/args.hh>
 #include <paludis/args/do_help.hh>
 #include <paludis/util/wrapped_forward_iterator.hh>
@@ -167,6 +168,8 @@ UpdateWorldCommand::run(
         }
     }
 
+    notify_server_of_changes();
+
     return EXIT_SUCCESS;
 }
 
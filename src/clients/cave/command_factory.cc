@@ -88,6 +88,7 @@
 #include "cmd_resolve.hh"
 #include "cmd_resume.hh"
 #include "cmd_search.hh"
+#include "cmd_serve.hh"
 #include "cmd_show.hh"
 #include "cmd_size.hh"
 #include "cmd_sync.hh"
@@ -212,6 +213,7 @@ CommandFactory::CommandFactory() :
     _imp->handlers.insert(std::make_pair("resolve", std::bind(&make_command<ResolveCommand>)));
     _imp->handlers.insert(std::make_pair("resume", std::bind(&make_command<ResumeCommand>)));
     _imp->handlers.insert(std::make_pair("search", std::bind(&make_command<SearchCommand>)));
+    _imp->handlers.insert(std::make_pair("serve", std::bind(&make_command<ServeCommand>)));
     _imp->handlers.insert(std::make_pair("show", std::bind(&make_command<ShowCommand>)));
     _imp->handlers.insert(std::make_pair("size", std::bind(&make_command<SizeCommand>)));
     _imp->handlers.insert(std::make_pair("sync", std::bind(&make_command<SyncCommand>)));
@@ -29,6 +29,10 @@ CaveCommandLine::CaveCommandLine() :
     a_environment(&g_global_options, "environment", 'E',
             "Environment specification (class:suffix, both parts optional)"),
     a_log_level(&g_global_options, "log-level", 'L'),
+    a_structured_log(&g_global_options, "structured-log", '\0',
+            "Also append log messages to this file, one JSON object per line"),
+    a_server(&g_global_options, "server", '\0',
+            "Have the 'cave serve' process listening on this Unix socket run read-only commands, if it is running"),
     a_colour(&g_global_options, "colour", 'c',
             "Specify whether to use colour",
             args::EnumArg::EnumArgOptions
@@ -43,6 +43,12 @@ paludis::cave::set_want_colours(const bool v)
     want_colours = v;
 }
 
+bool
+paludis::cave::get_want_colours()
+{
+    return want_colours;
+}
+
 namespace
 {
     std::string
@@ -34,6 +34,7 @@ namespace paludis
     namespace cave
     {
         void set_want_colours(const bool v);
+        bool get_want_colours() PALUDIS_ATTRIBUTE((warn_unused_result));
 
         class FormatUserConfigFile :
             public Singleton<FormatUserConfigFile>
@@ -85,6 +85,10 @@ ResolveCommandLineResolutionOptions::ResolveCommandLineResolutionOptions(args::A
     a_no_restarts_for(&g_resolution_options, "no-restarts-for", '\0',
             "Do not restart if the problematic package has the specified package name. May be specified "
             "multiple times. Use '*/*' to avoid all restarts."),
+    a_incremental_restarts(&g_resolution_options, "incremental-restarts", '\0',
+            "When restarting, undo only the decisions that were affected by the problematic package, "
+            "rather than starting again from scratch. This can be much faster when there are many "
+            "restarts, but may not always pick exactly the same solution.", true),
     a_promote_binaries(&g_resolution_options, "promote-binaries", '\0',
             "Select when to promote packages from binary repositories",
             args::EnumArg::EnumArgOptions
@@ -319,7 +323,10 @@ ResolveCommandLineResolutionOptions::ResolveCommandLineResolutionOptions(args::A
     g_dump_options(this, "Dump Options", "Dump the resolver's state to stdout after completion, or when an "
             "error occurs. For debugging purposes; produces rather a lot of noise."),
     a_dump(&g_dump_options, "dump", '\0', "Dump debug output", true),
-    a_dump_restarts(&g_dump_options, "dump-restarts", '\0', "Dump restarts", true)
+    a_dump_restarts(&g_dump_options, "dump-restarts", '\0', "Dump restarts", true),
+    a_profile_output(&g_dump_options, "profile-output", '\0', "Record where the resolver spends its time. A "
+            "trace is written to the specified file in Chrome's trace event format, for loading into chrome://tracing "
+            "or similar, and a summary is dumped.")
 {
 }
 
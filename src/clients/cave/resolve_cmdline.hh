@@ -51,6 +51,7 @@ namespace paludis
             args::SwitchArg a_no_override_masks;
             args::SwitchArg a_no_override_flags;
             args::StringSetArg a_no_restarts_for;
+            args::SwitchArg a_incremental_restarts;
             args::EnumArg a_promote_binaries;
 
             args::ArgsGroup g_dependent_options;
@@ -118,6 +119,7 @@ namespace paludis
             args::ArgsGroup g_dump_options;
             args::SwitchArg a_dump;
             args::SwitchArg a_dump_restarts;
+            args::StringArg a_profile_output;
 
             void apply_shortcuts();
             void verify(const std::shared_ptr<const Environment> & env);
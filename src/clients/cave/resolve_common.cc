@@ -45,6 +45,9 @@
 #include <paludis/util/join.hh>
 #include <paludis/util/tribool.hh>
 #include <paludis/util/process.hh>
+#include <paludis/util/profiler.hh>
+#include <paludis/util/safe_ofstream.hh>
+#include <paludis/util/fs_path.hh>
 
 #include <paludis/args/do_help.hh>
 #include <paludis/args/escape.hh>
@@ -106,6 +109,7 @@
 #include <paludis/elike_blocker.hh>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <list>
@@ -588,7 +592,43 @@ namespace
         }
     };
 
-    void display_restarts_if_requested(const std::list<SuggestRestart> & restarts,
+    void write_profile_if_requested(const ResolveCommandLineResolutionOptions & resolution_options)
+    {
+        if (! resolution_options.a_profile_output.specified())
+            return;
+
+        Profiler::get_instance()->set_enabled(false);
+
+        {
+            SafeOFStream trace(FSPath(resolution_options.a_profile_output.argument()), -1, true);
+            Profiler::get_instance()->write_trace(trace);
+        }
+
+        std::cout << "Dumping profile (trace written to '" << resolution_options.a_profile_output.argument()
+            << "'):" << std::endl << std::endl;
+        Profiler::get_instance()->write_summary(std::cout);
+        std::cout << std::endl;
+    }
+
+    struct Restart
+    {
+        SuggestRestart restart;
+        double seconds;
+        int decisions_before;
+        int decisions_after;
+        bool incremental;
+    };
+
+    int count_decisions(const std::shared_ptr<const Resolver> & resolver)
+    {
+        int result(0);
+        for (const auto & resolution : *resolver->resolved()->resolutions_by_resolvent())
+            if (resolution->decision())
+                ++result;
+        return result;
+    }
+
+    void display_restarts_if_requested(const std::list<Restart> & restarts,
             const ResolveCommandLineResolutionOptions & resolution_options)
     {
         if (! resolution_options.a_dump_restarts.specified())
@@ -596,8 +636,12 @@ namespace
 
         std::cout << "Dumping restarts:" << std::endl << std::endl;
 
-        for (const auto & restart : restarts)
+        double total_seconds(0);
+        for (const auto & r : restarts)
         {
+            const SuggestRestart & restart(r.restart);
+            total_seconds += r.seconds;
+
             std::cout << "* " << restart.resolvent() << std::endl;
 
             std::cout << "    Had decided upon ";
@@ -615,8 +659,16 @@ namespace
                 std::cout << ", nothing is fine too";
             std::cout << " " << restart.problematic_constraint()->reason()->accept_returning<std::string>(ShortReasonName());
             std::cout << std::endl;
+
+            std::cout << "    Cost " << r.seconds << "s, ";
+            if (r.incremental)
+                std::cout << "undid " << (r.decisions_before - r.decisions_after) << " of " << r.decisions_before << " decisions";
+            else
+                std::cout << "started again from scratch, discarding " << r.decisions_before << " decisions";
+            std::cout << std::endl;
         }
 
+        std::cout << std::endl << "Restarts cost " << total_seconds << "s in total" << std::endl;
         std::cout << std::endl;
     }
 
@@ -1087,10 +1139,16 @@ paludis::cave::resolve_common(
                 n::remove_if_dependent_fn() = std::cref(remove_if_dependent_helper)
                 ));
 
+    if (resolution_options.a_profile_output.specified())
+    {
+        Profiler::get_instance()->clear();
+        Profiler::get_instance()->set_enabled(true);
+    }
+
     std::shared_ptr<Resolver> resolver(std::make_shared<Resolver>(env.get(), resolver_functions));
     bool is_set(false);
     std::shared_ptr<const Sequence<std::string> > targets_cleaned_up;
-    std::list<SuggestRestart> restarts;
+    std::list<Restart> restarts;
 
     try
     {
@@ -1099,17 +1157,22 @@ paludis::cave::resolve_common(
             ScopedNotifierCallback display_callback_holder(env.get(),
                     NotifierCallbackFunction(std::cref(display_callback)));
 
-            bool first(true);
+            bool first(true), need_targets(true);
+            auto attempt_start(std::chrono::steady_clock::now());
             while (true)
             {
                 try
                 {
-                    if (purge)
+                    if (need_targets)
                     {
-                        resolver->purge();
-                        targets_cleaned_up = std::make_shared<Sequence<std::string>>();
-                    } else
-                        targets_cleaned_up = add_resolver_targets(env, resolver, resolution_options, targets_if_not_purge, is_set);
+                        if (purge)
+                        {
+                            resolver->purge();
+                            targets_cleaned_up = std::make_shared<Sequence<std::string>>();
+                        } else
+                            targets_cleaned_up = add_resolver_targets(env, resolver, resolution_options, targets_if_not_purge, is_set);
+                        need_targets = false;
+                    }
 
                     if (first)
                     {
@@ -1133,10 +1196,21 @@ paludis::cave::resolve_common(
                 }
                 catch (const SuggestRestart & e)
                 {
-                    restarts.push_back(e);
                     display_callback(ResolverRestart());
                     get_initial_constraints_for_helper.add_suggested_restart(e);
-                    resolver = std::make_shared<Resolver>(env.get(), resolver_functions);
+
+                    int decisions_before(count_decisions(resolver));
+                    bool incremental(resolution_options.a_incremental_restarts.specified() && resolver->undo_for_restart(e));
+                    if (! incremental)
+                    {
+                        resolver = std::make_shared<Resolver>(env.get(), resolver_functions);
+                        need_targets = true;
+                    }
+
+                    auto now(std::chrono::steady_clock::now());
+                    restarts.push_back(Restart{ e, std::chrono::duration<double>(now - attempt_start).count(),
+                            decisions_before, incremental ? count_decisions(resolver) : 0, incremental });
+                    attempt_start = now;
 
                     if (restarts.size() > 9000)
                         throw InternalError(PALUDIS_HERE, "Restarted over nine thousand times. Something's "
@@ -1150,6 +1224,7 @@ paludis::cave::resolve_common(
             display_restarts_if_requested(restarts, resolution_options);
 
         dump_if_requested(env, resolver, resolution_options);
+        write_profile_if_requested(resolution_options);
 
         retcode |= display_resolution(env, resolver->resolved(), resolution_options,
                 display_options, program_options, keys_if_import,
@@ -1197,6 +1272,7 @@ paludis::cave::resolve_common(
             display_restarts_if_requested(restarts, resolution_options);
 
         dump_if_requested(env, resolver, resolution_options);
+        write_profile_if_requested(resolution_options);
         throw;
     }
 
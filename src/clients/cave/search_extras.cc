@@ -28,8 +28,24 @@ struct CaveSearchExtrasDB
 {
     sqlite3 * db;
     sqlite3_stmt * add_candidate;
+    sqlite3_stmt * remove_candidates;
 };
 
+namespace
+{
+    void prepare_add_candidate(CaveSearchExtrasDB * const data)
+    {
+        if (data->add_candidate)
+            return;
+
+        if (SQLITE_OK != sqlite3_prepare_v2(data->db, "insert into candidates "
+                    "( spec, is_visible, is_best, is_best_visible, name, short_desc, long_desc ) "
+                    "values ( ?1, ?2, ?3, ?4, ?5, ?6, ?7 )",
+                    -1, &data->add_candidate, nullptr))
+            throw InternalError(PALUDIS_HERE, "sqlite3_prepare_v2 insert into candidates failed");
+    }
+}
+
 extern "C"
 CaveSearchExtrasDB *
 cave_search_extras_create_db(const std::string & file)
@@ -50,11 +66,11 @@ cave_search_extras_create_db(const std::string & file)
                 ")", nullptr, nullptr, nullptr))
         throw InternalError(PALUDIS_HERE, "sqlite3_exec create candidates failed");
 
-    if (SQLITE_OK != sqlite3_prepare_v2(data->db, "insert into candidates "
-                "( spec, is_visible, is_best, is_best_visible, name, short_desc, long_desc ) "
-                "values ( ?1, ?2, ?3, ?4, ?5, ?6, ?7 )",
-                -1, &data->add_candidate, nullptr))
-        throw InternalError(PALUDIS_HERE, "sqlite3_prepare_v2 insert into candidates failed");
+    /* so that updating one package doesn't mean scanning every row */
+    if (SQLITE_OK != sqlite3_exec(data->db, "create index candidates_name on candidates ( name )", nullptr, nullptr, nullptr))
+        throw InternalError(PALUDIS_HERE, "sqlite3_exec create index candidates_name failed");
+
+    prepare_add_candidate(data);
 
     return data;
 }
@@ -67,6 +83,7 @@ cave_search_extras_open_db(const std::string & file)
         throw InternalError(PALUDIS_HERE, "sqlite3_open failed");
 
     data->add_candidate = nullptr;
+    data->remove_candidates = nullptr;
 
     return data;
 }
@@ -77,6 +94,8 @@ cave_search_extras_cleanup(CaveSearchExtrasDB * const data)
 {
     if (data->add_candidate)
         sqlite3_finalize(data->add_candidate);
+    if (data->remove_candidates)
+        sqlite3_finalize(data->remove_candidates);
 
     sqlite3_close(data->db);
     delete data;
@@ -119,10 +138,36 @@ cave_search_extras_add_candidate(
         throw InternalError(PALUDIS_HERE, "sqlite3_step failed: " + stringify(code));
 }
 
+extern "C"
+void
+cave_search_extras_remove_candidates(
+        CaveSearchExtrasDB * const data,
+        const std::string & name)
+{
+    if (! data->remove_candidates)
+        if (SQLITE_OK != sqlite3_prepare_v2(data->db, "delete from candidates where name = ?1",
+                    -1, &data->remove_candidates, nullptr))
+            throw InternalError(PALUDIS_HERE, "sqlite3_prepare_v2 delete from candidates failed");
+
+    if (SQLITE_OK != sqlite3_reset(data->remove_candidates))
+        throw InternalError(PALUDIS_HERE, "sqlite3_reset remove candidates failed");
+    if (SQLITE_OK != sqlite3_clear_bindings(data->remove_candidates))
+        throw InternalError(PALUDIS_HERE, "sqlite3_clear_bindings remove candidates failed");
+
+    if (SQLITE_OK != sqlite3_bind_text(data->remove_candidates, 1, name.c_str(), name.length(), SQLITE_TRANSIENT))
+        throw InternalError(PALUDIS_HERE, "sqlite3_bind_text remove candidates 1 failed");
+
+    int code;
+    if (SQLITE_DONE != (code = sqlite3_step(data->remove_candidates)))
+        throw InternalError(PALUDIS_HERE, "sqlite3_step failed: " + stringify(code));
+}
+
 extern "C"
 void
 cave_search_extras_starting_adds(CaveSearchExtrasDB * const data)
 {
+    prepare_add_candidate(data);
+
     if (SQLITE_OK != sqlite3_exec(data->db, "begin", nullptr, nullptr, nullptr))
         throw InternalError(PALUDIS_HERE, "sqlite3_exec begin failed");
 }
@@ -37,6 +37,8 @@ extern "C" void cave_search_extras_starting_adds(CaveSearchExtrasDB * const) PAL
 extern "C" void cave_search_extras_add_candidate(CaveSearchExtrasDB * const, const std::string &,
         const bool, const bool, const bool, const std::string &, const std::string &, const std::string &) PALUDIS_VISIBLE;
 
+extern "C" void cave_search_extras_remove_candidates(CaveSearchExtrasDB * const, const std::string &) PALUDIS_VISIBLE;
+
 extern "C" void cave_search_extras_done_adds(CaveSearchExtrasDB * const) PALUDIS_VISIBLE;
 
 extern "C" void cave_search_extras_find_candidates(CaveSearchExtrasDB * const, std::list<std::string> &,
@@ -44,6 +44,7 @@ SearchExtrasHandle::SearchExtrasHandle() :
     cleanup_db_function(nullptr),
     starting_adds_function(nullptr),
     add_candidate_function(nullptr),
+    remove_candidates_function(nullptr),
     done_adds_function(nullptr),
     find_candidates_function(nullptr)
 {
@@ -70,6 +71,10 @@ SearchExtrasHandle::SearchExtrasHandle() :
     if (! add_candidate_function)
         throw args::DoHelp("Search index creation not available because dlsym said " + stringify(::dlerror()));
 
+    remove_candidates_function = STUPID_CAST(RemoveCandidatesFunction, ::dlsym(handle, "cave_search_extras_remove_candidates"));
+    if (! remove_candidates_function)
+        throw args::DoHelp("Search index updating not available because dlsym said " + stringify(::dlerror()));
+
     starting_adds_function = STUPID_CAST(StartingAddsFunction, ::dlsym(handle, "cave_search_extras_starting_adds"));
     if (! starting_adds_function)
         throw args::DoHelp("Search index creation not available because dlsym said " + stringify(::dlerror()));
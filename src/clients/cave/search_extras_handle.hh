@@ -40,6 +40,7 @@ namespace paludis
 
             typedef void (* AddCandidateFunction)(CaveSearchExtrasDB * const, const std::string &,
                     const bool, const bool, const bool, const std::string &, const std::string &, const std::string &);
+            typedef void (* RemoveCandidatesFunction)(CaveSearchExtrasDB * const, const std::string &);
             typedef void (* StartingAddsFunction)(CaveSearchExtrasDB * const);
             typedef void (* DoneAddsFunction)(CaveSearchExtrasDB * const);
 
@@ -55,6 +56,7 @@ namespace paludis
 
             StartingAddsFunction starting_adds_function;
             AddCandidateFunction add_candidate_function;
+            RemoveCandidatesFunction remove_candidates_function;
             DoneAddsFunction done_adds_function;
 
             FindCandidatesFunction find_candidates_function;
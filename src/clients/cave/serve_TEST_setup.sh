@@ -0,0 +1,79 @@
+#!/usr/bin/env bash
+# vim: set ft=sh sw=4 sts=4 et :
+
+mkdir serve_TEST_dir || exit 1
+cd serve_TEST_dir || exit 1
+
+mkdir -p config/.paludis-serve-test/repositories
+cat <<END > config/.paludis-serve-test/specpath.conf
+config-suffix =
+END
+
+cat <<END > config/.paludis-serve-test/use.conf
+*/* foo
+END
+
+cat <<END > config/.paludis-serve-test/licenses.conf
+*/* *
+END
+
+cat <<END > config/.paludis-serve-test/keywords.conf
+*/* test
+END
+
+cat <<END > config/.paludis-serve-test/general.conf
+world = `pwd`/root/world
+END
+
+cat <<END > config/.paludis-serve-test/repositories/repo1.conf
+location = `pwd`/repo1
+cache = /var/empty
+format = e
+names_cache = /var/empty
+profiles = \${location}/profiles/testprofile
+builddir = `pwd`/build
+END
+
+cat <<END > config/.paludis-serve-test/repositories/installed.conf
+location = `pwd`/root/var/db/pkg
+format = vdb
+names_cache = /var/empty
+builddir = `pwd`/build
+END
+
+cat <<END > repo2.conf
+location = `pwd`/repo2
+cache = /var/empty
+format = e
+names_cache = /var/empty
+profiles = `pwd`/repo1/profiles/testprofile
+builddir = `pwd`/build
+END
+
+mkdir -p build
+mkdir -p root/var/db/pkg
+
+for r in repo1 repo2 ; do
+    mkdir -p ${r}/{eclass,distfiles,metadata,profiles,cat/{a,b}} || exit 1
+    echo "test-${r}" > ${r}/profiles/repo_name || exit 1
+    echo "cat" > ${r}/profiles/categories || exit 1
+done
+
+mkdir -p repo1/profiles/testprofile || exit 1
+cat <<END > repo1/profiles/testprofile/make.defaults
+ARCH=test
+USERLAND=test
+KERNEL=test
+END
+
+for p in repo1/cat/a/a-1 repo2/cat/a/a-2 ; do
+    cat <<"END" > ${p}.ebuild || exit 1
+DESCRIPTION="Test"
+HOMEPAGE="http://paludis.exherbo.org/"
+SRC_URI=""
+SLOT="0"
+IUSE=""
+LICENSE="GPL-2"
+KEYWORDS="test"
+END
+done
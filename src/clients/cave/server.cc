@@ -0,0 +1,322 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "server.hh"
+
+#include <paludis/util/sequence.hh>
+#include <paludis/util/wrapped_forward_iterator.hh>
+#include <paludis/util/stringify.hh>
+#include <paludis/util/destringify.hh>
+#include <paludis/util/fs_path.hh>
+#include <paludis/util/join.hh>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+extern char ** environ;
+
+using namespace paludis;
+using namespace cave;
+
+namespace
+{
+    std::string the_server_socket;
+    std::string the_server_environment_spec;
+
+    const std::string protocol_magic("cave-server-2");
+
+    /* so that a huge or garbled length can't make us allocate everything */
+    const std::string::size_type max_string_length(1 << 30);
+
+    const char * const commands_for_server[] = {
+        "has-version",
+        "match",
+        "print-best-version",
+        "print-categories",
+        "print-ids",
+        "print-packages",
+        "print-repositories",
+        "print-set",
+        "print-sets"
+    };
+
+    bool starts_with(const std::string & s, const std::string & p)
+    {
+        return 0 == s.compare(0, p.length(), p);
+    }
+
+    bool ends_with(const std::string & s, const std::string & p)
+    {
+        return s.length() >= p.length() && 0 == s.compare(s.length() - p.length(), p.length(), p);
+    }
+}
+
+ServerError::ServerError(const std::string & s) noexcept :
+    Exception(s)
+{
+}
+
+ServerConnection::ServerConnection(const int fd) :
+    _fd(fd)
+{
+}
+
+ServerConnection::ServerConnection(const std::string & socket_name) :
+    _fd(-1)
+{
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_name.length() >= sizeof(addr.sun_path))
+        throw ServerError("Server socket name '" + socket_name + "' is too long");
+    std::strncpy(addr.sun_path, socket_name.c_str(), sizeof(addr.sun_path) - 1);
+
+    _fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (-1 == _fd)
+        throw ServerError("socket failed: " + std::string(std::strerror(errno)));
+
+    if (-1 == ::connect(_fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)))
+    {
+        int e(errno);
+        ::close(_fd);
+        _fd = -1;
+        throw ServerError("Cannot connect to server socket '" + socket_name + "': " + std::strerror(e));
+    }
+}
+
+ServerConnection::~ServerConnection()
+{
+    if (-1 != _fd)
+        ::close(_fd);
+}
+
+int
+ServerConnection::fd() const
+{
+    return _fd;
+}
+
+void
+ServerConnection::write_string(const std::string & s)
+{
+    std::string data(stringify(s.length()) + "\n" + s);
+
+    for (std::string::size_type done(0) ; done < data.length() ; )
+    {
+        /* MSG_NOSIGNAL, so a client going away doesn't kill a server */
+        ssize_t r(::send(_fd, data.data() + done, data.length() - done, MSG_NOSIGNAL));
+        if (r < 0)
+        {
+            if (EINTR == errno)
+                continue;
+            throw ServerError("send failed: " + std::string(std::strerror(errno)));
+        }
+        done += r;
+    }
+}
+
+std::string
+ServerConnection::read_string()
+{
+    std::string length_str;
+    while (true)
+    {
+        char c;
+        ssize_t r(::recv(_fd, &c, 1, 0));
+        if (r < 0 && EINTR == errno)
+            continue;
+        if (r < 0)
+            throw ServerError("recv failed: " + std::string(std::strerror(errno)));
+        if (0 == r)
+            throw ServerError("Connection closed unexpectedly");
+        if ('\n' == c)
+            break;
+        if (c < '0' || c > '9' || length_str.length() > 10)
+            throw ServerError("Bad length received");
+        length_str.append(1, c);
+    }
+
+    std::string::size_type length(destringify<std::string::size_type>(length_str));
+    if (length > max_string_length)
+        throw ServerError("Bad length received");
+
+    std::string result(length, '\0');
+    for (std::string::size_type done(0) ; done < length ; )
+    {
+        ssize_t r(::recv(_fd, &result[done], length - done, 0));
+        if (r < 0 && EINTR == errno)
+            continue;
+        if (r < 0)
+            throw ServerError("recv failed: " + std::string(std::strerror(errno)));
+        if (0 == r)
+            throw ServerError("Connection closed unexpectedly");
+        done += r;
+    }
+
+    return result;
+}
+
+void
+ServerConnection::write_request(const std::string & kind)
+{
+    write_string(protocol_magic);
+    write_string(kind);
+}
+
+std::string
+ServerConnection::read_request()
+{
+    if (read_string() != protocol_magic)
+        throw ServerError("Client is using a different protocol version");
+    return read_string();
+}
+
+void
+paludis::cave::set_server_options(const std::string & s, const std::string & e)
+{
+    the_server_socket = s;
+    the_server_environment_spec = e;
+}
+
+const std::string
+paludis::cave::server_socket()
+{
+    return the_server_socket;
+}
+
+const std::string
+paludis::cave::server_environment_spec()
+{
+    return the_server_environment_spec;
+}
+
+bool
+paludis::cave::command_can_run_on_server(const std::string & c)
+{
+    return std::end(commands_for_server) != std::find(std::begin(commands_for_server), std::end(commands_for_server), c);
+}
+
+const std::string
+paludis::cave::server_relevant_environment_variables()
+{
+    std::vector<std::string> result;
+    for (char ** e(environ) ; e && *e ; ++e)
+    {
+        std::string v(*e);
+        std::string name(v.substr(0, v.find('=')));
+
+        /* these are set by us as we run, rather than configuring us */
+        if (name == "PALUDIS_CLIENT" || name == "PALUDIS_PID")
+            continue;
+
+        if (starts_with(name, "PALUDIS_") || (starts_with(name, "CAVE") && ends_with(name, "_OPTIONS"))
+                || name == "HOME" || name == "ROOT")
+            result.push_back(v);
+    }
+
+    std::sort(result.begin(), result.end());
+    return join(result.begin(), result.end(), "\n");
+}
+
+bool
+paludis::cave::run_on_server(
+        const LogLevel log_level,
+        const bool want_colours,
+        const std::shared_ptr<const Sequence<std::string> > & args,
+        int & exit_status)
+{
+    if (the_server_socket.empty() || args->empty() || ! command_can_run_on_server(*args->begin()))
+        return false;
+
+    Context context("When asking the server at '" + the_server_socket + "' to run '" + join(args->begin(), args->end(), " ") + "':");
+
+    std::string out, err;
+    try
+    {
+        ServerConnection connection(the_server_socket);
+
+        connection.write_request("run");
+        connection.write_string(the_server_environment_spec);
+        connection.write_string(stringify(log_level));
+        connection.write_string(Log::get_instance()->structured_log_file());
+        connection.write_string(want_colours ? "yes" : "no");
+        connection.write_string(stringify(FSPath::cwd()));
+        connection.write_string(server_relevant_environment_variables());
+        connection.write_string(stringify(std::distance(args->begin(), args->end())));
+        for (const auto & a : *args)
+            connection.write_string(a);
+
+        std::string status(connection.read_string());
+        if (status == "error")
+        {
+            Log::get_instance()->message("cave.server.failed", ll_warning, lc_context)
+                << "Server failed to run the command, so running it ourselves: " << connection.read_string();
+            return false;
+        }
+        else if (status != "ok")
+        {
+            Log::get_instance()->message("cave.server.declined", ll_debug, lc_context)
+                << "Server declined to run the command, so running it ourselves: " << connection.read_string();
+            return false;
+        }
+
+        exit_status = destringify<int>(connection.read_string());
+        out = connection.read_string();
+        err = connection.read_string();
+    }
+    catch (const ServerError & e)
+    {
+        /* most likely the server just isn't running */
+        Log::get_instance()->message("cave.server.unavailable", ll_debug, lc_context)
+            << "Running the command ourselves: " << e.message();
+        return false;
+    }
+
+    std::cout << out << std::flush;
+    std::cerr << err << std::flush;
+    return true;
+}
+
+void
+paludis::cave::notify_server_of_changes()
+{
+    if (the_server_socket.empty())
+        return;
+
+    Context context("When telling the server at '" + the_server_socket + "' that things have changed:");
+
+    try
+    {
+        ServerConnection connection(the_server_socket);
+        connection.write_request("invalidate");
+        std::string PALUDIS_ATTRIBUTE((unused)) dummy(connection.read_string());
+    }
+    catch (const ServerError & e)
+    {
+        Log::get_instance()->message("cave.server.unavailable", ll_debug, lc_context)
+            << "Could not notify the server: " << e.message();
+    }
+}
@@ -0,0 +1,125 @@
+/* vim: set sw=4 sts=4 et foldmethod=syntax : */
+
+/*
+ * Copyright (c) 2026 Paludis developers
+ *
+ * This file is part of the Paludis package manager. Paludis is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU General
+ * Public License version 2, as published by the Free Software Foundation.
+ *
+ * Paludis is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PALUDIS_GUARD_SRC_CLIENTS_CAVE_SERVER_HH
+#define PALUDIS_GUARD_SRC_CLIENTS_CAVE_SERVER_HH 1
+
+#include <paludis/util/attributes.hh>
+#include <paludis/util/exception.hh>
+#include <paludis/util/sequence-fwd.hh>
+#include <paludis/util/log.hh>
+#include <memory>
+#include <string>
+
+namespace paludis
+{
+    namespace cave
+    {
+        class PALUDIS_VISIBLE ServerError :
+            public Exception
+        {
+            public:
+                ServerError(const std::string &) noexcept;
+        };
+
+        /**
+         * A connection to or from a 'cave serve' process, over a Unix socket.
+         *
+         * Everything sent is a string, written as its length in decimal, a
+         * newline, and then its contents.
+         */
+        class PALUDIS_VISIBLE ServerConnection
+        {
+            private:
+                int _fd;
+
+            public:
+                /**
+                 * Take ownership of an already connected socket.
+                 */
+                explicit ServerConnection(const int fd);
+
+                /**
+                 * Connect to a server, throwing ServerError if there isn't one.
+                 */
+                explicit ServerConnection(const std::string & socket);
+
+                ~ServerConnection();
+
+                ServerConnection(const ServerConnection &) = delete;
+                ServerConnection & operator= (const ServerConnection &) = delete;
+
+                int fd() const PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                void write_string(const std::string &);
+                std::string read_string() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+                /**
+                 * Start a request of a particular kind, with the protocol
+                 * version first so a server can reject a client it doesn't
+                 * understand.
+                 */
+                void write_request(const std::string & kind);
+
+                /**
+                 * Read the kind of request written by write_request.
+                 */
+                std::string read_request() PALUDIS_ATTRIBUTE((warn_unused_result));
+        };
+
+        /**
+         * Set from the global --server and --environment options.
+         */
+        void set_server_options(const std::string & socket, const std::string & environment_spec);
+        const std::string server_socket() PALUDIS_ATTRIBUTE((warn_unused_result));
+        const std::string server_environment_spec() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+        /**
+         * Only read-only commands whose output doesn't depend upon anything
+         * but the environment and their arguments may be run by a server.
+         */
+        bool command_can_run_on_server(const std::string &) PALUDIS_ATTRIBUTE((warn_unused_result));
+
+        /**
+         * The environment variables that must be the same for a client and a
+         * server to agree on how things are configured.
+         */
+        const std::string server_relevant_environment_variables() PALUDIS_ATTRIBUTE((warn_unused_result));
+
+        /**
+         * Try to have the server run a command for us, copying its output to
+         * our own. Returns false, having done nothing, if there is no server
+         * or it won't run the command for us.
+         */
+        bool run_on_server(
+                const LogLevel,
+                const bool want_colours,
+                const std::shared_ptr<const Sequence<std::string> > & args,
+                int & exit_status) PALUDIS_ATTRIBUTE((warn_unused_result));
+
+        /**
+         * Tell the server, if there is one, that we've changed installed
+         * packages, repositories or the world set, so it shouldn't keep using
+         * what it already knows.
+         */
+        void notify_server_of_changes();
+    }
+}
+
+#endif